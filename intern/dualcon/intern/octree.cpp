@@ -29,6 +29,10 @@
 #include <limits>
 #include <time.h>
 
+#ifdef _OPENMP
+#  include <omp.h>
+#endif
+
 /**
  * Implementations of Octree member functions.
  *
@@ -120,7 +124,7 @@ void Octree::scanConvert()
 
 	addAllTriangles();
 	resetMinimalEdges();
-	preparePrimalEdgesMask(&root->internal);
+	preparePrimalEdgesMask();
 
 #if DC_DEBUG
 	finish = clock();
@@ -206,6 +210,26 @@ void Octree::scanConvert()
 
 void Octree::initMemory()
 {
+#ifdef _OPENMP
+	numAllocators = omp_get_max_threads();
+#else
+	numAllocators = 1;
+#endif
+
+	/* the sets of the other threads are only created when the octree is
+	   built in threads, see addTrianglesThreaded() */
+	allocators = new NodeAllocators[numAllocators]();
+	initAllocators(0);
+}
+
+void Octree::initAllocators(int thread)
+{
+	VirtualMemoryAllocator **alloc = allocators[thread].alloc;
+	VirtualMemoryAllocator **leafalloc = allocators[thread].leafalloc;
+
+	if (alloc[0])
+		return;
+
 	leafalloc[0] = new MemoryAllocator<sizeof(LeafNode)>();
 	leafalloc[1] = new MemoryAllocator<sizeof(LeafNode) + sizeof(float) *EDGE_FLOATS>();
 	leafalloc[2] = new MemoryAllocator<sizeof(LeafNode) + sizeof(float) *EDGE_FLOATS * 2>();
@@ -224,34 +248,59 @@ void Octree::initMemory()
 
 void Octree::freeMemory()
 {
-	for (int i = 0; i < 9; i++) {
-		alloc[i]->destroy();
-		delete alloc[i];
+	for (int t = 0; t < numAllocators; t++) {
+		if (allocators[t].alloc[0] == NULL)
+			continue;
+
+		for (int i = 0; i < 9; i++) {
+			allocators[t].alloc[i]->destroy();
+			delete allocators[t].alloc[i];
+		}
+
+		for (int i = 0; i < 4; i++) {
+			allocators[t].leafalloc[i]->destroy();
+			delete allocators[t].leafalloc[i];
+		}
 	}
 
-	for (int i = 0; i < 4; i++) {
-		leafalloc[i]->destroy();
-		delete leafalloc[i];
+	delete [] allocators;
+}
+
+/* Nodes can be freed by another thread than the one which allocated them,
+   so the counts of one set can be negative, only their sum is printed */
+static void printAllocatorsInfo(NodeAllocators *allocators, int numAllocators,
+                                bool leaf, int num, int *totalbytes, int *totalused)
+{
+	int bytes = 0, used = 0, all = 0;
+
+	for (int t = 0; t < numAllocators; t++) {
+		VirtualMemoryAllocator *alloc = leaf ? allocators[t].leafalloc[num] : allocators[t].alloc[num];
+
+		if (alloc == NULL)
+			continue;
+
+		bytes = alloc->getBytes();
+		used += alloc->getAllocated();
+		all += alloc->getAll();
 	}
+
+	dc_printf("Bytes: %d Used: %d Allocated: %d\n", bytes, used, all);
+
+	*totalbytes += all * bytes;
+	*totalused += used;
 }
 
 void Octree::printMemUsage()
 {
-	int totalbytes = 0;
+	int totalbytes = 0, totalInternals = 0, totalLeafs = 0;
+
 	dc_printf("********* Internal nodes: \n");
-	for (int i = 0; i < 9; i++) {
-		alloc[i]->printInfo();
+	for (int i = 0; i < 9; i++)
+		printAllocatorsInfo(allocators, numAllocators, false, i, &totalbytes, &totalInternals);
 
-		totalbytes += alloc[i]->getAll() * alloc[i]->getBytes();
-	}
 	dc_printf("********* Leaf nodes: \n");
-	int totalLeafs = 0;
-	for (int i = 0; i < 4; i++) {
-		leafalloc[i]->printInfo();
-
-		totalbytes += leafalloc[i]->getAll() * leafalloc[i]->getBytes();
-		totalLeafs += leafalloc[i]->getAllocated();
-	}
+	for (int i = 0; i < 4; i++)
+		printAllocatorsInfo(allocators, numAllocators, true, i, &totalbytes, &totalLeafs);
 
 	dc_printf("Total allocated bytes on disk: %d \n", totalbytes);
 	dc_printf("Total leaf nodes: %d\n", totalLeafs);
@@ -264,76 +313,52 @@ void Octree::resetMinimalEdges()
 
 void Octree::addAllTriangles()
 {
+	std::vector<Triangle *> triangles;
 	Triangle *trian;
-	int count = 0;
 
 #if DC_DEBUG
-	int total = reader->getNumTriangles();
-	int unitcount = 1000;
 	dc_printf("\nScan converting to depth %d...\n", maxDepth);
 #endif
 
 	srand(0);
 
 	while ((trian = reader->getNextTriangle()) != NULL) {
-		// Drop triangles
-		{
-			addTriangle(trian, count);
-		}
-		delete trian;
-
-		count++;
-
-#if DC_DEBUG
-		if (count % unitcount == 0) {
-			putchar(13);
-
-			switch ((count / unitcount) % 4) {
-				case 0: dc_printf("-");
-					break;
-				case 1: dc_printf("/");
-					break;
-				case 2: dc_printf("|");
-					break;
-				case 3: dc_printf("\\");
-					break;
-			}
+		projectTriangle(trian);
+		triangles.push_back(trian);
+	}
 
-			float percent = (float) count / total;
+	/* below depth 3 the cells two levels down are leaves, too few to
+	   split the work over anyway */
+	if (numAllocators > 1 && maxDepth >= 3) {
+		addTrianglesThreaded(triangles);
+	}
+	else {
+		for (int i = 0; i < (int)triangles.size(); i++)
+			addTriangle(triangles[i], i);
+	}
 
-			/*
-			   int totbars = 50;
-			   int bars =(int)(percent * totbars);
-			   for(int i = 0; i < bars; i ++) {
-			    putchar(219);
-			   }
-			   for(i = bars; i < totbars; i ++) {
-			    putchar(176);
-			   }
-			 */
+	for (int i = 0; i < (int)triangles.size(); i++)
+		delete triangles[i];
 
-			dc_printf(" %d triangles: ", count);
-			dc_printf(" %f%% complete.", 100 * percent);
-		}
-#endif
-
-	}
 	putchar(13);
 }
 
-/* Prepare a triangle for insertion into the octree; call the other
-   addTriangle() to (recursively) build the octree */
-void Octree::addTriangle(Triangle *trian, int triind)
+/* Project the triangle's coordinates into the grid */
+void Octree::projectTriangle(Triangle *trian)
 {
 	int i, j;
 
-	/* Project the triangle's coordinates into the grid */
 	for (i = 0; i < 3; i++) {
 		for (j = 0; j < 3; j++)
 			trian->vt[i][j] = dimen * (trian->vt[i][j] - origin[j]) / range;
 	}
+}
+
+/* Generate projections of a grid triangle against the root cube */
+CubeTriangleIsect *Octree::createProjections(const Triangle *trian, int triind)
+{
+	int i, j;
 
-	/* Generate projections */
 	int64_t cube[2][3] = {{0, 0, 0}, {dimen, dimen, dimen}};
 	int64_t trig[3][3];
 	for (i = 0; i < 3; i++) {
@@ -341,15 +366,176 @@ void Octree::addTriangle(Triangle *trian, int triind)
 			trig[i][j] = (int64_t)(trian->vt[i][j]);
 	}
 
-	/* Add triangle to the octree */
 	int64_t errorvec = (int64_t)(0);
-	CubeTriangleIsect *proj = new CubeTriangleIsect(cube, trig, errorvec, triind);
+	return new CubeTriangleIsect(cube, trig, errorvec, triind);
+}
+
+/* Prepare a triangle for insertion into the octree; call the other
+   addTriangle() to (recursively) build the octree */
+void Octree::addTriangle(Triangle *trian, int triind)
+{
+	/* Add triangle to the octree */
+	CubeTriangleIsect *proj = createProjections(trian, triind);
 	root = (Node *)addTriangle(&root->internal, proj, maxDepth);
 
 	delete proj->inherit;
 	delete proj;
 }
 
+/* Projections for child `index' of the cube of `p', the same as the
+   shifts in addTriangle() add up to */
+static void child_projections(CubeTriangleIsect *p, int index, CubeTriangleIsect *r_subp)
+{
+	int off[3] = {(index >> 2) & 1, (index >> 1) & 1, index & 1};
+
+	*r_subp = CubeTriangleIsect(p);
+	r_subp->shift(off);
+}
+
+/* Find the children and grandchildren of the root that addTriangle()
+   would insert the triangle in */
+void Octree::findTriangleCells(CubeTriangleIsect *p, TriangleCells *cells)
+{
+	unsigned char boxmask = p->getBoxMask();
+	CubeTriangleIsect subp, subsubp;
+
+	cells->children = 0;
+	memset(cells->grandchildren, 0, sizeof(cells->grandchildren));
+
+	for (int i = 0; i < 8; i++) {
+		if (!(boxmask & (1 << i)))
+			continue;
+
+		child_projections(p, i, &subp);
+		if (!subp.isIntersecting())
+			continue;
+
+		cells->children |= (1 << i);
+
+		unsigned char subboxmask = subp.getBoxMask();
+		for (int j = 0; j < 8; j++) {
+			if (!(subboxmask & (1 << j)))
+				continue;
+
+			child_projections(&subp, j, &subsubp);
+			if (subsubp.isIntersecting())
+				cells->grandchildren[i] |= (1 << j);
+		}
+	}
+}
+
+/* Same result as calling addTriangle() for each triangle in order: the
+   nodes of the first two levels are created first, then the subtree of
+   each grandchild of the root is built in a thread from the triangles
+   intersecting it, in their original order. */
+void Octree::addTrianglesThreaded(const std::vector<Triangle *>& triangles)
+{
+	const int numtri = (int)triangles.size();
+	TriangleCells *tricells = new TriangleCells[numtri];
+	InternalNode *cells[64];
+	unsigned char children = 0, grandchildren[8] = {0};
+	int i, j;
+
+	for (i = 1; i < numAllocators; i++)
+		initAllocators(i);
+
+	/* Find the cells each triangle is inserted in */
+#pragma omp parallel for schedule(static)
+	for (int t = 0; t < numtri; t++) {
+		CubeTriangleIsect *proj = createProjections(triangles[t], t);
+		findTriangleCells(proj, &tricells[t]);
+
+		delete proj->inherit;
+		delete proj;
+	}
+
+	for (int t = 0; t < numtri; t++) {
+		children |= tricells[t].children;
+		for (i = 0; i < 8; i++)
+			grandchildren[i] |= tricells[t].grandchildren[i];
+	}
+
+	/* Create the nodes of the first two levels */
+	InternalNode *node = &root->internal;
+	int count = 0;
+	for (i = 0; i < 8; i++) {
+		if (children & (1 << i))
+			node = addInternalChild(node, i, count++, createInternal(0));
+	}
+	root = (Node *)node;
+
+	count = 0;
+	for (i = 0; i < 8; i++) {
+		for (j = 0; j < 8; j++)
+			cells[i * 8 + j] = NULL;
+
+		if (!(children & (1 << i)))
+			continue;
+
+		InternalNode *chd = &node->get_child(count)->internal;
+		int subcount = 0;
+		for (j = 0; j < 8; j++) {
+			if (grandchildren[i] & (1 << j))
+				chd = addInternalChild(chd, j, subcount++, createInternal(0));
+		}
+		node->set_child(count, (Node *)chd);
+
+		subcount = 0;
+		for (j = 0; j < 8; j++) {
+			if (grandchildren[i] & (1 << j))
+				cells[i * 8 + j] = &chd->get_child(subcount++)->internal;
+		}
+		count++;
+	}
+
+	/* Build the subtrees of the grandchildren */
+#pragma omp parallel for schedule(dynamic)
+	for (int c = 0; c < 64; c++) {
+		InternalNode *cell = cells[c];
+		CubeTriangleIsect subp, subsubp;
+#ifdef _OPENMP
+		int thread = omp_get_thread_num();
+#else
+		int thread = 0;
+#endif
+
+		if (cell == NULL)
+			continue;
+
+		for (int t = 0; t < numtri; t++) {
+			if (!(tricells[t].grandchildren[c / 8] & (1 << (c % 8))))
+				continue;
+
+			CubeTriangleIsect *proj = createProjections(triangles[t], t);
+			child_projections(proj, c / 8, &subp);
+			child_projections(&subp, c % 8, &subsubp);
+			cell = addTriangle(cell, &subsubp, maxDepth - 2, thread);
+
+			delete proj->inherit;
+			delete proj;
+		}
+
+		cells[c] = cell;
+	}
+
+	/* Link the rebuilt grandchildren */
+	count = 0;
+	for (i = 0; i < 8; i++) {
+		if (!(children & (1 << i)))
+			continue;
+
+		InternalNode *chd = &node->get_child(count)->internal;
+		int subcount = 0;
+		for (j = 0; j < 8; j++) {
+			if (grandchildren[i] & (1 << j))
+				chd->set_child(subcount++, (Node *)cells[i * 8 + j]);
+		}
+		count++;
+	}
+
+	delete [] tricells;
+}
+
 #if 0
 static void print_depth(int height, int maxDepth)
 {
@@ -358,7 +544,7 @@ static void print_depth(int height, int maxDepth)
 }
 #endif
 
-InternalNode *Octree::addTriangle(InternalNode *node, CubeTriangleIsect *p, int height)
+InternalNode *Octree::addTriangle(InternalNode *node, CubeTriangleIsect *p, int height, int thread)
 {
 	int i;
 	const int vertdiff[8][3] = {
@@ -391,16 +577,16 @@ InternalNode *Octree::addTriangle(InternalNode *node, CubeTriangleIsect *p, int
 			if (subp->isIntersecting()) {
 				if (!node->has_child(i)) {
 					if (height == 1)
-						node = addLeafChild(node, i, count, createLeaf(0));
+						node = addLeafChild(node, i, count, createLeaf(0, thread), thread);
 					else
-						node = addInternalChild(node, i, count, createInternal(0));
+						node = addInternalChild(node, i, count, createInternal(0, thread), thread);
 				}
 				Node *chd = node->get_child(count);
 
 				if (node->is_child_leaf(i))
-					node->set_child(count, (Node *)updateCell(&chd->leaf, subp));
+					node->set_child(count, (Node *)updateCell(&chd->leaf, subp, thread));
 				else
-					node->set_child(count, (Node *)addTriangle(&chd->internal, subp, height - 1));
+					node->set_child(count, (Node *)addTriangle(&chd->internal, subp, height - 1, thread));
 			}
 		}
 
@@ -413,7 +599,7 @@ InternalNode *Octree::addTriangle(InternalNode *node, CubeTriangleIsect *p, int
 	return node;
 }
 
-LeafNode *Octree::updateCell(LeafNode *node, CubeTriangleIsect *p)
+LeafNode *Octree::updateCell(LeafNode *node, CubeTriangleIsect *p, int thread)
 {
 	int i;
 
@@ -445,12 +631,33 @@ LeafNode *Octree::updateCell(LeafNode *node, CubeTriangleIsect *p)
 
 	if (newc > oldc) {
 		// New offsets added, update this node
-		node = updateEdgeOffsetsNormals(node, oldc, newc, offs, a, b, c);
+		node = updateEdgeOffsetsNormals(node, oldc, newc, offs, a, b, c, thread);
 	}
 
 	return node;
 }
 
+void Octree::preparePrimalEdgesMask()
+{
+	InternalNode *node = &root->internal;
+	Node *chd[8];
+	int leaf[8];
+
+	/* the subtrees of the root are independent */
+	node->fill_children(chd, leaf);
+
+#pragma omp parallel for schedule(dynamic)
+	for (int i = 0; i < 8; i++) {
+		if (chd[i] == NULL)
+			continue;
+
+		if (leaf[i])
+			createPrimalEdgesMask(&chd[i]->leaf);
+		else
+			preparePrimalEdgesMask(&chd[i]->internal);
+	}
+}
+
 void Octree::preparePrimalEdgesMask(InternalNode *node)
 {
 	int count = 0;
@@ -1712,8 +1919,20 @@ void Octree::buildSigns()
 
 	// Next, traverse the grid
 	int sg = 1;
-	int cube[8];
-	buildSigns(table, root, 0, sg, cube);
+	Node *chd[8];
+	int leaf[8];
+	int oris[8];
+
+	// The signs at the corners of the first cube give the signs the
+	// others start with, after that their subtrees are independent
+	root->internal.fill_children(chd, leaf);
+	buildSigns(table, chd[0], leaf[0], sg, oris);
+
+#pragma omp parallel for schedule(dynamic)
+	for (int i = 1; i < 8; i++) {
+		int cube[8];
+		buildSigns(table, chd[i], leaf[i], oris[i], cube);
+	}
 }
 
 void Octree::buildSigns(unsigned char table[], Node *node, int isLeaf, int sg, int rvalue[8])
@@ -27,6 +27,7 @@
 #include <cstring>
 #include <stdio.h>
 #include <math.h>
+#include <vector>
 #include "GeoCommon.h"
 #include "Projections.h"
 #include "ModelReader.h"
@@ -223,6 +224,23 @@ struct PathList {
 };
 
 
+/**
+ * Memory allocators for internal and leaf nodes. Each thread building a
+ * part of the octree has its own set, so no locking is needed.
+ */
+struct NodeAllocators {
+	VirtualMemoryAllocator *alloc[9];
+	VirtualMemoryAllocator *leafalloc[4];
+};
+
+/**
+ * Cells intersected by a triangle, one and two levels below the root
+ */
+struct TriangleCells {
+	unsigned char children;
+	unsigned char grandchildren[8];
+};
+
 /**
  * Class for building and processing an octree
  */
@@ -231,9 +249,9 @@ class Octree
  public:
 	/* Public members */
 
-	/// Memory allocators
-	VirtualMemoryAllocator *alloc[9];
-	VirtualMemoryAllocator *leafalloc[4];
+	/// Memory allocators, one set per thread
+	NodeAllocators *allocators;
+	int numAllocators;
 
 	/// Root node
 	Node *root;
@@ -310,6 +328,11 @@ class Octree
 	 */
 	void initMemory();
 
+	/**
+	 * Create the memory allocators of a thread, if not done yet
+	 */
+	void initAllocators(int thread);
+
 	/**
 	 * Release memory
 	 */
@@ -337,12 +360,25 @@ class Octree
 	 */
 	void addAllTriangles();
 	void addTriangle(Triangle *trian, int triind);
-	InternalNode *addTriangle(InternalNode *node, CubeTriangleIsect *p, int height);
+	InternalNode *addTriangle(InternalNode *node, CubeTriangleIsect *p, int height, int thread = 0);
+
+	/**
+	 * Add triangles to the tree in threads, each thread building the
+	 * subtrees of cells two levels below the root
+	 */
+	void addTrianglesThreaded(const std::vector<Triangle *>& triangles);
+	void findTriangleCells(CubeTriangleIsect *p, TriangleCells *cells);
+
+	/**
+	 * Project the triangle's coordinates into the grid
+	 */
+	void projectTriangle(Triangle *trian);
+	CubeTriangleIsect *createProjections(const Triangle *trian, int triind);
 
 	/**
 	 * Method to update minimizer in a cell: update edge intersections instead
 	 */
-	LeafNode *updateCell(LeafNode *node, CubeTriangleIsect *p);
+	LeafNode *updateCell(LeafNode *node, CubeTriangleIsect *p, int thread = 0);
 
 	/* Routines to detect and patch holes */
 	int numRings;
@@ -385,6 +421,7 @@ class Octree
 	int findPair(PathElement *head, int pos, int dir, PathElement *& pre1, PathElement *& pre2);
 	int getSide(PathElement *e, int pos, int dir);
 	int isEqual(PathElement *e1, PathElement *e2);
+	void preparePrimalEdgesMask();
 	void preparePrimalEdgesMask(InternalNode *node);
 	void testFacePoint(PathElement *e1, PathElement *e2);
 
@@ -1143,17 +1180,18 @@ class Octree
 
 
 	/// Update method
-	LeafNode *updateEdgeOffsetsNormals(LeafNode *leaf, int oldlen, int newlen, float offs[3], float a[3], float b[3], float c[3])
+	LeafNode *updateEdgeOffsetsNormals(LeafNode *leaf, int oldlen, int newlen, float offs[3], float a[3], float b[3], float c[3],
+	                                   int thread = 0)
 	{
 		// First, create a new leaf node
-		LeafNode *nleaf = createLeaf(newlen);
+		LeafNode *nleaf = createLeaf(newlen, thread);
 		*nleaf = *leaf;
 
 		// Next, fill in the offsets
 		setEdgeOffsetsNormals(nleaf, offs, a, b, c, newlen);
 
 		// Finally, delete the old leaf
-		removeLeaf(oldlen, leaf);
+		removeLeaf(oldlen, leaf, thread);
 
 		return nleaf;
 	}
@@ -1306,20 +1344,20 @@ class Octree
 		return rnode;
 	}
 
-	/// Allocate a node
-	InternalNode *createInternal(int length)
+	/// Allocate a node, with the allocators of the thread
+	InternalNode *createInternal(int length, int thread = 0)
 	{
-		InternalNode *inode = (InternalNode *)alloc[length]->allocate();
+		InternalNode *inode = (InternalNode *)allocators[thread].alloc[length]->allocate();
 		inode->has_child_bitfield = 0;
 		inode->child_is_leaf_bitfield = 0;
 		return inode;
 	}
 
-	LeafNode *createLeaf(int length)
+	LeafNode *createLeaf(int length, int thread = 0)
 	{
 		assert(length <= 3);
 
-		LeafNode *lnode = (LeafNode *)leafalloc[length]->allocate();
+		LeafNode *lnode = (LeafNode *)allocators[thread].leafalloc[length]->allocate();
 		lnode->edge_parity = 0;
 		lnode->primary_edge_intersections = 0;
 		lnode->signs = 0;
@@ -1327,23 +1365,26 @@ class Octree
 		return lnode;
 	}
 
-	void removeInternal(int num, InternalNode *node)
+	/* Nodes can be removed by another thread than the one which allocated
+	   them, the memory is owned by the allocator that created it until all
+	   allocators are destroyed together */
+	void removeInternal(int num, InternalNode *node, int thread = 0)
 	{
-		alloc[num]->deallocate(node);
+		allocators[thread].alloc[num]->deallocate(node);
 	}
 
-	void removeLeaf(int num, LeafNode *leaf)
+	void removeLeaf(int num, LeafNode *leaf, int thread = 0)
 	{
 		assert(num >= 0 && num <= 3);
-		leafalloc[num]->deallocate(leaf);
+		allocators[thread].leafalloc[num]->deallocate(leaf);
 	}
 
 	/// Add a leaf (by creating a new par node with the leaf added)
 	InternalNode *addLeafChild(InternalNode *par, int index, int count,
-							   LeafNode *leaf)
+							   LeafNode *leaf, int thread = 0)
 	{
 		int num = par->get_num_children() + 1;
-		InternalNode *npar = createInternal(num);
+		InternalNode *npar = createInternal(num, thread);
 		*npar = *par;
 
 		if (num == 1) {
@@ -1360,15 +1401,15 @@ class Octree
 			}
 		}
 
-		removeInternal(num - 1, par);
+		removeInternal(num - 1, par, thread);
 		return npar;
 	}
 
 	InternalNode *addInternalChild(InternalNode *par, int index, int count,
-								   InternalNode *node)
+								   InternalNode *node, int thread = 0)
 	{
 		int num = par->get_num_children() + 1;
-		InternalNode *npar = createInternal(num);
+		InternalNode *npar = createInternal(num, thread);
 		*npar = *par;
 
 		if (num == 1) {
@@ -1385,7 +1426,7 @@ class Octree
 			}
 		}
 
-		removeInternal(num - 1, par);
+		removeInternal(num - 1, par, thread);
 		return npar;
 	}
 
@@ -400,30 +400,20 @@ void FLUID_3D::step(float dt, float gravity[3])
 	SWAP_POINTERS(_zVelocity, _zVelocityTemp);
 #if PARALLEL==1
 	}	// end of single
+	}	// end of parallel region
 
-	#pragma omp barrier
-
-	#pragma omp for
-	for (int i=0; i<2; i++)
-	{
-		if (i==0)
-		{
-#endif
-			project();
-#if PARALLEL==1
-		}
-		else if (i==1)
-		{
+	/*
+	* The pressure and heat solvers split their own loops over
+	* all threads, so run them one after the other
+	*/
 #endif
-			if (_heat) {
-				diffuseHeat();
-			}
-#if PARALLEL==1
-		}
+	project();
+	if (_heat) {
+		diffuseHeat();
 	}
-
-	#pragma omp barrier
-
+#if PARALLEL==1
+	#pragma omp parallel
+	{
 	#pragma omp single
 	{
 #endif
@@ -31,16 +31,35 @@
 #include <cstring>
 #define SOLVER_ACCURACY 1e-06
 
+//////////////////////////////////////////////////////////////////////
+// The solver loops run over z slices in parallel. Sums and maxima are
+// kept per slice and combined afterwards, so the result does not
+// depend on the number of threads.
+//////////////////////////////////////////////////////////////////////
+static float sumSlices(const float *slices, int zRes)
+{
+	float sum = 0.0f;
+	for (int z = 1; z < zRes - 1; z++)
+		sum += slices[z];
+	return sum;
+}
+
+static float maxSlices(const float *slices, int zRes)
+{
+	float max = 0.0f;
+	for (int z = 1; z < zRes - 1; z++)
+		max = (slices[z] > max) ? slices[z] : max;
+	return max;
+}
+
 //////////////////////////////////////////////////////////////////////
 // solve the heat equation with CG
 //////////////////////////////////////////////////////////////////////
 void FLUID_3D::solveHeat(float* field, float* b, unsigned char* skip)
 {
-	int x, y, z;
-	const int twoxr = 2 * _xRes;
-	size_t index;
 	const float heatConst = _dt * _heatDiffusion / (_dx * _dx);
 	float *_q, *_residual, *_direction, *_Acenter;
+	float *sliceSum, *sliceMax;
 
 	// i = 0
 	int i = 0;
@@ -49,112 +68,139 @@ void FLUID_3D::solveHeat(float* field, float* b, unsigned char* skip)
 	_direction    = new float[_totalCells]; // set 0
 	_q            = new float[_totalCells]; // set 0
 	_Acenter       = new float[_totalCells]; // set 0
+	sliceSum      = new float[_zRes];
+	sliceMax      = new float[_zRes];
 
-  	memset(_residual, 0, sizeof(float)*_totalCells);
+	memset(_residual, 0, sizeof(float)*_totalCells);
 	memset(_q, 0, sizeof(float)*_totalCells);
 	memset(_direction, 0, sizeof(float)*_totalCells);
 	memset(_Acenter, 0, sizeof(float)*_totalCells);
 
-	float deltaNew = 0.0f;
-
-  // r = b - Ax
-  index = _slabSize + _xRes + 1;
-  for (z = 1; z < _zRes - 1; z++, index += twoxr)
-    for (y = 1; y < _yRes - 1; y++, index += 2)
-      for (x = 1; x < _xRes - 1; x++, index++)
-      {
-        // if the cell is a variable
-        _Acenter[index] = 1.0f;
-        if (!skip[index])
-        {
-          // set the matrix to the Poisson stencil in order
-          if (!skip[index + 1]) _Acenter[index] += heatConst;
-          if (!skip[index - 1]) _Acenter[index] += heatConst;
-          if (!skip[index + _xRes]) _Acenter[index] += heatConst;
-          if (!skip[index - _xRes]) _Acenter[index] += heatConst;
-          if (!skip[index + _slabSize]) _Acenter[index] += heatConst;
-          if (!skip[index - _slabSize]) _Acenter[index] += heatConst;
-
-		  _residual[index] = b[index] - (_Acenter[index] * field[index] + 
-          field[index - 1] * (skip[index - 1] ? 0.0f : -heatConst) +
-          field[index + 1] * (skip[index + 1] ? 0.0f : -heatConst) +
-          field[index - _xRes] * (skip[index - _xRes] ? 0.0f : -heatConst) +
-          field[index + _xRes] * (skip[index + _xRes] ? 0.0f : -heatConst) +
-          field[index - _slabSize] * (skip[index - _slabSize] ? 0.0f : -heatConst) +
-          field[index + _slabSize] * (skip[index + _slabSize] ? 0.0f : -heatConst));
-        }
-		else
-		{
-        _residual[index] = 0.0f;
-		}
-
-		_direction[index] = _residual[index];
-		deltaNew += _residual[index] * _residual[index];
-      }
+	// r = b - Ax
+#if PARALLEL==1
+	#pragma omp parallel for schedule(static)
+#endif
+	for (int z = 1; z < _zRes - 1; z++)
+	{
+		size_t index = (size_t)z * _slabSize + _xRes + 1;
+		float sum = 0.0f;
+
+		for (int y = 1; y < _yRes - 1; y++, index += 2)
+			for (int x = 1; x < _xRes - 1; x++, index++)
+			{
+				// if the cell is a variable
+				_Acenter[index] = 1.0f;
+				if (!skip[index])
+				{
+					// set the matrix to the Poisson stencil in order
+					if (!skip[index + 1]) _Acenter[index] += heatConst;
+					if (!skip[index - 1]) _Acenter[index] += heatConst;
+					if (!skip[index + _xRes]) _Acenter[index] += heatConst;
+					if (!skip[index - _xRes]) _Acenter[index] += heatConst;
+					if (!skip[index + _slabSize]) _Acenter[index] += heatConst;
+					if (!skip[index - _slabSize]) _Acenter[index] += heatConst;
+
+					_residual[index] = b[index] - (_Acenter[index] * field[index] + 
+					field[index - 1] * (skip[index - 1] ? 0.0f : -heatConst) +
+					field[index + 1] * (skip[index + 1] ? 0.0f : -heatConst) +
+					field[index - _xRes] * (skip[index - _xRes] ? 0.0f : -heatConst) +
+					field[index + _xRes] * (skip[index + _xRes] ? 0.0f : -heatConst) +
+					field[index - _slabSize] * (skip[index - _slabSize] ? 0.0f : -heatConst) +
+					field[index + _slabSize] * (skip[index + _slabSize] ? 0.0f : -heatConst));
+				}
+				else
+				{
+					_residual[index] = 0.0f;
+				}
+
+				_direction[index] = _residual[index];
+				sum += _residual[index] * _residual[index];
+			}
 
+		sliceSum[z] = sum;
+	}
+
+	float deltaNew = sumSlices(sliceSum, _zRes);
 
   // While deltaNew > (eps^2) * delta0
   const float eps  = SOLVER_ACCURACY;
   float maxR = 2.0f * eps;
   while ((i < _iterations) && (maxR > eps))
   {
-    // q = Ad
-	float alpha = 0.0f;
-
-    index = _slabSize + _xRes + 1;
-    for (z = 1; z < _zRes - 1; z++, index += twoxr)
-      for (y = 1; y < _yRes - 1; y++, index += 2)
-        for (x = 1; x < _xRes - 1; x++, index++)
-        {
-          // if the cell is a variable
-          if (!skip[index])
-          {
-
-			_q[index] = (_Acenter[index] * _direction[index] + 
-            _direction[index - 1] * (skip[index - 1] ? 0.0f : -heatConst) +
-            _direction[index + 1] * (skip[index + 1] ? 0.0f : -heatConst) +
-            _direction[index - _xRes] * (skip[index - _xRes] ? 0.0f : -heatConst) +
-            _direction[index + _xRes] * (skip[index + _xRes] ? 0.0f : -heatConst) +
-            _direction[index - _slabSize] * (skip[index - _slabSize] ? 0.0f : -heatConst) +
-            _direction[index + _slabSize] * (skip[index + _slabSize] ? 0.0f : -heatConst));
-          }
-		  else
-		  {
-          _q[index] = 0.0f;
-		  }
-		  alpha += _direction[index] * _q[index];
-        }
+	// q = Ad
+	// The direction stays zero in skipped cells, so the neighbours
+	// need no test and the inner loop has no branches.
+#if PARALLEL==1
+	#pragma omp parallel for schedule(static)
+#endif
+	for (int z = 1; z < _zRes - 1; z++)
+	{
+		size_t index = (size_t)z * _slabSize + _xRes + 1;
+		float sum = 0.0f;
+
+		for (int y = 1; y < _yRes - 1; y++, index += 2)
+			for (int x = 1; x < _xRes - 1; x++, index++)
+			{
+				float q = _Acenter[index] * _direction[index] - heatConst * (
+				          _direction[index - 1] + _direction[index + 1] +
+				          _direction[index - _xRes] + _direction[index + _xRes] +
+				          _direction[index - _slabSize] + _direction[index + _slabSize]);
+
+				q = skip[index] ? 0.0f : q;
+				_q[index] = q;
+				sum += _direction[index] * q;
+			}
+
+		sliceSum[z] = sum;
+	}
+
+	float alpha = sumSlices(sliceSum, _zRes);
 
     if (fabs(alpha) > 0.0f)
       alpha = deltaNew / alpha;
 	
 	float deltaOld = deltaNew;
-	deltaNew = 0.0f;
 
-	maxR = 0.0f;
+#if PARALLEL==1
+	#pragma omp parallel for schedule(static)
+#endif
+	for (int z = 1; z < _zRes - 1; z++)
+	{
+		size_t index = (size_t)z * _slabSize + _xRes + 1;
+		float sum = 0.0f, max = 0.0f;
+
+		for (int y = 1; y < _yRes - 1; y++, index += 2)
+			for (int x = 1; x < _xRes - 1; x++, index++)
+			{
+				field[index] += alpha * _direction[index];
+
+				_residual[index] -= alpha * _q[index];
+				max = (_residual[index] > max) ? _residual[index] : max;
 
-    index = _slabSize + _xRes + 1;
-    for (z = 1; z < _zRes - 1; z++, index += twoxr)
-      for (y = 1; y < _yRes - 1; y++, index += 2)
-        for (x = 1; x < _xRes - 1; x++, index++)
-		{
-          field[index] += alpha * _direction[index];
+				sum += _residual[index] * _residual[index];
+			}
 
-		  _residual[index] -= alpha * _q[index];
-          maxR = (_residual[index] > maxR) ? _residual[index] : maxR;
+		sliceSum[z] = sum;
+		sliceMax[z] = max;
+	}
 
-		  deltaNew += _residual[index] * _residual[index];
-		}
+	deltaNew = sumSlices(sliceSum, _zRes);
+	maxR = maxSlices(sliceMax, _zRes);
 
     float beta = deltaNew / deltaOld;
 
-    index = _slabSize + _xRes + 1;
-    for (z = 1; z < _zRes - 1; z++, index += twoxr)
-      for (y = 1; y < _yRes - 1; y++, index += 2)
-        for (x = 1; x < _xRes - 1; x++, index++)
-         _direction[index] = _residual[index] + beta * _direction[index];
+#if PARALLEL==1
+	#pragma omp parallel for schedule(static)
+#endif
+	for (int z = 1; z < _zRes - 1; z++)
+	{
+		size_t index = (size_t)z * _slabSize + _xRes + 1;
+
+		for (int y = 1; y < _yRes - 1; y++, index += 2)
+			for (int x = 1; x < _xRes - 1; x++, index++)
+				_direction[index] = _residual[index] + beta * _direction[index];
+	}
 
-	
     i++;
   }
   // cout << i << " iterations converged to " << maxR << endl;
@@ -163,13 +209,14 @@ void FLUID_3D::solveHeat(float* field, float* b, unsigned char* skip)
 	if (_direction) delete[] _direction;
 	if (_q)       delete[] _q;
 	if (_Acenter)  delete[] _Acenter;
+	delete[] sliceSum;
+	delete[] sliceMax;
 }
 
 void FLUID_3D::solvePressurePre(float* field, float* b, unsigned char* skip)
 {
-	int x, y, z;
-	size_t index;
-	float *_q, *_Precond, *_h, *_residual, *_direction;
+	float *_q, *_Precond, *_h, *_residual, *_direction, *_Acenter;
+	float *sliceSum, *sliceMax;
 
 	// i = 0
 	int i = 0;
@@ -179,58 +226,74 @@ void FLUID_3D::solvePressurePre(float* field, float* b, unsigned char* skip)
 	_q            = new float[_totalCells]; // set 0
 	_h			  = new float[_totalCells]; // set 0
 	_Precond	  = new float[_totalCells]; // set 0
+	_Acenter	  = new float[_totalCells]; // set 0
+	sliceSum      = new float[_zRes];
+	sliceMax      = new float[_zRes];
 
 	memset(_residual, 0, sizeof(float)*_xRes*_yRes*_zRes);
 	memset(_q, 0, sizeof(float)*_xRes*_yRes*_zRes);
 	memset(_direction, 0, sizeof(float)*_xRes*_yRes*_zRes);
 	memset(_h, 0, sizeof(float)*_xRes*_yRes*_zRes);
 	memset(_Precond, 0, sizeof(float)*_xRes*_yRes*_zRes);
-
-	float deltaNew = 0.0f;
+	memset(_Acenter, 0, sizeof(float)*_xRes*_yRes*_zRes);
 
 	// r = b - Ax
-	index = _slabSize + _xRes + 1;
-	for (z = 1; z < _zRes - 1; z++, index += 2 * _xRes)
-		for (y = 1; y < _yRes - 1; y++, index += 2)
-		  for (x = 1; x < _xRes - 1; x++, index++)
-		  {
-			// if the cell is a variable
-			float Acenter = 0.0f;
-			if (!skip[index])
-			{
-			  // set the matrix to the Poisson stencil in order
-			  if (!skip[index + 1]) Acenter += 1.0f;
-			  if (!skip[index - 1]) Acenter += 1.0f;
-			  if (!skip[index + _xRes]) Acenter += 1.0f;
-			  if (!skip[index - _xRes]) Acenter += 1.0f;
-			  if (!skip[index + _slabSize]) Acenter += 1.0f;
-			  if (!skip[index - _slabSize]) Acenter += 1.0f;
-
-			  _residual[index] = b[index] - (Acenter * field[index] +  
-			  field[index - 1] * (skip[index - 1] ? 0.0f : -1.0f) +
-			  field[index + 1] * (skip[index + 1] ? 0.0f : -1.0f) +
-			  field[index - _xRes] * (skip[index - _xRes] ? 0.0f : -1.0f)+
-			  field[index + _xRes] * (skip[index + _xRes] ? 0.0f : -1.0f)+
-			  field[index - _slabSize] * (skip[index - _slabSize] ? 0.0f : -1.0f)+
-			  field[index + _slabSize] * (skip[index + _slabSize] ? 0.0f : -1.0f) );
-			}
-			else
+	// The stencil only changes with the obstacles, so it is set up
+	// once here instead of in every iteration.
+#if PARALLEL==1
+	#pragma omp parallel for schedule(static)
+#endif
+	for (int z = 1; z < _zRes - 1; z++)
+	{
+		size_t index = (size_t)z * _slabSize + _xRes + 1;
+		float sum = 0.0f;
+
+		for (int y = 1; y < _yRes - 1; y++, index += 2)
+			for (int x = 1; x < _xRes - 1; x++, index++)
 			{
-			_residual[index] = 0.0f;
+				// if the cell is a variable
+				float Acenter = 0.0f;
+				if (!skip[index])
+				{
+					// set the matrix to the Poisson stencil in order
+					if (!skip[index + 1]) Acenter += 1.0f;
+					if (!skip[index - 1]) Acenter += 1.0f;
+					if (!skip[index + _xRes]) Acenter += 1.0f;
+					if (!skip[index - _xRes]) Acenter += 1.0f;
+					if (!skip[index + _slabSize]) Acenter += 1.0f;
+					if (!skip[index - _slabSize]) Acenter += 1.0f;
+
+					_residual[index] = b[index] - (Acenter * field[index] +  
+					field[index - 1] * (skip[index - 1] ? 0.0f : -1.0f) +
+					field[index + 1] * (skip[index + 1] ? 0.0f : -1.0f) +
+					field[index - _xRes] * (skip[index - _xRes] ? 0.0f : -1.0f)+
+					field[index + _xRes] * (skip[index + _xRes] ? 0.0f : -1.0f)+
+					field[index - _slabSize] * (skip[index - _slabSize] ? 0.0f : -1.0f)+
+					field[index + _slabSize] * (skip[index + _slabSize] ? 0.0f : -1.0f) );
+				}
+				else
+				{
+					_residual[index] = 0.0f;
+				}
+
+				_Acenter[index] = Acenter;
+
+				// P^-1
+				if(Acenter < 1.0f)
+					_Precond[index] = 0.0;
+				else
+					_Precond[index] = 1.0f / Acenter;
+
+				// p = P^-1 * r
+				_direction[index] = _residual[index] * _Precond[index];
+
+				sum += _residual[index] * _direction[index];
 			}
 
-			// P^-1
-			if(Acenter < 1.0f)
-				_Precond[index] = 0.0;
-			else
-				_Precond[index] = 1.0f / Acenter;
-
-			// p = P^-1 * r
-			_direction[index] = _residual[index] * _Precond[index];
-
-			deltaNew += _residual[index] * _direction[index];
-		  }
+		sliceSum[z] = sum;
+	}
 
+	float deltaNew = sumSlices(sliceSum, _zRes);
 
   // While deltaNew > (eps^2) * delta0
   const float eps  = SOLVER_ACCURACY;
@@ -239,81 +302,85 @@ void FLUID_3D::solvePressurePre(float* field, float* b, unsigned char* skip)
   // while (i < _iterations)
   while ((i < _iterations) && (maxR > 0.001f * eps))
   {
+	// q = Ad
+	// P^-1 is zero in skipped cells, so the direction stays zero there
+	// and the neighbours need no test.
+#if PARALLEL==1
+	#pragma omp parallel for schedule(static)
+#endif
+	for (int z = 1; z < _zRes - 1; z++)
+	{
+		size_t index = (size_t)z * _slabSize + _xRes + 1;
+		float sum = 0.0f;
+
+		for (int y = 1; y < _yRes - 1; y++, index += 2)
+			for (int x = 1; x < _xRes - 1; x++, index++)
+			{
+				float q = _Acenter[index] * _direction[index] - (
+				          _direction[index - 1] + _direction[index + 1] +
+				          _direction[index - _xRes] + _direction[index + _xRes] +
+				          _direction[index - _slabSize] + _direction[index + _slabSize]);
+
+				q = skip[index] ? 0.0f : q;
+				_q[index] = q;
+				sum += _direction[index] * q;
+			}
 
-	float alpha = 0.0f;
-
-    index = _slabSize + _xRes + 1;
-    for (z = 1; z < _zRes - 1; z++, index += 2 * _xRes)
-      for (y = 1; y < _yRes - 1; y++, index += 2)
-        for (x = 1; x < _xRes - 1; x++, index++)
-        {
-          // if the cell is a variable
-          float Acenter = 0.0f;
-          if (!skip[index])
-          {
-            // set the matrix to the Poisson stencil in order
-            if (!skip[index + 1]) Acenter += 1.0f;
-            if (!skip[index - 1]) Acenter += 1.0f;
-            if (!skip[index + _xRes]) Acenter += 1.0f;
-            if (!skip[index - _xRes]) Acenter += 1.0f;
-            if (!skip[index + _slabSize]) Acenter += 1.0f;
-            if (!skip[index - _slabSize]) Acenter += 1.0f;
-
-			_q[index] = Acenter * _direction[index] +  
-            _direction[index - 1] * (skip[index - 1] ? 0.0f : -1.0f) +
-            _direction[index + 1] * (skip[index + 1] ? 0.0f : -1.0f) +
-            _direction[index - _xRes] * (skip[index - _xRes] ? 0.0f : -1.0f) +
-            _direction[index + _xRes] * (skip[index + _xRes] ? 0.0f : -1.0f)+
-            _direction[index - _slabSize] * (skip[index - _slabSize] ? 0.0f : -1.0f) +
-            _direction[index + _slabSize] * (skip[index + _slabSize] ? 0.0f : -1.0f);
-          }
-		  else
-		  {
-          _q[index] = 0.0f;
-		  }
-
-		  alpha += _direction[index] * _q[index];
-        }
+		sliceSum[z] = sum;
+	}
 
+	float alpha = sumSlices(sliceSum, _zRes);
 
     if (fabs(alpha) > 0.0f)
       alpha = deltaNew / alpha;
 
 	float deltaOld = deltaNew;
-	deltaNew = 0.0f;
-
-	maxR = 0.0;
-
-	float tmp;
 
     // x = x + alpha * d
-    index = _slabSize + _xRes + 1;
-    for (z = 1; z < _zRes - 1; z++, index += 2 * _xRes)
-      for (y = 1; y < _yRes - 1; y++, index += 2)
-        for (x = 1; x < _xRes - 1; x++, index++)
-		{
-          field[index] += alpha * _direction[index];
+#if PARALLEL==1
+	#pragma omp parallel for schedule(static)
+#endif
+	for (int z = 1; z < _zRes - 1; z++)
+	{
+		size_t index = (size_t)z * _slabSize + _xRes + 1;
+		float sum = 0.0f, max = 0.0f;
+
+		for (int y = 1; y < _yRes - 1; y++, index += 2)
+			for (int x = 1; x < _xRes - 1; x++, index++)
+			{
+				field[index] += alpha * _direction[index];
 
-		  _residual[index] -= alpha * _q[index];
+				_residual[index] -= alpha * _q[index];
 
-		  _h[index] = _Precond[index] * _residual[index];
+				_h[index] = _Precond[index] * _residual[index];
 
-		  tmp = _residual[index] * _h[index];
-		  deltaNew += tmp;
-		  maxR = (tmp > maxR) ? tmp : maxR;
+				float tmp = _residual[index] * _h[index];
+				sum += tmp;
+				max = (tmp > max) ? tmp : max;
+			}
 
-		}
+		sliceSum[z] = sum;
+		sliceMax[z] = max;
+	}
 
+	deltaNew = sumSlices(sliceSum, _zRes);
+	maxR = maxSlices(sliceMax, _zRes);
 
     // beta = deltaNew / deltaOld
     float beta = deltaNew / deltaOld;
 
     // d = h + beta * d
-    index = _slabSize + _xRes + 1;
-    for (z = 1; z < _zRes - 1; z++, index += 2 * _xRes)
-      for (y = 1; y < _yRes - 1; y++, index += 2)
-        for (x = 1; x < _xRes - 1; x++, index++)
-          _direction[index] = _h[index] + beta * _direction[index];
+#if PARALLEL==1
+	#pragma omp parallel for schedule(static)
+#endif
+	for (int z = 1; z < _zRes - 1; z++)
+	{
+		size_t index = (size_t)z * _slabSize + _xRes + 1;
+
+		for (int y = 1; y < _yRes - 1; y++, index += 2)
+			for (int x = 1; x < _xRes - 1; x++, index++)
+				_direction[index] = _h[index] + beta * _direction[index];
+	}
 
     // i = i + 1
     i++;
@@ -325,4 +392,7 @@ void FLUID_3D::solvePressurePre(float* field, float* b, unsigned char* skip)
 	if (_residual) delete[] _residual;
 	if (_direction) delete[] _direction;
 	if (_q)       delete[] _q;
+	if (_Acenter)  delete[] _Acenter;
+	delete[] sliceSum;
+	delete[] sliceMax;
 }
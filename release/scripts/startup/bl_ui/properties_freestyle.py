@@ -134,6 +134,7 @@ class RENDERLAYER_PT_freestyle(RenderLayerFreestyleButtonsPanel, Panel):
         col = split.column()
         col.prop(freestyle, "crease_angle")
         col.prop(freestyle, "use_culling")
+        col.prop(freestyle, "use_view_map_cache")
         col.prop(freestyle, "use_advanced_options")
 
         col = split.column()
@@ -94,6 +94,7 @@ struct ChannelDriver *fcurve_copy_driver(struct ChannelDriver *driver);
 void driver_free_variable(struct ChannelDriver *driver, struct DriverVar *dvar);
 void driver_change_variable_type(struct DriverVar *dvar, int type);
 struct DriverVar *driver_add_new_variable(struct ChannelDriver *driver);
+void driver_invalidate_expression(struct ChannelDriver *driver, bool expr_changed, bool varname_changed);
 
 float driver_get_variable_value(struct ChannelDriver *driver, struct DriverVar *dvar);
 
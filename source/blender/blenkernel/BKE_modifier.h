@@ -43,6 +43,7 @@ struct LinkNode;
 struct bArmature;
 struct ModifierData;
 struct BMEditMesh;
+struct Mesh;
 
 typedef enum {
 	/* Should not be used, only for None modifier type */
@@ -424,5 +425,14 @@ void modwrap_deformVertsEM(
         struct BMEditMesh *em, struct DerivedMesh *dm,
         float (*vertexCos)[3], int numVerts);
 
+/* modifier_cache.c */
+bool     BKE_modifier_cache_supported(struct Object *ob, struct ModifierData *md);
+uint64_t BKE_modifier_cache_key_mesh(struct Scene *scene, struct Object *ob, struct Mesh *me, float (*vertexCos)[3],
+                                     int useRenderParams, int needMapping, CustomDataMask dataMask);
+uint64_t BKE_modifier_cache_key_modifier(uint64_t key, struct ModifierData *md, CustomDataMask mask);
+struct DerivedMesh *BKE_modifier_cache_get(uint64_t key);
+void     BKE_modifier_cache_put(uint64_t key, struct DerivedMesh *dm);
+void     BKE_modifier_cache_free(void);
+
 #endif
 
@@ -34,6 +34,7 @@ struct bContext;
 struct EvaluationContext;
 struct StripColorBalance;
 struct Editing;
+struct GSet;
 struct ImBuf;
 struct Main;
 struct Mask;
@@ -230,8 +231,10 @@ struct StripElem *BKE_sequencer_give_stripelem(struct Sequence *seq, int cfra);
 void BKE_sequencer_update_changed_seq_and_deps(struct Scene *scene, struct Sequence *changed_seq, int len_change, int ibuf_change);
 int BKE_sequencer_input_have_to_preprocess(const SeqRenderData *context, struct Sequence *seq, float cfra);
 
-struct SeqIndexBuildContext *BKE_sequencer_proxy_rebuild_context(struct Main *bmain, struct Scene *scene, struct Sequence *seq);
+struct SeqIndexBuildContext *BKE_sequencer_proxy_rebuild_context(struct Main *bmain, struct Scene *scene, struct Sequence *seq,
+                                                                 struct GSet *file_list);
 void BKE_sequencer_proxy_rebuild(struct SeqIndexBuildContext *context, short *stop, short *do_update, float *progress);
+bool BKE_sequencer_proxy_rebuild_is_threadsafe(struct SeqIndexBuildContext *context);
 void BKE_sequencer_proxy_rebuild_finish(struct SeqIndexBuildContext *context, short stop);
 
 /* **********************************************************************
@@ -65,6 +65,8 @@ typedef enum {
 /***/
 
 #define CCG_OMP_LIMIT	1000000
+/* minimum amount of work for a pass to run in tasks */
+#define CCG_TASK_LIMIT	16384
 
 /***/
 
@@ -1408,6 +1408,112 @@ static void dm_ensure_display_normals(DerivedMesh *dm)
 		CDDM_calc_normals_mapping_ex(dm, (dm->dirty & DM_DIRTY_NORMALS) ? false : true);
 	}
 }
+/**
+ * Apply deformed coordinates to \a dm which is not used afterwards, returning a CDDM.
+ *
+ * A CDDM owned by the modifier stack is taken over instead of being copied,
+ * only its vertex layer is written (and duplicated first if it references the mesh),
+ * all other layers are kept as-is instead of duplicating every one of them.
+ */
+static DerivedMesh *dm_apply_vert_coords_release(DerivedMesh *dm, float (*deformedVerts)[3])
+{
+	if (dm->type == DM_TYPE_CDDM && dm->needsFree) {
+		/* cached data depends on the coordinates */
+		bvhcache_free(&dm->bvhCache);
+		GPU_drawobject_free(dm);
+	}
+	else {
+		DerivedMesh *tdm = CDDM_copy(dm);
+		dm->release(dm);
+		dm = tdm;
+	}
+
+	CDDM_apply_vert_coords(dm, deformedVerts);
+
+	return dm;
+}
+
+/**
+ * Cache keys of the results of the modifiers from \a md on, 0 for the results which are not cached:
+ * deform modifiers (their result is only coordinates) and all modifiers from the first one which
+ * doesn't support caching on.
+ *
+ * Returns a copy of the cached result of the last modifier found in the cache, with its position
+ * in \a r_cached_index, or NULL.
+ *
+ * \a r_keys is NULL when the input of the stack changed since the last evaluation of \a ob:
+ * the mesh is likely animated and its results wouldn't be found again, so they aren't stored.
+ */
+static DerivedMesh *mesh_modifier_cache_lookup(Scene *scene, Object *ob, ModifierData *md, CDMaskLink *curr,
+                                               float (*deformedVerts)[3], int required_mode,
+                                               int useRenderParams, int needMapping, CustomDataMask dataMask,
+                                               uint64_t **r_keys, int *r_cached_index)
+{
+	const CustomDataMask orco_mask = CD_MASK_ORCO | CD_MASK_CLOTH_ORCO;
+	DerivedMesh *dm = NULL;
+	ModifierData *md_iter;
+	CDMaskLink *curr_iter;
+	uint64_t *keys, key;
+	int tot = 0, i;
+	bool has_dm = false, use_store;
+
+	*r_keys = NULL;
+	*r_cached_index = -1;
+
+	/* orco derived meshes are evaluated along with the stack, they are not cached */
+	if (dataMask & orco_mask)
+		return NULL;
+
+	for (md_iter = md, curr_iter = curr; md_iter; md_iter = md_iter->next, curr_iter = curr_iter->next) {
+		if (curr_iter->mask & orco_mask)
+			return NULL;
+		tot++;
+	}
+
+	if (tot == 0)
+		return NULL;
+
+	keys = MEM_callocN(sizeof(*keys) * (size_t)tot, __func__);
+	key = BKE_modifier_cache_key_mesh(scene, ob, ob->data, deformedVerts, useRenderParams, needMapping, dataMask);
+
+	use_store = (key == ob->modifier_cache_key);
+	ob->modifier_cache_key = key;
+
+	/* same checks as mesh_calc_modifiers */
+	for (i = 0; md; md = md->next, curr = curr->next, i++) {
+		ModifierTypeInfo *mti = modifierType_getInfo(md->type);
+		CustomDataMask nextmask = curr->next ? curr->next->mask : dataMask;
+
+		if (!modifier_isEnabled(scene, md, required_mode)) continue;
+		if (needMapping && !modifier_supportsMapping(md)) continue;
+		if ((mti->flags & eModifierTypeFlag_RequiresOriginalData) && has_dm) break;
+		if (!BKE_modifier_cache_supported(ob, md)) break;
+
+		key = BKE_modifier_cache_key_modifier(key, md, curr->mask | nextmask);
+
+		if (mti->type != eModifierTypeType_OnlyDeform) {
+			keys[i] = key;
+			has_dm = true;
+		}
+	}
+
+	for (i = tot - 1; i >= 0; i--) {
+		if (keys[i] && (dm = BKE_modifier_cache_get(keys[i]))) {
+			*r_cached_index = i;
+			break;
+		}
+	}
+
+	if (use_store) {
+		*r_keys = keys;
+	}
+	else {
+		MEM_freeN(keys);
+	}
+
+	return dm;
+}
+
 /* new value for useDeform -1  (hack for the gameengine):
  * - apply only the modifier stack of the object, skipping the virtual modifiers,
  * - don't apply the key
@@ -1447,6 +1553,12 @@ static void mesh_calc_modifiers(Scene *scene, Object *ob, float (*inputVertexCos
 	/* XXX Same as above... For now, only weights preview in WPaint mode. */
 	const bool do_mod_wmcol = do_init_wmcol;
 
+	/* intermediate results are only cached for the viewport object evaluation */
+	const bool use_modifier_cache = ((U.flag & USER_MODIFIER_CACHE) && useCache && useDeform > 0 && index < 0 &&
+	                                 !sculpt_mode && !do_init_wmcol && !build_shapekey_layers);
+	uint64_t *cache_keys = NULL;
+	int modifier_index = 0;
+
 	VirtualModifierData virtualModifierData;
 
 	ModifierApplyFlag app_flags = useRenderParams ? MOD_APPLY_RENDER : 0;
@@ -1553,7 +1665,27 @@ static void mesh_calc_modifiers(Scene *scene, Object *ob, float (*inputVertexCos
 	orcodm = NULL;
 	clothorcodm = NULL;
 
-	for (; md; md = md->next, curr = curr->next) {
+	if (use_modifier_cache) {
+		int cached_index;
+
+		dm = mesh_modifier_cache_lookup(scene, ob, md, curr, deformedVerts, required_mode,
+		                                useRenderParams, needMapping, dataMask, &cache_keys, &cached_index);
+
+		/* continue after the cached result */
+		if (dm) {
+			for (; modifier_index <= cached_index; modifier_index++) {
+				md->scene = scene;
+				md = md->next;
+				curr = curr->next;
+			}
+
+			if (deformedVerts && deformedVerts != inputVertexCos)
+				MEM_freeN(deformedVerts);
+			deformedVerts = NULL;
+		}
+	}
+
+	for (; md; md = md->next, curr = curr->next, modifier_index++) {
 		ModifierTypeInfo *mti = modifierType_getInfo(md->type);
 
 		md->scene = scene;
@@ -1645,11 +1777,7 @@ static void mesh_calc_modifiers(Scene *scene, Object *ob, float (*inputVertexCos
 			/* apply vertex coordinates or build a DerivedMesh as necessary */
 			if (dm) {
 				if (deformedVerts) {
-					DerivedMesh *tdm = CDDM_copy(dm);
-					dm->release(dm);
-					dm = tdm;
-
-					CDDM_apply_vert_coords(dm, deformedVerts);
+					dm = dm_apply_vert_coords_release(dm, deformedVerts);
 				}
 			}
 			else {
@@ -1726,6 +1854,9 @@ static void mesh_calc_modifiers(Scene *scene, Object *ob, float (*inputVertexCos
 
 					deformedVerts = NULL;
 				}
+
+				if (cache_keys && cache_keys[modifier_index])
+					BKE_modifier_cache_put(cache_keys[modifier_index], dm);
 			}
 
 			/* create an orco derivedmesh in parallel */
@@ -1791,16 +1922,15 @@ static void mesh_calc_modifiers(Scene *scene, Object *ob, float (*inputVertexCos
 	for (md = firstmd; md; md = md->next)
 		modifier_freeTemporaryData(md);
 
+	if (cache_keys)
+		MEM_freeN(cache_keys);
+
 	/* Yay, we are done. If we have a DerivedMesh and deformed vertices
 	 * need to apply these back onto the DerivedMesh. If we have no
 	 * DerivedMesh then we need to build one.
 	 */
 	if (dm && deformedVerts) {
-		finaldm = CDDM_copy(dm);
-
-		dm->release(dm);
-
-		CDDM_apply_vert_coords(finaldm, deformedVerts);
+		finaldm = dm_apply_vert_coords_release(dm, deformedVerts);
 
 #if 0 /* For later nice mod preview! */
 		/* In case we need modified weights in CD_PREVIEW_MCOL, we have to re-compute it. */
@@ -2046,11 +2176,13 @@ static void editbmesh_calc_modifiers(Scene *scene, Object *ob, BMEditMesh *em, D
 			/* apply vertex coordinates or build a DerivedMesh as necessary */
 			if (dm) {
 				if (deformedVerts) {
-					DerivedMesh *tdm = CDDM_copy(dm);
-					if (!(cage_r && dm == *cage_r)) dm->release(dm);
-					dm = tdm;
-
-					CDDM_apply_vert_coords(dm, deformedVerts);
+					if (cage_r && dm == *cage_r) {
+						dm = CDDM_copy(dm);
+						CDDM_apply_vert_coords(dm, deformedVerts);
+					}
+					else {
+						dm = dm_apply_vert_coords_release(dm, deformedVerts);
+					}
 				}
 				else if (cage_r && dm == *cage_r) {
 					/* dm may be changed by this modifier, so we need to copy it
@@ -2157,11 +2289,13 @@ static void editbmesh_calc_modifiers(Scene *scene, Object *ob, BMEditMesh *em, D
 	 * then we need to build one.
 	 */
 	if (dm && deformedVerts) {
-		*final_r = CDDM_copy(dm);
-
-		if (!(cage_r && dm == *cage_r)) dm->release(dm);
-
-		CDDM_apply_vert_coords(*final_r, deformedVerts);
+		if (cage_r && dm == *cage_r) {
+			*final_r = CDDM_copy(dm);
+			CDDM_apply_vert_coords(*final_r, deformedVerts);
+		}
+		else {
+			*final_r = dm_apply_vert_coords_release(dm, deformedVerts);
+		}
 	}
 	else if (dm) {
 		*final_r = dm;
@@ -76,6 +76,7 @@
 #include "BKE_ipo.h"
 #include "BKE_library.h"
 #include "BKE_main.h"
+#include "BKE_modifier.h"
 #include "BKE_node.h"
 #include "BKE_report.h"
 #include "BKE_scene.h"
@@ -128,6 +129,7 @@ void free_blender(void)
 
 	BKE_sequencer_cache_destruct();
 	IMB_moviecache_destruct();
+	BKE_modifier_cache_free();
 	
 	free_nodesystem();
 }
@@ -2388,8 +2388,8 @@ void CDDM_calc_normals_tessface(DerivedMesh *dm)
  *
  * note, CDDM_recalc_tessellation has to run on the returned DM if you want to access tessfaces.
  *
- * Note: This function is currently only used by the Mirror modifier, so it
- *       skips any faces that have all vertices merged (to avoid creating pairs
+ * Note: This function is currently only used by the Mirror and Array modifiers,
+ *       so it skips any faces that have all vertices merged (to avoid creating pairs
  *       of faces sharing the same set of vertices). If used elsewhere, it may
  *       be necessary to make this functionality optional.
  */
@@ -44,6 +44,8 @@
 #include "DNA_object_types.h"
 
 #include "BLI_blenlib.h"
+#include "BLI_alloca.h"
+#include "BLI_expr_pylike_eval.h"
 #include "BLI_math.h"
 #include "BLI_utildefines.h"
 
@@ -1477,11 +1479,8 @@ void driver_free_variable(ChannelDriver *driver, DriverVar *dvar)
 	/* remove the variable from the driver */
 	BLI_freelinkN(&driver->variables, dvar);
 
-#ifdef WITH_PYTHON
 	/* since driver variables are cached, the expression needs re-compiling too */
-	if (driver->type == DRIVER_TYPE_PYTHON)
-		driver->flag |= DRIVER_FLAG_RENAMEVAR;
-#endif
+	driver_invalidate_expression(driver, false, true);
 }
 
 /* Change the type of driver variable */
@@ -1535,16 +1534,29 @@ DriverVar *driver_add_new_variable(ChannelDriver *driver)
 	/* set the default type to 'single prop' */
 	driver_change_variable_type(dvar, DVAR_TYPE_SINGLE_PROP);
 	
-#ifdef WITH_PYTHON
 	/* since driver variables are cached, the expression needs re-compiling too */
-	if (driver->type == DRIVER_TYPE_PYTHON)
-		driver->flag |= DRIVER_FLAG_RENAMEVAR;
-#endif
+	driver_invalidate_expression(driver, false, true);
 
 	/* return the target */
 	return dvar;
 }
 
+/* Tag the cached compiled forms of the driver expression for rebuilding,
+ * after the expression text or the names of the variables changed */
+void driver_invalidate_expression(ChannelDriver *driver, bool expr_changed, bool varname_changed)
+{
+	if (expr_changed || varname_changed) {
+		/* variables are bound by index when parsing, so reparse in both cases */
+		BLI_expr_pylike_free(driver->expr_simple);
+		driver->expr_simple = NULL;
+	}
+
+	if (expr_changed)
+		driver->flag |= DRIVER_FLAG_RECOMPILE;
+	if (varname_changed)
+		driver->flag |= DRIVER_FLAG_RENAMEVAR;
+}
+
 /* This frees the driver itself */
 void fcurve_free_driver(FCurve *fcu)
 {
@@ -1568,6 +1580,8 @@ void fcurve_free_driver(FCurve *fcu)
 		BPY_DECREF(driver->expr_comp);
 #endif
 
+	BLI_expr_pylike_free(driver->expr_simple);
+
 	/* free driver itself, then set F-Curve's point to this to NULL (as the curve may still be used) */
 	MEM_freeN(driver);
 	fcu->driver = NULL;
@@ -1586,6 +1600,7 @@ ChannelDriver *fcurve_copy_driver(ChannelDriver *driver)
 	/* copy all data */
 	ndriver = MEM_dupallocN(driver);
 	ndriver->expr_comp = NULL;
+	ndriver->expr_simple = NULL;
 	
 	/* copy variables */
 	BLI_listbase_clear(&ndriver->variables);
@@ -1631,6 +1646,43 @@ float driver_get_variable_value(ChannelDriver *driver, DriverVar *dvar)
 	return dvar->curval;
 }
 
+/* Evaluate the driver expression natively, without Python (and the GIL) when it's simple enough.
+ * Returns false when Python has to evaluate it, either because it uses unsupported
+ * syntax or because of math errors that need to be reported the Python way.
+ */
+static bool driver_evaluate_simple_expr(ChannelDriver *driver, const float evaltime, float *r_value)
+{
+	DriverVar *dvar;
+	double *vars, result;
+	int vars_len = BLI_countlist(&driver->variables);
+	int i;
+
+	/* parse once, variables are bound by index and the current frame is passed last */
+	if (driver->expr_simple == NULL) {
+		const char **names = BLI_array_alloca(names, vars_len + 1);
+
+		for (dvar = driver->variables.first, i = 0; dvar; dvar = dvar->next)
+			names[i++] = dvar->name;
+		names[i] = "frame";
+
+		driver->expr_simple = BLI_expr_pylike_parse(driver->expression, names, vars_len + 1);
+	}
+
+	if (!BLI_expr_pylike_is_valid(driver->expr_simple))
+		return false;
+
+	vars = BLI_array_alloca(vars, vars_len + 1);
+	for (dvar = driver->variables.first, i = 0; dvar; dvar = dvar->next)
+		vars[i++] = (double)driver_get_variable_value(driver, dvar);
+	vars[i] = (double)evaltime;
+
+	if (!BLI_expr_pylike_eval(driver->expr_simple, vars, vars_len + 1, &result))
+		return false;
+
+	*r_value = (float)result;
+	return true;
+}
+
 /* Evaluate an Channel-Driver to get a 'time' value to use instead of "evaltime"
  *	- "evaltime" is the frame at which F-Curve is being evaluated
  *  - has to return a float value
@@ -1708,22 +1760,23 @@ static float evaluate_driver(ChannelDriver *driver, const float evaltime)
 		}
 		case DRIVER_TYPE_PYTHON: /* expression */
 		{
-#ifdef WITH_PYTHON
 			/* check for empty or invalid expression */
 			if ( (driver->expression[0] == '\0') ||
 			     (driver->flag & DRIVER_FLAG_INVALID) )
 			{
 				driver->curval = 0.0f;
 			}
+			else if (driver_evaluate_simple_expr(driver, evaltime, &driver->curval)) {
+				/* simple arithmetic expressions don't need Python */
+			}
 			else {
+#ifdef WITH_PYTHON
 				/* this evaluates the expression using Python, and returns its result:
 				 *  - on errors it reports, then returns 0.0f
 				 */
 				driver->curval = BPY_driver_exec(driver, evaltime);
-			}
-#else /* WITH_PYTHON*/
-			(void)evaltime;
 #endif /* WITH_PYTHON*/
+			}
 			break;
 		}
 		default:
@@ -82,6 +82,7 @@
 #include "BLI_rect.h"
 #include "BLI_listbase.h"
 #include "BLI_linklist.h"
+#include "BLI_task.h"
 #include "BLI_strict_flags.h"
 
 #include "BKE_mask.h"
@@ -1326,6 +1327,84 @@ static float layer_bucket_depth_from_xy(MaskRasterLayer *layer, const float xy[2
 	}
 }
 
+/* apply the layer falloff and alpha to the layer value (1.0 - depth) */
+BLI_INLINE float maskrasterize_layer_value(const MaskRasterLayer *layer, float value_layer)
+{
+	switch (layer->falloff) {
+		case PROP_SMOOTH:
+			/* ease - gives less hard lines for dilate/erode feather */
+			value_layer = (3.0f * value_layer * value_layer - 2.0f * value_layer * value_layer * value_layer);
+			break;
+		case PROP_SPHERE:
+			value_layer = sqrtf(2.0f * value_layer - value_layer * value_layer);
+			break;
+		case PROP_ROOT:
+			value_layer = sqrtf(value_layer);
+			break;
+		case PROP_SHARP:
+			value_layer = value_layer * value_layer;
+			break;
+		case PROP_LIN:
+		default:
+			/* nothing */
+			break;
+	}
+
+	if (layer->blend != MASK_BLEND_REPLACE) {
+		value_layer *= layer->alpha;
+	}
+
+	return value_layer;
+}
+
+/* blend the layer value over the value of the layers below it */
+BLI_INLINE float maskrasterize_layer_blend(const MaskRasterLayer *layer, float value, float value_layer)
+{
+	if (layer->blend_flag & MASK_BLENDFLAG_INVERT) {
+		value_layer = 1.0f - value_layer;
+	}
+
+	switch (layer->blend) {
+		case MASK_BLEND_MERGE_ADD:
+			value += value_layer * (1.0f - value);
+			break;
+		case MASK_BLEND_MERGE_SUBTRACT:
+			value -= value_layer * value;
+			break;
+		case MASK_BLEND_ADD:
+			value += value_layer;
+			break;
+		case MASK_BLEND_SUBTRACT:
+			value -= value_layer;
+			break;
+		case MASK_BLEND_LIGHTEN:
+			value = max_ff(value, value_layer);
+			break;
+		case MASK_BLEND_DARKEN:
+			value = min_ff(value, value_layer);
+			break;
+		case MASK_BLEND_MUL:
+			value *= value_layer;
+			break;
+		case MASK_BLEND_REPLACE:
+			value = (value * (1.0f - layer->alpha)) + (value_layer * layer->alpha);
+			break;
+		case MASK_BLEND_DIFFERENCE:
+			value = fabsf(value - value_layer);
+			break;
+		default: /* same as add */
+			BLI_assert(0);
+			value += value_layer;
+			break;
+	}
+
+	/* clamp after applying each layer so we don't get
+	 * issues subtracting after accumulating over 1.0f */
+	CLAMP(value, 0.0f, 1.0f);
+
+	return value;
+}
+
 float BKE_maskrasterize_handle_sample(MaskRasterHandle *mr_handle, const float xy[2])
 {
 	/* can't do this because some layers may invert */
@@ -1343,121 +1422,267 @@ float BKE_maskrasterize_handle_sample(MaskRasterHandle *mr_handle, const float x
 
 		/* also used as signal for unused layer (when render is disabled) */
 		if (layer->alpha != 0.0f && BLI_rctf_isect_pt_v(&layer->bounds, xy)) {
-			value_layer = 1.0f - layer_bucket_depth_from_xy(layer, xy);
-
-			switch (layer->falloff) {
-				case PROP_SMOOTH:
-					/* ease - gives less hard lines for dilate/erode feather */
-					value_layer = (3.0f * value_layer * value_layer - 2.0f * value_layer * value_layer * value_layer);
-					break;
-				case PROP_SPHERE:
-					value_layer = sqrtf(2.0f * value_layer - value_layer * value_layer);
-					break;
-				case PROP_ROOT:
-					value_layer = sqrtf(value_layer);
-					break;
-				case PROP_SHARP:
-					value_layer = value_layer * value_layer;
-					break;
-				case PROP_LIN:
-				default:
-					/* nothing */
-					break;
-			}
-
-			if (layer->blend != MASK_BLEND_REPLACE) {
-				value_layer *= layer->alpha;
-			}
+			value_layer = maskrasterize_layer_value(layer, 1.0f - layer_bucket_depth_from_xy(layer, xy));
 		}
 		else {
 			value_layer = 0.0f;
 		}
 
-		if (layer->blend_flag & MASK_BLENDFLAG_INVERT) {
-			value_layer = 1.0f - value_layer;
+		value = maskrasterize_layer_blend(layer, value, value_layer);
+	}
+
+	return value;
+}
+
+
+/* --------------------------------------------------------------------- */
+/* tiled buffer rasterization                                            */
+/* --------------------------------------------------------------------- */
+
+/* Instead of sampling each pixel, walking all layers and looking up the bucket every time,
+ * a buffer is rasterized in tiles: for every layer the faces of each bucket the tile overlaps
+ * are tested once against the pixels of the tile inside their bounds, keeping the closest depth
+ * per pixel, then the layer is blended over the tile.
+ *
+ * Pixels only ever test the faces of their own bucket, the same as #BKE_maskrasterize_handle_sample,
+ * so the result is identical. */
+
+#define TILE_SIZE 64u
+
+typedef struct MaskRasterizeBufferData {
+	MaskRasterHandle *mr_handle;
+	unsigned int width, height;
+	unsigned int tiles_x;
+	float *buffer;
+} MaskRasterizeBufferData;
+
+/* range of pixels [r_min, r_max) of the tile within the layer bounds (on one axis),
+ * coordinates increase with the pixel index so this is always contiguous */
+static void maskrasterize_tile_layer_range(const float *co, const unsigned int size,
+                                           const float bounds_min, const float bounds_max,
+                                           unsigned int *r_min, unsigned int *r_max)
+{
+	unsigned int min = 0, max = size;
+
+	while (min < size && co[min] < bounds_min) {
+		min++;
+	}
+	while (max > min && co[max - 1] > bounds_max) {
+		max--;
+	}
+
+	*r_min = min;
+	*r_max = max;
+}
+
+/* range of pixels of the tile inside [co_min, co_max] on one axis, clipped to [clip_min, clip_max),
+ * the range is made a pixel wider on both sides, the face tests are exact */
+BLI_INLINE void maskrasterize_tile_face_range(const float co_min, const float co_max, const float scale,
+                                              const unsigned int offset,
+                                              const unsigned int clip_min, const unsigned int clip_max,
+                                              unsigned int *r_min, unsigned int *r_max)
+{
+	float min = floorf(co_min * scale) - (float)offset - 1.0f;
+	float max = ceilf(co_max * scale) - (float)offset + 2.0f;
+
+	CLAMP(min, (float)clip_min, (float)clip_max);
+	CLAMP(max, (float)clip_min, (float)clip_max);
+
+	*r_min = (unsigned int)min;
+	*r_max = (unsigned int)max;
+}
+
+static void maskrasterize_tile_layer_depth(MaskRasterLayer *layer, float *depth,
+                                           const unsigned int x_ofs, const unsigned int y_ofs,
+                                           const float fwidth, const float fheight,
+                                           const float *co_x, const float *co_y,
+                                           const unsigned int x_min, const unsigned int x_max,
+                                           const unsigned int y_min, const unsigned int y_max)
+{
+	unsigned int (*face_array)[4] = layer->face_array;
+	float        (*cos)[3]        = layer->face_coords;
+	unsigned int bucket_x[TILE_SIZE], bucket_y[TILE_SIZE];
+	unsigned int x, y;
+	unsigned int by_min, by_max;
+
+	/* same as layer_bucket_index_from_xy, split by axis */
+	for (x = x_min; x < x_max; x++) {
+		bucket_x[x] = (unsigned int)((co_x[x] - layer->bounds.xmin) * layer->buckets_xy_scalar[0]);
+	}
+	for (y = y_min; y < y_max; y++) {
+		bucket_y[y] = (unsigned int)((co_y[y] - layer->bounds.ymin) * layer->buckets_xy_scalar[1]);
+	}
+
+	/* rows of pixels sharing the same row of buckets */
+	for (by_min = y_min; by_min < y_max; by_min = by_max) {
+		unsigned int bx_min, bx_max;
+
+		by_max = by_min + 1;
+		while (by_max < y_max && bucket_y[by_max] == bucket_y[by_min]) {
+			by_max++;
 		}
 
-		switch (layer->blend) {
-			case MASK_BLEND_MERGE_ADD:
-				value += value_layer * (1.0f - value);
-				break;
-			case MASK_BLEND_MERGE_SUBTRACT:
-				value -= value_layer * value;
-				break;
-			case MASK_BLEND_ADD:
-				value += value_layer;
-				break;
-			case MASK_BLEND_SUBTRACT:
-				value -= value_layer;
-				break;
-			case MASK_BLEND_LIGHTEN:
-				value = max_ff(value, value_layer);
-				break;
-			case MASK_BLEND_DARKEN:
-				value = min_ff(value, value_layer);
-				break;
-			case MASK_BLEND_MUL:
-				value *= value_layer;
-				break;
-			case MASK_BLEND_REPLACE:
-				value = (value * (1.0f - layer->alpha)) + (value_layer * layer->alpha);
-				break;
-			case MASK_BLEND_DIFFERENCE:
-				value = fabsf(value - value_layer);
-				break;
-			default: /* same as add */
-				BLI_assert(0);
-				value += value_layer;
-				break;
+		/* columns of pixels sharing the same bucket */
+		for (bx_min = x_min; bx_min < x_max; bx_min = bx_max) {
+			unsigned int *face_index;
+
+			bx_max = bx_min + 1;
+			while (bx_max < x_max && bucket_x[bx_max] == bucket_x[bx_min]) {
+				bx_max++;
+			}
+
+			face_index = layer->buckets_face[bucket_x[bx_min] + (bucket_y[by_min] * layer->buckets_x)];
+			if (face_index == NULL) {
+				continue;
+			}
+
+			for (; *face_index != TRI_TERMINATOR_ID; face_index++) {
+				unsigned int *face = face_array[*face_index];
+				float face_min[2], face_max[2];
+				unsigned int fx_min, fx_max, fy_min, fy_max;
+
+				INIT_MINMAX2(face_min, face_max);
+				minmax_v2v2_v2(face_min, face_max, cos[face[0]]);
+				minmax_v2v2_v2(face_min, face_max, cos[face[1]]);
+				minmax_v2v2_v2(face_min, face_max, cos[face[2]]);
+				if (face[3] != TRI_VERT) {
+					minmax_v2v2_v2(face_min, face_max, cos[face[3]]);
+				}
+
+				maskrasterize_tile_face_range(face_min[0], face_max[0], fwidth, x_ofs, bx_min, bx_max,
+				                              &fx_min, &fx_max);
+				maskrasterize_tile_face_range(face_min[1], face_max[1], fheight, y_ofs, by_min, by_max,
+				                              &fy_min, &fy_max);
+
+				for (y = fy_min; y < fy_max; y++) {
+					float *depth_row = &depth[y * TILE_SIZE];
+					float xy[2];
+
+					xy[1] = co_y[y];
+
+					for (x = fx_min; x < fx_max; x++) {
+						/* comparing with 0.0f is OK here because triangles are always zero depth */
+						if (depth_row[x] != 0.0f) {
+							float test_dist;
+
+							xy[0] = co_x[x];
+							test_dist = maskrasterize_layer_isect(face, cos, depth_row[x], xy);
+							if (test_dist < depth_row[x]) {
+								depth_row[x] = test_dist;
+							}
+						}
+					}
+				}
+			}
 		}
+	}
+}
+
+static void maskrasterize_buffer_tile(TaskPool *pool, void *taskdata, int UNUSED(threadid))
+{
+	MaskRasterizeBufferData *data = BLI_task_pool_userdata(pool);
+	MaskRasterHandle *mr_handle = data->mr_handle;
+	const unsigned int tile_index = GET_UINT_FROM_POINTER(taskdata);
+	const unsigned int x_ofs = (tile_index % data->tiles_x) * TILE_SIZE;
+	const unsigned int y_ofs = (tile_index / data->tiles_x) * TILE_SIZE;
+	const unsigned int size_x = MIN2(TILE_SIZE, data->width - x_ofs);
+	const unsigned int size_y = MIN2(TILE_SIZE, data->height - y_ofs);
+	const float fwidth = (float)data->width;
+	const float fheight = (float)data->height;
+
+	float co_x[TILE_SIZE], co_y[TILE_SIZE];
+	float depth[TILE_SIZE * TILE_SIZE];
+	unsigned int x, y, i;
+	MaskRasterLayer *layer;
+
+	for (x = 0; x < size_x; x++) {
+		co_x[x] = (float)(x_ofs + x) / fwidth;
+	}
+	for (y = 0; y < size_y; y++) {
+		co_y[y] = (float)(y_ofs + y) / fheight;
+	}
 
-		/* clamp after applying each layer so we don't get
-		 * issues subtracting after accumulating over 1.0f */
-		CLAMP(value, 0.0f, 1.0f);
+	for (y = 0; y < size_y; y++) {
+		float *value = &data->buffer[(y_ofs + y) * data->width + x_ofs];
+		for (x = 0; x < size_x; x++) {
+			value[x] = 0.0f;
+		}
 	}
 
-	return value;
+	for (i = 0, layer = mr_handle->layers; i < mr_handle->layers_tot; i++, layer++) {
+		unsigned int x_min = 0, x_max = 0, y_min = 0, y_max = 0;
+
+		/* also used as signal for unused layer (when render is disabled) */
+		if (layer->alpha != 0.0f) {
+			maskrasterize_tile_layer_range(co_x, size_x, layer->bounds.xmin, layer->bounds.xmax, &x_min, &x_max);
+			maskrasterize_tile_layer_range(co_y, size_y, layer->bounds.ymin, layer->bounds.ymax, &y_min, &y_max);
+
+			if (x_min == x_max || y_min == y_max) {
+				x_min = x_max = y_min = y_max = 0;
+			}
+		}
+
+		if (x_min != x_max) {
+			for (y = y_min; y < y_max; y++) {
+				for (x = x_min; x < x_max; x++) {
+					depth[y * TILE_SIZE + x] = 1.0f;
+				}
+			}
+
+			maskrasterize_tile_layer_depth(layer, depth, x_ofs, y_ofs, fwidth, fheight,
+			                               co_x, co_y, x_min, x_max, y_min, y_max);
+		}
+
+		for (y = 0; y < size_y; y++) {
+			float *value = &data->buffer[(y_ofs + y) * data->width + x_ofs];
+			const float *depth_row = &depth[y * TILE_SIZE];
+			const bool row_inside = (y >= y_min && y < y_max);
+
+			for (x = 0; x < size_x; x++) {
+				float value_layer;
+
+				if (row_inside && x >= x_min && x < x_max) {
+					value_layer = maskrasterize_layer_value(layer, 1.0f - depth_row[x]);
+				}
+				else {
+					value_layer = 0.0f;
+				}
+
+				value[x] = maskrasterize_layer_blend(layer, value[x], value_layer);
+			}
+		}
+	}
 }
 
 /**
  * \brief Rasterize a buffer from a single mask
  *
- * We could get some speedup by inlining #BKE_maskrasterize_handle_sample
- * and calculating each layer then blending buffers, but this function is only
- * used by the sequencer - so better have the caller thread.
- *
- * Since #BKE_maskrasterize_handle_sample is used threaded elsewhere,
- * we can simply use openmp here for some speedup.
+ * The buffer is split in tiles which are rasterized in parallel,
+ * gives the same result as calling #BKE_maskrasterize_handle_sample for each pixel.
  */
 void BKE_maskrasterize_buffer(MaskRasterHandle *mr_handle,
                               const unsigned int width, const unsigned int height,
                               float *buffer)
 {
-#ifdef _MSC_VER
-	int y;  /* msvc requires signed for some reason */
+	TaskScheduler *task_scheduler = BLI_task_scheduler_get();
+	TaskPool *task_pool;
+	MaskRasterizeBufferData data;
+	unsigned int tiles_tot, i;
 
-	/* ignore sign mismatch */
-#  pragma warning(push)
-#  pragma warning(disable:4018)
-#else
-	unsigned int y;
-#endif
+	data.mr_handle = mr_handle;
+	data.width = width;
+	data.height = height;
+	data.tiles_x = (width + TILE_SIZE - 1) / TILE_SIZE;
+	data.buffer = buffer;
 
-#pragma omp parallel for private(y)
-	for (y = 0; y < height; y++) {
-		unsigned int i = y * width;
-		unsigned int x;
-		float xy[2];
-		xy[1] = (float)y / (float)height;
-		for (x = 0; x < width; x++, i++) {
-			xy[0] = (float)x / (float)width;
+	tiles_tot = data.tiles_x * ((height + TILE_SIZE - 1) / TILE_SIZE);
 
-			buffer[i] = BKE_maskrasterize_handle_sample(mr_handle, xy);
-		}
-	}
+	task_pool = BLI_task_pool_create(task_scheduler, &data);
 
-#ifdef _MSC_VER
-#  pragma warning(pop)
-#endif
+	for (i = 0; i < tiles_tot; i++) {
+		BLI_task_pool_push(task_pool, maskrasterize_buffer_tile, SET_UINT_IN_POINTER(i), false, TASK_PRIORITY_LOW);
+	}
 
+	BLI_task_pool_work_and_wait(task_pool);
+	BLI_task_pool_free(task_pool);
 }
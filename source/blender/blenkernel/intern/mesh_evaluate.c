@@ -46,6 +46,7 @@
 #include "BLI_linklist.h"
 #include "BLI_linklist_stack.h"
 #include "BLI_alloca.h"
+#include "BLI_threads.h"
 
 #include "BKE_customdata.h"
 #include "BKE_mesh.h"
@@ -161,8 +162,12 @@ void BKE_mesh_calc_normals_mapping_ex(
 	
 }
 
-static void mesh_calc_normals_poly_accum(MPoly *mp, MLoop *ml,
-                                         MVert *mvert, float polyno[3], float (*tnorms)[3])
+/**
+ * Calculate the poly normal and the angle weights of its corners,
+ * the weight of a corner is the angle between the two poly edges incident on its vertex.
+ */
+static void mesh_calc_normals_poly_weights(MPoly *mp, MLoop *ml,
+                                           MVert *mvert, float polyno[3], float *r_weights)
 {
 	const int nverts = mp->totloop;
 	float (*edgevecbuf)[3] = BLI_array_alloca(edgevecbuf, (size_t)nverts);
@@ -193,7 +198,7 @@ static void mesh_calc_normals_poly_accum(MPoly *mp, MLoop *ml,
 		}
 	}
 
-	/* accumulate angle weighted face normal */
+	/* angle weights */
 	/* inline version of #accumulate_vertex_normals_poly */
 	{
 		const float *prev_edge = edgevecbuf[nverts - 1];
@@ -203,18 +208,108 @@ static void mesh_calc_normals_poly_accum(MPoly *mp, MLoop *ml,
 
 			/* calculate angle between the two poly edges incident on
 			 * this vertex */
-			const float fac = saacos(-dot_v3v3(cur_edge, prev_edge));
+			r_weights[i] = saacos(-dot_v3v3(cur_edge, prev_edge));
 
-			/* accumulate */
-			madd_v3_v3fl(tnorms[ml[i].v], polyno, fac);
 			prev_edge = cur_edge;
 		}
 	}
+}
+
+static void mesh_calc_normals_poly_accum(MPoly *mp, MLoop *ml,
+                                         MVert *mvert, float polyno[3], float (*tnorms)[3])
+{
+	const int nverts = mp->totloop;
+	float *weights = BLI_array_alloca(weights, (size_t)nverts);
+	int i;
+
+	mesh_calc_normals_poly_weights(mp, ml, mvert, polyno, weights);
 
+	/* accumulate angle weighted face normal */
+	for (i = 0; i < nverts; i++) {
+		madd_v3_v3fl(tnorms[ml[i].v], polyno, weights[i]);
+	}
 }
 
+#ifdef _OPENMP
+/**
+ * Threaded version of the vertex normals calculation.
+ *
+ * Poly normals and corner weights are calculated in parallel, then each vertex sums the weighted
+ * normals of its loops through a vertex to loop map, so no two threads write to the same normal.
+ * The loops of each vertex are mapped in poly order, the sums are done in the same order
+ * as with #mesh_calc_normals_poly_accum and give the same result.
+ */
+static void mesh_calc_normals_poly_threaded(MVert *mverts, int numVerts, MLoop *mloop, MPoly *mpolys,
+                                            int numLoops, int numPolys, float (*pnors)[3])
+{
+	float *lweights = MEM_mallocN(sizeof(*lweights) * (size_t)numLoops, __func__);
+	int *loop_to_poly = MEM_mallocN(sizeof(*loop_to_poly) * (size_t)numLoops, __func__);
+	int *vert_loops = MEM_mallocN(sizeof(*vert_loops) * (size_t)numLoops, __func__);
+	int *vert_loops_offs = MEM_callocN(sizeof(*vert_loops_offs) * (size_t)(numVerts + 1), __func__);
+	int i;
+
+#pragma omp parallel for schedule(static)
+	for (i = 0; i < numPolys; i++) {
+		MPoly *mp = &mpolys[i];
+		mesh_calc_normals_poly_weights(mp, mloop + mp->loopstart, mverts, pnors[i], lweights + mp->loopstart);
+	}
+
+	/* vertex to loop map, only loops used by polys are mapped */
+	for (i = 0; i < numPolys; i++) {
+		const MPoly *mp = &mpolys[i];
+		const MLoop *ml = &mloop[mp->loopstart];
+		int j;
+
+		for (j = 0; j < mp->totloop; j++, ml++) {
+			vert_loops_offs[ml->v]++;
+		}
+	}
+	for (i = 1; i < numVerts; i++) {
+		vert_loops_offs[i] += vert_loops_offs[i - 1];
+	}
+	vert_loops_offs[numVerts] = vert_loops_offs[numVerts - 1];
+
+	/* fill backwards, this keeps the loops of each vertex in poly order
+	 * and leaves the offsets pointing to the first loop of each vertex */
+	for (i = numPolys - 1; i >= 0; i--) {
+		const MPoly *mp = &mpolys[i];
+		int j;
+
+		for (j = mp->loopstart + mp->totloop - 1; j >= mp->loopstart; j--) {
+			vert_loops[--vert_loops_offs[mloop[j].v]] = j;
+			loop_to_poly[j] = i;
+		}
+	}
+
+#pragma omp parallel for schedule(static)
+	for (i = 0; i < numVerts; i++) {
+		MVert *mv = &mverts[i];
+		float no[3];
+		int j;
+
+		zero_v3(no);
+		for (j = vert_loops_offs[i]; j < vert_loops_offs[i + 1]; j++) {
+			const int l = vert_loops[j];
+			madd_v3_v3fl(no, pnors[loop_to_poly[l]], lweights[l]);
+		}
+
+		/* following Mesh convention; we use vertex coordinate itself for normal in this case */
+		if (UNLIKELY(normalize_v3(no) == 0.0f)) {
+			normalize_v3_v3(no, mv->co);
+		}
+
+		normal_float_to_short_v3(mv->no, no);
+	}
+
+	MEM_freeN(lweights);
+	MEM_freeN(loop_to_poly);
+	MEM_freeN(vert_loops);
+	MEM_freeN(vert_loops_offs);
+}
+#endif  /* _OPENMP */
+
 void BKE_mesh_calc_normals_poly(MVert *mverts, int numVerts, MLoop *mloop, MPoly *mpolys,
-                                int UNUSED(numLoops), int numPolys, float (*r_polynors)[3],
+                                int numLoops, int numPolys, float (*r_polynors)[3],
                                 const bool only_face_normals)
 {
 	float (*pnors)[3] = r_polynors;
@@ -232,6 +327,22 @@ void BKE_mesh_calc_normals_poly(MVert *mverts, int numVerts, MLoop *mloop, MPoly
 		return;
 	}
 
+#ifdef _OPENMP
+	if (numPolys > BKE_MESH_OMP_LIMIT && numVerts != 0) {
+		if (pnors) {
+			mesh_calc_normals_poly_threaded(mverts, numVerts, mloop, mpolys, numLoops, numPolys, pnors);
+		}
+		else {
+			pnors = MEM_mallocN(sizeof(*pnors) * (size_t)numPolys, __func__);
+			mesh_calc_normals_poly_threaded(mverts, numVerts, mloop, mpolys, numLoops, numPolys, pnors);
+			MEM_freeN(pnors);
+		}
+		return;
+	}
+#else
+	(void)numLoops;
+#endif
+
 	/* first go through and calculate normals for all the polys */
 	tnorms = MEM_callocN(sizeof(*tnorms) * (size_t)numVerts, __func__);
 
@@ -1227,217 +1338,279 @@ void BKE_mesh_loops_to_tessdata(CustomData *fdata, CustomData *ldata, CustomData
 	}
 }
 
-/**
- * Recreate tessellation.
- *
- * @do_face_nor_copy controls whether the normals from the poly are copied to the tessellated faces.
- *
- * \return number of tessellation faces.
- */
-int BKE_mesh_recalc_tessellation(CustomData *fdata, CustomData *ldata, CustomData *pdata,
-                                 MVert *mvert, int totface, int totloop, int totpoly, const bool do_face_nor_cpy)
-{
-	/* use this to avoid locking pthread for _every_ polygon
-	 * and calling the fill function */
-
+/* use this to avoid locking pthread for _every_ polygon
+ * and calling the fill function */
 #define USE_TESSFACE_SPEEDUP
 #define USE_TESSFACE_QUADS  /* NEEDS FURTHER TESTING */
 
 /* We abuse MFace->edcode to tag quad faces. See below for details. */
 #define TESSFACE_IS_QUAD 1
 
-	const int looptris_tot = poly_to_tri_count(totpoly, totloop);
+/**
+ * \return the number of tessellation faces a polygon is split into.
+ */
+static int mesh_tessface_poly_count(const MPoly *mp)
+{
+	if (mp->totloop < 3) {
+		return 0;
+	}
+#if defined(USE_TESSFACE_SPEEDUP) && defined(USE_TESSFACE_QUADS)
+	else if (mp->totloop == 4) {
+		return 1;
+	}
+#endif
+	else {
+		return mp->totloop - 2;
+	}
+}
 
-	MPoly *mp, *mpoly;
-	MLoop *ml, *mloop;
-	MFace *mface, *mf;
-	MemArena *arena = NULL;
-	int *mface_to_poly_map;
-	unsigned int (*lindices)[4];
-	int poly_index, mface_index;
+/**
+ * Tessellate a single polygon, its faces are written from \a mface_index on
+ * (see #mesh_tessface_poly_count), so polygons can be tessellated in any order.
+ *
+ * \param arena_p: memory arena used for ngons, created on first use.
+ */
+static void mesh_recalc_tessellation_poly(
+        MVert *mvert, MLoop *mloop, MPoly *mp, const int poly_index, int mface_index,
+        MFace *mface, int *mface_to_poly_map, unsigned int (*lindices)[4], MemArena **arena_p)
+{
+	const unsigned int mp_loopstart = (unsigned int)mp->loopstart;
+	const unsigned int mp_totloop = (unsigned int)mp->totloop;
+	unsigned int l1, l2, l3, l4;
+	unsigned int *lidx;
+	MLoop *ml;
+	MFace *mf;
 	unsigned int j;
 
-	mpoly = CustomData_get_layer(pdata, CD_MPOLY);
-	mloop = CustomData_get_layer(ldata, CD_MLOOP);
-
-	/* allocate the length of totfaces, avoid many small reallocs,
-	 * if all faces are tri's it will be correct, quads == 2x allocs */
-	/* take care. we are _not_ calloc'ing so be sure to initialize each field */
-	mface_to_poly_map = MEM_mallocN(sizeof(*mface_to_poly_map) * (size_t)looptris_tot, __func__);
-	mface             = MEM_mallocN(sizeof(*mface) *             (size_t)looptris_tot, __func__);
-	lindices          = MEM_mallocN(sizeof(*lindices) *          (size_t)looptris_tot, __func__);
-
-	mface_index = 0;
-	mp = mpoly;
-	for (poly_index = 0; poly_index < totpoly; poly_index++, mp++) {
-		const unsigned int mp_loopstart = (unsigned int)mp->loopstart;
-		const unsigned int mp_totloop = (unsigned int)mp->totloop;
-		unsigned int l1, l2, l3, l4;
-		unsigned int *lidx;
-		if (mp_totloop < 3) {
-			/* do nothing */
-		}
+	if (mp_totloop < 3) {
+		/* do nothing */
+	}
 
 #ifdef USE_TESSFACE_SPEEDUP
 
 #define ML_TO_MF(i1, i2, i3)                                                  \
-		mface_to_poly_map[mface_index] = poly_index;                          \
-		mf = &mface[mface_index];                                             \
-		lidx = lindices[mface_index];                                         \
-		/* set loop indices, transformed to vert indices later */             \
-		l1 = mp_loopstart + i1;                                               \
-		l2 = mp_loopstart + i2;                                               \
-		l3 = mp_loopstart + i3;                                               \
-		mf->v1 = mloop[l1].v;                                                 \
-		mf->v2 = mloop[l2].v;                                                 \
-		mf->v3 = mloop[l3].v;                                                 \
-		mf->v4 = 0;                                                           \
-		lidx[0] = l1;                                                         \
-		lidx[1] = l2;                                                         \
-		lidx[2] = l3;                                                         \
-		lidx[3] = 0;                                                          \
-		mf->mat_nr = mp->mat_nr;                                              \
-		mf->flag = mp->flag;                                                  \
-		mf->edcode = 0;                                                       \
-		(void)0
+	mface_to_poly_map[mface_index] = poly_index;                              \
+	mf = &mface[mface_index];                                                 \
+	lidx = lindices[mface_index];                                             \
+	/* set loop indices, transformed to vert indices later */                 \
+	l1 = mp_loopstart + i1;                                                   \
+	l2 = mp_loopstart + i2;                                                   \
+	l3 = mp_loopstart + i3;                                                   \
+	mf->v1 = mloop[l1].v;                                                     \
+	mf->v2 = mloop[l2].v;                                                     \
+	mf->v3 = mloop[l3].v;                                                     \
+	mf->v4 = 0;                                                               \
+	lidx[0] = l1;                                                             \
+	lidx[1] = l2;                                                             \
+	lidx[2] = l3;                                                             \
+	lidx[3] = 0;                                                              \
+	mf->mat_nr = mp->mat_nr;                                                  \
+	mf->flag = mp->flag;                                                      \
+	mf->edcode = 0;                                                           \
+	(void)0
 
 /* ALMOST IDENTICAL TO DEFINE ABOVE (see EXCEPTION) */
 #define ML_TO_MF_QUAD()                                                       \
-		mface_to_poly_map[mface_index] = poly_index;                          \
-		mf = &mface[mface_index];                                             \
-		lidx = lindices[mface_index];                                         \
-		/* set loop indices, transformed to vert indices later */             \
-		l1 = mp_loopstart + 0; /* EXCEPTION */                                \
-		l2 = mp_loopstart + 1; /* EXCEPTION */                                \
-		l3 = mp_loopstart + 2; /* EXCEPTION */                                \
-		l4 = mp_loopstart + 3; /* EXCEPTION */                                \
-		mf->v1 = mloop[l1].v;                                                 \
-		mf->v2 = mloop[l2].v;                                                 \
-		mf->v3 = mloop[l3].v;                                                 \
-		mf->v4 = mloop[l4].v;                                                 \
-		lidx[0] = l1;                                                         \
-		lidx[1] = l2;                                                         \
-		lidx[2] = l3;                                                         \
-		lidx[3] = l4;                                                         \
-		mf->mat_nr = mp->mat_nr;                                              \
-		mf->flag = mp->flag;                                                  \
-		mf->edcode = TESSFACE_IS_QUAD;                                        \
-		(void)0
-
-
-		else if (mp_totloop == 3) {
-			ML_TO_MF(0, 1, 2);
-			mface_index++;
-		}
-		else if (mp_totloop == 4) {
+	mface_to_poly_map[mface_index] = poly_index;                              \
+	mf = &mface[mface_index];                                                 \
+	lidx = lindices[mface_index];                                             \
+	/* set loop indices, transformed to vert indices later */                 \
+	l1 = mp_loopstart + 0; /* EXCEPTION */                                    \
+	l2 = mp_loopstart + 1; /* EXCEPTION */                                    \
+	l3 = mp_loopstart + 2; /* EXCEPTION */                                    \
+	l4 = mp_loopstart + 3; /* EXCEPTION */                                    \
+	mf->v1 = mloop[l1].v;                                                     \
+	mf->v2 = mloop[l2].v;                                                     \
+	mf->v3 = mloop[l3].v;                                                     \
+	mf->v4 = mloop[l4].v;                                                     \
+	lidx[0] = l1;                                                             \
+	lidx[1] = l2;                                                             \
+	lidx[2] = l3;                                                             \
+	lidx[3] = l4;                                                             \
+	mf->mat_nr = mp->mat_nr;                                                  \
+	mf->flag = mp->flag;                                                      \
+	mf->edcode = TESSFACE_IS_QUAD;                                            \
+	(void)0
+
+
+	else if (mp_totloop == 3) {
+		ML_TO_MF(0, 1, 2);
+		mface_index++;
+	}
+	else if (mp_totloop == 4) {
 #ifdef USE_TESSFACE_QUADS
-			ML_TO_MF_QUAD();
-			mface_index++;
+		ML_TO_MF_QUAD();
+		mface_index++;
 #else
-			ML_TO_MF(0, 1, 2);
-			mface_index++;
-			ML_TO_MF(0, 2, 3);
-			mface_index++;
+		ML_TO_MF(0, 1, 2);
+		mface_index++;
+		ML_TO_MF(0, 2, 3);
+		mface_index++;
 #endif
-		}
+	}
 #endif /* USE_TESSFACE_SPEEDUP */
-		else {
-			const float *co_curr, *co_prev;
+	else {
+		const float *co_curr, *co_prev;
 
-			float normal[3];
+		float normal[3];
 
-			float axis_mat[3][3];
-			float (*projverts)[2];
-			unsigned int (*tris)[3];
+		float axis_mat[3][3];
+		float (*projverts)[2];
+		unsigned int (*tris)[3];
 
-			const unsigned int totfilltri = mp_totloop - 2;
+		const unsigned int totfilltri = mp_totloop - 2;
 
-			if (UNLIKELY(arena == NULL)) {
-				arena = BLI_memarena_new(BLI_MEMARENA_STD_BUFSIZE, __func__);
-			}
+		MemArena *arena = *arena_p;
 
-			tris = BLI_memarena_alloc(arena, sizeof(*tris) * (size_t)totfilltri);
-			projverts = BLI_memarena_alloc(arena, sizeof(*projverts) * (size_t)mp_totloop);
+		if (UNLIKELY(arena == NULL)) {
+			arena = *arena_p = BLI_memarena_new(BLI_MEMARENA_STD_BUFSIZE, __func__);
+		}
 
-			zero_v3(normal);
+		tris = BLI_memarena_alloc(arena, sizeof(*tris) * (size_t)totfilltri);
+		projverts = BLI_memarena_alloc(arena, sizeof(*projverts) * (size_t)mp_totloop);
 
-			/* calc normal */
-			ml = mloop + mp_loopstart;
-			co_prev = mvert[ml[mp_totloop - 1].v].co;
-			for (j = 0; j < mp_totloop; j++, ml++) {
-				co_curr = mvert[ml->v].co;
-				add_newell_cross_v3_v3v3(normal, co_prev, co_curr);
-				co_prev = co_curr;
-			}
-			if (UNLIKELY(normalize_v3(normal) == 0.0f)) {
-				normal[2] = 1.0f;
-			}
+		zero_v3(normal);
 
-			/* project verts to 2d */
-			axis_dominant_v3_to_m3(axis_mat, normal);
+		/* calc normal */
+		ml = mloop + mp_loopstart;
+		co_prev = mvert[ml[mp_totloop - 1].v].co;
+		for (j = 0; j < mp_totloop; j++, ml++) {
+			co_curr = mvert[ml->v].co;
+			add_newell_cross_v3_v3v3(normal, co_prev, co_curr);
+			co_prev = co_curr;
+		}
+		if (UNLIKELY(normalize_v3(normal) == 0.0f)) {
+			normal[2] = 1.0f;
+		}
 
-			ml = mloop + mp_loopstart;
-			for (j = 0; j < mp_totloop; j++, ml++) {
-				mul_v2_m3v3(projverts[j], axis_mat, mvert[ml->v].co);
-			}
+		/* project verts to 2d */
+		axis_dominant_v3_to_m3(axis_mat, normal);
 
-			BLI_polyfill_calc_arena((const float (*)[2])projverts, mp_totloop, tris, arena);
+		ml = mloop + mp_loopstart;
+		for (j = 0; j < mp_totloop; j++, ml++) {
+			mul_v2_m3v3(projverts[j], axis_mat, mvert[ml->v].co);
+		}
 
-			/* apply fill */
-			for (j = 0; j < totfilltri; j++) {
-				unsigned int *tri = tris[j];
-				lidx = lindices[mface_index];
+		BLI_polyfill_calc_arena((const float (*)[2])projverts, mp_totloop, tris, arena);
 
-				mface_to_poly_map[mface_index] = poly_index;
-				mf = &mface[mface_index];
+		/* apply fill */
+		for (j = 0; j < totfilltri; j++) {
+			unsigned int *tri = tris[j];
+			lidx = lindices[mface_index];
 
-				/* set loop indices, transformed to vert indices later */
-				l1 = mp_loopstart + tri[0];
-				l2 = mp_loopstart + tri[1];
-				l3 = mp_loopstart + tri[2];
+			mface_to_poly_map[mface_index] = poly_index;
+			mf = &mface[mface_index];
 
-				/* sort loop indices to ensure winding is correct */
-				if (l1 > l2) SWAP(unsigned int, l1, l2);
-				if (l2 > l3) SWAP(unsigned int, l2, l3);
-				if (l1 > l2) SWAP(unsigned int, l1, l2);
+			/* set loop indices, transformed to vert indices later */
+			l1 = mp_loopstart + tri[0];
+			l2 = mp_loopstart + tri[1];
+			l3 = mp_loopstart + tri[2];
 
-				mf->v1 = mloop[l1].v;
-				mf->v2 = mloop[l2].v;
-				mf->v3 = mloop[l3].v;
-				mf->v4 = 0;
+			/* sort loop indices to ensure winding is correct */
+			if (l1 > l2) SWAP(unsigned int, l1, l2);
+			if (l2 > l3) SWAP(unsigned int, l2, l3);
+			if (l1 > l2) SWAP(unsigned int, l1, l2);
 
-				lidx[0] = l1;
-				lidx[1] = l2;
-				lidx[2] = l3;
-				lidx[3] = 0;
+			mf->v1 = mloop[l1].v;
+			mf->v2 = mloop[l2].v;
+			mf->v3 = mloop[l3].v;
+			mf->v4 = 0;
 
-				mf->mat_nr = mp->mat_nr;
-				mf->flag = mp->flag;
-				mf->edcode = 0;
+			lidx[0] = l1;
+			lidx[1] = l2;
+			lidx[2] = l3;
+			lidx[3] = 0;
 
-				mface_index++;
-			}
+			mf->mat_nr = mp->mat_nr;
+			mf->flag = mp->flag;
+			mf->edcode = 0;
 
-			BLI_memarena_clear(arena);
+			mface_index++;
 		}
+
+		BLI_memarena_clear(arena);
+	}
+
+#undef ML_TO_MF
+#undef ML_TO_MF_QUAD
+
+}
+
+/**
+ * Recreate tessellation.
+ *
+ * @do_face_nor_copy controls whether the normals from the poly are copied to the tessellated faces.
+ *
+ * \return number of tessellation faces.
+ */
+int BKE_mesh_recalc_tessellation(CustomData *fdata, CustomData *ldata, CustomData *pdata,
+                                 MVert *mvert, int totface, int UNUSED(totloop), int totpoly, const bool do_face_nor_cpy)
+{
+	MPoly *mpoly;
+	MLoop *mloop;
+	MFace *mface, *mf;
+	int *mface_to_poly_map;
+	int *poly_mface_offs;
+	unsigned int (*lindices)[4];
+	int poly_index, mface_index, mface_tot;
+#ifdef _OPENMP
+	const bool use_threads = (totpoly > BKE_MESH_OMP_LIMIT);
+#else
+	const bool use_threads = false;
+#endif
+
+#ifdef DEBUG_TIME
+	TIMEIT_START(BKE_mesh_recalc_tessellation);
+#endif
+
+	mpoly = CustomData_get_layer(pdata, CD_MPOLY);
+	mloop = CustomData_get_layer(ldata, CD_MLOOP);
+
+	/* count the faces of each poly first, the polys can then be tessellated
+	 * in parallel, each one writing its faces from its own offset on */
+	poly_mface_offs = MEM_mallocN(sizeof(*poly_mface_offs) * (size_t)totpoly, __func__);
+	mface_tot = 0;
+	for (poly_index = 0; poly_index < totpoly; poly_index++) {
+		poly_mface_offs[poly_index] = mface_tot;
+		mface_tot += mesh_tessface_poly_count(&mpoly[poly_index]);
 	}
 
-	if (arena) {
-		BLI_memarena_free(arena);
-		arena = NULL;
+	/* take care. we are _not_ calloc'ing so be sure to initialize each field */
+	mface_to_poly_map = MEM_mallocN(sizeof(*mface_to_poly_map) * (size_t)mface_tot, __func__);
+	mface             = MEM_mallocN(sizeof(*mface) *             (size_t)mface_tot, __func__);
+	lindices          = MEM_mallocN(sizeof(*lindices) *          (size_t)mface_tot, __func__);
+
+	/* ngons allocate their arena and polyfill buffers in the threads */
+	if (use_threads) {
+		BLI_begin_threaded_malloc();
 	}
 
-	CustomData_free(fdata, totface);
-	totface = mface_index;
+#pragma omp parallel if (use_threads)
+	{
+		/* one arena per thread, for ngons */
+		MemArena *arena = NULL;
+		int i;
 
-	BLI_assert(totface <= looptris_tot);
+#pragma omp for schedule(dynamic, 1024)
+		for (i = 0; i < totpoly; i++) {
+			mesh_recalc_tessellation_poly(mvert, mloop, &mpoly[i], i, poly_mface_offs[i],
+			                              mface, mface_to_poly_map, lindices, &arena);
+		}
 
-	/* not essential but without this we store over-alloc'd memory in the CustomData layers */
-	if (LIKELY(looptris_tot != totface)) {
-		mface = MEM_reallocN(mface, sizeof(*mface) * (size_t)totface);
-		mface_to_poly_map = MEM_reallocN(mface_to_poly_map, sizeof(*mface_to_poly_map) * (size_t)totface);
+		if (arena) {
+			BLI_memarena_free(arena);
+		}
+	}
+
+	if (use_threads) {
+		BLI_end_threaded_malloc();
 	}
 
+	MEM_freeN(poly_mface_offs);
+
+	CustomData_free(fdata, totface);
+	totface = mface_tot;
+
 	CustomData_add_layer(fdata, CD_MFACE, CD_ASSIGN, mface, totface);
 
 	/* CD_ORIGINDEX will contain an array of indices from tessfaces to the polygons
@@ -1482,16 +1655,16 @@ int BKE_mesh_recalc_tessellation(CustomData *fdata, CustomData *ldata, CustomDat
 
 	MEM_freeN(lindices);
 
+#ifdef DEBUG_TIME
+	TIMEIT_END(BKE_mesh_recalc_tessellation);
+#endif
+
 	return totface;
+}
 
 #undef USE_TESSFACE_SPEEDUP
 #undef USE_TESSFACE_QUADS
 
-#undef ML_TO_MF
-#undef ML_TO_MF_QUAD
-
-}
-
 #ifdef USE_BMESH_SAVE_AS_COMPAT
 
 /**
@@ -0,0 +1,503 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/blenkernel/intern/modifier_cache.c
+ *  \ingroup bke
+ *
+ * Cache of intermediate results of the mesh modifier stack.
+ *
+ * Results are keyed by content rather than by object: the key of the mesh
+ * going into the stack is a hash of its geometry and layers, the key of each
+ * modifier result combines the key of its input with the settings of the
+ * modifier. A result is only ever found again when its input and all the
+ * settings leading to it are the same, so there is no need to invalidate
+ * anything, unused entries are freed by the memory cache limiter.
+ *
+ * Modifiers which depend on time, other datablocks or have side effects
+ * can't be cached, the stack is evaluated as usual from the first of them on.
+ */
+
+#include <string.h>
+
+#include "MEM_guardedalloc.h"
+#include "MEM_CacheLimiterC-Api.h"
+
+#include "DNA_color_types.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_modifier_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_ghash.h"
+#include "BLI_threads.h"
+
+#include "BKE_cdderivedmesh.h"
+#include "BKE_customdata.h"
+#include "BKE_DerivedMesh.h"
+#include "BKE_modifier.h"
+
+typedef struct ModifierCacheEntry {
+	uint64_t key;
+	DerivedMesh *dm;
+	MEM_CacheLimiterHandleC *handle;
+} ModifierCacheEntry;
+
+static GHash *cache_hash = NULL;
+static MEM_CacheLimiterC *cache_limiter = NULL;
+static ThreadMutex cache_lock = BLI_MUTEX_INITIALIZER;
+
+/* --------------------------------------------------------------------- */
+/* keys                                                                  */
+/* --------------------------------------------------------------------- */
+
+#define HASH_MUL 0xc6a4a7935bd1e995ULL
+
+/* murmur64 style mixing, collisions would give wrong meshes so use 64 bits */
+BLI_INLINE uint64_t hash_word(uint64_t hash, uint64_t word)
+{
+	word *= HASH_MUL;
+	word ^= word >> 47;
+	word *= HASH_MUL;
+
+	hash ^= word;
+	hash *= HASH_MUL;
+
+	return hash;
+}
+
+static uint64_t hash_data(uint64_t hash, const void *data, size_t size)
+{
+	const unsigned char *p = data;
+	uint64_t word;
+
+	hash = hash_word(hash, (uint64_t)size);
+
+	for (; size >= sizeof(word); size -= sizeof(word), p += sizeof(word)) {
+		memcpy(&word, p, sizeof(word));
+		hash = hash_word(hash, word);
+	}
+
+	if (size) {
+		word = 0;
+		memcpy(&word, p, size);
+		hash = hash_word(hash, word);
+	}
+
+	return hash;
+}
+
+static uint64_t hash_customdata(uint64_t hash, const CustomData *data, int totelem)
+{
+	int i, j;
+
+	hash = hash_word(hash, (uint64_t)totelem);
+
+	for (i = 0; i < data->totlayer; i++) {
+		const CustomDataLayer *layer = &data->layers[i];
+
+		hash = hash_word(hash, (uint64_t)layer->type);
+		hash = hash_word(hash, (uint64_t)layer->flag);
+		hash = hash_word(hash, (uint64_t)layer->active);
+		hash = hash_word(hash, (uint64_t)layer->active_rnd);
+		hash = hash_word(hash, (uint64_t)layer->active_clone);
+		hash = hash_word(hash, (uint64_t)layer->active_mask);
+		hash = hash_data(hash, layer->name, strlen(layer->name));
+
+		if (layer->data == NULL) {
+			continue;
+		}
+
+		hash = hash_data(hash, layer->data, (size_t)CustomData_sizeof(layer->type) * (size_t)totelem);
+
+		/* weights are not stored in the layer itself */
+		if (layer->type == CD_MDEFORMVERT) {
+			const MDeformVert *dvert = layer->data;
+
+			for (j = 0; j < totelem; j++, dvert++) {
+				if (dvert->dw) {
+					hash = hash_data(hash, dvert->dw, sizeof(*dvert->dw) * (size_t)dvert->totweight);
+				}
+			}
+		}
+	}
+
+	return hash;
+}
+
+static void modifier_cache_id_walk(void *userData, Object *UNUSED(ob), ID **idpoin)
+{
+	if (*idpoin) {
+		*((bool *)userData) = true;
+	}
+}
+
+static void modifier_cache_object_walk(void *userData, Object *UNUSED(ob), Object **obpoin)
+{
+	if (*obpoin) {
+		*((bool *)userData) = true;
+	}
+}
+
+/* modifiers which give the same result for the same input and settings */
+bool BKE_modifier_cache_supported(Object *ob, ModifierData *md)
+{
+	ModifierTypeInfo *mti = modifierType_getInfo(md->type);
+	bool has_id = false;
+
+	if (mti->flags & eModifierTypeFlag_UsesPointCache)
+		return false;
+	if (mti->dependsOnTime && mti->dependsOnTime(md))
+		return false;
+
+	/* store data outside of the stack or read data not in the mesh */
+	if (ELEM6(md->type, eModifierType_ParticleSystem, eModifierType_Multires,
+	          eModifierType_DynamicPaint, eModifierType_Explode, eModifierType_Ocean,
+	          eModifierType_MeshDeform))
+	{
+		return false;
+	}
+
+	/* other objects and textures may change without the modifier knowing */
+	if (mti->foreachIDLink) {
+		mti->foreachIDLink(md, ob, modifier_cache_id_walk, &has_id);
+	}
+	else if (mti->foreachObjectLink) {
+		mti->foreachObjectLink(md, ob, modifier_cache_object_walk, &has_id);
+	}
+
+	return !has_id;
+}
+
+/**
+ * Key of the mesh going into the modifier stack, \a vertexCos are the
+ * coordinates deformed by the leading deform modifiers, if any.
+ */
+uint64_t BKE_modifier_cache_key_mesh(Scene *scene, Object *ob, Mesh *me, float (*vertexCos)[3],
+                                     int useRenderParams, int needMapping, CustomDataMask dataMask)
+{
+	uint64_t key = 0;
+	bDeformGroup *dg;
+
+	key = hash_customdata(key, &me->vdata, me->totvert);
+	key = hash_customdata(key, &me->edata, me->totedge);
+	key = hash_customdata(key, &me->ldata, me->totloop);
+	key = hash_customdata(key, &me->pdata, me->totpoly);
+
+	key = hash_word(key, (uint64_t)me->flag);
+	key = hash_word(key, (uint64_t)me->cd_flag);
+	key = hash_data(key, &me->smoothresh, sizeof(me->smoothresh));
+
+	if (vertexCos) {
+		key = hash_data(key, vertexCos, sizeof(*vertexCos) * (size_t)me->totvert);
+	}
+
+	/* modifiers look up vertex groups by name */
+	for (dg = ob->defbase.first; dg; dg = dg->next) {
+		key = hash_data(key, dg->name, strlen(dg->name));
+	}
+
+	key = hash_data(key, ob->obmat, sizeof(ob->obmat));
+
+	/* material indices are offset and clamped to the object materials (solidify) */
+	key = hash_word(key, (uint64_t)ob->totcol);
+
+	/* simplify changes the subdivision levels */
+	if (scene->r.mode & R_SIMPLIFY) {
+		key = hash_word(key, (uint64_t)scene->r.simplify_subsurf);
+	}
+
+	key = hash_word(key, (uint64_t)useRenderParams);
+	key = hash_word(key, (uint64_t)needMapping);
+	key = hash_word(key, (uint64_t)dataMask);
+
+	/* 0 is used for results which are not cached */
+	return key ? key : 1;
+}
+
+static uint64_t hash_curvemapping(uint64_t hash, const CurveMapping *cumap)
+{
+	int a, i;
+
+	if (cumap == NULL) {
+		return hash_word(hash, 0);
+	}
+
+	hash = hash_word(hash, (uint64_t)cumap->flag);
+	hash = hash_data(hash, &cumap->clipr, sizeof(cumap->clipr));
+
+	/* the tables are made from the points */
+	for (a = 0; a < CM_TOT; a++) {
+		const CurveMap *cuma = &cumap->cm[a];
+
+		hash = hash_word(hash, (uint64_t)cuma->totpoint);
+		hash = hash_word(hash, (uint64_t)cuma->flag);
+
+		for (i = 0; i < cuma->totpoint; i++) {
+			const CurveMapPoint *cmp = &cuma->curve[i];
+
+			hash = hash_data(hash, &cmp->x, sizeof(cmp->x));
+			hash = hash_data(hash, &cmp->y, sizeof(cmp->y));
+			hash = hash_word(hash, (uint64_t)(cmp->flag & CUMA_VECTOR));
+		}
+	}
+
+	return hash;
+}
+
+/* the settings follow the ModifierData header */
+#define HASH_SETTINGS(hash, md, size) \
+	hash_data(hash, (const char *)(md) + sizeof(ModifierData), (size) - sizeof(ModifierData))
+
+/**
+ * Hash the settings of \a md, pointers to data other than ID's change
+ * between evaluations or files, so they are hashed by content or skipped.
+ */
+static uint64_t hash_modifier_settings(uint64_t hash, ModifierData *md, size_t size)
+{
+	switch (md->type) {
+		case eModifierType_Subsurf:
+		{
+			SubsurfModifierData smd;
+
+			memcpy(&smd, md, sizeof(smd));
+			smd.emCache = smd.mCache = NULL;
+			return HASH_SETTINGS(hash, &smd, sizeof(smd));
+		}
+		case eModifierType_Armature:
+		{
+			ArmatureModifierData amd;
+
+			memcpy(&amd, md, sizeof(amd));
+			amd.prevCos = NULL;
+			return HASH_SETTINGS(hash, &amd, sizeof(amd));
+		}
+		case eModifierType_Hook:
+		{
+			HookModifierData hmd;
+
+			memcpy(&hmd, md, sizeof(hmd));
+			if (hmd.indexar) {
+				hash = hash_data(hash, hmd.indexar, sizeof(*hmd.indexar) * (size_t)hmd.totindex);
+			}
+			hmd.indexar = NULL;
+			return HASH_SETTINGS(hash, &hmd, sizeof(hmd));
+		}
+		case eModifierType_LaplacianDeform:
+		{
+			LaplacianDeformModifierData lmd;
+
+			memcpy(&lmd, md, sizeof(lmd));
+			if (lmd.vertexco) {
+				hash = hash_data(hash, lmd.vertexco, sizeof(float[3]) * (size_t)lmd.total_verts);
+			}
+			lmd.vertexco = NULL;
+			lmd.cache_system = NULL;
+			return HASH_SETTINGS(hash, &lmd, sizeof(lmd));
+		}
+		case eModifierType_Warp:
+		{
+			WarpModifierData wmd;
+
+			memcpy(&wmd, md, sizeof(wmd));
+			hash = hash_curvemapping(hash, wmd.curfalloff);
+			wmd.curfalloff = NULL;
+			return HASH_SETTINGS(hash, &wmd, sizeof(wmd));
+		}
+		case eModifierType_WeightVGEdit:
+		{
+			WeightVGEditModifierData wmd;
+
+			memcpy(&wmd, md, sizeof(wmd));
+			hash = hash_curvemapping(hash, wmd.cmap_curve);
+			wmd.cmap_curve = NULL;
+			return HASH_SETTINGS(hash, &wmd, sizeof(wmd));
+		}
+		default:
+			/* any other pointers are ID's or runtime data of modifiers which are never cached */
+			return HASH_SETTINGS(hash, md, size);
+	}
+}
+
+#undef HASH_SETTINGS
+
+/**
+ * Key of the result of \a md applied to the mesh with key \a key,
+ * \a mask are the layers kept for the following modifiers.
+ */
+uint64_t BKE_modifier_cache_key_modifier(uint64_t key, ModifierData *md, CustomDataMask mask)
+{
+	ModifierTypeInfo *mti = modifierType_getInfo(md->type);
+
+	key = hash_word(key, (uint64_t)md->type);
+	/* folding the modifier panel doesn't change the result */
+	key = hash_word(key, (uint64_t)(md->mode & ~eModifierMode_Expanded));
+	key = hash_word(key, (uint64_t)mask);
+
+	key = hash_modifier_settings(key, md, (size_t)mti->structSize);
+
+	return key ? key : 1;
+}
+
+/* --------------------------------------------------------------------- */
+/* storage                                                               */
+/* --------------------------------------------------------------------- */
+
+static unsigned int modifier_cache_hashhash(const void *key_v)
+{
+	const ModifierCacheEntry *entry = key_v;
+
+	return (unsigned int)(entry->key ^ (entry->key >> 32));
+}
+
+static int modifier_cache_hashcmp(const void *a_v, const void *b_v)
+{
+	const ModifierCacheEntry *a = a_v;
+	const ModifierCacheEntry *b = b_v;
+
+	return (a->key != b->key);
+}
+
+static size_t modifier_cache_customdata_size(const CustomData *data, int totelem)
+{
+	size_t size = 0;
+	int i;
+
+	for (i = 0; i < data->totlayer; i++) {
+		if (!(data->layers[i].flag & CD_FLAG_NOFREE)) {
+			size += (size_t)CustomData_sizeof(data->layers[i].type) * (size_t)totelem;
+		}
+	}
+
+	return size;
+}
+
+static size_t modifier_cache_get_item_size(void *p)
+{
+	ModifierCacheEntry *entry = p;
+	DerivedMesh *dm = entry->dm;
+
+	return sizeof(ModifierCacheEntry) +
+	       modifier_cache_customdata_size(&dm->vertData, dm->numVertData) +
+	       modifier_cache_customdata_size(&dm->edgeData, dm->numEdgeData) +
+	       modifier_cache_customdata_size(&dm->faceData, dm->numTessFaceData) +
+	       modifier_cache_customdata_size(&dm->loopData, dm->numLoopData) +
+	       modifier_cache_customdata_size(&dm->polyData, dm->numPolyData);
+}
+
+/* called by the limiter, with cache_lock held */
+static void modifier_cache_destructor(void *p)
+{
+	ModifierCacheEntry *entry = p;
+
+	BLI_ghash_remove(cache_hash, entry, NULL, NULL);
+
+	entry->dm->release(entry->dm);
+	MEM_freeN(entry);
+}
+
+/* returns a copy of the cached result, or NULL */
+DerivedMesh *BKE_modifier_cache_get(uint64_t key)
+{
+	ModifierCacheEntry *entry, lookup;
+	DerivedMesh *dm = NULL;
+
+	lookup.key = key;
+
+	BLI_mutex_lock(&cache_lock);
+
+	if (cache_hash) {
+		entry = BLI_ghash_lookup(cache_hash, &lookup);
+
+		if (entry) {
+			MEM_CacheLimiter_touch(entry->handle);
+			dm = CDDM_copy(entry->dm);
+		}
+	}
+
+	BLI_mutex_unlock(&cache_lock);
+
+	return dm;
+}
+
+/* stores a copy of \a dm, only CDDM results are stored since the copies are CDDM's */
+void BKE_modifier_cache_put(uint64_t key, DerivedMesh *dm)
+{
+	ModifierCacheEntry *entry, lookup;
+
+	/* subsurf gives a CCGDM, which the stack and drawing treat differently */
+	if (dm->type != DM_TYPE_CDDM) {
+		return;
+	}
+
+	lookup.key = key;
+
+	BLI_mutex_lock(&cache_lock);
+
+	if (cache_hash == NULL) {
+		cache_hash = BLI_ghash_new(modifier_cache_hashhash, modifier_cache_hashcmp, "modifier cache hash");
+		cache_limiter = new_MEM_CacheLimiter(modifier_cache_destructor, modifier_cache_get_item_size);
+	}
+
+	entry = BLI_ghash_lookup(cache_hash, &lookup);
+
+	if (entry) {
+		MEM_CacheLimiter_touch(entry->handle);
+	}
+	else {
+		entry = MEM_mallocN(sizeof(ModifierCacheEntry), "ModifierCacheEntry");
+		entry->key = key;
+		entry->dm = CDDM_copy(dm);
+
+		BLI_ghash_insert(cache_hash, entry, entry);
+		entry->handle = MEM_CacheLimiter_insert(cache_limiter, entry);
+
+		/* may free the new entry too, if it doesn't fit */
+		MEM_CacheLimiter_enforce_limits(cache_limiter);
+	}
+
+	BLI_mutex_unlock(&cache_lock);
+}
+
+void BKE_modifier_cache_free(void)
+{
+	BLI_mutex_lock(&cache_lock);
+
+	if (cache_hash) {
+		GHashIterator gh_iter;
+
+		GHASH_ITER (gh_iter, cache_hash) {
+			ModifierCacheEntry *entry = BLI_ghashIterator_getValue(&gh_iter);
+
+			MEM_CacheLimiter_unmanage(entry->handle);
+			entry->dm->release(entry->dm);
+			MEM_freeN(entry);
+		}
+
+		BLI_ghash_free(cache_hash, NULL, NULL);
+		delete_MEM_CacheLimiter(cache_limiter);
+
+		cache_hash = NULL;
+		cache_limiter = NULL;
+	}
+
+	BLI_mutex_unlock(&cache_lock);
+}
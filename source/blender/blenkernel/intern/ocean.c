@@ -42,6 +42,7 @@
 #include "BLI_path_util.h"
 #include "BLI_rand.h"
 #include "BLI_string.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
@@ -462,10 +463,9 @@ void BKE_ocean_eval_xz_catrom(struct Ocean *oc, struct OceanResult *ocr, float x
 /* note that this doesn't wrap properly for i, j < 0, but its not really meant for that being just a way to get
  * the raw data out to save in some image format.
  */
-void BKE_ocean_eval_ij(struct Ocean *oc, struct OceanResult *ocr, int i, int j)
+/* caller must hold the read lock */
+static void ocean_eval_ij_nolock(struct Ocean *oc, struct OceanResult *ocr, int i, int j)
 {
-	BLI_rw_mutex_lock(&oc->oceanmutex, THREAD_LOCK_READ);
-
 	i = abs(i) % oc->_M;
 	j = abs(j) % oc->_N;
 
@@ -491,7 +491,12 @@ void BKE_ocean_eval_ij(struct Ocean *oc, struct OceanResult *ocr, int i, int j)
 	if (oc->_do_jacobian) {
 		compute_eigenstuff(ocr, oc->_Jxx[i * oc->_N + j], oc->_Jzz[i * oc->_N + j], oc->_Jxz[i * oc->_N + j]);
 	}
+}
 
+void BKE_ocean_eval_ij(struct Ocean *oc, struct OceanResult *ocr, int i, int j)
+{
+	BLI_rw_mutex_lock(&oc->oceanmutex, THREAD_LOCK_READ);
+	ocean_eval_ij_nolock(oc, ocr, i, j);
 	BLI_rw_mutex_unlock(&oc->oceanmutex);
 }
 
@@ -1183,24 +1188,61 @@ void BKE_simulate_ocean_cache(struct OceanCache *och, int frame)
 }
 
 
+typedef struct OceanBakeState {
+	struct OceanCache *och;
+	ImageFormatData imf;
+	short do_foam, do_normals;
+} OceanBakeState;
+
+typedef struct OceanBakeFrame {
+	int frame;
+	ImBuf *ibuf_disp, *ibuf_foam, *ibuf_normal;
+} OceanBakeFrame;
+
+static void ocean_bake_write_image(ImBuf *ibuf, OceanBakeState *state, int frame, int type, const char *name)
+{
+	char string[FILE_MAX];
+
+	cache_filename(string, state->och->bakepath, state->och->relbase, frame, type);
+	if (0 == BKE_imbuf_write(ibuf, string, &state->imf))
+		printf("Cannot save %s File Output to %s\n", name, string);
+}
+
+/* compressing and writing the EXR files runs in the task pool,
+ * overlapping with the simulation of the next frames */
+static void ocean_bake_write_frame(TaskPool *pool, void *taskdata, int UNUSED(threadid))
+{
+	OceanBakeState *state = BLI_task_pool_userdata(pool);
+	OceanBakeFrame *bf = taskdata;
+
+	ocean_bake_write_image(bf->ibuf_disp, state, bf->frame, CACHE_TYPE_DISPLACE, "Displacement");
+
+	if (state->do_foam)
+		ocean_bake_write_image(bf->ibuf_foam, state, bf->frame, CACHE_TYPE_FOAM, "Foam");
+
+	if (state->do_normals)
+		ocean_bake_write_image(bf->ibuf_normal, state, bf->frame, CACHE_TYPE_NORMAL, "Normal");
+
+	IMB_freeImBuf(bf->ibuf_disp);
+	IMB_freeImBuf(bf->ibuf_foam);
+	IMB_freeImBuf(bf->ibuf_normal);
+}
+
 void BKE_bake_ocean(struct Ocean *o, struct OceanCache *och, void (*update_cb)(void *, float progress, int *cancel),
                     void *update_cb_data)
 {
-	/* note: some of these values remain uninitialized unless certain options
-	 * are enabled, take care that BKE_ocean_eval_ij() initializes a member
-	 * before use - campbell */
-	OceanResult ocr;
-
-	ImageFormatData imf = {0};
+	OceanBakeState state = {NULL};
+	TaskScheduler *task_scheduler;
+	TaskPool *task_pool;
+	int num_threads, num_queued = 0;
 
-	int f, i = 0, x, y, cancel = 0;
+	int f, i = 0, y, cancel = 0;
 	float progress;
 
 	ImBuf *ibuf_foam, *ibuf_disp, *ibuf_normal;
 	float *prev_foam;
 	int res_x = och->resolution_x;
 	int res_y = och->resolution_y;
-	char string[FILE_MAX];
 	//RNG *rng;
 
 	if (!o) return;
@@ -1211,11 +1253,19 @@ void BKE_bake_ocean(struct Ocean *o, struct OceanCache *och, void (*update_cb)(v
 	//rng = BLI_rng_new(0);
 
 	/* setup image format */
-	imf.imtype = R_IMF_IMTYPE_OPENEXR;
-	imf.depth =  R_IMF_CHAN_DEPTH_16;
-	imf.exr_codec = R_IMF_EXR_CODEC_ZIP;
+	state.och = och;
+	state.imf.imtype = R_IMF_IMTYPE_OPENEXR;
+	state.imf.depth =  R_IMF_CHAN_DEPTH_16;
+	state.imf.exr_codec = R_IMF_EXR_CODEC_ZIP;
+	state.do_foam = o->_do_jacobian;
+	state.do_normals = o->_do_normals;
+
+	task_scheduler = BLI_task_scheduler_get();
+	task_pool = BLI_task_pool_create(task_scheduler, &state);
+	num_threads = BLI_task_scheduler_num_threads(task_scheduler);
 
 	for (f = och->start, i = 0; f <= och->end; f++, i++) {
+		OceanBakeFrame *bf;
 
 		/* create a new imbuf to store image for this frame */
 		ibuf_foam = IMB_allocImBuf(res_x, res_y, 32, IB_rectfloat);
@@ -1224,11 +1274,20 @@ void BKE_bake_ocean(struct Ocean *o, struct OceanCache *och, void (*update_cb)(v
 
 		BKE_simulate_ocean(o, och->time[i], och->wave_scale, och->chop_amount);
 
-		/* add new foam */
+		BLI_rw_mutex_lock(&o->oceanmutex, THREAD_LOCK_READ);
+
+		/* add new foam, the cells only depend on their own value of the previous frame */
+#pragma omp parallel for private(y) schedule(static)
 		for (y = 0; y < res_y; y++) {
+			int x;
+
 			for (x = 0; x < res_x; x++) {
+				/* note: some of these values remain uninitialized unless certain options
+				 * are enabled, take care that ocean_eval_ij_nolock() initializes a member
+				 * before use - campbell */
+				OceanResult ocr;
 
-				BKE_ocean_eval_ij(o, &ocr, x, y);
+				ocean_eval_ij_nolock(o, &ocr, x, y);
 
 				/* add to the image */
 				rgb_to_rgba_unit_alpha(&ibuf_disp->rect_float[4 * (res_x * y + x)], ocr.disp);
@@ -1298,38 +1357,38 @@ void BKE_bake_ocean(struct Ocean *o, struct OceanCache *och, void (*update_cb)(v
 			}
 		}
 
-		/* write the images */
-		cache_filename(string, och->bakepath, och->relbase, f, CACHE_TYPE_DISPLACE);
-		if (0 == BKE_imbuf_write(ibuf_disp, string, &imf))
-			printf("Cannot save Displacement File Output to %s\n", string);
+		BLI_rw_mutex_unlock(&o->oceanmutex);
 
-		if (o->_do_jacobian) {
-			cache_filename(string, och->bakepath, och->relbase, f, CACHE_TYPE_FOAM);
-			if (0 == BKE_imbuf_write(ibuf_foam, string, &imf))
-				printf("Cannot save Foam File Output to %s\n", string);
-		}
+		/* write the images in the background */
+		bf = MEM_mallocN(sizeof(OceanBakeFrame), "ocean bake frame");
+		bf->frame = f;
+		bf->ibuf_disp = ibuf_disp;
+		bf->ibuf_foam = ibuf_foam;
+		bf->ibuf_normal = ibuf_normal;
+		BLI_task_pool_push(task_pool, ocean_bake_write_frame, bf, true, TASK_PRIORITY_LOW);
 
-		if (o->_do_normals) {
-			cache_filename(string, och->bakepath, och->relbase, f, CACHE_TYPE_NORMAL);
-			if (0 == BKE_imbuf_write(ibuf_normal, string, &imf))
-				printf("Cannot save Normal File Output to %s\n", string);
+		/* limit the number of frames waiting to be written */
+		if (++num_queued >= num_threads) {
+			BLI_task_pool_work_and_wait(task_pool);
+			num_queued = 0;
 		}
 
-		IMB_freeImBuf(ibuf_disp);
-		IMB_freeImBuf(ibuf_foam);
-		IMB_freeImBuf(ibuf_normal);
-
 		progress = (f - och->start) / (float)och->duration;
 
 		update_cb(update_cb_data, progress, &cancel);
 
 		if (cancel) {
+			BLI_task_pool_work_and_wait(task_pool);
+			BLI_task_pool_free(task_pool);
 			if (prev_foam) MEM_freeN(prev_foam);
 			//BLI_rng_free(rng);
 			return;
 		}
 	}
 
+	BLI_task_pool_work_and_wait(task_pool);
+	BLI_task_pool_free(task_pool);
+
 	//BLI_rng_free(rng);
 	if (prev_foam) MEM_freeN(prev_foam);
 	och->baked = 1;
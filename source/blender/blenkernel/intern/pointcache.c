@@ -51,6 +51,7 @@
 #include "BLI_threads.h"
 #include "BLI_math.h"
 #include "BLI_utildefines.h"
+#include "BLI_voxel.h"
 
 #include "BLF_translation.h"
 
@@ -572,7 +573,76 @@ static void ptcache_smoke_error(void *smoke_v, const char *message)
 	modifier_setError(&smd->modifier, "%s", message);
 }
 
-#define SMOKE_CACHE_VERSION "1.04"
+#define SMOKE_CACHE_VERSION "1.05"
+/* last version storing the fields as dense arrays */
+#define SMOKE_CACHE_VERSION_DENSE "1.04"
+
+/* The fields are stored as sparse blocks: a mask of the blocks holding non-zero
+ * values, then the values of these blocks only. Most of a large domain is empty,
+ * so the cache size and load time scale with the smoke instead of the domain. */
+typedef struct SmokeSparseBuffer {
+	int res[3];
+	unsigned char *mask;
+	float *packed;
+} SmokeSparseBuffer;
+
+static void ptcache_smoke_sparse_init(SmokeSparseBuffer *sb, const int res[3])
+{
+	int block_res[3];
+
+	copy_v3_v3_int(sb->res, res);
+	sb->mask = MEM_mallocN(BLI_voxel_block_res(res, block_res), "smoke sparse mask");
+	sb->packed = MEM_mallocN(sizeof(float) * res[0] * res[1] * res[2], "smoke sparse data");
+}
+
+static void ptcache_smoke_sparse_free(SmokeSparseBuffer *sb)
+{
+	MEM_freeN(sb->mask);
+	MEM_freeN(sb->packed);
+}
+
+static void ptcache_smoke_sparse_write(PTCacheFile *pf, SmokeSparseBuffer *sb, float *data, unsigned char *out, int mode)
+{
+	int block_res[3];
+	unsigned int totblock = (unsigned int)BLI_voxel_block_res(sb->res, block_res);
+	unsigned int totvoxel = BLI_voxel_block_mask(data, sb->res, sb->mask);
+
+	ptcache_file_compressed_write(pf, sb->mask, totblock, out, mode);
+	ptcache_file_write(pf, &totvoxel, 1, sizeof(unsigned int));
+
+	if (totvoxel) {
+		BLI_voxel_block_pack(data, sb->res, sb->mask, sb->packed);
+		ptcache_file_compressed_write(pf, (unsigned char *)sb->packed, totvoxel * sizeof(float), out, mode);
+	}
+}
+
+static void ptcache_smoke_sparse_read(PTCacheFile *pf, SmokeSparseBuffer *sb, float *data, int sparse)
+{
+	unsigned int totcell = (unsigned int)(sb->res[0] * sb->res[1] * sb->res[2]);
+	int block_res[3];
+	unsigned int totblock, totvoxel = 0;
+
+	if (!sparse) {
+		ptcache_file_compressed_read(pf, (unsigned char *)data, totcell * sizeof(float));
+		return;
+	}
+
+	totblock = (unsigned int)BLI_voxel_block_res(sb->res, block_res);
+
+	ptcache_file_compressed_read(pf, sb->mask, totblock);
+	ptcache_file_read(pf, &totvoxel, 1, sizeof(unsigned int));
+
+	if (totvoxel > totcell) {
+		/* corrupt file, don't read past the buffer */
+		memset(data, 0, totcell * sizeof(float));
+		return;
+	}
+
+	if (totvoxel)
+		ptcache_file_compressed_read(pf, (unsigned char *)sb->packed, totvoxel * sizeof(float));
+
+	BLI_voxel_block_unpack(data, sb->res, sb->mask, sb->packed);
+}
 
 static int  ptcache_smoke_write(PTCacheFile *pf, void *smoke_v)
 {	
@@ -594,31 +664,34 @@ static int  ptcache_smoke_write(PTCacheFile *pf, void *smoke_v)
 		unsigned char *obstacles;
 		unsigned int in_len = sizeof(float)*(unsigned int)res;
 		unsigned char *out = (unsigned char *)MEM_callocN(LZO_OUT_LEN(in_len) * 4, "pointcache_lzo_buffer");
+		SmokeSparseBuffer sb;
 		//int mode = res >= 1000000 ? 2 : 1;
 		int mode=1;		// light
 		if (sds->cache_comp == SM_CACHE_HEAVY) mode=2;	// heavy
 
 		smoke_export(sds->fluid, &dt, &dx, &dens, &react, &flame, &fuel, &heat, &heatold, &vx, &vy, &vz, &r, &g, &b, &obstacles);
 
-		ptcache_file_compressed_write(pf, (unsigned char *)sds->shadow, in_len, out, mode);
-		ptcache_file_compressed_write(pf, (unsigned char *)dens, in_len, out, mode);
+		ptcache_smoke_sparse_init(&sb, sds->res);
+		ptcache_smoke_sparse_write(pf, &sb, sds->shadow, out, mode);
+		ptcache_smoke_sparse_write(pf, &sb, dens, out, mode);
 		if (fluid_fields & SM_ACTIVE_HEAT) {
-			ptcache_file_compressed_write(pf, (unsigned char *)heat, in_len, out, mode);
-			ptcache_file_compressed_write(pf, (unsigned char *)heatold, in_len, out, mode);
+			ptcache_smoke_sparse_write(pf, &sb, heat, out, mode);
+			ptcache_smoke_sparse_write(pf, &sb, heatold, out, mode);
 		}
 		if (fluid_fields & SM_ACTIVE_FIRE) {
-			ptcache_file_compressed_write(pf, (unsigned char *)flame, in_len, out, mode);
-			ptcache_file_compressed_write(pf, (unsigned char *)fuel, in_len, out, mode);
-			ptcache_file_compressed_write(pf, (unsigned char *)react, in_len, out, mode);
+			ptcache_smoke_sparse_write(pf, &sb, flame, out, mode);
+			ptcache_smoke_sparse_write(pf, &sb, fuel, out, mode);
+			ptcache_smoke_sparse_write(pf, &sb, react, out, mode);
 		}
 		if (fluid_fields & SM_ACTIVE_COLORS) {
-			ptcache_file_compressed_write(pf, (unsigned char *)r, in_len, out, mode);
-			ptcache_file_compressed_write(pf, (unsigned char *)g, in_len, out, mode);
-			ptcache_file_compressed_write(pf, (unsigned char *)b, in_len, out, mode);
-		}
-		ptcache_file_compressed_write(pf, (unsigned char *)vx, in_len, out, mode);
-		ptcache_file_compressed_write(pf, (unsigned char *)vy, in_len, out, mode);
-		ptcache_file_compressed_write(pf, (unsigned char *)vz, in_len, out, mode);
+			ptcache_smoke_sparse_write(pf, &sb, r, out, mode);
+			ptcache_smoke_sparse_write(pf, &sb, g, out, mode);
+			ptcache_smoke_sparse_write(pf, &sb, b, out, mode);
+		}
+		ptcache_smoke_sparse_write(pf, &sb, vx, out, mode);
+		ptcache_smoke_sparse_write(pf, &sb, vy, out, mode);
+		ptcache_smoke_sparse_write(pf, &sb, vz, out, mode);
+		ptcache_smoke_sparse_free(&sb);
 		ptcache_file_compressed_write(pf, (unsigned char *)obstacles, (unsigned int)res, out, mode);
 		ptcache_file_write(pf, &dt, 1, sizeof(float));
 		ptcache_file_write(pf, &dx, 1, sizeof(float));
@@ -646,6 +719,7 @@ static int  ptcache_smoke_write(PTCacheFile *pf, void *smoke_v)
 		unsigned int in_len = sizeof(float)*(unsigned int)res;
 		unsigned int in_len_big;
 		unsigned char *out;
+		SmokeSparseBuffer sb;
 		int mode;
 
 		smoke_turbulence_get_res(sds->wt, res_big_array);
@@ -659,19 +733,23 @@ static int  ptcache_smoke_write(PTCacheFile *pf, void *smoke_v)
 		smoke_turbulence_export(sds->wt, &dens, &react, &flame, &fuel, &r, &g, &b, &tcu, &tcv, &tcw);
 
 		out = (unsigned char *)MEM_callocN(LZO_OUT_LEN(in_len_big), "pointcache_lzo_buffer");
-		ptcache_file_compressed_write(pf, (unsigned char *)dens, in_len_big, out, mode);
+		ptcache_smoke_sparse_init(&sb, res_big_array);
+		ptcache_smoke_sparse_write(pf, &sb, dens, out, mode);
 		if (fluid_fields & SM_ACTIVE_FIRE) {
-			ptcache_file_compressed_write(pf, (unsigned char *)flame, in_len_big, out, mode);
-			ptcache_file_compressed_write(pf, (unsigned char *)fuel, in_len_big, out, mode);
-			ptcache_file_compressed_write(pf, (unsigned char *)react, in_len_big, out, mode);
+			ptcache_smoke_sparse_write(pf, &sb, flame, out, mode);
+			ptcache_smoke_sparse_write(pf, &sb, fuel, out, mode);
+			ptcache_smoke_sparse_write(pf, &sb, react, out, mode);
 		}
 		if (fluid_fields & SM_ACTIVE_COLORS) {
-			ptcache_file_compressed_write(pf, (unsigned char *)r, in_len_big, out, mode);
-			ptcache_file_compressed_write(pf, (unsigned char *)g, in_len_big, out, mode);
-			ptcache_file_compressed_write(pf, (unsigned char *)b, in_len_big, out, mode);
+			ptcache_smoke_sparse_write(pf, &sb, r, out, mode);
+			ptcache_smoke_sparse_write(pf, &sb, g, out, mode);
+			ptcache_smoke_sparse_write(pf, &sb, b, out, mode);
 		}
+		ptcache_smoke_sparse_free(&sb);
 		MEM_freeN(out);
 
+		/* texture coordinates are never zero, keep them dense */
+
 		out = (unsigned char *)MEM_callocN(LZO_OUT_LEN(in_len), "pointcache_lzo_buffer");
 		ptcache_file_compressed_write(pf, (unsigned char *)tcu, in_len, out, mode);
 		ptcache_file_compressed_write(pf, (unsigned char *)tcv, in_len, out, mode);
@@ -773,10 +851,14 @@ static int ptcache_smoke_read(PTCacheFile *pf, void *smoke_v)
 	int cache_fields = 0;
 	int active_fields = 0;
 	int reallocate = 0;
+	int sparse = 1;
 
 	/* version header */
 	ptcache_file_read(pf, version, 4, sizeof(char));
-	if (strncmp(version, SMOKE_CACHE_VERSION, 4))
+	if (strncmp(version, SMOKE_CACHE_VERSION_DENSE, 4) == 0) {
+		sparse = 0;
+	}
+	else if (strncmp(version, SMOKE_CACHE_VERSION, 4))
 	{
 		/* reset file pointer */
 		fseek(pf->fp, -4, SEEK_CUR);
@@ -819,29 +901,31 @@ static int ptcache_smoke_read(PTCacheFile *pf, void *smoke_v)
 		size_t res = sds->res[0]*sds->res[1]*sds->res[2];
 		float dt, dx, *dens, *react, *fuel, *flame, *heat, *heatold, *vx, *vy, *vz, *r, *g, *b;
 		unsigned char *obstacles;
-		unsigned int out_len = (unsigned int)res * sizeof(float);
+		SmokeSparseBuffer sb;
 		
 		smoke_export(sds->fluid, &dt, &dx, &dens, &react, &flame, &fuel, &heat, &heatold, &vx, &vy, &vz, &r, &g, &b, &obstacles);
 
-		ptcache_file_compressed_read(pf, (unsigned char *)sds->shadow, out_len);
-		ptcache_file_compressed_read(pf, (unsigned char *)dens, out_len);
+		ptcache_smoke_sparse_init(&sb, sds->res);
+		ptcache_smoke_sparse_read(pf, &sb, sds->shadow, sparse);
+		ptcache_smoke_sparse_read(pf, &sb, dens, sparse);
 		if (cache_fields & SM_ACTIVE_HEAT) {
-			ptcache_file_compressed_read(pf, (unsigned char *)heat, out_len);
-			ptcache_file_compressed_read(pf, (unsigned char *)heatold, out_len);
+			ptcache_smoke_sparse_read(pf, &sb, heat, sparse);
+			ptcache_smoke_sparse_read(pf, &sb, heatold, sparse);
 		}
 		if (cache_fields & SM_ACTIVE_FIRE) {
-			ptcache_file_compressed_read(pf, (unsigned char *)flame, out_len);
-			ptcache_file_compressed_read(pf, (unsigned char *)fuel, out_len);
-			ptcache_file_compressed_read(pf, (unsigned char *)react, out_len);
+			ptcache_smoke_sparse_read(pf, &sb, flame, sparse);
+			ptcache_smoke_sparse_read(pf, &sb, fuel, sparse);
+			ptcache_smoke_sparse_read(pf, &sb, react, sparse);
 		}
 		if (cache_fields & SM_ACTIVE_COLORS) {
-			ptcache_file_compressed_read(pf, (unsigned char *)r, out_len);
-			ptcache_file_compressed_read(pf, (unsigned char *)g, out_len);
-			ptcache_file_compressed_read(pf, (unsigned char *)b, out_len);
-		}
-		ptcache_file_compressed_read(pf, (unsigned char *)vx, out_len);
-		ptcache_file_compressed_read(pf, (unsigned char *)vy, out_len);
-		ptcache_file_compressed_read(pf, (unsigned char *)vz, out_len);
+			ptcache_smoke_sparse_read(pf, &sb, r, sparse);
+			ptcache_smoke_sparse_read(pf, &sb, g, sparse);
+			ptcache_smoke_sparse_read(pf, &sb, b, sparse);
+		}
+		ptcache_smoke_sparse_read(pf, &sb, vx, sparse);
+		ptcache_smoke_sparse_read(pf, &sb, vy, sparse);
+		ptcache_smoke_sparse_read(pf, &sb, vz, sparse);
+		ptcache_smoke_sparse_free(&sb);
 		ptcache_file_compressed_read(pf, (unsigned char *)obstacles, (unsigned int)res);
 		ptcache_file_read(pf, &dt, 1, sizeof(float));
 		ptcache_file_read(pf, &dx, 1, sizeof(float));
@@ -859,28 +943,28 @@ static int ptcache_smoke_read(PTCacheFile *pf, void *smoke_v)
 
 	if (pf->data_types & (1<<BPHYS_DATA_SMOKE_HIGH) && sds->wt) {
 			int res = sds->res[0]*sds->res[1]*sds->res[2];
-			int res_big, res_big_array[3];
+			int res_big_array[3];
 			float *dens, *react, *fuel, *flame, *tcu, *tcv, *tcw, *r, *g, *b;
 			unsigned int out_len = sizeof(float)*(unsigned int)res;
-			unsigned int out_len_big;
+			SmokeSparseBuffer sb;
 
 			smoke_turbulence_get_res(sds->wt, res_big_array);
-			res_big = res_big_array[0]*res_big_array[1]*res_big_array[2];
-			out_len_big = sizeof(float) * (unsigned int)res_big;
 
 			smoke_turbulence_export(sds->wt, &dens, &react, &flame, &fuel, &r, &g, &b, &tcu, &tcv, &tcw);
 
-			ptcache_file_compressed_read(pf, (unsigned char *)dens, out_len_big);
+			ptcache_smoke_sparse_init(&sb, res_big_array);
+			ptcache_smoke_sparse_read(pf, &sb, dens, sparse);
 			if (cache_fields & SM_ACTIVE_FIRE) {
-				ptcache_file_compressed_read(pf, (unsigned char *)flame, out_len_big);
-				ptcache_file_compressed_read(pf, (unsigned char *)fuel, out_len_big);
-				ptcache_file_compressed_read(pf, (unsigned char *)react, out_len_big);
+				ptcache_smoke_sparse_read(pf, &sb, flame, sparse);
+				ptcache_smoke_sparse_read(pf, &sb, fuel, sparse);
+				ptcache_smoke_sparse_read(pf, &sb, react, sparse);
 			}
 			if (cache_fields & SM_ACTIVE_COLORS) {
-				ptcache_file_compressed_read(pf, (unsigned char *)r, out_len_big);
-				ptcache_file_compressed_read(pf, (unsigned char *)g, out_len_big);
-				ptcache_file_compressed_read(pf, (unsigned char *)b, out_len_big);
+				ptcache_smoke_sparse_read(pf, &sb, r, sparse);
+				ptcache_smoke_sparse_read(pf, &sb, g, sparse);
+				ptcache_smoke_sparse_read(pf, &sb, b, sparse);
 			}
+			ptcache_smoke_sparse_free(&sb);
 
 			ptcache_file_compressed_read(pf, (unsigned char *)tcu, out_len);
 			ptcache_file_compressed_read(pf, (unsigned char *)tcv, out_len);
@@ -759,6 +759,8 @@ Tex *localize_texture(Tex *tex)
 		texn->vd = MEM_dupallocN(texn->vd);
 		if (texn->vd->dataset)
 			texn->vd->dataset = MEM_dupallocN(texn->vd->dataset);
+		if (texn->vd->blockmask)
+			texn->vd->blockmask = MEM_dupallocN(texn->vd->blockmask);
 	}
 	if (texn->ot) {
 		texn->ot = BKE_copy_oceantex(tex->ot);
@@ -1356,7 +1358,10 @@ void BKE_free_voxeldatadata(VoxelData *vd)
 		MEM_freeN(vd->dataset);
 		vd->dataset = NULL;
 	}
-
+	if (vd->blockmask) {
+		MEM_freeN(vd->blockmask);
+		vd->blockmask = NULL;
+	}
 }
  
 void BKE_free_voxeldata(VoxelData *vd)
@@ -1389,6 +1394,7 @@ VoxelData *BKE_copy_voxeldata(VoxelData *vd)
 
 	vdn = MEM_dupallocN(vd);
 	vdn->dataset = NULL;
+	vdn->blockmask = NULL;
 
 	return vdn;
 }
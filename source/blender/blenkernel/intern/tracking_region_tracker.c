@@ -40,6 +40,7 @@
 #include "BLI_utildefines.h"
 #include "BLI_math.h"
 #include "BLI_ghash.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 
 #include "BKE_tracking.h"
@@ -77,6 +78,12 @@ typedef struct MovieTrackingContext {
 
 	bool backwards, sequence;
 	int sync_frame;
+
+	/* Read-ahead of the next destination frame, decoded in the background
+	 * while the tracks of the current frame are tracked. */
+	TaskPool *prefetch_pool;
+	MovieClipUser prefetch_user;
+	ImBuf *prefetch_ibuf;
 } MovieTrackingContext;
 
 static void track_context_free(void *customdata)
@@ -171,6 +178,8 @@ MovieTrackingContext *BKE_tracking_context_new(MovieClip *clip, MovieClipUser *u
 
 	if (!sequence)
 		BLI_begin_threaded_malloc();
+	else if (num_tracks)
+		context->prefetch_pool = BLI_task_pool_create(BLI_task_scheduler_get(), context);
 
 	return context;
 }
@@ -181,6 +190,14 @@ void BKE_tracking_context_free(MovieTrackingContext *context)
 	if (!context->sequence)
 		BLI_end_threaded_malloc();
 
+	if (context->prefetch_pool) {
+		BLI_task_pool_work_and_wait(context->prefetch_pool);
+		BLI_task_pool_free(context->prefetch_pool);
+
+		if (context->prefetch_ibuf)
+			IMB_freeImBuf(context->prefetch_ibuf);
+	}
+
 	tracks_map_free(context->tracks_map, track_context_free);
 
 	MEM_freeN(context);
@@ -600,6 +617,52 @@ static bool configure_and_run_tracker(ImBuf *destination_ibuf, MovieTrackingTrac
 	return tracked;
 }
 
+static void tracking_context_prefetch_run(TaskPool *pool, void *UNUSED(taskdata), int UNUSED(threadid))
+{
+	MovieTrackingContext *context = BLI_task_pool_userdata(pool);
+
+	/* Movie clip access is guarded by LOCK_MOVIECLIP. */
+	context->prefetch_ibuf = BKE_movieclip_get_ibuf_flag(context->clip, &context->prefetch_user,
+	                                                     context->clip_flag, MOVIECLIP_CACHE_SKIP);
+}
+
+/* Start decoding the frame following the current one in tracking direction. */
+static void tracking_context_prefetch_next(MovieTrackingContext *context, int frame_delta)
+{
+	context->prefetch_user = context->user;
+	context->prefetch_user.framenr += frame_delta;
+
+	BLI_task_pool_push(context->prefetch_pool, tracking_context_prefetch_run, NULL, false, TASK_PRIORITY_HIGH);
+}
+
+/* Get image buffer for the frame we're tracking to, using the
+ * read-ahead frame when it's the one needed.
+ */
+static ImBuf *tracking_context_get_destination_ibuf(MovieTrackingContext *context)
+{
+	ImBuf *ibuf = NULL;
+
+	if (context->prefetch_pool) {
+		BLI_task_pool_work_and_wait(context->prefetch_pool);
+
+		if (context->prefetch_ibuf) {
+			if (context->prefetch_user.framenr == context->user.framenr)
+				ibuf = context->prefetch_ibuf;
+			else
+				IMB_freeImBuf(context->prefetch_ibuf);
+
+			context->prefetch_ibuf = NULL;
+		}
+	}
+
+	if (!ibuf) {
+		ibuf = BKE_movieclip_get_ibuf_flag(context->clip, &context->user,
+		                                   context->clip_flag, MOVIECLIP_CACHE_SKIP);
+	}
+
+	return ibuf;
+}
+
 /* Track all the tracks from context one more frame,
  * returns FALSe if nothing was tracked.
  */
@@ -622,11 +685,14 @@ bool BKE_tracking_context_step(MovieTrackingContext *context)
 	/* Get an image buffer for frame we're tracking to. */
 	context->user.framenr += frame_delta;
 
-	destination_ibuf = BKE_movieclip_get_ibuf_flag(context->clip, &context->user,
-	                                               context->clip_flag, MOVIECLIP_CACHE_SKIP);
+	destination_ibuf = tracking_context_get_destination_ibuf(context);
 	if (!destination_ibuf)
 		return false;
 
+	/* Decode the next frame while this one is being tracked. */
+	if (context->prefetch_pool)
+		tracking_context_prefetch_next(context, frame_delta);
+
 	frame_width = destination_ibuf->x;
 	frame_height = destination_ibuf->y;
 
@@ -0,0 +1,50 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+#ifndef __BLI_EXPR_PYLIKE_EVAL_H__
+#define __BLI_EXPR_PYLIKE_EVAL_H__
+
+/** \file BLI_expr_pylike_eval.h
+ *  \ingroup bli
+ *  \brief Evaluator for a subset of Python expressions
+ *
+ * Handles float arithmetic, comparisons, boolean operators, conditional
+ * expressions and the common functions of the Python math module,
+ * without needing the Python interpreter.
+ */
+
+typedef struct ExprPyLike_Parsed ExprPyLike_Parsed;
+
+/* Parse the expression, resolving identifiers to indices in param_names.
+ * Always returns a non-NULL result, check it with BLI_expr_pylike_is_valid(). */
+ExprPyLike_Parsed *BLI_expr_pylike_parse(const char *expression, const char **param_names, int param_names_len);
+void BLI_expr_pylike_free(ExprPyLike_Parsed *expr);
+
+/* False if the expression uses syntax or names this evaluator doesn't support. */
+bool BLI_expr_pylike_is_valid(const ExprPyLike_Parsed *expr);
+
+/* Evaluate the expression with the given parameter values.
+ * Returns false on math errors (division by zero, domain errors, overflow)
+ * or non-finite results, leaving it to Python to report them.
+ * Thread-safe, the parsed expression is not modified. */
+bool BLI_expr_pylike_eval(const ExprPyLike_Parsed *expr, const double *param_values, int param_values_len,
+                          double *r_result);
+
+#endif  /* __BLI_EXPR_PYLIKE_EVAL_H__ */
@@ -100,6 +100,24 @@ ThreadMutex *BLI_task_pool_user_mutex(TaskPool *pool);
 /* number of tasks done, for stats, don't use this to make decisions */
 size_t BLI_task_pool_tasks_done(TaskPool *pool);
 
+/* Parallel for routines
+ *
+ * Run func for each iteration in [start, stop) on the shared task scheduler.
+ * The calling thread works too, so this can be nested in a running task
+ * without launching more threads. Iterations are handed out in chunks sized
+ * from the range and the number of threads.
+ *
+ * Each task gets its own copy of userdata_chunk, to use as scratch memory.
+ * With use_threading false, all iterations run in the calling thread. */
+
+typedef void (*TaskParallelRangeFunc)(void *userdata, void *userdata_chunk, int iter);
+
+void BLI_task_parallel_range_ex(int start, int stop, void *userdata,
+                                void *userdata_chunk, size_t userdata_chunk_size,
+                                TaskParallelRangeFunc func, bool use_threading);
+void BLI_task_parallel_range(int start, int stop, void *userdata,
+                             TaskParallelRangeFunc func, bool use_threading);
+
 #ifdef __cplusplus
 }
 #endif
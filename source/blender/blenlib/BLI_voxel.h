@@ -41,4 +41,15 @@ float BLI_voxel_sample_trilinear(float *data, const int res[3], const float co[3
 float BLI_voxel_sample_triquadratic(float *data, const int res[3], const float co[3]);
 float BLI_voxel_sample_tricubic(float *data, const int res[3], const float co[3], int bspline);
 
+/* sparse blocks: the grid is split in cubes of BLI_VOXEL_BLOCK_SIZE voxels per side,
+ * a mask with one byte per block tells which blocks hold non-zero values */
+#define BLI_VOXEL_BLOCK_SIZE 8
+
+int BLI_voxel_block_res(const int res[3], int r_block_res[3]);
+unsigned int BLI_voxel_block_mask(const float *data, const int res[3], unsigned char *r_mask);
+void BLI_voxel_block_mask_dilate(const int block_res[3], unsigned char *mask);
+void BLI_voxel_block_pack(const float *data, const int res[3], const unsigned char *mask, float *r_packed);
+void BLI_voxel_block_unpack(float *data, const int res[3], const unsigned char *mask, const float *packed);
+int BLI_voxel_block_is_empty(const unsigned char *mask, const int res[3], const float co[3]);
+
 #endif /* __BLI_VOXEL_H__ */
@@ -0,0 +1,1023 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/blenlib/intern/expr_pylike_eval.c
+ *  \ingroup bli
+ *
+ * Compiles simple Python-like expressions into a flat list of stack machine
+ * opcodes, so they can be evaluated quickly and from any thread.
+ *
+ * Supported syntax:
+ *
+ * - float and integer literals, True and False.
+ * - parameters (resolved to indices at parse time) and the constants pi and e.
+ * - + - * / // % ** arithmetic, with Python semantics for // and %.
+ * - < <= > >= == != comparisons, including chains like a < b < c.
+ * - and, or, not and the 'a if cond else b' conditional expression.
+ * - a subset of the Python math module functions, abs, min and max.
+ *
+ * Anything else makes the expression invalid. Evaluation is done in doubles,
+ * and any operation with a non-finite result aborts it, so that the caller can
+ * fall back to Python to get the exact Python behavior and error reporting.
+ *
+ * \note
+ *
+ * No globals - keep threadsafe.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_math_base.h"
+
+#include "BLI_expr_pylike_eval.h"  /* own include */
+
+/* Evaluation stack size, expressions needing more are rejected at parse time. */
+#define EXPR_MAX_STACK 64
+
+/* -------------------------------------------------------------------- */
+/* Internal Types */
+
+typedef enum eOpCode {
+	/* Double constant: (-> dval) */
+	OPCODE_CONST,
+	/* 1 argument function call: (a -> func1(a)) */
+	OPCODE_FUNC1,
+	/* 2 argument function call: (a b -> func2(a,b)) */
+	OPCODE_FUNC2,
+	/* Parameter access: (-> params[ival]) */
+	OPCODE_PARAMETER,
+	/* Minimum of multiple inputs: (a b c... -> min); ival = arg count */
+	OPCODE_MIN,
+	/* Maximum of multiple inputs: (a b c... -> max); ival = arg count */
+	OPCODE_MAX,
+	/* Jump (pc += jmp_offset) */
+	OPCODE_JMP,
+	/* Pop and jump if zero: (a -> ) */
+	OPCODE_JMP_ELSE,
+	/* Jump if nonzero, or pop: (a -> a JUMP) or (a -> ) */
+	OPCODE_JMP_OR,
+	/* Jump if zero, or pop: (a -> a JUMP) or (a -> ) */
+	OPCODE_JMP_AND,
+	/* For comparison chaining: (a b -> 0 JUMP) or (a b -> b) */
+	OPCODE_CMP_CHAIN,
+} eOpCode;
+
+BLI_INLINE double min_dd(double a, double b)
+{
+	return (a < b) ? a : b;
+}
+
+BLI_INLINE double max_dd(double a, double b)
+{
+	return (a > b) ? a : b;
+}
+
+typedef double (*UnaryOpFunc)(double);
+typedef double (*BinaryOpFunc)(double, double);
+
+typedef struct ExprOp {
+	eOpCode opcode;
+
+	int jmp_offset;
+
+	union {
+		int ival;
+		double dval;
+		void *ptr;
+		UnaryOpFunc func1;
+		BinaryOpFunc func2;
+	} arg;
+} ExprOp;
+
+struct ExprPyLike_Parsed {
+	int ops_count;
+	int max_stack;
+
+	ExprOp ops[1];
+};
+
+/* -------------------------------------------------------------------- */
+/* Public API */
+
+void BLI_expr_pylike_free(ExprPyLike_Parsed *expr)
+{
+	if (expr != NULL) {
+		MEM_freeN(expr);
+	}
+}
+
+bool BLI_expr_pylike_is_valid(const ExprPyLike_Parsed *expr)
+{
+	return expr != NULL && expr->ops_count > 0;
+}
+
+bool BLI_expr_pylike_eval(const ExprPyLike_Parsed *expr, const double *param_values, int param_values_len,
+                          double *r_result)
+{
+	double stack[EXPR_MAX_STACK];
+	int sp = 0, pc;
+
+	*r_result = 0.0;
+
+	if (!BLI_expr_pylike_is_valid(expr)) {
+		return false;
+	}
+
+	BLI_assert(expr->max_stack <= EXPR_MAX_STACK);
+
+	for (pc = 0; pc >= 0 && pc < expr->ops_count; pc++) {
+		const ExprOp *op = &expr->ops[pc];
+
+		switch (op->opcode) {
+			/* Arithmetic */
+			case OPCODE_CONST:
+				stack[sp++] = op->arg.dval;
+				break;
+			case OPCODE_PARAMETER:
+				if (op->arg.ival >= param_values_len) {
+					return false;
+				}
+				stack[sp++] = param_values[op->arg.ival];
+				break;
+			case OPCODE_FUNC1:
+				stack[sp - 1] = op->arg.func1(stack[sp - 1]);
+				if (!finite(stack[sp - 1])) {
+					return false;
+				}
+				break;
+			case OPCODE_FUNC2:
+				stack[sp - 2] = op->arg.func2(stack[sp - 2], stack[sp - 1]);
+				sp--;
+				if (!finite(stack[sp - 1])) {
+					return false;
+				}
+				break;
+			case OPCODE_MIN:
+			{
+				int i;
+				for (i = 1; i < op->arg.ival; i++, sp--) {
+					stack[sp - 2] = min_dd(stack[sp - 2], stack[sp - 1]);
+				}
+				break;
+			}
+			case OPCODE_MAX:
+			{
+				int i;
+				for (i = 1; i < op->arg.ival; i++, sp--) {
+					stack[sp - 2] = max_dd(stack[sp - 2], stack[sp - 1]);
+				}
+				break;
+			}
+
+			/* Jumps */
+			case OPCODE_JMP:
+				pc += op->jmp_offset - 1;
+				break;
+			case OPCODE_JMP_ELSE:
+				if (!stack[--sp]) {
+					pc += op->jmp_offset - 1;
+				}
+				break;
+			case OPCODE_JMP_OR:
+			case OPCODE_JMP_AND:
+				if (!stack[sp - 1] == !(op->opcode == OPCODE_JMP_OR)) {
+					pc += op->jmp_offset - 1;
+				}
+				else {
+					sp--;
+				}
+				break;
+
+			/* For chaining comparisons, i.e. "a < b < c" as "a < b and b < c" */
+			case OPCODE_CMP_CHAIN:
+				if (op->arg.func2(stack[sp - 2], stack[sp - 1]) == 0.0) {
+					stack[sp - 2] = 0.0;
+					sp--;
+					pc += op->jmp_offset - 1;
+				}
+				else {
+					stack[sp - 2] = stack[sp - 1];
+					sp--;
+				}
+				break;
+
+			default:
+				BLI_assert(!"unknown expression opcode");
+				return false;
+		}
+	}
+
+	if (sp != 1 || pc != expr->ops_count) {
+		BLI_assert(!"stack machine is out of balance");
+		return false;
+	}
+
+	*r_result = stack[0];
+	return finite(*r_result) != 0;
+}
+
+/* -------------------------------------------------------------------- */
+/* Builtin Operations */
+
+static double op_negate(double arg)
+{
+	return -arg;
+}
+
+static double op_not(double a)
+{
+	return a ? 0.0 : 1.0;
+}
+
+static double op_add(double a, double b)
+{
+	return a + b;
+}
+
+static double op_sub(double a, double b)
+{
+	return a - b;
+}
+
+static double op_mul(double a, double b)
+{
+	return a * b;
+}
+
+static double op_div(double a, double b)
+{
+	return a / b;
+}
+
+/* Python float modulo: the result has the sign of the divisor. */
+static double op_mod(double a, double b)
+{
+	double mod = fmod(a, b);
+
+	if (mod) {
+		if ((b < 0) != (mod < 0)) {
+			mod += b;
+		}
+	}
+	else {
+		mod = copysign(0.0, b);
+	}
+
+	return mod;
+}
+
+/* Python float floor division, consistent with op_mod(). */
+static double op_floordiv(double a, double b)
+{
+	double mod = fmod(a, b);
+	double div = (a - mod) / b;
+	double floordiv;
+
+	if (mod) {
+		if ((b < 0) != (mod < 0)) {
+			div -= 1.0;
+		}
+	}
+
+	if (div) {
+		floordiv = floor(div);
+		if (div - floordiv > 0.5) {
+			floordiv += 1.0;
+		}
+	}
+	else {
+		floordiv = copysign(0.0, a / b);
+	}
+
+	return floordiv;
+}
+
+static double op_pow(double a, double b)
+{
+	/* Python raises ZeroDivisionError instead of returning inf. */
+	if (a == 0.0 && b < 0.0) {
+		return a / 0.0;
+	}
+	return pow(a, b);
+}
+
+static double op_log2(double a, double b)
+{
+	/* Python raises a domain error for these bases instead of returning a value,
+	 * log(x, 0) would otherwise give -0.0. */
+	if (b <= 0.0 || b == 1.0) {
+		return NAN_FLT;
+	}
+	return log(a) / log(b);
+}
+
+static double op_lt(double a, double b)
+{
+	return a < b ? 1.0 : 0.0;
+}
+
+static double op_le(double a, double b)
+{
+	return a <= b ? 1.0 : 0.0;
+}
+
+static double op_gt(double a, double b)
+{
+	return a > b ? 1.0 : 0.0;
+}
+
+static double op_ge(double a, double b)
+{
+	return a >= b ? 1.0 : 0.0;
+}
+
+static double op_eq(double a, double b)
+{
+	return a == b ? 1.0 : 0.0;
+}
+
+static double op_ne(double a, double b)
+{
+	return a != b ? 1.0 : 0.0;
+}
+
+static double op_radians(double arg)
+{
+	return arg * M_PI / 180.0;
+}
+
+static double op_degrees(double arg)
+{
+	return arg * 180.0 / M_PI;
+}
+
+typedef struct BuiltinConstDef {
+	const char *name;
+	double value;
+} BuiltinConstDef;
+
+static BuiltinConstDef builtin_consts[] = {
+	{"pi", M_PI},
+	{"e", M_E},
+	{"True", 1.0},
+	{"False", 0.0},
+	{NULL, 0.0}
+};
+
+typedef struct BuiltinOpDef {
+	const char *name;
+	eOpCode op;
+	void *funcptr;
+} BuiltinOpDef;
+
+static BuiltinOpDef builtin_ops[] = {
+	{"radians", OPCODE_FUNC1, op_radians},
+	{"degrees", OPCODE_FUNC1, op_degrees},
+	{"abs", OPCODE_FUNC1, fabs},
+	{"fabs", OPCODE_FUNC1, fabs},
+	{"floor", OPCODE_FUNC1, floor},
+	{"ceil", OPCODE_FUNC1, ceil},
+	{"sqrt", OPCODE_FUNC1, sqrt},
+	{"sin", OPCODE_FUNC1, sin},
+	{"cos", OPCODE_FUNC1, cos},
+	{"tan", OPCODE_FUNC1, tan},
+	{"asin", OPCODE_FUNC1, asin},
+	{"acos", OPCODE_FUNC1, acos},
+	{"atan", OPCODE_FUNC1, atan},
+	{"sinh", OPCODE_FUNC1, sinh},
+	{"cosh", OPCODE_FUNC1, cosh},
+	{"tanh", OPCODE_FUNC1, tanh},
+	{"exp", OPCODE_FUNC1, exp},
+	{"log", OPCODE_FUNC1, log},       /* log(x, base) is handled by the parser */
+	{"log10", OPCODE_FUNC1, log10},
+	{"atan2", OPCODE_FUNC2, atan2},
+	{"fmod", OPCODE_FUNC2, fmod},
+	{"hypot", OPCODE_FUNC2, hypot},
+	{"pow", OPCODE_FUNC2, op_pow},
+	{"min", OPCODE_MIN, NULL},
+	{"max", OPCODE_MAX, NULL},
+	{NULL, OPCODE_CONST, NULL}
+};
+
+/* -------------------------------------------------------------------- */
+/* Expression Parser State */
+
+#define MAKE_CHAR2(a, b) (((a) << 8) | (b))
+
+#define CHECK_ERROR(condition) if (!(condition)) { return false; } ((void)0)
+
+/* For simplicity simple token types are represented by their own character;
+ * these are special identifiers for multi-character tokens. */
+#define TOKEN_ID         MAKE_CHAR2('I', 'D')
+#define TOKEN_NUMBER     MAKE_CHAR2('0', '0')
+#define TOKEN_GE         MAKE_CHAR2('>', '=')
+#define TOKEN_LE         MAKE_CHAR2('<', '=')
+#define TOKEN_NE         MAKE_CHAR2('!', '=')
+#define TOKEN_EQ         MAKE_CHAR2('=', '=')
+#define TOKEN_POW        MAKE_CHAR2('*', '*')
+#define TOKEN_FLOORDIV   MAKE_CHAR2('/', '/')
+#define TOKEN_AND        MAKE_CHAR2('A', 'N')
+#define TOKEN_OR         MAKE_CHAR2('O', 'R')
+#define TOKEN_NOT        MAKE_CHAR2('N', 'O')
+#define TOKEN_IF         MAKE_CHAR2('I', 'F')
+#define TOKEN_ELSE       MAKE_CHAR2('E', 'L')
+
+static const char *token_eq_characters = "!=><";
+static const char *token_characters = "~`!@#$%^&*+-=/\\?:;<>(){}[]|.,\"'";
+
+typedef struct KeywordTokenDef {
+	const char *name;
+	short token;
+} KeywordTokenDef;
+
+static KeywordTokenDef keyword_list[] = {
+	{"and", TOKEN_AND},
+	{"or", TOKEN_OR},
+	{"not", TOKEN_NOT},
+	{"if", TOKEN_IF},
+	{"else", TOKEN_ELSE},
+	{NULL, TOKEN_ID}
+};
+
+typedef struct ExprParseState {
+	int param_names_len;
+	const char **param_names;
+
+	/* Original expression */
+	const char *expr;
+	const char *cur;
+
+	/* Current token */
+	short token;
+	char *tokenbuf;
+	double tokenval;
+
+	/* Opcode buffer */
+	int ops_count, max_ops;
+	ExprOp *ops;
+
+	/* Stack space requirement tracking */
+	int stack_ptr, max_stack;
+} ExprParseState;
+
+/* Add one operation and track stack usage. */
+static ExprOp *parse_add_op(ExprParseState *state, eOpCode code, int stack_delta)
+{
+	ExprOp *op;
+
+	/* track evaluation stack depth */
+	state->stack_ptr += stack_delta;
+	state->max_stack = max_ii(state->max_stack, state->stack_ptr);
+
+	/* allocate the new instruction */
+	if (state->ops_count >= state->max_ops) {
+		state->max_ops = power_of_2_max_i(state->ops_count + 1);
+		state->ops = MEM_reallocN(state->ops, state->max_ops * sizeof(ExprOp));
+	}
+
+	op = &state->ops[state->ops_count++];
+	memset(op, 0, sizeof(ExprOp));
+	op->opcode = code;
+	return op;
+}
+
+/* Add one jump operation and return an index for parse_set_jump. */
+static int parse_add_jump(ExprParseState *state, eOpCode code)
+{
+	parse_add_op(state, code, -1);
+	return state->ops_count - 1;
+}
+
+/* Set the jump offset in a previously added jump operation. */
+static void parse_set_jump(ExprParseState *state, int jump)
+{
+	state->ops[jump].jmp_offset = state->ops_count - jump;
+}
+
+/* Move the ops in [start, end) before the ops in [end, state->ops_count),
+ * jump offsets are relative so both blocks stay valid. */
+static void parse_move_ops_back(ExprParseState *state, int start, int end)
+{
+	int len_a = end - start, len_b = state->ops_count - end;
+	ExprOp *tmp;
+
+	if (len_a == 0 || len_b == 0) {
+		return;
+	}
+
+	tmp = MEM_mallocN(len_a * sizeof(ExprOp), __func__);
+	memcpy(tmp, state->ops + start, len_a * sizeof(ExprOp));
+	memmove(state->ops + start, state->ops + end, len_b * sizeof(ExprOp));
+	memcpy(state->ops + start + len_b, tmp, len_a * sizeof(ExprOp));
+	MEM_freeN(tmp);
+}
+
+/* Insert an empty operation at the given position. */
+static void parse_insert_op(ExprParseState *state, int index, eOpCode code)
+{
+	int tail = state->ops_count - index;
+
+	parse_add_op(state, code, 0);
+	memmove(state->ops + index + 1, state->ops + index, tail * sizeof(ExprOp));
+	memset(&state->ops[index], 0, sizeof(ExprOp));
+	state->ops[index].opcode = code;
+}
+
+/* -------------------------------------------------------------------- */
+/* Lexer */
+
+static bool parse_next_token(ExprParseState *state)
+{
+	/* skip whitespace */
+	while (isspace((unsigned char)*state->cur)) {
+		state->cur++;
+	}
+
+	/* end of string */
+	if (*state->cur == 0) {
+		state->token = 0;
+		return true;
+	}
+
+	/* floating point numbers */
+	if (isdigit((unsigned char)*state->cur) || (state->cur[0] == '.' && isdigit((unsigned char)state->cur[1]))) {
+		const char *start = state->cur;
+		bool is_int = true;
+		size_t len;
+
+		while (isdigit((unsigned char)*state->cur)) {
+			state->cur++;
+		}
+		if (*state->cur == '.') {
+			is_int = false;
+			state->cur++;
+			while (isdigit((unsigned char)*state->cur)) {
+				state->cur++;
+			}
+		}
+		if (ELEM(*state->cur, 'e', 'E')) {
+			const char *exp = state->cur + 1;
+			if (ELEM(*exp, '+', '-')) {
+				exp++;
+			}
+			CHECK_ERROR(isdigit((unsigned char)*exp));
+			is_int = false;
+			state->cur = exp;
+			while (isdigit((unsigned char)*state->cur)) {
+				state->cur++;
+			}
+		}
+
+		/* reject suffixes, hex, digit separators and the like */
+		CHECK_ERROR(!(isalnum((unsigned char)*state->cur) || ELEM(*state->cur, '_', '.')));
+
+		len = (size_t)(state->cur - start);
+
+		/* Python doesn't allow integers with leading zeros, except for zero itself */
+		if (is_int && start[0] == '0') {
+			size_t i;
+			for (i = 1; i < len; i++) {
+				CHECK_ERROR(start[i] == '0');
+			}
+		}
+
+		memcpy(state->tokenbuf, start, len);
+		state->tokenbuf[len] = 0;
+
+		state->token = TOKEN_NUMBER;
+		state->tokenval = strtod(state->tokenbuf, NULL);
+		return true;
+	}
+
+	/* ?= tokens */
+	if (state->cur[1] == '=' && strchr(token_eq_characters, state->cur[0])) {
+		state->token = MAKE_CHAR2(state->cur[0], state->cur[1]);
+		state->cur += 2;
+		return true;
+	}
+
+	/* special characters (single character tokens) */
+	if (strchr(token_characters, *state->cur)) {
+		/* ** and // operators */
+		if (ELEM(state->cur[0], '*', '/') && state->cur[1] == state->cur[0]) {
+			state->token = MAKE_CHAR2(state->cur[0], state->cur[1]);
+			state->cur += 2;
+			return true;
+		}
+
+		state->token = *state->cur++;
+		return true;
+	}
+
+	/* identifiers, non-ASCII ones are left to Python */
+	if (isalpha((unsigned char)*state->cur) || *state->cur == '_') {
+		char *out = state->tokenbuf;
+		int i;
+
+		while (isalnum((unsigned char)*state->cur) || *state->cur == '_') {
+			*out++ = *state->cur++;
+		}
+
+		*out = 0;
+
+		for (i = 0; keyword_list[i].name; i++) {
+			if (STREQ(state->tokenbuf, keyword_list[i].name)) {
+				state->token = keyword_list[i].token;
+				return true;
+			}
+		}
+
+		state->token = TOKEN_ID;
+		return true;
+	}
+
+	return false;
+}
+
+/* -------------------------------------------------------------------- */
+/* Recursive Descent Parser */
+
+static bool parse_expr(ExprParseState *state);
+
+static int parse_function_args(ExprParseState *state)
+{
+	int arg_count = 0;
+
+	if (!parse_next_token(state) || state->token != '(' || !parse_next_token(state)) {
+		return -1;
+	}
+
+	if (state->token == ')') {
+		return parse_next_token(state) ? arg_count : -1;
+	}
+
+	for (;;) {
+		if (!parse_expr(state)) {
+			return -1;
+		}
+
+		arg_count++;
+
+		if (state->token == ')') {
+			return parse_next_token(state) ? arg_count : -1;
+		}
+		if (state->token != ',' || !parse_next_token(state)) {
+			return -1;
+		}
+	}
+}
+
+static bool parse_unary(ExprParseState *state);
+
+static bool parse_name(ExprParseState *state)
+{
+	const char *name = state->tokenbuf;
+	int i;
+
+	/* Parameters shadow everything else, like locals in Python. */
+	for (i = 0; i < state->param_names_len; i++) {
+		if (STREQ(name, state->param_names[i])) {
+			/* calling a float would be a Python error */
+			CHECK_ERROR(parse_next_token(state) && state->token != '(');
+			parse_add_op(state, OPCODE_PARAMETER, 1)->arg.ival = i;
+			return true;
+		}
+	}
+
+	for (i = 0; builtin_consts[i].name; i++) {
+		if (STREQ(name, builtin_consts[i].name)) {
+			CHECK_ERROR(parse_next_token(state) && state->token != '(');
+			parse_add_op(state, OPCODE_CONST, 1)->arg.dval = builtin_consts[i].value;
+			return true;
+		}
+	}
+
+	for (i = 0; builtin_ops[i].name; i++) {
+		if (STREQ(name, builtin_ops[i].name)) {
+			BuiltinOpDef *def = &builtin_ops[i];
+			int args = parse_function_args(state);
+
+			switch (def->op) {
+				case OPCODE_FUNC1:
+					if (args == 2 && def->funcptr == (void *)log) {
+						parse_add_op(state, OPCODE_FUNC2, -1)->arg.func2 = op_log2;
+						return true;
+					}
+					CHECK_ERROR(args == 1);
+					parse_add_op(state, OPCODE_FUNC1, 0)->arg.ptr = def->funcptr;
+					return true;
+
+				case OPCODE_FUNC2:
+					CHECK_ERROR(args == 2);
+					parse_add_op(state, OPCODE_FUNC2, -1)->arg.ptr = def->funcptr;
+					return true;
+
+				case OPCODE_MIN:
+				case OPCODE_MAX:
+					/* a single argument would have to be an iterable */
+					CHECK_ERROR(args > 1);
+					parse_add_op(state, def->op, 1 - args)->arg.ival = args;
+					return true;
+
+				default:
+					BLI_assert(false);
+					return false;
+			}
+		}
+	}
+
+	return false;
+}
+
+static bool parse_primary(ExprParseState *state)
+{
+	switch (state->token) {
+		/* Parenthesis */
+		case '(':
+			return (parse_next_token(state) &&
+			        parse_expr(state) &&
+			        state->token == ')' &&
+			        parse_next_token(state));
+
+		/* Number literal */
+		case TOKEN_NUMBER:
+			parse_add_op(state, OPCODE_CONST, 1)->arg.dval = state->tokenval;
+			return parse_next_token(state);
+
+		/* Parameter, constant or function call */
+		case TOKEN_ID:
+			return parse_name(state);
+
+		default:
+			return false;
+	}
+}
+
+static bool parse_power(ExprParseState *state)
+{
+	CHECK_ERROR(parse_primary(state));
+
+	/* ** is right-associative and binds tighter than a unary minus on its left */
+	if (state->token == TOKEN_POW) {
+		CHECK_ERROR(parse_next_token(state) && parse_unary(state));
+		parse_add_op(state, OPCODE_FUNC2, -1)->arg.func2 = op_pow;
+	}
+
+	return true;
+}
+
+static bool parse_unary(ExprParseState *state)
+{
+	switch (state->token) {
+		case '+':
+			return parse_next_token(state) && parse_unary(state);
+
+		case '-':
+			CHECK_ERROR(parse_next_token(state) && parse_unary(state));
+			parse_add_op(state, OPCODE_FUNC1, 0)->arg.func1 = op_negate;
+			return true;
+
+		default:
+			return parse_power(state);
+	}
+}
+
+static BinaryOpFunc parse_get_mul_func(short token)
+{
+	switch (token) {
+		case '*':
+			return op_mul;
+		case '/':
+			return op_div;
+		case '%':
+			return op_mod;
+		case TOKEN_FLOORDIV:
+			return op_floordiv;
+		default:
+			return NULL;
+	}
+}
+
+static bool parse_mul(ExprParseState *state)
+{
+	BinaryOpFunc func;
+
+	CHECK_ERROR(parse_unary(state));
+
+	while ((func = parse_get_mul_func(state->token))) {
+		CHECK_ERROR(parse_next_token(state) && parse_unary(state));
+		parse_add_op(state, OPCODE_FUNC2, -1)->arg.func2 = func;
+	}
+
+	return true;
+}
+
+static bool parse_add(ExprParseState *state)
+{
+	CHECK_ERROR(parse_mul(state));
+
+	while (ELEM(state->token, '+', '-')) {
+		BinaryOpFunc func = (state->token == '+') ? op_add : op_sub;
+
+		CHECK_ERROR(parse_next_token(state) && parse_mul(state));
+		parse_add_op(state, OPCODE_FUNC2, -1)->arg.func2 = func;
+	}
+
+	return true;
+}
+
+static BinaryOpFunc parse_get_cmp_func(short token)
+{
+	switch (token) {
+		case TOKEN_EQ:
+			return op_eq;
+		case TOKEN_NE:
+			return op_ne;
+		case '>':
+			return op_gt;
+		case TOKEN_GE:
+			return op_ge;
+		case '<':
+			return op_lt;
+		case TOKEN_LE:
+			return op_le;
+		default:
+			return NULL;
+	}
+}
+
+static bool parse_cmp_chain(ExprParseState *state, BinaryOpFunc cur_func)
+{
+	BinaryOpFunc next_func = parse_get_cmp_func(state->token);
+
+	if (next_func) {
+		ExprOp *op = parse_add_op(state, OPCODE_CMP_CHAIN, -1);
+		int jump = state->ops_count - 1;
+
+		op->arg.func2 = cur_func;
+
+		CHECK_ERROR(parse_next_token(state) && parse_add(state));
+		CHECK_ERROR(parse_cmp_chain(state, next_func));
+
+		parse_set_jump(state, jump);
+	}
+	else {
+		parse_add_op(state, OPCODE_FUNC2, -1)->arg.func2 = cur_func;
+	}
+
+	return true;
+}
+
+static bool parse_cmp(ExprParseState *state)
+{
+	BinaryOpFunc func;
+
+	CHECK_ERROR(parse_add(state));
+
+	if ((func = parse_get_cmp_func(state->token))) {
+		CHECK_ERROR(parse_next_token(state) && parse_add(state));
+
+		return parse_cmp_chain(state, func);
+	}
+
+	return true;
+}
+
+static bool parse_not(ExprParseState *state)
+{
+	if (state->token == TOKEN_NOT) {
+		CHECK_ERROR(parse_next_token(state) && parse_not(state));
+		parse_add_op(state, OPCODE_FUNC1, 0)->arg.func1 = op_not;
+		return true;
+	}
+
+	return parse_cmp(state);
+}
+
+static bool parse_and(ExprParseState *state)
+{
+	CHECK_ERROR(parse_not(state));
+
+	if (state->token == TOKEN_AND) {
+		int jump = parse_add_jump(state, OPCODE_JMP_AND);
+
+		CHECK_ERROR(parse_next_token(state) && parse_and(state));
+
+		parse_set_jump(state, jump);
+	}
+
+	return true;
+}
+
+static bool parse_or(ExprParseState *state)
+{
+	CHECK_ERROR(parse_and(state));
+
+	if (state->token == TOKEN_OR) {
+		int jump = parse_add_jump(state, OPCODE_JMP_OR);
+
+		CHECK_ERROR(parse_next_token(state) && parse_or(state));
+
+		parse_set_jump(state, jump);
+	}
+
+	return true;
+}
+
+static bool parse_expr(ExprParseState *state)
+{
+	int start = state->ops_count, cond_start, jmp_else, jmp_end;
+
+	CHECK_ERROR(parse_or(state));
+
+	if (state->token == TOKEN_IF) {
+		/* Ternary IF expression in python requires swapping the
+		 * main body with condition, so stash the body opcodes. */
+		cond_start = state->ops_count;
+
+		CHECK_ERROR(parse_next_token(state) && parse_or(state));
+
+		/* Evaluate the condition first: COND JMP_ELSE BODY JMP ELSE_BODY */
+		parse_move_ops_back(state, start, cond_start);
+		jmp_else = start + (state->ops_count - cond_start);
+		parse_insert_op(state, jmp_else, OPCODE_JMP_ELSE);
+		state->stack_ptr--;
+
+		CHECK_ERROR(state->token == TOKEN_ELSE);
+
+		jmp_end = parse_add_jump(state, OPCODE_JMP);
+		state->ops[jmp_else].jmp_offset = state->ops_count - jmp_else;
+
+		CHECK_ERROR(parse_next_token(state) && parse_expr(state));
+
+		parse_set_jump(state, jmp_end);
+	}
+
+	return true;
+}
+
+/* -------------------------------------------------------------------- */
+/* Main Parsing Function */
+
+ExprPyLike_Parsed *BLI_expr_pylike_parse(const char *expression, const char **param_names, int param_names_len)
+{
+	ExprParseState state = {0};
+	ExprPyLike_Parsed *expr;
+	size_t len = strlen(expression);
+	bool ok;
+
+	/* Prepare the parser state */
+	state.param_names_len = param_names_len;
+	state.param_names = param_names;
+
+	state.expr = state.cur = expression;
+	state.tokenbuf = MEM_mallocN(len + 1, __func__);
+
+	state.max_ops = 16;
+	state.ops = MEM_mallocN(state.max_ops * sizeof(ExprOp), __func__);
+
+	/* Parse the expression */
+	ok = parse_next_token(&state) && parse_expr(&state) && state.token == 0 &&
+	     state.max_stack <= EXPR_MAX_STACK;
+
+	if (ok) {
+		BLI_assert(state.stack_ptr == 1);
+
+		expr = MEM_mallocN(sizeof(ExprPyLike_Parsed) + state.ops_count * sizeof(ExprOp), "ExprPyLike_Parsed");
+		expr->ops_count = state.ops_count;
+		expr->max_stack = state.max_stack;
+
+		memcpy(expr->ops, state.ops, state.ops_count * sizeof(ExprOp));
+	}
+	else {
+		/* Always return a non-NULL object so that parse failure can be cached. */
+		expr = MEM_callocN(sizeof(ExprPyLike_Parsed), "ExprPyLike_Parsed(empty)");
+	}
+
+	MEM_freeN(state.tokenbuf);
+	MEM_freeN(state.ops);
+	return expr;
+}
@@ -25,10 +25,12 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "MEM_guardedalloc.h"
 
 #include "BLI_listbase.h"
+#include "BLI_math_base.h"
 #include "BLI_task.h"
 #include "BLI_threads.h"
 
@@ -428,3 +430,114 @@ size_t BLI_task_pool_tasks_done(TaskPool *pool)
 	return pool->done;
 }
 
+/* Parallel Range */
+
+/* each thread gets this many chunks of the range on average, more helps
+ * balancing iterations of uneven cost, less keeps locking down */
+#define PARALLEL_RANGE_CHUNKS_PER_THREAD 8
+
+typedef struct ParallelRangeState {
+	int stop;
+	void *userdata;
+	TaskParallelRangeFunc func;
+
+	int iter;
+	int chunk_size;
+	SpinLock lock;
+} ParallelRangeState;
+
+BLI_INLINE bool parallel_range_next_iter_get(ParallelRangeState *state, int *r_iter, int *r_count)
+{
+	bool result = false;
+
+	BLI_spin_lock(&state->lock);
+	if (state->iter < state->stop) {
+		*r_count = min_ii(state->chunk_size, state->stop - state->iter);
+		*r_iter = state->iter;
+		state->iter += *r_count;
+		result = true;
+	}
+	BLI_spin_unlock(&state->lock);
+
+	return result;
+}
+
+static void parallel_range_func(TaskPool *pool, void *userdata_chunk, int UNUSED(threadid))
+{
+	ParallelRangeState *state = BLI_task_pool_userdata(pool);
+	int iter, count, i;
+
+	while (parallel_range_next_iter_get(state, &iter, &count)) {
+		for (i = 0; i < count; i++)
+			state->func(state->userdata, userdata_chunk, iter + i);
+	}
+}
+
+void BLI_task_parallel_range_ex(int start, int stop, void *userdata,
+                                void *userdata_chunk, size_t userdata_chunk_size,
+                                TaskParallelRangeFunc func, bool use_threading)
+{
+	TaskScheduler *task_scheduler;
+	TaskPool *task_pool;
+	ParallelRangeState state;
+	char *chunks = NULL;
+	int i, num_threads, num_tasks;
+
+	if (start >= stop)
+		return;
+
+	/* single threaded, or not worth the overhead */
+	if (!use_threading || stop - start == 1) {
+		for (i = start; i < stop; i++)
+			func(userdata, userdata_chunk, i);
+		return;
+	}
+
+	task_scheduler = BLI_task_scheduler_get();
+	num_threads = BLI_task_scheduler_num_threads(task_scheduler);
+	num_tasks = min_ii(num_threads, stop - start);
+
+	if (num_tasks == 1) {
+		for (i = start; i < stop; i++)
+			func(userdata, userdata_chunk, i);
+		return;
+	}
+
+	task_pool = BLI_task_pool_create(task_scheduler, &state);
+
+	state.stop = stop;
+	state.userdata = userdata;
+	state.func = func;
+	state.iter = start;
+	state.chunk_size = max_ii(1, (stop - start) / (num_threads * PARALLEL_RANGE_CHUNKS_PER_THREAD));
+	BLI_spin_init(&state.lock);
+
+	/* copies of the chunk are made here, not in the threads */
+	if (userdata_chunk)
+		chunks = MEM_mallocN(userdata_chunk_size * num_tasks, "BLI_task_parallel_range chunks");
+
+	for (i = 0; i < num_tasks; i++) {
+		void *chunk = NULL;
+
+		if (chunks) {
+			chunk = chunks + userdata_chunk_size * i;
+			memcpy(chunk, userdata_chunk, userdata_chunk_size);
+		}
+
+		BLI_task_pool_push(task_pool, parallel_range_func, chunk, false, TASK_PRIORITY_HIGH);
+	}
+
+	BLI_task_pool_work_and_wait(task_pool);
+	BLI_task_pool_free(task_pool);
+
+	BLI_spin_end(&state.lock);
+
+	if (chunks)
+		MEM_freeN(chunks);
+}
+
+void BLI_task_parallel_range(int start, int stop, void *userdata,
+                             TaskParallelRangeFunc func, bool use_threading)
+{
+	BLI_task_parallel_range_ex(start, stop, userdata, NULL, 0, func, use_threading);
+}
@@ -122,6 +122,9 @@ static pthread_mutex_t _nodes_lock = PTHREAD_MUTEX_INITIALIZER;
 static pthread_mutex_t _movieclip_lock = PTHREAD_MUTEX_INITIALIZER;
 static pthread_mutex_t _colormanage_lock = PTHREAD_MUTEX_INITIALIZER;
 static pthread_mutex_t _fftw_lock = PTHREAD_MUTEX_INITIALIZER;
+/* threads are also started from worker threads (nested task pools), the malloc
+ * lock callback is only changed together with the level, under this lock */
+static pthread_mutex_t _thread_levels_lock = PTHREAD_MUTEX_INITIALIZER;
 static pthread_t mainid;
 static int thread_levels = 0;  /* threads can be invoked inside threads */
 static int num_threads_override = 0;
@@ -198,6 +201,7 @@ void BLI_init_threads(ListBase *threadbase, void *(*do_thread)(void *), int tot)
 		}
 	}
 	
+	pthread_mutex_lock(&_thread_levels_lock);
 	if (thread_levels == 0) {
 		MEM_set_lock_callback(BLI_lock_malloc_thread, BLI_unlock_malloc_thread);
 
@@ -210,6 +214,7 @@ void BLI_init_threads(ListBase *threadbase, void *(*do_thread)(void *), int tot)
 	}
 
 	thread_levels++;
+	pthread_mutex_unlock(&_thread_levels_lock);
 }
 
 /* amount of available threads */
@@ -328,9 +333,11 @@ void BLI_end_threads(ListBase *threadbase)
 		BLI_freelistN(threadbase);
 	}
 
+	pthread_mutex_lock(&_thread_levels_lock);
 	thread_levels--;
 	if (thread_levels == 0)
 		MEM_set_lock_callback(NULL, NULL);
+	pthread_mutex_unlock(&_thread_levels_lock);
 }
 
 /* System Information */
@@ -797,10 +804,12 @@ void BLI_begin_threaded_malloc(void)
 	/* Used for debug only */
 	/* BLI_assert(thread_levels >= 0); */
 
+	pthread_mutex_lock(&_thread_levels_lock);
 	if (thread_levels == 0) {
 		MEM_set_lock_callback(BLI_lock_malloc_thread, BLI_unlock_malloc_thread);
 	}
 	thread_levels++;
+	pthread_mutex_unlock(&_thread_levels_lock);
 }
 
 void BLI_end_threaded_malloc(void)
@@ -808,8 +817,10 @@ void BLI_end_threaded_malloc(void)
 	/* Used for debug only */
 	/* BLI_assert(thread_levels >= 0); */
 
+	pthread_mutex_lock(&_thread_levels_lock);
 	thread_levels--;
 	if (thread_levels == 0)
 		MEM_set_lock_callback(NULL, NULL);
+	pthread_mutex_unlock(&_thread_levels_lock);
 }
 
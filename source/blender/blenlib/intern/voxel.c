@@ -30,7 +30,12 @@
  */
 
 
+#include <string.h>
+
+#include "MEM_guardedalloc.h"
+
 #include "BLI_voxel.h"
+#include "BLI_math_base.h"
 #include "BLI_utildefines.h"
 
 
@@ -198,3 +203,165 @@ float BLI_voxel_sample_tricubic(float *data, const int res[3], const float co[3]
 	}
 	return 0.f;
 }
+
+/* *** sparse blocks *** */
+
+/* visit the voxels of block (bx, by, bz), clipped to the grid */
+#define BLOCK_ITER_BEGIN(res, bx, by, bz, index) \
+	{ \
+		const int _x0 = (bx) * BLI_VOXEL_BLOCK_SIZE, _x1 = min_ii(_x0 + BLI_VOXEL_BLOCK_SIZE, (res)[0]); \
+		const int _y0 = (by) * BLI_VOXEL_BLOCK_SIZE, _y1 = min_ii(_y0 + BLI_VOXEL_BLOCK_SIZE, (res)[1]); \
+		const int _z0 = (bz) * BLI_VOXEL_BLOCK_SIZE, _z1 = min_ii(_z0 + BLI_VOXEL_BLOCK_SIZE, (res)[2]); \
+		int _x, _y, _z; \
+		for (_z = _z0; _z < _z1; _z++) { \
+			for (_y = _y0; _y < _y1; _y++) { \
+				size_t index = (size_t)BLI_VOXEL_INDEX(_x0, _y, _z, res); \
+				for (_x = _x0; _x < _x1; _x++, index++)
+
+#define BLOCK_ITER_END \
+			} \
+		} \
+	} (void)0
+
+/* returns the total number of blocks */
+int BLI_voxel_block_res(const int res[3], int r_block_res[3])
+{
+	r_block_res[0] = (res[0] + BLI_VOXEL_BLOCK_SIZE - 1) / BLI_VOXEL_BLOCK_SIZE;
+	r_block_res[1] = (res[1] + BLI_VOXEL_BLOCK_SIZE - 1) / BLI_VOXEL_BLOCK_SIZE;
+	r_block_res[2] = (res[2] + BLI_VOXEL_BLOCK_SIZE - 1) / BLI_VOXEL_BLOCK_SIZE;
+
+	return r_block_res[0] * r_block_res[1] * r_block_res[2];
+}
+
+/* fill r_mask, one byte per block, and return the number of voxels in the occupied blocks */
+unsigned int BLI_voxel_block_mask(const float *data, const int res[3], unsigned char *r_mask)
+{
+	int block_res[3];
+	int bx, by, bz, b = 0;
+	unsigned int totvoxel = 0;
+
+	BLI_voxel_block_res(res, block_res);
+
+	for (bz = 0; bz < block_res[2]; bz++) {
+		for (by = 0; by < block_res[1]; by++) {
+			for (bx = 0; bx < block_res[0]; bx++, b++) {
+				unsigned int blockvoxel = 0;
+				bool occupied = false;
+
+				BLOCK_ITER_BEGIN(res, bx, by, bz, index)
+				{
+					if (data[index] != 0.0f)
+						occupied = true;
+					blockvoxel++;
+				}
+				BLOCK_ITER_END;
+
+				r_mask[b] = occupied;
+				if (occupied)
+					totvoxel += blockvoxel;
+			}
+		}
+	}
+
+	return totvoxel;
+}
+
+/* also mark the neighbors of occupied blocks, so that samples
+ * reaching into the next block are not skipped */
+void BLI_voxel_block_mask_dilate(const int block_res[3], unsigned char *mask)
+{
+	const int totblock = block_res[0] * block_res[1] * block_res[2];
+	unsigned char *orig = MEM_mallocN(totblock, "voxel block mask");
+	int bx, by, bz, b = 0;
+
+	memcpy(orig, mask, totblock);
+
+	for (bz = 0; bz < block_res[2]; bz++) {
+		for (by = 0; by < block_res[1]; by++) {
+			for (bx = 0; bx < block_res[0]; bx++, b++) {
+				int x, y, z;
+
+				if (orig[b])
+					continue;
+
+				for (z = max_ii(bz - 1, 0); z <= min_ii(bz + 1, block_res[2] - 1) && !mask[b]; z++)
+					for (y = max_ii(by - 1, 0); y <= min_ii(by + 1, block_res[1] - 1) && !mask[b]; y++)
+						for (x = max_ii(bx - 1, 0); x <= min_ii(bx + 1, block_res[0] - 1); x++)
+							if (orig[BLI_VOXEL_INDEX(x, y, z, block_res)]) {
+								mask[b] = 1;
+								break;
+							}
+			}
+		}
+	}
+
+	MEM_freeN(orig);
+}
+
+/* copy the voxels of the occupied blocks to r_packed, one block after the other */
+void BLI_voxel_block_pack(const float *data, const int res[3], const unsigned char *mask, float *r_packed)
+{
+	int block_res[3];
+	int bx, by, bz, b = 0;
+
+	BLI_voxel_block_res(res, block_res);
+
+	for (bz = 0; bz < block_res[2]; bz++) {
+		for (by = 0; by < block_res[1]; by++) {
+			for (bx = 0; bx < block_res[0]; bx++, b++) {
+				if (!mask[b])
+					continue;
+
+				BLOCK_ITER_BEGIN(res, bx, by, bz, index)
+				{
+					*r_packed++ = data[index];
+				}
+				BLOCK_ITER_END;
+			}
+		}
+	}
+}
+
+/* inverse of BLI_voxel_block_pack, the empty blocks are cleared */
+void BLI_voxel_block_unpack(float *data, const int res[3], const unsigned char *mask, const float *packed)
+{
+	int block_res[3];
+	int bx, by, bz, b = 0;
+
+	BLI_voxel_block_res(res, block_res);
+
+	for (bz = 0; bz < block_res[2]; bz++) {
+		for (by = 0; by < block_res[1]; by++) {
+			for (bx = 0; bx < block_res[0]; bx++, b++) {
+				if (mask[b]) {
+					BLOCK_ITER_BEGIN(res, bx, by, bz, index)
+					{
+						data[index] = *packed++;
+					}
+					BLOCK_ITER_END;
+				}
+				else {
+					BLOCK_ITER_BEGIN(res, bx, by, bz, index)
+					{
+						data[index] = 0.0f;
+					}
+					BLOCK_ITER_END;
+				}
+			}
+		}
+	}
+}
+
+/* input coordinates must be in bounding box 0.0 - 1.0, the mask must be dilated
+ * for samplers reading more than the nearest voxel */
+int BLI_voxel_block_is_empty(const unsigned char *mask, const int res[3], const float co[3])
+{
+	int block_res[3];
+	const int x = _clamp((int)(co[0] * res[0]), 0, res[0] - 1) / BLI_VOXEL_BLOCK_SIZE;
+	const int y = _clamp((int)(co[1] * res[1]), 0, res[1] - 1) / BLI_VOXEL_BLOCK_SIZE;
+	const int z = _clamp((int)(co[2] * res[2]), 0, res[2] - 1) / BLI_VOXEL_BLOCK_SIZE;
+
+	BLI_voxel_block_res(res, block_res);
+
+	return !mask[BLI_VOXEL_INDEX(x, y, z, block_res)];
+}
@@ -2090,6 +2090,7 @@ static void direct_link_fcurves(FileData *fd, ListBase *list)
 			
 			/* compiled expression data will need to be regenerated (old pointer may still be set here) */
 			driver->expr_comp = NULL;
+			driver->expr_simple = NULL;
 			
 			/* give the driver a fresh chance - the operating environment may be different now 
 			 * (addons, etc. may be different) so the driver namespace may be sane now [#32155]
@@ -3458,6 +3459,7 @@ static void direct_link_texture(FileData *fd, Tex *tex)
 	tex->vd = newdataadr(fd, tex->vd);
 	if (tex->vd) {
 		tex->vd->dataset = NULL;
+		tex->vd->blockmask = NULL;
 		tex->vd->ok = 0;
 	}
 	else {
@@ -5030,6 +5032,7 @@ static void direct_link_object(FileData *fd, Object *ob)
 	}
 
 	ob->customdata_mask = 0;
+	ob->modifier_cache_key = 0;
 	ob->bb = NULL;
 	ob->derivedDeform = NULL;
 	ob->derivedFinal = NULL;
@@ -238,17 +238,6 @@ void bmo_weld_verts_exec(BMesh *bm, BMOperator *op)
 	BMO_mesh_delete_oflag_context(bm, ELE_DEL, DEL_ONLYTAGGED);
 }
 
-static int vergaverco(const void *e1, const void *e2)
-{
-	const BMVert *v1 = *(void **)e1, *v2 = *(void **)e2;
-	float x1 = v1->co[0] + v1->co[1] + v1->co[2];
-	float x2 = v2->co[0] + v2->co[1] + v2->co[2];
-
-	if      (x1 > x2) return  1;
-	else if (x1 < x2) return -1;
-	else return 0;
-}
-
 // #define VERT_TESTED	1 // UNUSED
 #define VERT_DOUBLE	2
 #define VERT_TARGET	4
@@ -521,16 +510,219 @@ void bmo_collapse_uvs_exec(BMesh *bm, BMOperator *op)
 
 }
 
+/* -------------------------------------------------------------------- */
+/* Find Doubles
+ *
+ * Vertices are visited in the order of their coordinates added together,
+ * each one becomes the target of the following vertices within the distance
+ * which aren't merged yet.
+ *
+ * Comparing each vertex to the following ones until their sums differ more
+ * than the distance degrades badly when many sums are the same (planar or
+ * axis aligned scans), instead the vertices within the distance are found
+ * with a spatial hash. The search skips the vertices merged already, so
+ * each vertex is found as a double once, even when all are at one location. */
+
+/* cells are at least this size, so a distance of zero still
+ * finds the vertices at the same location */
+#define DOUBLES_CELL_MIN 1e-5f
+/* only keeps the conversion defined for non-finite coordinates: beyond it
+ * floats are much further apart than a cell, so nothing is merged anyway */
+#define DOUBLES_CELL_MAX ((double)((int64_t)1 << 62))
+
+typedef struct DoublesSortVert {
+	float sum;  /* coordinates added together */
+	int index;  /* position in the slot, so ties sort the same on all platforms */
+} DoublesSortVert;
+
+typedef struct DoublesGrid {
+	BMVert **verts;   /* sorted */
+	const char *keep; /* keep_verts flag of each vertex, NULL when there are none */
+	float dist;
+	float cell_size;
+	unsigned int mask;
+	/* the vertices in a cell are cell_verts[cell_start[i]] to cell_verts[cell_start[i + 1] - 1],
+	 * in sort order */
+	int *cell_start;
+	int *cell_verts;
+} DoublesGrid;
+
+static int doubles_sort_cmp(const void *e1, const void *e2)
+{
+	const DoublesSortVert *s1 = e1, *s2 = e2;
+
+	if      (s1->sum > s2->sum) return  1;
+	else if (s1->sum < s2->sum) return -1;
+	else if (s1->index > s2->index) return  1;
+	else if (s1->index < s2->index) return -1;
+	else return 0;
+}
+
+static int doubles_index_cmp(const void *e1, const void *e2)
+{
+	const int i1 = *(const int *)e1, i2 = *(const int *)e2;
+
+	if      (i1 > i2) return  1;
+	else if (i1 < i2) return -1;
+	else return 0;
+}
+
+static void doubles_cell(const float co[3], const float cell_size, int64_t r_cell[3])
+{
+	int i;
+
+	for (i = 0; i < 3; i++) {
+		double f = floor((double)co[i] / (double)cell_size);
+		if (!(f > -DOUBLES_CELL_MAX)) f = -DOUBLES_CELL_MAX;
+		else if (f > DOUBLES_CELL_MAX) f = DOUBLES_CELL_MAX;
+		r_cell[i] = (int64_t)f;
+	}
+}
+
+static unsigned int doubles_cell_hash(const int64_t cell[3], const unsigned int mask)
+{
+	const uint64_t hash = (((uint64_t)cell[0] * 73856093u) ^
+	                       ((uint64_t)cell[1] * 19349663u) ^
+	                       ((uint64_t)cell[2] * 83492791u));
+
+	return (unsigned int)(hash ^ (hash >> 32)) & mask;
+}
+
+static void doubles_grid_init(DoublesGrid *grid, BMVert **verts, const int verts_len,
+                              const char *keep, const float dist)
+{
+	unsigned int *vert_cell;
+	int *cell_fill;
+	unsigned int h;
+	int i;
+
+	grid->verts = verts;
+	grid->keep = keep;
+	grid->dist = dist;
+	grid->cell_size = max_ff(dist, DOUBLES_CELL_MIN);
+	grid->mask = (unsigned int)power_of_2_max_i(verts_len) - 1;
+
+	vert_cell = MEM_mallocN(sizeof(*vert_cell) * verts_len, __func__);
+
+#pragma omp parallel for if (verts_len >= BM_OMP_LIMIT)
+	for (i = 0; i < verts_len; i++) {
+		int64_t cell[3];
+		doubles_cell(verts[i]->co, grid->cell_size, cell);
+		vert_cell[i] = doubles_cell_hash(cell, grid->mask);
+	}
+
+	/* count the vertices of each cell, then fill them in sort order */
+	grid->cell_start = MEM_callocN(sizeof(int) * (grid->mask + 2), __func__);
+	for (i = 0; i < verts_len; i++) {
+		grid->cell_start[vert_cell[i] + 1]++;
+	}
+	for (h = 0; h <= grid->mask; h++) {
+		grid->cell_start[h + 1] += grid->cell_start[h];
+	}
+
+	grid->cell_verts = MEM_mallocN(sizeof(int) * verts_len, __func__);
+	cell_fill = MEM_dupallocN(grid->cell_start);
+	for (i = 0; i < verts_len; i++) {
+		grid->cell_verts[cell_fill[vert_cell[i]]++] = i;
+	}
+
+	MEM_freeN(cell_fill);
+	MEM_freeN(vert_cell);
+}
+
+static void doubles_grid_free(DoublesGrid *grid)
+{
+	MEM_freeN(grid->cell_start);
+	MEM_freeN(grid->cell_verts);
+}
+
+/**
+ * Find the vertices after \a i in sort order which may be merged with it:
+ * within the distance, not merged yet, and unless one of them is kept the other one isn't.
+ *
+ * \param r_found  Filled in sort order, reallocated when \a r_found_alloc is too small.
+ * \return the number of vertices found.
+ */
+static int doubles_grid_find(BMesh *bm, const DoublesGrid *grid, const int i,
+                             int **r_found, int *r_found_alloc)
+{
+	const float *co = grid->verts[i]->co;
+	unsigned int visited[27];
+	int visited_len = 0;
+	int found_len = 0;
+	int64_t cell[3];
+	int x, y, z;
+
+	doubles_cell(co, grid->cell_size, cell);
+
+	/* cells are as large as the distance, so only the neighbors have to be searched */
+	for (x = -1; x <= 1; x++) {
+		for (y = -1; y <= 1; y++) {
+			for (z = -1; z <= 1; z++) {
+				const int64_t cell_near[3] = {cell[0] + x, cell[1] + y, cell[2] + z};
+				const unsigned int h = doubles_cell_hash(cell_near, grid->mask);
+				int k;
+
+				/* cells can share a hash, don't find their vertices twice */
+				for (k = 0; k < visited_len; k++) {
+					if (visited[k] == h) {
+						break;
+					}
+				}
+				if (k != visited_len) {
+					continue;
+				}
+				visited[visited_len++] = h;
+
+				for (k = grid->cell_start[h]; k < grid->cell_start[h + 1]; k++) {
+					const int j = grid->cell_verts[k];
+
+					if (j <= i) {
+						continue;
+					}
+					if (grid->keep && (grid->keep[i] == grid->keep[j])) {
+						continue;
+					}
+					if (BMO_elem_flag_test(bm, grid->verts[j], VERT_DOUBLE | VERT_TARGET)) {
+						continue;
+					}
+					if (compare_len_v3v3(co, grid->verts[j]->co, grid->dist)) {
+						/* each vertex is found once, so this stays below the vertex count */
+						if (found_len == *r_found_alloc) {
+							*r_found_alloc *= 2;
+							*r_found = MEM_reallocN(*r_found, sizeof(**r_found) * (size_t)*r_found_alloc);
+						}
+						(*r_found)[found_len++] = j;
+					}
+				}
+			}
+		}
+	}
+
+	if (found_len > 1) {
+		qsort(*r_found, found_len, sizeof(int), doubles_index_cmp);
+	}
+
+	return found_len;
+}
+
+#undef DOUBLES_CELL_MIN
+#undef DOUBLES_CELL_MAX
+
 static void bmesh_find_doubles_common(BMesh *bm, BMOperator *op,
                                       BMOperator *optarget, BMOpSlot *optarget_slot)
 {
-	BMVert  **verts;
+	BMVert  **verts_in, **verts;
+	DoublesSortVert *sort;
+	DoublesGrid grid;
+	char *keep = NULL;
+	int *found;
+	int found_alloc = 64;
 	int       verts_len;
 
-	int i, j, keepvert = 0;
+	int i, keepvert = 0;
 
 	const float dist  = BMO_slot_float_get(op->slots_in, "dist");
-	const float dist3 = dist * 3.0f;
 
 	/* Test whether keep_verts arg exists and is non-empty */
 	if (BMO_slot_exists(op->slots_in, "keep_verts")) {
@@ -539,60 +731,89 @@ static void bmesh_find_doubles_common(BMesh *bm, BMOperator *op,
 	}
 
 	/* get the verts as an array we can sort */
-	verts = BMO_slot_as_arrayN(op->slots_in, "verts", &verts_len);
+	verts_in = BMO_slot_as_arrayN(op->slots_in, "verts", &verts_len);
+
+	if (verts_len == 0) {
+		MEM_freeN(verts_in);
+		return;
+	}
 
 	/* sort by vertex coordinates added together */
-	qsort(verts, verts_len, sizeof(BMVert *), vergaverco);
+	sort = MEM_mallocN(sizeof(*sort) * verts_len, __func__);
+	for (i = 0; i < verts_len; i++) {
+		const float *co = verts_in[i]->co;
+		sort[i].sum = co[0] + co[1] + co[2];
+		sort[i].index = i;
+	}
+	qsort(sort, verts_len, sizeof(*sort), doubles_sort_cmp);
+
+	verts = MEM_mallocN(sizeof(*verts) * verts_len, __func__);
+	for (i = 0; i < verts_len; i++) {
+		verts[i] = verts_in[sort[i].index];
+	}
+	MEM_freeN(sort);
+	MEM_freeN(verts_in);
 
 	/* Flag keep_verts */
 	if (keepvert) {
 		BMO_slot_buffer_flag_enable(bm, op->slots_in, "keep_verts", BM_VERT, VERT_KEEP);
+
+		keep = MEM_mallocN(sizeof(*keep) * verts_len, __func__);
+		for (i = 0; i < verts_len; i++) {
+			keep[i] = BMO_elem_flag_test(bm, verts[i], VERT_KEEP) != 0;
+		}
 	}
 
+	doubles_grid_init(&grid, verts, verts_len, keep, dist);
+
+	found = MEM_mallocN(sizeof(*found) * (size_t)found_alloc, __func__);
+
+	/* assign the targets in sort order */
 	for (i = 0; i < verts_len; i++) {
-		BMVert *v_check = verts[i];
+		int v_check = i;
+		int k, found_len;
 
-		if (BMO_elem_flag_test(bm, v_check, VERT_DOUBLE | VERT_TARGET)) {
+		if (BMO_elem_flag_test(bm, verts[i], VERT_DOUBLE | VERT_TARGET)) {
 			continue;
 		}
 
-		for (j = i + 1; j < verts_len; j++) {
-			BMVert *v_other = verts[j];
+		found_len = doubles_grid_find(bm, &grid, v_check, &found, &found_alloc);
+
+		for (k = 0; k < found_len; k++) {
+			const int v_other = found[k];
 
 			/* a match has already been found, (we could check which is best, for now don't) */
-			if (BMO_elem_flag_test(bm, v_other, VERT_DOUBLE | VERT_TARGET)) {
+			if (BMO_elem_flag_test(bm, verts[v_other], VERT_DOUBLE | VERT_TARGET)) {
 				continue;
 			}
 
-			/* Compare sort values of the verts using 3x tolerance (allowing for the tolerance
-			 * on each of the three axes). This avoids the more expensive length comparison
-			 * for most vertex pairs. */
-			if ((v_other->co[0] + v_other->co[1] + v_other->co[2]) -
-			    (v_check->co[0] + v_check->co[1] + v_check->co[2]) > dist3)
-			{
-				break;
-			}
-
-			if (keepvert) {
-				if (BMO_elem_flag_test(bm, v_other, VERT_KEEP) == BMO_elem_flag_test(bm, v_check, VERT_KEEP))
-					continue;
-			}
+			/* If one vert is marked as keep, make sure it will be the target,
+			 * the following vertices are then compared to it */
+			if (keep && keep[v_other]) {
+				BMO_elem_flag_enable(bm, verts[v_check], VERT_DOUBLE);
+				BMO_elem_flag_enable(bm, verts[v_other], VERT_TARGET);
 
-			if (compare_len_v3v3(v_check->co, v_other->co, dist)) {
+				BMO_slot_map_elem_insert(optarget, optarget_slot, verts[v_check], verts[v_other]);
 
-				/* If one vert is marked as keep, make sure it will be the target */
-				if (BMO_elem_flag_test(bm, v_other, VERT_KEEP)) {
-					SWAP(BMVert *, v_check, v_other);
-				}
+				v_check = v_other;
+				found_len = doubles_grid_find(bm, &grid, v_check, &found, &found_alloc);
+				k = -1;
+				continue;
+			}
 
-				BMO_elem_flag_enable(bm, v_other, VERT_DOUBLE);
-				BMO_elem_flag_enable(bm, v_check, VERT_TARGET);
+			BMO_elem_flag_enable(bm, verts[v_other], VERT_DOUBLE);
+			BMO_elem_flag_enable(bm, verts[v_check], VERT_TARGET);
 
-				BMO_slot_map_elem_insert(optarget, optarget_slot, v_other, v_check);
-			}
+			BMO_slot_map_elem_insert(optarget, optarget_slot, verts[v_other], verts[v_check]);
 		}
 	}
 
+	doubles_grid_free(&grid);
+
+	MEM_freeN(found);
+	if (keep) {
+		MEM_freeN(keep);
+	}
 	MEM_freeN(verts);
 }
 
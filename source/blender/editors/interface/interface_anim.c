@@ -119,7 +119,7 @@ bool ui_but_anim_expression_set(uiBut *but, const char *str)
 		
 		if (driver && driver->type == DRIVER_TYPE_PYTHON) {
 			BLI_strncpy_utf8(driver->expression, str, sizeof(driver->expression));
-			driver->flag |= DRIVER_FLAG_RECOMPILE;
+			driver_invalidate_expression(driver, true, false);
 			WM_event_add_notifier(but->block->evil_C, NC_ANIMATION | ND_KEYFRAME, NULL);
 			return true;
 		}
@@ -178,7 +178,7 @@ bool ui_but_anim_expression_create(uiBut *but, const char *str)
 			BLI_strncpy_utf8(driver->expression, str, sizeof(driver->expression));
 
 			/* updates */
-			driver->flag |= DRIVER_FLAG_RECOMPILE;
+			driver_invalidate_expression(driver, true, false);
 			WM_event_add_notifier(C, NC_ANIMATION | ND_KEYFRAME, NULL);
 			ok = true;
 		}
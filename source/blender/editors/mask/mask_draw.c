@@ -35,7 +35,6 @@
 #include "BLI_utildefines.h"
 #include "BLI_math.h"
 #include "BLI_rect.h"
-#include "BLI_task.h"
 
 #include "BKE_context.h"
 #include "BKE_mask.h"
@@ -537,81 +536,18 @@ void ED_mask_draw(const bContext *C,
 	draw_masklays(C, mask, draw_flag, draw_type, width, height);
 }
 
-typedef struct ThreadedMaskRasterizeState {
-	MaskRasterHandle *handle;
-	float *buffer;
-	int width, height;
-} ThreadedMaskRasterizeState;
-
-typedef struct ThreadedMaskRasterizeData {
-	int start_scanline;
-	int num_scanlines;
-} ThreadedMaskRasterizeData;
-
-static void mask_rasterize_func(TaskPool *pool, void *taskdata, int UNUSED(threadid))
-{
-	ThreadedMaskRasterizeState *state = (ThreadedMaskRasterizeState *) BLI_task_pool_userdata(pool);
-	ThreadedMaskRasterizeData *data = (ThreadedMaskRasterizeData *) taskdata;
-	int scanline;
-
-	for (scanline = 0; scanline < data->num_scanlines; scanline++) {
-		int x, y = data->start_scanline + scanline;
-		for (x = 0; x < state->width; x++) {
-			int index = y * state->width + x;
-			float xy[2];
-
-			xy[0] = (float) x / state->width;
-			xy[1] = (float) y / state->height;
-
-			state->buffer[index] = BKE_maskrasterize_handle_sample(state->handle, xy);
-		}
-	}
-}
-
-static float *threaded_mask_rasterize(Mask *mask, const int width, const int height)
+static float *mask_rasterize(Mask *mask, const int width, const int height)
 {
-	TaskScheduler *task_scheduler = BLI_task_scheduler_get();
-	TaskPool *task_pool;
 	MaskRasterHandle *handle;
-	ThreadedMaskRasterizeState state;
-	float *buffer;
-	int i, num_threads = BLI_task_scheduler_num_threads(task_scheduler), scanlines_per_thread;
-
-	buffer = MEM_mallocN(sizeof(float) * height * width, "rasterized mask buffer");
+	float *buffer = MEM_mallocN(sizeof(float) * height * width, "rasterized mask buffer");
 
 	/* Initialize rasterization handle. */
 	handle = BKE_maskrasterize_handle_new();
 	BKE_maskrasterize_handle_init(handle, mask, width, height, TRUE, TRUE, TRUE);
 
-	state.handle = handle;
-	state.buffer = buffer;
-	state.width = width;
-	state.height = height;
-
-	task_pool = BLI_task_pool_create(task_scheduler, &state);
-
-	scanlines_per_thread = height / num_threads;
-	for (i = 0; i < num_threads; i++) {
-		ThreadedMaskRasterizeData *data = MEM_mallocN(sizeof(ThreadedMaskRasterizeData),
-		                                                "threaded mask rasterize data");
-
-		data->start_scanline = i * scanlines_per_thread;
-
-		if (i < num_threads - 1) {
-			data->num_scanlines = scanlines_per_thread;
-		}
-		else {
-			data->num_scanlines = height - data->start_scanline;
-		}
-
-		BLI_task_pool_push(task_pool, mask_rasterize_func, data, true, TASK_PRIORITY_LOW);
-	}
-
-	/* work and wait until tasks are done */
-	BLI_task_pool_work_and_wait(task_pool);
+	BKE_maskrasterize_buffer(handle, width, height, buffer);
 
 	/* Free memory. */
-	BLI_task_pool_free(task_pool);
 	BKE_maskrasterize_handle_free(handle);
 
 	return buffer;
@@ -675,7 +611,7 @@ void ED_mask_draw_region(Mask *mask, ARegion *ar,
 	}
 
 	if (draw_flag & MASK_DRAWFLAG_OVERLAY) {
-		float *buffer = threaded_mask_rasterize(mask, width, height);
+		float *buffer = mask_rasterize(mask, width, height);
 		int format;
 
 		if (overlay_mode == MASK_OVERLAY_ALPHACHANNEL) {
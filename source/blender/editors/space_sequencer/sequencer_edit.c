@@ -42,12 +42,15 @@
 #include "MEM_guardedalloc.h"
 
 #include "BLI_blenlib.h"
+#include "BLI_ghash.h"
 #include "BLI_math.h"
 #include "BLI_utildefines.h"
 #include "BLI_threads.h"
 
 #include "BLF_translation.h"
 
+#include "PIL_time.h"
+
 #include "DNA_scene_types.h"
 #include "DNA_userdef_types.h"
 
@@ -132,6 +135,7 @@ typedef struct ProxyBuildJob {
 	Scene *scene; 
 	struct Main *main;
 	ListBase queue;
+	struct GSet *file_list;  /* files written by the queued contexts */
 	int stop;
 } ProxyJob;
 
@@ -140,20 +144,120 @@ static void proxy_freejob(void *pjv)
 	ProxyJob *pj = pjv;
 
 	BLI_freelistN(&pj->queue);
+	BLI_gset_free(pj->file_list, MEM_freeN);
 
 	MEM_freeN(pj);
 }
 
+typedef struct ProxyBuildTask {
+	struct SeqIndexBuildContext *context;
+	float progress;
+} ProxyBuildTask;
+
+typedef struct ProxyBuildThread {
+	ThreadQueue *queue;
+	short *stop, *do_update;
+	bool done;
+} ProxyBuildThread;
+
+static void *proxy_build_thread(void *data)
+{
+	ProxyBuildThread *thread = data;
+	ProxyBuildTask *task;
+
+	while ((task = BLI_thread_queue_pop(thread->queue))) {
+		BKE_sequencer_proxy_rebuild(task->context, thread->stop, thread->do_update, &task->progress);
+		task->progress = 1.0f;
+	}
+
+	thread->done = true;
+
+	return NULL;
+}
+
+/* build the proxies of several movies at once, one thread per movie,
+ * the contexts don't share output files, see seq_proxy_build_job() */
+static void proxy_build_movies(ListBase *queue, short *stop, short *do_update, float *progress)
+{
+	ListBase threads;
+	ThreadQueue *task_queue;
+	ProxyBuildTask *tasks;
+	ProxyBuildThread *thread_data;
+	LinkData *link;
+	int num_tasks = 0, num_threads, i;
+	bool done = false;
+
+	for (link = queue->first; link; link = link->next) {
+		if (link->data && BKE_sequencer_proxy_rebuild_is_threadsafe(link->data))
+			num_tasks++;
+	}
+
+	if (num_tasks == 0)
+		return;
+
+	tasks = MEM_callocN(sizeof(ProxyBuildTask) * num_tasks, "proxy build tasks");
+	task_queue = BLI_thread_queue_init();
+
+	for (link = queue->first, i = 0; link; link = link->next) {
+		if (link->data && BKE_sequencer_proxy_rebuild_is_threadsafe(link->data)) {
+			tasks[i].context = link->data;
+			BLI_thread_queue_push(task_queue, &tasks[i]);
+			i++;
+		}
+	}
+
+	/* threads stop once the queue is empty */
+	BLI_thread_queue_nowait(task_queue);
+
+	num_threads = min_ii(num_tasks, BLI_system_thread_count());
+	thread_data = MEM_callocN(sizeof(ProxyBuildThread) * num_threads, "proxy build threads");
+
+	BLI_init_threads(&threads, proxy_build_thread, num_threads);
+	for (i = 0; i < num_threads; i++) {
+		thread_data[i].queue = task_queue;
+		thread_data[i].stop = stop;
+		thread_data[i].do_update = do_update;
+		BLI_insert_thread(&threads, &thread_data[i]);
+	}
+
+	while (!done) {
+		float total = 0.0f;
+
+		PIL_sleep_ms(50);
+
+		for (i = 0; i < num_tasks; i++)
+			total += tasks[i].progress;
+
+		*progress = total / num_tasks;
+		*do_update = TRUE;
+
+		done = true;
+		for (i = 0; i < num_threads; i++) {
+			if (!thread_data[i].done)
+				done = false;
+		}
+	}
+
+	BLI_end_threads(&threads);
+	BLI_thread_queue_free(task_queue);
+
+	MEM_freeN(thread_data);
+	MEM_freeN(tasks);
+}
+
 /* only this runs inside thread */
 static void proxy_startjob(void *pjv, short *stop, short *do_update, float *progress)
 {
 	ProxyJob *pj = pjv;
 	LinkData *link;
 
-	for (link = pj->queue.first; link; link = link->next) {
+	proxy_build_movies(&pj->queue, stop, do_update, progress);
+
+	for (link = pj->queue.first; link && !*stop; link = link->next) {
 		struct SeqIndexBuildContext *context = link->data;
 
-		BKE_sequencer_proxy_rebuild(context, stop, do_update, progress);
+		if (context && !BKE_sequencer_proxy_rebuild_is_threadsafe(context))
+			BKE_sequencer_proxy_rebuild(context, stop, do_update, progress);
 	}
 
 	if (*stop) {
@@ -198,6 +302,7 @@ static void seq_proxy_build_job(const bContext *C)
 	
 		pj->scene = scene;
 		pj->main = CTX_data_main(C);
+		pj->file_list = BLI_gset_new(BLI_ghashutil_strhash, BLI_ghashutil_strcmp, "proxy rebuild files");
 
 		WM_jobs_customdata_set(wm_job, pj, proxy_freejob);
 		WM_jobs_timer(wm_job, 0.1, NC_SCENE | ND_SEQUENCER, NC_SCENE | ND_SEQUENCER);
@@ -207,7 +312,8 @@ static void seq_proxy_build_job(const bContext *C)
 	SEQP_BEGIN (ed, seq)
 	{
 		if ((seq->flag & SELECT)) {
-			context = BKE_sequencer_proxy_rebuild_context(pj->main, pj->scene, seq);
+			/* strips of the same movie share their proxy files, build those once */
+			context = BKE_sequencer_proxy_rebuild_context(pj->main, pj->scene, seq, pj->file_list);
 			link = BLI_genericNodeN(context);
 			BLI_addtail(&pj->queue, link);
 		}
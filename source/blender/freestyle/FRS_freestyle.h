@@ -37,6 +37,7 @@ extern struct Scene *freestyle_scene;
 extern float freestyle_viewpoint[3];
 extern float freestyle_mv[4][4];
 extern float freestyle_proj[4][4];
+extern float freestyle_viewmat[4][4];
 extern int freestyle_viewport[4];
 
 /* Rendering */
@@ -24,6 +24,7 @@
 
 #include <string>
 #include <fstream>
+#include <sstream>
 #include <float.h>
 
 #include "AppView.h"
@@ -49,6 +50,7 @@
 
 #include "../view_map/SteerableViewMap.h"
 #include "../view_map/ViewMap.h"
+#include "../view_map/ViewMapCache.h"
 #include "../view_map/ViewMapIO.h"
 #include "../view_map/ViewMapTesselator.h"
 
@@ -114,6 +116,8 @@ Controller::Controller()
 
 	_inter = new PythonInterpreter();
 	_EnableQI = true;
+	_numThreads = 1;
+	_EnableViewMapCache = false;
 	_EnableFaceSmoothness = false;
 	_ComputeRidges = true;
 	_ComputeSteerableViewMap = false;
@@ -490,6 +494,51 @@ void Controller::ComputeViewMap()
 	}
 #endif
 
+	// Look for a view map computed from the same geometry and settings
+	//----------------------------------------------------------
+	string cacheKey;
+	if (_EnableViewMapCache) {
+		stringstream settings;
+		settings.precision(17);
+		settings << _ComputeRidges << _ComputeSuggestive << _ComputeMaterialBoundaries << _EnableFaceSmoothness <<
+		            _EnableQI << " " << _VisibilityAlgo << " " << _creaseAngle << " " << _sphereRadius << " " <<
+		            _suggestiveContourKrDerivativeEpsilon << " " << _pView->GetFocalLength() << " " <<
+		            _pView->znear() << " " << _pView->zfar();
+		for (int i = 0; i < 4; i++) {
+			settings << " " << viewport[i];
+			for (int j = 0; j < 4; j++)
+				settings << " " << proj[i][j];
+		}
+		cacheKey = ViewMapCache::computeKey(*_winged_edge, settings.str());
+
+		_ViewMap = _ViewMapCache.loadViewMap(cacheKey);
+		if (_ViewMap) {
+			if (G.debug & G_DEBUG_FREESTYLE) {
+				cout << "\n===  Reusing the cached view map  ===" << endl;
+			}
+			_ViewMap->setScene3dBBox(_Scene3dBBox);
+			ViewMapTesselator3D sTesselator3d;
+			sTesselator3d.setNature(_edgeTesselationNature);
+			_SilhouetteNode = sTesselator3d.Tesselate(_ViewMap);
+			_SilhouetteNode->addRef();
+			_pView->AddSilhouette(_SilhouetteNode);
+			_pView->AddDebug(_DebugNode);
+			if (_ComputeSteerableViewMap)
+				ComputeSteerableViewMap();
+			resetModified(true);
+			DeleteWingedEdge();
+			return;
+		}
+
+		// Principal curvatures do not depend on the camera
+		if (_ComputeRidges || _ComputeSuggestive) {
+			unsigned restored = _ViewMapCache.restoreCurvatures(*_winged_edge, freestyle_viewmat, _sphereRadius);
+			if (G.debug & G_DEBUG_FREESTYLE) {
+				cout << "Curvatures restored for " << restored << " shapes" << endl;
+			}
+		}
+	}
+
 	// Flag the WXEdge structure for silhouette edge detection:
 	//----------------------------------------------------------
 
@@ -518,10 +567,14 @@ void Controller::ComputeViewMap()
 	if (_pRenderMonitor->testBreak())
 		return;
 
+	if (_EnableViewMapCache && (_ComputeRidges || _ComputeSuggestive))
+		_ViewMapCache.storeCurvatures(*_winged_edge, freestyle_viewmat, _sphereRadius);
+
 	// Builds the view map structure from the flagged WSEdge structure:
 	//----------------------------------------------------------
 	ViewMapBuilder vmBuilder;
 	vmBuilder.setEnableQI(_EnableQI);
+	vmBuilder.setNumThreads(_numThreads);
 	vmBuilder.setViewpoint(Vec3r(vp));
 	vmBuilder.setTransform(mv, proj, viewport, _pView->GetFocalLength(), _pView->GetAspect(), _pView->GetFovyRadian());
 	vmBuilder.setFrustum(_pView->znear(), _pView->zfar());
@@ -545,6 +598,10 @@ void Controller::ComputeViewMap()
 	_ViewMap = vmBuilder.BuildViewMap(*_winged_edge, _VisibilityAlgo, _EPSILON, _Scene3dBBox, _SceneNumFaces);
 	_ViewMap->setScene3dBBox(_Scene3dBBox);
 
+	// Do not keep a view map whose computation was interrupted
+	if (_EnableViewMapCache && !_pRenderMonitor->testBreak())
+		_ViewMapCache.storeViewMap(cacheKey, _ViewMap);
+
 	if (G.debug & G_DEBUG_FREESTYLE) {
 		printf("ViewMap edge count : %i\n", _ViewMap->viewedges_size());
 	}
@@ -756,6 +813,13 @@ void Controller::setQuantitativeInvisibility(bool iBool)
 	_EnableQI = iBool;
 }
 
+void Controller::setViewMapCache(bool iBool)
+{
+	_EnableViewMapCache = iBool;
+	if (!iBool)
+		_ViewMapCache.clear();
+}
+
 bool Controller::getQuantitativeInvisibility() const
 {
 	return _EnableQI;
@@ -39,6 +39,7 @@
 #include "../system/TimeUtils.h"
 #include "../view_map/FEdgeXDetector.h"
 #include "../view_map/ViewMapBuilder.h"
+#include "../view_map/ViewMapCache.h"
 
 extern "C" {
 #include "render_types.h"
@@ -138,6 +139,11 @@ public:
 	real getSphereRadius() const {return _sphereRadius;}
 	void setSuggestiveContourKrDerivativeEpsilon(real dkr) {_suggestiveContourKrDerivativeEpsilon = dkr;}
 	real getSuggestiveContourKrDerivativeEpsilon() const {return _suggestiveContourKrDerivativeEpsilon;}
+	void setNumThreads(unsigned n) {_numThreads = n;}
+	unsigned getNumThreads() const {return _numThreads;}
+	void setViewMapCache(bool iBool);
+	bool getViewMapCache() const {return _EnableViewMapCache;}
+	void ClearViewMapCache() {_ViewMapCache.clear();}
 
 	void setModelsDir(const string& dir);
 	string getModelsDir() const;
@@ -239,6 +245,11 @@ private:
 	real _creaseAngle;
 	real _sphereRadius;
 	real _suggestiveContourKrDerivativeEpsilon;
+	unsigned _numThreads;
+	bool _EnableViewMapCache;
+
+	// View map and curvatures of the previous frame
+	ViewMapCache _ViewMapCache;
 
 	bool _ComputeSteerableViewMap;
 
@@ -79,6 +79,7 @@ static bool lineset_copied = false;
 float freestyle_viewpoint[3];
 float freestyle_mv[4][4];
 float freestyle_proj[4][4];
+float freestyle_viewmat[4][4];
 int freestyle_viewport[4];
 
 // current scene
@@ -89,6 +90,9 @@ static string default_module_path;
 static void load_post_callback(struct Main *main, struct ID *id, void *arg)
 {
 	lineset_copied = false;
+	// cached view maps refer to the geometry of the previous file
+	if (freestyle_is_initialized)
+		controller->ClearViewMapCache();
 }
 
 static bCallbackFuncStore load_post_callback_funcstore = {
@@ -193,6 +197,7 @@ static void init_camera(Render *re)
 	unit_m4(freestyle_mv);
 
 	copy_m4_m4(freestyle_proj, re->winmat);
+	copy_m4_m4(freestyle_viewmat, re->viewmat);
 
 #if 0
 	print_m4("mv", freestyle_mv);
@@ -439,6 +444,8 @@ static void prepare(Main *bmain, Render *re, SceneRenderLayer *srl)
 	controller->setVisibilityAlgo((config->flags & FREESTYLE_CULLING) ?
 	                              FREESTYLE_ALGO_CULLED_ADAPTIVE_CUMULATIVE :
 	                              FREESTYLE_ALGO_ADAPTIVE_CUMULATIVE);
+	controller->setNumThreads(re->r.threads);
+	controller->setViewMapCache((config->flags & FREESTYLE_VIEW_MAP_CACHE) ? true : false);
 
 	if (G.debug & G_DEBUG_FREESTYLE) {
 		cout << "Crease angle : " << controller->getCreaseAngle() << endl;
@@ -452,6 +459,8 @@ static void prepare(Main *bmain, Render *re, SceneRenderLayer *srl)
 		        controller->getSuggestiveContourKrDerivativeEpsilon() << endl;
 		cout << "Material boundaries : " <<
 		        (controller->getComputeMaterialBoundariesFlag() ? "enabled" : "disabled") << endl;
+		cout << "Visibility threads : " << controller->getNumThreads() << endl;
+		cout << "View map cache : " << (controller->getViewMapCache() ? "enabled" : "disabled") << endl;
 		cout << endl;
 	}
 
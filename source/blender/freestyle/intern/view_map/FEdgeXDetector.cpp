@@ -190,21 +190,25 @@ void FEdgeXDetector::computeCurvatures(WXVertex *vertex)
 
 	// view independant stuff
 	if (_computeViewIndependant) {
-		C = new CurvatureInfo();
-		vertex->setCurvatures(C);
-		OGF::NormalCycle ncycle;
-		ncycle.begin();
-		if (radius > 0) {
-			OGF::compute_curvature_tensor(vertex, radius, ncycle);
-		}
-		else {
-			OGF::compute_curvature_tensor_one_ring(vertex, ncycle);
+		// The principal curvatures may have been restored from a previous frame (see ViewMapCache)
+		C = vertex->curvatures();
+		if (!C) {
+			C = new CurvatureInfo();
+			vertex->setCurvatures(C);
+			OGF::NormalCycle ncycle;
+			ncycle.begin();
+			if (radius > 0) {
+				OGF::compute_curvature_tensor(vertex, radius, ncycle);
+			}
+			else {
+				OGF::compute_curvature_tensor_one_ring(vertex, ncycle);
+			}
+			ncycle.end();
+			C->K1 = ncycle.kmin();
+			C->K2 = ncycle.kmax();
+			C->e1 = ncycle.Kmax(); //ncycle.kmin() * ncycle.Kmax();
+			C->e2 = ncycle.Kmin(); //ncycle.kmax() * ncycle.Kmin();
 		}
-		ncycle.end();
-		C->K1 = ncycle.kmin();
-		C->K2 = ncycle.kmax();
-		C->e1 = ncycle.Kmax(); //ncycle.kmin() * ncycle.Kmax();
-		C->e2 = ncycle.Kmin(); //ncycle.kmax() * ncycle.Kmin();
 
 		real absK1 = fabs(C->K1);
 		_meanK1 += absK1;
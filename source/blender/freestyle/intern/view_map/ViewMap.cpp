@@ -65,7 +65,9 @@ ViewMap::~ViewMap()
 
 ViewShape *ViewMap::viewShape(unsigned id)
 {
-	int index = _shapeIdToIndex[id];
+	// Use find() rather than operator[] so that concurrent lookups never modify the map.
+	id_to_index_map::const_iterator it = _shapeIdToIndex.find(id);
+	int index = (it != _shapeIdToIndex.end()) ? it->second : 0;
 	return _VShapes[ index ];
 }
 
@@ -46,6 +46,8 @@
 
 #include "BKE_global.h"
 
+#include "BLI_task.h"
+
 namespace Freestyle {
 
 // XXX Grmll... G is used as template's typename parameter :/
@@ -396,386 +398,311 @@ static int computeVisibility(ViewMap *viewMap, FEdge *fe, G& grid, real epsilon,
 	return qi;
 }
 
-// computeCumulativeVisibility returns the lowest x such that the majority of FEdges have QI <= x
+// computeViewEdgeVisibility computes the QI, the occluders and the occludee of a single ViewEdge.
 //
+// When cumulative is true, the QI is the lowest x such that the majority of FEdges have QI <= x.
 // This was probably the original intention of the "normal" algorithm on which computeDetailedVisibility is based.
 // But because the "normal" algorithm chooses the most popular QI, without considering any other values, a ViewEdge
 // with FEdges having QIs of 0, 21, 22, 23, 24 and 25 will end up having a total QI of 0, even though most of the
 // FEdges are heavily occluded. computeCumulativeVisibility will treat this case as a QI of 22 because 3 out of
 // 6 occluders have QI <= 22.
+//
+// Only the ViewEdge, its FEdges and a local occluder iterator are written to, the grid is only read.
+// This allows distinct ViewEdges to be processed concurrently.
 
 template <typename G, typename I>
-static void computeCumulativeVisibility(ViewMap *ioViewMap, G& grid, real epsilon, RenderMonitor *iRenderMonitor)
+static void computeViewEdgeVisibility(ViewMap *ioViewMap, ViewEdge *ve, G& grid, real epsilon, bool cumulative)
 {
-	vector<ViewEdge*>& vedges = ioViewMap->ViewEdges();
-
 	FEdge *fe, *festart;
 	int nSamples = 0;
 	vector<WFace*> wFaces;
 	WFace *wFace = NULL;
-	unsigned cnt = 0;
-	unsigned cntStep = (unsigned)ceil(0.01f * vedges.size());
 	unsigned tmpQI = 0;
 	unsigned qiClasses[256];
 	unsigned maxIndex, maxCard;
 	unsigned qiMajority;
-	for (vector<ViewEdge*>::iterator ve = vedges.begin(), veend = vedges.end(); ve != veend; ve++) {
-		if (iRenderMonitor) {
-			if (iRenderMonitor->testBreak())
-				break;
-			if (cnt % cntStep == 0) {
-				stringstream ss;
-				ss << "Freestyle: Visibility computations " << (100 * cnt / vedges.size()) << "%";
-				iRenderMonitor->setInfo(ss.str());
-				iRenderMonitor->progress((float)cnt / vedges.size());
-			}
-			cnt++;
-		}
+
+#if LOGGING
+	if (_global.debug & G_DEBUG_FREESTYLE) {
+		cout << "Processing ViewEdge " << ve->getId() << endl;
+	}
+#endif
+	// Find an edge to test
+	if (!ve->isInImage()) {
+		// This view edge has been proscenium culled
+		ve->setQI(255);
+		ve->setaShape(0);
 #if LOGGING
 		if (_global.debug & G_DEBUG_FREESTYLE) {
-			cout << "Processing ViewEdge " << (*ve)->getId() << endl;
+			cout << "\tCulled." << endl;
 		}
 #endif
-		// Find an edge to test
-		if (!(*ve)->isInImage()) {
-			// This view edge has been proscenium culled
-			(*ve)->setQI(255);
-			(*ve)->setaShape(0);
+		return;
+	}
+
+	// Test edge
+	festart = ve->fedgeA();
+	fe = ve->fedgeA();
+	qiMajority = 0;
+	do {
+		if (fe != NULL && fe->isInImage()) {
+			qiMajority++;
+		}
+		fe = fe->nextEdge();
+	} while (fe && fe != festart);
+
+	if (qiMajority == 0) {
+		// There are no occludable FEdges on this ViewEdge
+		// This should be impossible.
+		if (_global.debug & G_DEBUG_FREESTYLE) {
+			cout << "View Edge in viewport without occludable FEdges: " << ve->getId() << endl;
+		}
+		// We can recover from this error:
+		// Treat this edge as fully visible with no occludee
+		ve->setQI(0);
+		ve->setaShape(0);
+		return;
+	}
+	else {
+		++qiMajority;
+		qiMajority >>= 1;
+	}
 #if LOGGING
-			if (_global.debug & G_DEBUG_FREESTYLE) {
-				cout << "\tCulled." << endl;
-			}
+	if (_global.debug & G_DEBUG_FREESTYLE) {
+		cout << "\tqiMajority: " << qiMajority << endl;
+	}
 #endif
-			continue;
-		}
 
-		// Test edge
-		festart = (*ve)->fedgeA();
-		fe = (*ve)->fedgeA();
-		qiMajority = 0;
-		do {
-			if (fe != NULL && fe->isInImage()) {
-				qiMajority++;
-			}
-			fe = fe->nextEdge();
-		} while (fe && fe != festart);
+	tmpQI = 0;
+	maxIndex = 0;
+	maxCard = 0;
+	nSamples = 0;
+	memset(qiClasses, 0, 256 * sizeof(*qiClasses));
+	set<ViewShape*> foundOccluders;
 
-		if (qiMajority == 0) {
-			// There are no occludable FEdges on this ViewEdge
-			// This should be impossible.
-			if (_global.debug & G_DEBUG_FREESTYLE) {
-				cout << "View Edge in viewport without occludable FEdges: " << (*ve)->getId() << endl;
-			}
-			// We can recover from this error:
-			// Treat this edge as fully visible with no occludee
-			(*ve)->setQI(0);
-			(*ve)->setaShape(0);
+	fe = ve->fedgeA();
+	do {
+		if (fe == NULL || ! fe->isInImage()) {
+			fe = fe->nextEdge();
 			continue;
 		}
-		else {
-			++qiMajority;
-			qiMajority >>= 1;
-		}
+		if ((maxCard < qiMajority)) {
+			//ARB: change &wFace to wFace and use reference in called function
+			tmpQI = computeVisibility<G, I>(ioViewMap, fe, grid, epsilon, ve, &wFace, &foundOccluders);
 #if LOGGING
-		if (_global.debug & G_DEBUG_FREESTYLE) {
-			cout << "\tqiMajority: " << qiMajority << endl;
-		}
+			if (_global.debug & G_DEBUG_FREESTYLE) {
+				cout << "\tFEdge: visibility " << tmpQI << endl;
+			}
 #endif
 
-		tmpQI = 0;
-		maxIndex = 0;
-		maxCard = 0;
-		nSamples = 0;
-		memset(qiClasses, 0, 256 * sizeof(*qiClasses));
-		set<ViewShape*> foundOccluders;
+			//ARB: This is an error condition, not an alert condition.
+			// Some sort of recovery or abort is necessary.
+			if (tmpQI >= 256) {
+				cerr << "Warning: too many occluding levels" << endl;
+				//ARB: Wild guess: instead of aborting or corrupting memory, treat as tmpQI == 255
+				tmpQI = 255;
+			}
 
-		fe = (*ve)->fedgeA();
-		do {
-			if (!fe || !fe->isInImage()) {
-				fe = fe->nextEdge();
-				continue;
+			if (++qiClasses[tmpQI] > maxCard) {
+				maxCard = qiClasses[tmpQI];
+				maxIndex = tmpQI;
 			}
-			if ((maxCard < qiMajority)) {
-				//ARB: change &wFace to wFace and use reference in called function
-				tmpQI = computeVisibility<G, I>(ioViewMap, fe, grid, epsilon, *ve, &wFace, &foundOccluders);
+		}
+		else {
+			//ARB: FindOccludee is redundant if ComputeRayCastingVisibility has been called
+			//ARB: change &wFace to wFace and use reference in called function
+			findOccludee<G, I>(fe, grid, epsilon, ve, &wFace);
 #if LOGGING
-				if (_global.debug & G_DEBUG_FREESTYLE) {
-					cout << "\tFEdge: visibility " << tmpQI << endl;
-				}
+			if (_global.debug & G_DEBUG_FREESTYLE) {
+				cout << "\tFEdge: occludee only (" << (wFace != NULL ? "found" : "not found") << ")" << endl;
+			}
 #endif
+		}
 
-				//ARB: This is an error condition, not an alert condition.
-				// Some sort of recovery or abort is necessary.
-				if (tmpQI >= 256) {
-					cerr << "Warning: too many occluding levels" << endl;
-					//ARB: Wild guess: instead of aborting or corrupting memory, treat as tmpQI == 255
-					tmpQI = 255;
-				}
-
-				if (++qiClasses[tmpQI] > maxCard) {
-					maxCard = qiClasses[tmpQI];
-					maxIndex = tmpQI;
-				}
+		// Store test results
+		if (wFace) {
+			vector<Vec3r> vertices;
+			for (int i = 0, numEdges = wFace->numberOfEdges(); i < numEdges; ++i) {
+				vertices.push_back(Vec3r(wFace->GetVertex(i)->GetVertex()));
 			}
-			else {
-				//ARB: FindOccludee is redundant if ComputeRayCastingVisibility has been called
-				//ARB: change &wFace to wFace and use reference in called function
-				findOccludee<G, I>(fe, grid, epsilon, *ve, &wFace);
+			Polygon3r poly(vertices, wFace->GetNormal());
+			poly.userdata = (void *)wFace;
+			fe->setaFace(poly);
+			wFaces.push_back(wFace);
+			fe->setOccludeeEmpty(false);
 #if LOGGING
-				if (_global.debug & G_DEBUG_FREESTYLE) {
-					cout << "\tFEdge: occludee only (" << (wFace != NULL ? "found" : "not found") << ")" << endl;
-				}
-#endif
+			if (_global.debug & G_DEBUG_FREESTYLE) {
+				cout << "\tFound occludee" << endl;
 			}
-
-			// Store test results
-			if (wFace) {
-				vector<Vec3r> vertices;
-				for (int i = 0, numEdges = wFace->numberOfEdges(); i < numEdges; ++i) {
-					vertices.push_back(Vec3r(wFace->GetVertex(i)->GetVertex()));
-				}
-				Polygon3r poly(vertices, wFace->GetNormal());
-				poly.userdata = (void *)wFace;
-				fe->setaFace(poly);
-				wFaces.push_back(wFace);
-				fe->setOccludeeEmpty(false);
-#if LOGGING
-				if (_global.debug & G_DEBUG_FREESTYLE) {
-					cout << "\tFound occludee" << endl;
-				}
 #endif
-			}
-			else {
-				fe->setOccludeeEmpty(true);
-			}
+		}
+		else {
+			fe->setOccludeeEmpty(true);
+		}
 
-			++nSamples;
-			fe = fe->nextEdge();
-		} while ((maxCard < qiMajority) && (fe) && (fe != festart));
+		++nSamples;
+		fe = fe->nextEdge();
+	} while ((maxCard < qiMajority) && (fe) && (fe != festart));
 
 #if LOGGING
-		if (_global.debug & G_DEBUG_FREESTYLE) {
-			cout << "\tFinished with " << nSamples << " samples, maxCard = " << maxCard << endl;
-		}
+	if (_global.debug & G_DEBUG_FREESTYLE) {
+		cout << "\tFinished with " << nSamples << " samples, maxCard = " << maxCard << endl;
+	}
 #endif
 
-		// ViewEdge
-		// qi --
+	// ViewEdge
+	// qi --
+	if (cumulative) {
 		// Find the minimum value that is >= the majority of the QI
 		for (unsigned count = 0, i = 0; i < 256; ++i) {
 			count += qiClasses[i];
 			if (count >= qiMajority) {
-				(*ve)->setQI(i);
+				ve->setQI(i);
 				break;
 			}
 		}
-		// occluders --
-		// I would rather not have to go through the effort of creating this set and then copying out its contents.
-		// Is there a reason why ViewEdge::_Occluders cannot be converted to a set<>?
-		for (set<ViewShape*>::iterator o = foundOccluders.begin(), oend = foundOccluders.end(); o != oend; ++o) {
-			(*ve)->AddOccluder((*o));
-		}
+	}
+	else {
+		ve->setQI(maxIndex);
+	}
+	// occluders --
+	// I would rather not have to go through the effort of creating this set and then copying out its contents.
+	// Is there a reason why ViewEdge::_Occluders cannot be converted to a set<>?
+	for (set<ViewShape*>::iterator o = foundOccluders.begin(), oend = foundOccluders.end(); o != oend; ++o) {
+		ve->AddOccluder((*o));
+	}
 #if LOGGING
-		if (_global.debug & G_DEBUG_FREESTYLE) {
-			cout << "\tConclusion: QI = " << maxIndex << ", " << (*ve)->occluders_size() << " occluders." << endl;
-		}
-#else
-		(void)maxIndex;
+	if (_global.debug & G_DEBUG_FREESTYLE) {
+		cout << "\tConclusion: QI = " << maxIndex << ", " << ve->occluders_size() << " occluders." << endl;
+	}
 #endif
-		// occludee --
-		if (!wFaces.empty()) {
-			if (wFaces.size() <= (float)nSamples / 2.0f) {
-				(*ve)->setaShape(0);
-			}
-			else {
-				ViewShape *vshape = ioViewMap->viewShape((*wFaces.begin())->GetVertex(0)->shape()->GetId());
-				(*ve)->setaShape(vshape);
-			}
+	// occludee --
+	if (!wFaces.empty()) {
+		if (wFaces.size() <= (float)nSamples / 2.0f) {
+			ve->setaShape(0);
+		}
+		else {
+			ViewShape *vshape = ioViewMap->viewShape((*wFaces.begin())->GetVertex(0)->shape()->GetId());
+			ve->setaShape(vshape);
 		}
-
-		wFaces.clear();
-	}
-	if (iRenderMonitor && vedges.size()) {
-		stringstream ss;
-		ss << "Freestyle: Visibility computations " << (100 * cnt / vedges.size()) << "%";
-		iRenderMonitor->setInfo(ss.str());
-		iRenderMonitor->progress((float)cnt / vedges.size());
 	}
 }
 
+// Number of ViewEdges handed to a single task. Visibility cost varies a lot from one ViewEdge to another,
+// so tasks are kept small enough for the scheduler to balance the load.
+static const unsigned gVisibilityTaskSize = 64;
+
+template <typename G>
+struct VisibilityTaskData
+{
+	ViewMap *viewMap;
+	G *grid;
+	real epsilon;
+	bool cumulative;
+	unsigned begin, end;
+};
+
 template <typename G, typename I>
-static void computeDetailedVisibility(ViewMap *ioViewMap, G& grid, real epsilon, RenderMonitor *iRenderMonitor)
+static void computeVisibilityTask(TaskPool * /*pool*/, void *taskdata, int /*threadid*/)
 {
-	vector<ViewEdge*>& vedges = ioViewMap->ViewEdges();
+	VisibilityTaskData<G> *data = (VisibilityTaskData<G> *)taskdata;
+	vector<ViewEdge*>& vedges = data->viewMap->ViewEdges();
 
-	FEdge *fe, *festart;
-	int nSamples = 0;
-	vector<WFace*> wFaces;
-	WFace *wFace = NULL;
-	unsigned tmpQI = 0;
-	unsigned qiClasses[256];
-	unsigned maxIndex, maxCard;
-	unsigned qiMajority;
-	for (vector<ViewEdge*>::iterator ve = vedges.begin(), veend = vedges.end(); ve != veend; ve++) {
-		if (iRenderMonitor && iRenderMonitor->testBreak())
-			break;
-#if LOGGING
-		if (_global.debug & G_DEBUG_FREESTYLE) {
-			cout << "Processing ViewEdge " << (*ve)->getId() << endl;
-		}
-#endif
-		// Find an edge to test
-		if (!(*ve)->isInImage()) {
-			// This view edge has been proscenium culled
-			(*ve)->setQI(255);
-			(*ve)->setaShape(0);
-#if LOGGING
-			if (_global.debug & G_DEBUG_FREESTYLE) {
-				cout << "\tCulled." << endl;
-			}
-#endif
-			continue;
-		}
+	for (unsigned i = data->begin; i < data->end; ++i) {
+		computeViewEdgeVisibility<G, I>(data->viewMap, vedges[i], *data->grid, data->epsilon, data->cumulative);
+	}
+}
 
-		// Test edge
-		festart = (*ve)->fedgeA();
-		fe = (*ve)->fedgeA();
-		qiMajority = 0;
-		do {
-			if (fe != NULL && fe->isInImage()) {
-				qiMajority++;
-			}
-			fe = fe->nextEdge();
-		} while (fe && fe != festart);
+// computeViewEdgesVisibility runs computeViewEdgeVisibility on every ViewEdge of the view map.
+//
+// ViewEdges are processed in batches of about 1% of the view map, each batch being split into tasks run by
+// numThreads threads. The render monitor is only polled from the calling thread, between two batches.
+// Since every ViewEdge is computed independently of the others, the result does not depend on the number of
+// threads nor on the order in which tasks are executed.
 
-		if (qiMajority == 0) {
-			// There are no occludable FEdges on this ViewEdge
-			// This should be impossible.
-			if (_global.debug & G_DEBUG_FREESTYLE) {
-				cout << "View Edge in viewport without occludable FEdges: " << (*ve)->getId() << endl;
-			}
-			// We can recover from this error:
-			// Treat this edge as fully visible with no occludee
-			(*ve)->setQI(0);
-			(*ve)->setaShape(0);
-			continue;
-		}
-		else {
-			++qiMajority;
-			qiMajority >>= 1;
-		}
-#if LOGGING
-		if (_global.debug & G_DEBUG_FREESTYLE) {
-			cout << "\tqiMajority: " << qiMajority << endl;
-		}
-#endif
+template <typename G, typename I>
+static void computeViewEdgesVisibility(ViewMap *ioViewMap, G& grid, real epsilon, bool cumulative,
+                                       unsigned numThreads, RenderMonitor *iRenderMonitor, bool reportProgress)
+{
+	vector<ViewEdge*>& vedges = ioViewMap->ViewEdges();
+	unsigned numEdges = vedges.size();
+	unsigned cnt = 0;
+	unsigned batchSize = (unsigned)ceil(0.01f * numEdges);
+	TaskScheduler *task_scheduler = NULL;
 
-		tmpQI = 0;
-		maxIndex = 0;
-		maxCard = 0;
-		nSamples = 0;
-		memset(qiClasses, 0, 256 * sizeof(*qiClasses));
-		set<ViewShape*> foundOccluders;
+	if (numThreads > 1) {
+		task_scheduler = BLI_task_scheduler_create(numThreads);
+		batchSize = max(batchSize, gVisibilityTaskSize * numThreads);
+	}
 
-		fe = (*ve)->fedgeA();
-		do {
-			if (fe == NULL || ! fe->isInImage()) {
-				fe = fe->nextEdge();
-				continue;
+	while (cnt < numEdges) {
+		if (iRenderMonitor) {
+			if (iRenderMonitor->testBreak())
+				break;
+			if (reportProgress) {
+				stringstream ss;
+				ss << "Freestyle: Visibility computations " << (100 * cnt / numEdges) << "%";
+				iRenderMonitor->setInfo(ss.str());
+				iRenderMonitor->progress((float)cnt / numEdges);
 			}
-			if ((maxCard < qiMajority)) {
-				//ARB: change &wFace to wFace and use reference in called function
-				tmpQI = computeVisibility<G, I>(ioViewMap, fe, grid, epsilon, *ve, &wFace, &foundOccluders);
-#if LOGGING
-				if (_global.debug & G_DEBUG_FREESTYLE) {
-					cout << "\tFEdge: visibility " << tmpQI << endl;
-				}
-#endif
+		}
 
-				//ARB: This is an error condition, not an alert condition.
-				// Some sort of recovery or abort is necessary.
-				if (tmpQI >= 256) {
-					cerr << "Warning: too many occluding levels" << endl;
-					//ARB: Wild guess: instead of aborting or corrupting memory, treat as tmpQI == 255
-					tmpQI = 255;
-				}
+		unsigned batchEnd = min(cnt + batchSize, numEdges);
 
-				if (++qiClasses[tmpQI] > maxCard) {
-					maxCard = qiClasses[tmpQI];
-					maxIndex = tmpQI;
-				}
-			}
-			else {
-				//ARB: FindOccludee is redundant if ComputeRayCastingVisibility has been called
-				//ARB: change &wFace to wFace and use reference in called function
-				findOccludee<G, I>(fe, grid, epsilon, *ve, &wFace);
-#if LOGGING
-				if (_global.debug & G_DEBUG_FREESTYLE) {
-					cout << "\tFEdge: occludee only (" << (wFace != NULL ? "found" : "not found") << ")" << endl;
-				}
-#endif
-			}
+		if (task_scheduler) {
+			TaskPool *task_pool = BLI_task_pool_create(task_scheduler, NULL);
+			unsigned numTasks = (batchEnd - cnt + gVisibilityTaskSize - 1) / gVisibilityTaskSize;
+			vector<VisibilityTaskData<G> > tasks(numTasks);
 
-			// Store test results
-			if (wFace) {
-				vector<Vec3r> vertices;
-				for (int i = 0, numEdges = wFace->numberOfEdges(); i < numEdges; ++i) {
-					vertices.push_back(Vec3r(wFace->GetVertex(i)->GetVertex()));
-				}
-				Polygon3r poly(vertices, wFace->GetNormal());
-				poly.userdata = (void *)wFace;
-				fe->setaFace(poly);
-				wFaces.push_back(wFace);
-				fe->setOccludeeEmpty(false);
-#if LOGGING
-				if (_global.debug & G_DEBUG_FREESTYLE) {
-					cout << "\tFound occludee" << endl;
-				}
-#endif
-			}
-			else {
-				fe->setOccludeeEmpty(true);
+			for (unsigned t = 0; t < numTasks; ++t) {
+				VisibilityTaskData<G>& data = tasks[t];
+				data.viewMap = ioViewMap;
+				data.grid = &grid;
+				data.epsilon = epsilon;
+				data.cumulative = cumulative;
+				data.begin = cnt + t * gVisibilityTaskSize;
+				data.end = min(data.begin + gVisibilityTaskSize, batchEnd);
+				BLI_task_pool_push(task_pool, computeVisibilityTask<G, I>, &data, false, TASK_PRIORITY_LOW);
 			}
 
-			++nSamples;
-			fe = fe->nextEdge();
-		} while ((maxCard < qiMajority) && (fe) && (fe != festart));
-
-#if LOGGING
-		if (_global.debug & G_DEBUG_FREESTYLE) {
-			cout << "\tFinished with " << nSamples << " samples, maxCard = " << maxCard << endl;
+			BLI_task_pool_work_and_wait(task_pool);
+			BLI_task_pool_free(task_pool);
 		}
-#endif
-
-		// ViewEdge
-		// qi --
-		(*ve)->setQI(maxIndex);
-		// occluders --
-		// I would rather not have to go through the effort of creating this this set and then copying out its contents.
-		// Is there a reason why ViewEdge::_Occluders cannot be converted to a set<>?
-		for (set<ViewShape*>::iterator o = foundOccluders.begin(), oend = foundOccluders.end(); o != oend; ++o) {
-			(*ve)->AddOccluder((*o));
-		}
-#if LOGGING
-		if (_global.debug & G_DEBUG_FREESTYLE) {
-			cout << "\tConclusion: QI = " << maxIndex << ", " << (*ve)->occluders_size() << " occluders." << endl;
-		}
-#endif
-		// occludee --
-		if (!wFaces.empty()) {
-			if (wFaces.size() <= (float)nSamples / 2.0f) {
-				(*ve)->setaShape(0);
-			}
-			else {
-				ViewShape *vshape = ioViewMap->viewShape((*wFaces.begin())->GetVertex(0)->shape()->GetId());
-				(*ve)->setaShape(vshape);
+		else {
+			for (unsigned i = cnt; i < batchEnd; ++i) {
+				computeViewEdgeVisibility<G, I>(ioViewMap, vedges[i], grid, epsilon, cumulative);
 			}
 		}
 
-		wFaces.clear();
+		cnt = batchEnd;
+	}
+
+	if (task_scheduler) {
+		BLI_task_scheduler_free(task_scheduler);
+	}
+
+	if (iRenderMonitor && reportProgress && numEdges) {
+		stringstream ss;
+		ss << "Freestyle: Visibility computations " << (100 * cnt / numEdges) << "%";
+		iRenderMonitor->setInfo(ss.str());
+		iRenderMonitor->progress((float)cnt / numEdges);
 	}
 }
 
+template <typename G, typename I>
+static void computeCumulativeVisibility(ViewMap *ioViewMap, G& grid, real epsilon, unsigned numThreads,
+                                        RenderMonitor *iRenderMonitor)
+{
+	computeViewEdgesVisibility<G, I>(ioViewMap, grid, epsilon, true, numThreads, iRenderMonitor, true);
+}
+
+template <typename G, typename I>
+static void computeDetailedVisibility(ViewMap *ioViewMap, G& grid, real epsilon, unsigned numThreads,
+                                      RenderMonitor *iRenderMonitor)
+{
+	computeViewEdgesVisibility<G, I>(ioViewMap, grid, epsilon, false, numThreads, iRenderMonitor, false);
+}
+
 template <typename G, typename I>
 static void computeFastVisibility(ViewMap *ioViewMap, G& grid, real epsilon)
 {
@@ -1321,11 +1248,13 @@ void ViewMapBuilder::ComputeCumulativeVisibility(ViewMap *ioViewMap, WingedEdge&
 
 	if (_orthographicProjection) {
 		BoxGrid grid(*source, *density, ioViewMap, _viewpoint, _EnableQI);
-		computeCumulativeVisibility<BoxGrid, BoxGrid::Iterator>(ioViewMap, grid, epsilon, _pRenderMonitor);
+		computeCumulativeVisibility<BoxGrid, BoxGrid::Iterator>(ioViewMap, grid, epsilon, _numThreads,
+		                                                        _pRenderMonitor);
 	}
 	else {
 		SphericalGrid grid(*source, *density, ioViewMap, _viewpoint, _EnableQI);
-		computeCumulativeVisibility<SphericalGrid, SphericalGrid::Iterator>(ioViewMap, grid, epsilon, _pRenderMonitor);
+		computeCumulativeVisibility<SphericalGrid, SphericalGrid::Iterator>(ioViewMap, grid, epsilon, _numThreads,
+		                                                                    _pRenderMonitor);
 	}
 }
 
@@ -1353,11 +1282,12 @@ void ViewMapBuilder::ComputeDetailedVisibility(ViewMap *ioViewMap, WingedEdge& w
 
 	if (_orthographicProjection) {
 		BoxGrid grid(*source, *density, ioViewMap, _viewpoint, _EnableQI);
-		computeDetailedVisibility<BoxGrid, BoxGrid::Iterator>(ioViewMap, grid, epsilon, _pRenderMonitor);
+		computeDetailedVisibility<BoxGrid, BoxGrid::Iterator>(ioViewMap, grid, epsilon, _numThreads, _pRenderMonitor);
 	}
 	else {
 		SphericalGrid grid(*source, *density, ioViewMap, _viewpoint, _EnableQI);
-		computeDetailedVisibility<SphericalGrid, SphericalGrid::Iterator>(ioViewMap, grid, epsilon, _pRenderMonitor);
+		computeDetailedVisibility<SphericalGrid, SphericalGrid::Iterator>(ioViewMap, grid, epsilon, _numThreads,
+		                                                                  _pRenderMonitor);
 	}
 }
 
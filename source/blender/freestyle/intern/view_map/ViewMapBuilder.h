@@ -73,6 +73,7 @@ private:
 	ViewEdgeXBuilder *_pViewEdgeBuilder;
 	bool _EnableQI;
 	double _epsilon;
+	unsigned _numThreads;
 
 	// tmp values:
 	int _currentId;
@@ -104,6 +105,7 @@ public:
 		_currentSVertexId = 0;
 		_pViewEdgeBuilder = new ViewEdgeXBuilder;
 		_EnableQI = true;
+		_numThreads = 1;
 	}
 
 	inline ~ViewMapBuilder()
@@ -208,6 +210,12 @@ public:
 		_EnableQI = iBool;
 	}
 
+	/*! Sets the number of threads used for the visibility computations of the adaptive algorithms */
+	inline void setNumThreads(unsigned iNumThreads)
+	{
+		_numThreads = (iNumThreads > 0) ? iNumThreads : 1;
+	}
+
 protected:
 	/*! Computes intersections on all edges of the scene using a sweep line algorithm */
 	void ComputeSweepLineIntersections(ViewMap *ioViewMap, real epsilon = 1.0e-6);
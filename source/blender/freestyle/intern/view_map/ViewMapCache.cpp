@@ -0,0 +1,334 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/freestyle/intern/view_map/ViewMapCache.cpp
+ *  \ingroup freestyle
+ *  \brief Frame-to-frame cache of view maps and of view independent edge detection results
+ */
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+#include "ViewMapCache.h"
+#include "ViewMapIO.h"
+
+#include "../winged_edge/WXEdge.h"
+
+extern "C" {
+#include "BLI_math.h"
+}
+
+namespace Freestyle {
+
+/* 64 bit FNV-1a hash, fed incrementally with the bytes of the geometry */
+class GeometryHash
+{
+public:
+	GeometryHash() : _hash(0xcbf29ce484222325ULL) {}
+
+	inline void add(const void *data, size_t size)
+	{
+		const unsigned char *p = (const unsigned char *)data;
+		for (size_t i = 0; i < size; i++) {
+			_hash ^= p[i];
+			_hash *= 0x100000001b3ULL;
+		}
+	}
+
+	template<class T>
+	inline void add(const T& value)
+	{
+		add(&value, sizeof(T));
+	}
+
+	inline unsigned long long value() const
+	{
+		return _hash;
+	}
+
+private:
+	unsigned long long _hash;
+};
+
+static void hash_material(GeometryHash& hash, const FrsMaterial& mat)
+{
+	hash.add(mat.diffuse(), 4 * sizeof(float));
+	hash.add(mat.specular(), 4 * sizeof(float));
+	hash.add(mat.ambient(), 4 * sizeof(float));
+	hash.add(mat.emission(), 4 * sizeof(float));
+	hash.add(mat.shininess());
+}
+
+/* Transforms a point (or a direction when w is zero) by a Blender matrix, in double precision */
+static Vec3r transform_point(const float mat[4][4], const Vec3r& v, real w)
+{
+	Vec3r r;
+	for (unsigned int i = 0; i < 3; i++)
+		r[i] = mat[0][i] * v[0] + mat[1][i] * v[1] + mat[2][i] * v[2] + mat[3][i] * w;
+	return r;
+}
+
+ViewMapCache::ShapeCurvatures::~ShapeCurvatures()
+{
+	for (vector<CurvatureInfo*>::iterator ci = curvatures.begin(), ciend = curvatures.end(); ci != ciend; ++ci) {
+		if (*ci)
+			delete *ci;
+	}
+}
+
+ViewMapCache::ViewMapCache()
+{
+	unit_m4(_viewMatrix);
+	_sphereRadius = 0.0;
+}
+
+ViewMapCache::~ViewMapCache()
+{
+	clear();
+}
+
+void ViewMapCache::clear()
+{
+	_viewMapKey.clear();
+	_viewMapData.clear();
+	clearCurvatures();
+}
+
+void ViewMapCache::clearCurvatures()
+{
+	for (shape_curvatures_map::iterator it = _shapeCurvatures.begin(), itend = _shapeCurvatures.end();
+	     it != itend;
+	     ++it)
+	{
+		delete it->second;
+	}
+	_shapeCurvatures.clear();
+}
+
+string ViewMapCache::computeKey(WingedEdge& we, const string& settings)
+{
+	GeometryHash hash;
+	unsigned int size;
+
+	vector<WShape*>& wshapes = we.getWShapes();
+	size = wshapes.size();
+	hash.add(size);
+	for (vector<WShape*>::const_iterator it = wshapes.begin(); it != wshapes.end(); it++) {
+		WShape *ws = *it;
+		const string& name = ws->getName();
+		hash.add(name.data(), name.size());
+		hash.add(ws->GetId());
+
+		const vector<FrsMaterial>& materials = ws->frs_materials();
+		size = materials.size();
+		hash.add(size);
+		for (vector<FrsMaterial>::const_iterator m = materials.begin(), mend = materials.end(); m != mend; ++m)
+			hash_material(hash, *m);
+
+		vector<WVertex*>& wvertices = ws->getVertexList();
+		size = wvertices.size();
+		hash.add(size);
+		for (vector<WVertex*>::iterator wv = wvertices.begin(), wvend = wvertices.end(); wv != wvend; ++wv) {
+			const Vec3r& v = (*wv)->GetVertex();
+			for (unsigned int i = 0; i < 3; i++)
+				hash.add(v[i]);
+			hash.add((*wv)->isSmooth());
+		}
+
+		vector<WFace*>& wfaces = ws->GetFaceList();
+		size = wfaces.size();
+		hash.add(size);
+		for (vector<WFace*>::iterator wf = wfaces.begin(), wfend = wfaces.end(); wf != wfend; ++wf) {
+			WFace *f = *wf;
+			int nverts = f->numberOfVertices();
+			hash.add(nverts);
+			for (int i = 0; i < nverts; i++)
+				hash.add(f->GetVertex(i)->GetId());
+			// Shading: flat faces have the face normal at every corner, smooth faces (and custom or
+			// auto smooth normals) have their own corner normals, both change silhouettes and creases
+			const Vec3r& n = f->GetNormal();
+			for (unsigned int i = 0; i < 3; i++)
+				hash.add(n[i]);
+			vector<Vec3r>& vnormals = f->GetPerVertexNormals();
+			size = vnormals.size();
+			hash.add(size);
+			for (vector<Vec3r>::const_iterator vn = vnormals.begin(), vnend = vnormals.end(); vn != vnend; ++vn) {
+				for (unsigned int i = 0; i < 3; i++)
+					hash.add((*vn)[i]);
+			}
+			hash.add(f->frs_materialIndex());
+			hash.add(f->GetMark());
+		}
+
+		vector<WEdge*>& wedges = ws->getEdgeList();
+		size = wedges.size();
+		hash.add(size);
+		for (vector<WEdge*>::iterator e = wedges.begin(), eend = wedges.end(); e != eend; ++e)
+			hash.add((*e)->GetMark());
+	}
+
+	ostringstream key;
+	key << settings << " " << hex << setw(16) << setfill('0') << hash.value();
+	return key.str();
+}
+
+ViewMap *ViewMapCache::loadViewMap(const string& key)
+{
+	if (_viewMapData.empty() || key != _viewMapKey)
+		return NULL;
+
+	ViewMap *vm = new ViewMap;
+	istringstream in(_viewMapData);
+	unsigned char flags = ViewMapIO::Options::getFlags();
+	int err = ViewMapIO::load(in, vm);
+	ViewMapIO::Options::setFlags(flags);
+	if (err) {
+		delete vm;
+		clear();
+		return NULL;
+	}
+	return vm;
+}
+
+void ViewMapCache::storeViewMap(const string& key, ViewMap *iViewMap)
+{
+	_viewMapKey.clear();
+	_viewMapData.clear();
+	if (!iViewMap)
+		return;
+
+	// Save with full precision and occluders, the restored view map has to be identical
+	ostringstream out;
+	unsigned char flags = ViewMapIO::Options::getFlags();
+	ViewMapIO::Options::setFlags(0);
+	int err = ViewMapIO::save(out, iViewMap);
+	ViewMapIO::Options::setFlags(flags);
+	if (err)
+		return;
+
+	_viewMapKey = key;
+	_viewMapData = out.str();
+}
+
+unsigned ViewMapCache::restoreCurvatures(WingedEdge& we, const float iViewMatrix[4][4], real iSphereRadius,
+                                         real epsilon)
+{
+	if (_shapeCurvatures.empty() || iSphereRadius != _sphereRadius)
+		return 0;
+
+	// Rigid motion of the camera space geometry between the cached frame and this one
+	float viewinv[4][4], delta[4][4];
+	if (!invert_m4_m4(viewinv, (float (*)[4])_viewMatrix))
+		return 0;
+	mul_m4_m4m4(delta, (float (*)[4])iViewMatrix, viewinv);
+
+	unsigned restored = 0;
+	map<string, unsigned> occurrences;
+	vector<WShape*>& wshapes = we.getWShapes();
+	for (vector<WShape*>::const_iterator it = wshapes.begin(); it != wshapes.end(); it++) {
+		WXShape *wxs = dynamic_cast<WXShape*>(*it);
+		if (!wxs)
+			continue;
+		stringstream name;
+		name << wxs->getName() << "#" << occurrences[wxs->getName()]++;
+		shape_curvatures_map::iterator sc = _shapeCurvatures.find(name.str());
+		if (sc == _shapeCurvatures.end())
+			continue;
+		ShapeCurvatures *cached = sc->second;
+
+		vector<WVertex*>& wvertices = wxs->getVertexList();
+		if (wvertices.size() != cached->vertices.size() || wxs->GetFaceList().size() != cached->numFaces)
+			continue;
+
+		// Float matrices and camera space coordinates limit the precision, so the tolerance accounts for the
+		// distance to the camera as well as for the shape size.
+		real tolerance = 0.0;
+		for (vector<WVertex*>::size_type i = 0; i < wvertices.size(); i++)
+			tolerance = max(tolerance, wvertices[i]->GetVertex().norm());
+		tolerance = epsilon * (tolerance + cached->size);
+
+		bool match = true;
+		for (vector<WVertex*>::size_type i = 0; i < wvertices.size() && match; i++) {
+			Vec3r v = transform_point(delta, cached->vertices[i], 1.0);
+			match = ((v - wvertices[i]->GetVertex()).norm() <= tolerance);
+		}
+		if (!match)
+			continue;
+
+		for (vector<WVertex*>::size_type i = 0; i < wvertices.size(); i++) {
+			WXVertex *wxv = dynamic_cast<WXVertex*>(wvertices[i]);
+			CurvatureInfo *ci = cached->curvatures[i];
+			if (!ci || wxv->curvatures())
+				continue;
+			// Only the principal curvatures are view independent, the radial ones are recomputed
+			CurvatureInfo *C = new CurvatureInfo();
+			C->K1 = ci->K1;
+			C->K2 = ci->K2;
+			C->e1 = transform_point(delta, ci->e1, 0.0);
+			C->e2 = transform_point(delta, ci->e2, 0.0);
+			wxv->setCurvatures(C);
+		}
+		restored++;
+	}
+	return restored;
+}
+
+void ViewMapCache::storeCurvatures(WingedEdge& we, const float iViewMatrix[4][4], real iSphereRadius)
+{
+	clearCurvatures();
+	copy_m4_m4(_viewMatrix, (float (*)[4])iViewMatrix);
+	_sphereRadius = iSphereRadius;
+
+	map<string, unsigned> occurrences;
+	vector<WShape*>& wshapes = we.getWShapes();
+	for (vector<WShape*>::const_iterator it = wshapes.begin(); it != wshapes.end(); it++) {
+		WXShape *wxs = dynamic_cast<WXShape*>(*it);
+		if (!wxs)
+			continue;
+		stringstream name;
+		name << wxs->getName() << "#" << occurrences[wxs->getName()]++;
+
+		vector<WVertex*>& wvertices = wxs->getVertexList();
+		ShapeCurvatures *sc = new ShapeCurvatures;
+		sc->numFaces = wxs->GetFaceList().size();
+		sc->vertices.reserve(wvertices.size());
+		sc->curvatures.reserve(wvertices.size());
+		bool empty = true;
+		for (vector<WVertex*>::iterator wv = wvertices.begin(), wvend = wvertices.end(); wv != wvend; ++wv) {
+			WXVertex *wxv = dynamic_cast<WXVertex*>(*wv);
+			CurvatureInfo *ci = wxv->curvatures();
+			sc->vertices.push_back(wxv->GetVertex());
+			sc->curvatures.push_back(ci ? new CurvatureInfo(*ci) : NULL);
+			if (ci)
+				empty = false;
+		}
+		if (empty) {
+			delete sc;
+			continue;
+		}
+		Vec3r min, max;
+		wxs->bbox(min, max);
+		sc->size = (max - min).norm();
+		_shapeCurvatures[name.str()] = sc;
+	}
+}
+
+} /* namespace Freestyle */
@@ -0,0 +1,143 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+#ifndef __FREESTYLE_VIEW_MAP_CACHE_H__
+#define __FREESTYLE_VIEW_MAP_CACHE_H__
+
+/** \file blender/freestyle/intern/view_map/ViewMapCache.h
+ *  \ingroup freestyle
+ *  \brief Frame-to-frame cache of view maps and of view independent edge detection results
+ */
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "ViewMap.h"
+
+#include "../geometry/Geom.h"
+
+#include "../system/FreestyleConfig.h"
+
+#include "../winged_edge/Curvature.h"
+#include "../winged_edge/WEdge.h"
+
+#ifdef WITH_CXX_GUARDEDALLOC
+#include "MEM_guardedalloc.h"
+#endif
+
+namespace Freestyle {
+
+using namespace Geometry;
+
+/*! Keeps data computed for a frame so that it can be reused for the next ones.
+ *
+ *  Meshes are imported in camera space, so two levels of reuse are provided:
+ *  - When the imported geometry and all the view map settings are unchanged (static camera and scene),
+ *    the whole view map is restored from its ViewMapIO serialization, skipping edge detection and
+ *    visibility computations.
+ *  - When the camera moves, each shape whose geometry only differs from the previous frame by the camera
+ *    motion gets back its view independent curvature information, so that only view dependent features
+ *    (silhouettes, suggestive contours, visibility) are recomputed.
+ */
+class LIB_VIEW_MAP_EXPORT ViewMapCache
+{
+public:
+	ViewMapCache();
+	~ViewMapCache();
+
+	/*! Releases all the cached data */
+	void clear();
+
+	/*! Computes the key identifying a view map built from the WingedEdge we with the given settings.
+	 *  The key changes whenever the camera space geometry, the face/edge marks, the material indices
+	 *  or the settings change.
+	 */
+	static string computeKey(WingedEdge& we, const string& settings);
+
+	/*! Returns a copy of the cached view map if it was stored with the same key, NULL otherwise.
+	 *  It is up to the caller to delete the returned ViewMap.
+	 */
+	ViewMap *loadViewMap(const string& key);
+
+	/*! Serializes the view map and stores it with the given key, replacing any previously cached view map */
+	void storeViewMap(const string& key, ViewMap *iViewMap);
+
+	/*! Copies the curvature information of the shapes of the previous frame into the matching shapes of we.
+	 *  A shape matches if it has the same name and topology and if its vertices only moved by the change of
+	 *  the world-to-camera matrix.
+	 *    iViewMatrix
+	 *      The world-to-camera matrix of the current frame.
+	 *    iSphereRadius
+	 *      The curvature sphere radius setting, nothing is restored if it differs from the stored one.
+	 *    epsilon
+	 *      Tolerance on vertex positions, relative to the shape size.
+	 *  Returns the number of shapes whose curvatures were restored.
+	 */
+	unsigned restoreCurvatures(WingedEdge& we, const float iViewMatrix[4][4], real iSphereRadius,
+	                           real epsilon = 1.0e-5);
+
+	/*! Stores the curvature information computed by FEdgeXDetector for the shapes of we */
+	void storeCurvatures(WingedEdge& we, const float iViewMatrix[4][4], real iSphereRadius);
+
+	inline bool hasViewMap() const
+	{
+		return !_viewMapData.empty();
+	}
+
+private:
+	struct ShapeCurvatures
+	{
+		vector<Vec3r> vertices;
+		vector<WFace*>::size_type numFaces;
+		real size;
+		// One entry per vertex, NULL where no curvature was computed
+		vector<CurvatureInfo*> curvatures;
+
+		~ShapeCurvatures();
+
+#ifdef WITH_CXX_GUARDEDALLOC
+		MEM_CXX_CLASS_ALLOC_FUNCS("Freestyle:ViewMapCache:ShapeCurvatures")
+#endif
+	};
+
+	typedef map<string, ShapeCurvatures*> shape_curvatures_map;
+
+	void clearCurvatures();
+
+	// Prevent copies and assignments
+	ViewMapCache(const ViewMapCache& other);
+	ViewMapCache& operator=(const ViewMapCache& other);
+
+	string _viewMapKey;
+	string _viewMapData;
+
+	shape_curvatures_map _shapeCurvatures;
+	float _viewMatrix[4][4];
+	real _sphereRadius;
+
+#ifdef WITH_CXX_GUARDEDALLOC
+	MEM_CXX_CLASS_ALLOC_FUNCS("Freestyle:ViewMapCache")
+#endif
+};
+
+} /* namespace Freestyle */
+
+#endif // __FREESTYLE_VIEW_MAP_CACHE_H__
@@ -35,17 +35,17 @@
 #  define READ(n) in.read((char *)(&(n)), sizeof((n)))
 #endif
 
-#define WRITE_IF_NON_NULL(ptr)  \
-	if (ptr) {                  \
-		WRITE((ptr)->userdata); \
-	}                           \
-	else {                      \
-		WRITE(ZERO);            \
+/* Objects are referenced by their index in the ViewMap lists, stored as an unsigned int in 'userdata'
+ * (see save()). ZERO stands for a NULL pointer, so that index 0 remains a valid reference. */
+#define WRITE_IF_NON_NULL(ptr)                                          \
+	{                                                                   \
+		unsigned _index = (ptr) ? GET_UINT_FROM_POINTER((ptr)->userdata) : ZERO; \
+		WRITE(_index);                                                  \
 	} (void)0
 
 #define READ_IF_NON_NULL(ptr, array) \
 	READ(tmp);                       \
-	if (tmp) {                       \
+	if (tmp != ZERO) {               \
 		(ptr) = (array)[tmp];        \
 	}                                \
 	else {                           \
@@ -109,6 +109,28 @@ inline int load(istream& in, Polygon3r& p)
 	return 0;
 }
 
+inline string load_string(istream& in)
+{
+	unsigned size;
+	READ(size);
+	string str(size, '\0');
+	if (size)
+		in.read(&str[0], size);
+	return str;
+}
+
+inline int load(istream& in, CurvatureInfo& ci)
+{
+	READ(ci.K1);
+	READ(ci.K2);
+	load(in, ci.e1);
+	load(in, ci.e2);
+	READ(ci.Kr);
+	READ(ci.dKr);
+	load(in, ci.er);
+	return 0;
+}
+
 inline int load(istream& in, FrsMaterial& m)
 {
 	float tmp_array[4];
@@ -159,6 +181,9 @@ static int load(istream& in, ViewShape *vs)
 	READ(importance);
 	vs->sshape()->setImportance(importance);
 
+	// -> Name
+	vs->sshape()->setName(load_string(in));
+
 	// -> BBox
 	//    Not necessary (only used during view map computatiom)
 
@@ -272,6 +297,10 @@ static int load(istream& in, FEdge *fe)
 		// Material
 		READ(matindex);
 		fesmooth->setFrsMaterialIndex(matindex);
+
+		// FaceMark
+		READ(b);
+		fesmooth->setFaceMark(b);
 	}
 	else {
 		// aNormal
@@ -287,6 +316,12 @@ static int load(istream& in, FEdge *fe)
 		fesharp->setaFrsMaterialIndex(matindex);
 		READ(matindex);
 		fesharp->setbFrsMaterialIndex(matindex);
+
+		// FaceMarks
+		READ(b);
+		fesharp->setaFaceMark(b);
+		READ(b);
+		fesharp->setbFaceMark(b);
 	}
 
 	unsigned tmp;
@@ -386,6 +421,15 @@ static int load(istream& in, SVertex *sv)
 		sv->AddFEdge(fe);
 	}
 
+	// CurvatureInfo
+	bool b;
+	READ(b);
+	if (b) {
+		CurvatureInfo *ci = new CurvatureInfo();
+		load(in, *ci);
+		sv->setCurvatureInfo(ci);
+	}
+
 	return 0;
 }
 
@@ -584,6 +628,26 @@ inline int save(ostream& out, const Polygon3r& p)
 	return 0;
 }
 
+inline int save_string(ostream& out, const string& str)
+{
+	unsigned size = str.size();
+	WRITE(size);
+	out.write(str.data(), size);
+	return 0;
+}
+
+inline int save(ostream& out, const CurvatureInfo& ci)
+{
+	WRITE(ci.K1);
+	WRITE(ci.K2);
+	save(out, ci.e1);
+	save(out, ci.e2);
+	WRITE(ci.Kr);
+	WRITE(ci.dKr);
+	save(out, ci.er);
+	return 0;
+}
+
 inline int save(ostream& out, const FrsMaterial& m)
 {
 	unsigned i;
@@ -632,6 +696,9 @@ static int save(ostream& out, ViewShape *vs)
 	float importance = vs->sshape()->importance();
 	WRITE(importance);
 
+	// -> Name
+	save_string(out, vs->sshape()->getName());
+
 	// -> BBox
 	//    Not necessary (only used during view map computatiom)
 
@@ -728,6 +795,9 @@ static int save(ostream& out, FEdge *fe)
 		// material
 		index = fesmooth->frs_materialIndex();
 		WRITE(index);
+		// faceMark
+		b = fesmooth->faceMark();
+		WRITE(b);
 	}
 	else {
 		// aNormal
@@ -740,6 +810,12 @@ static int save(ostream& out, FEdge *fe)
 		// bMaterial
 		index = fesharp->bFrsMaterialIndex();
 		WRITE(index);
+		// aFaceMark
+		b = fesharp->aFaceMark();
+		WRITE(b);
+		// bFaceMark
+		b = fesharp->bFaceMark();
+		WRITE(b);
 	}
 
 	// VertexA
@@ -819,6 +895,13 @@ static int save(ostream& out, SVertex *sv)
 	for (vector<FEdge*>::const_iterator j = sv->fedges_begin(); j != sv->fedges_end(); j++)
 		WRITE_IF_NON_NULL(*j);
 
+	// CurvatureInfo
+	const CurvatureInfo *ci = sv->getCurvatureInfo();
+	bool b = (ci != NULL);
+	WRITE(b);
+	if (ci)
+		save(out, *ci);
+
 	return 0;
 }
 
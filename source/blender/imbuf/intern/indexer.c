@@ -35,7 +35,9 @@
 #include "BLI_path_util.h"
 #include "BLI_string.h"
 #include "BLI_fileops.h"
+#include "BLI_ghash.h"
 #include "BLI_math_base.h"
+#include "BLI_threads.h"
 
 #include "IMB_indexer.h"
 #include "IMB_anim.h"
@@ -61,12 +63,10 @@ static const int proxy_sizes[] = { IMB_PROXY_25, IMB_PROXY_50, IMB_PROXY_75,
 	                         IMB_PROXY_100 };
 static const float proxy_fac[] = { 0.25, 0.50, 0.75, 1.00 };
 
-#ifdef WITH_FFMPEG
 static int tc_types[] = {IMB_TC_RECORD_RUN,
                          IMB_TC_FREE_RUN,
                          IMB_TC_INTERPOLATED_REC_DATE_FREE_RUN,
                          IMB_TC_RECORD_RUN_NO_GAPS};
-#endif
 
 #define INDEX_FILE_VERSION 1
 
@@ -694,6 +694,169 @@ static void free_proxy_output_ffmpeg(struct proxy_output_ctx *ctx,
 	MEM_freeN(ctx);
 }
 
+/* Pipeline running every proxy encoder in its own thread. The decoded frames
+ * are copied once and handed to all encoders through bounded queues, so the
+ * decoder gets ahead of the encoders by at most PROXY_QUEUE_LENGTH frames. */
+
+#define PROXY_QUEUE_LENGTH 8
+
+typedef struct ProxyFrame {
+	AVFrame *frame;
+	int users;
+} ProxyFrame;
+
+struct ProxyPipeline;
+
+typedef struct ProxyEncoder {
+	struct ProxyPipeline *pipeline;
+	struct proxy_output_ctx *ctx;
+
+	ProxyFrame *queue[PROXY_QUEUE_LENGTH];
+	int queue_start, queue_len;
+} ProxyEncoder;
+
+typedef struct ProxyPipeline {
+	ThreadMutex mutex;
+	ThreadCondition cond;  /* notified on every change of the queues */
+	bool finished;
+
+	ListBase threads;
+	ProxyEncoder encoders[IMB_PROXY_MAX_SLOT];
+	int num_encoders;
+
+	int pix_fmt;
+	int width, height;
+} ProxyPipeline;
+
+static void proxy_frame_release(ProxyFrame *pf)
+{
+	avpicture_free((AVPicture *)pf->frame);
+	av_free(pf->frame);
+	MEM_freeN(pf);
+}
+
+static void *proxy_encoder_thread(void *data)
+{
+	ProxyEncoder *encoder = data;
+	ProxyPipeline *pipeline = encoder->pipeline;
+
+	while (true) {
+		ProxyFrame *pf;
+		bool release;
+
+		BLI_mutex_lock(&pipeline->mutex);
+
+		while (encoder->queue_len == 0 && !pipeline->finished)
+			BLI_condition_wait(&pipeline->cond, &pipeline->mutex);
+
+		if (encoder->queue_len == 0) {
+			BLI_mutex_unlock(&pipeline->mutex);
+			break;
+		}
+
+		pf = encoder->queue[encoder->queue_start];
+		encoder->queue_start = (encoder->queue_start + 1) % PROXY_QUEUE_LENGTH;
+		encoder->queue_len--;
+
+		BLI_condition_notify_all(&pipeline->cond);
+		BLI_mutex_unlock(&pipeline->mutex);
+
+		add_to_proxy_output_ffmpeg(encoder->ctx, pf->frame);
+
+		BLI_mutex_lock(&pipeline->mutex);
+		release = (--pf->users == 0);
+		BLI_mutex_unlock(&pipeline->mutex);
+
+		if (release)
+			proxy_frame_release(pf);
+	}
+
+	return NULL;
+}
+
+static ProxyPipeline *proxy_pipeline_start(struct proxy_output_ctx **proxy_ctx, int num_proxy_sizes,
+                                           AVCodecContext *iCodecCtx)
+{
+	ProxyPipeline *pipeline;
+	int i;
+
+	for (i = 0; i < num_proxy_sizes; i++) {
+		if (proxy_ctx[i])
+			break;
+	}
+
+	if (i == num_proxy_sizes)
+		return NULL;
+
+	pipeline = MEM_callocN(sizeof(ProxyPipeline), "proxy pipeline");
+	BLI_mutex_init(&pipeline->mutex);
+	BLI_condition_init(&pipeline->cond);
+
+	pipeline->pix_fmt = iCodecCtx->pix_fmt;
+	pipeline->width = iCodecCtx->width;
+	pipeline->height = iCodecCtx->height;
+
+	for (i = 0; i < num_proxy_sizes; i++) {
+		if (proxy_ctx[i]) {
+			ProxyEncoder *encoder = &pipeline->encoders[pipeline->num_encoders++];
+
+			encoder->pipeline = pipeline;
+			encoder->ctx = proxy_ctx[i];
+		}
+	}
+
+	BLI_init_threads(&pipeline->threads, proxy_encoder_thread, pipeline->num_encoders);
+	for (i = 0; i < pipeline->num_encoders; i++)
+		BLI_insert_thread(&pipeline->threads, &pipeline->encoders[i]);
+
+	return pipeline;
+}
+
+/* hand a decoded frame over to all encoders, waits while a queue is full */
+static void proxy_pipeline_push(ProxyPipeline *pipeline, AVFrame *in_frame)
+{
+	ProxyFrame *pf = MEM_mallocN(sizeof(ProxyFrame), "proxy frame");
+	int i;
+
+	/* the decoder reuses its frame buffers, encoders get a copy */
+	pf->frame = avcodec_alloc_frame();
+	pf->users = pipeline->num_encoders;
+	avpicture_alloc((AVPicture *)pf->frame, pipeline->pix_fmt, pipeline->width, pipeline->height);
+	av_picture_copy((AVPicture *)pf->frame, (const AVPicture *)in_frame,
+	                pipeline->pix_fmt, pipeline->width, pipeline->height);
+
+	BLI_mutex_lock(&pipeline->mutex);
+
+	for (i = 0; i < pipeline->num_encoders; i++) {
+		ProxyEncoder *encoder = &pipeline->encoders[i];
+
+		while (encoder->queue_len == PROXY_QUEUE_LENGTH)
+			BLI_condition_wait(&pipeline->cond, &pipeline->mutex);
+
+		encoder->queue[(encoder->queue_start + encoder->queue_len) % PROXY_QUEUE_LENGTH] = pf;
+		encoder->queue_len++;
+		BLI_condition_notify_all(&pipeline->cond);
+	}
+
+	BLI_mutex_unlock(&pipeline->mutex);
+}
+
+/* encode the queued frames and stop the encoder threads */
+static void proxy_pipeline_finish(ProxyPipeline *pipeline)
+{
+	BLI_mutex_lock(&pipeline->mutex);
+	pipeline->finished = true;
+	BLI_condition_notify_all(&pipeline->cond);
+	BLI_mutex_unlock(&pipeline->mutex);
+
+	BLI_end_threads(&pipeline->threads);
+
+	BLI_condition_end(&pipeline->cond);
+	BLI_mutex_end(&pipeline->mutex);
+
+	MEM_freeN(pipeline);
+}
+
 typedef struct FFmpegIndexBuilderContext {
 	int anim_type;
 
@@ -708,6 +871,7 @@ typedef struct FFmpegIndexBuilderContext {
 
 	struct proxy_output_ctx *proxy_ctx[IMB_PROXY_MAX_SLOT];
 	anim_index_builder *indexer[IMB_TC_MAX_SLOT];
+	ProxyPipeline *proxy_pipeline;
 
 	IMB_Timecode_Type tcs_in_use;
 	IMB_Proxy_Size proxy_sizes_in_use;
@@ -852,8 +1016,13 @@ static void index_rebuild_ffmpeg_proc_decoded_frame(
 	unsigned long long s_dts = context->seek_pos_dts;
 	unsigned long long pts = av_get_pts_from_frame(context->iFormatCtx, in_frame);
 
-	for (i = 0; i < context->num_proxy_sizes; i++) {
-		add_to_proxy_output_ffmpeg(context->proxy_ctx[i], in_frame);
+	if (context->proxy_pipeline) {
+		proxy_pipeline_push(context->proxy_pipeline, in_frame);
+	}
+	else {
+		for (i = 0; i < context->num_proxy_sizes; i++) {
+			add_to_proxy_output_ffmpeg(context->proxy_ctx[i], in_frame);
+		}
 	}
 
 	if (!context->start_pts_set) {
@@ -912,6 +1081,9 @@ static int index_rebuild_ffmpeg(FFmpegIndexBuilderContext *context,
 	context->frame_rate = av_q2d(av_get_r_frame_rate_compat(context->iStream));
 	context->pts_time_base = av_q2d(context->iStream->time_base);
 
+	context->proxy_pipeline = proxy_pipeline_start(context->proxy_ctx, context->num_proxy_sizes,
+	                                               context->iCodecCtx);
+
 	while (av_read_frame(context->iFormatCtx, &next_packet) >= 0) {
 		int frame_finished = 0;
 		float next_progress =  (float)((int)floor(((double) next_packet.pos) * 100 /
@@ -973,6 +1145,11 @@ static int index_rebuild_ffmpeg(FFmpegIndexBuilderContext *context,
 		} while (frame_finished);
 	}
 
+	if (context->proxy_pipeline) {
+		proxy_pipeline_finish(context->proxy_pipeline);
+		context->proxy_pipeline = NULL;
+	}
+
 	av_free(in_frame);
 
 	return 1;
@@ -1152,9 +1329,42 @@ static void index_rebuild_fallback(FallbackIndexBuilderContext *context,
  * ---------------------------------------------------------------------- */
 
 IndexBuildContext *IMB_anim_index_rebuild_context(struct anim *anim, IMB_Timecode_Type tcs_in_use,
-                                                  IMB_Proxy_Size proxy_sizes_in_use, int quality)
+                                                  IMB_Proxy_Size proxy_sizes_in_use, int quality,
+                                                  struct GSet *file_list)
 {
 	IndexBuildContext *context = NULL;
+	int i;
+
+	/* skip the files another context already writes, so movies opened
+	 * by several strips are built only once */
+	if (file_list) {
+		char fname[FILE_MAX];
+
+		for (i = 0; i < IMB_PROXY_MAX_SLOT; i++) {
+			if (proxy_sizes_in_use & proxy_sizes[i]) {
+				get_proxy_filename(anim, proxy_sizes[i], fname, FALSE);
+
+				if (BLI_gset_haskey(file_list, fname))
+					proxy_sizes_in_use &= ~proxy_sizes[i];
+				else
+					BLI_gset_insert(file_list, BLI_strdup(fname));
+			}
+		}
+
+		for (i = 0; i < IMB_TC_MAX_SLOT; i++) {
+			if (tcs_in_use & tc_types[i]) {
+				get_tc_filename(anim, tc_types[i], fname);
+
+				if (BLI_gset_haskey(file_list, fname))
+					tcs_in_use &= ~tc_types[i];
+				else
+					BLI_gset_insert(file_list, BLI_strdup(fname));
+			}
+		}
+
+		if (proxy_sizes_in_use == IMB_PROXY_NONE && tcs_in_use == IMB_TC_NONE)
+			return NULL;
+	}
 
 	switch (anim->curtype) {
 #ifdef WITH_FFMPEG
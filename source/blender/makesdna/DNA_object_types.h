@@ -274,6 +274,7 @@ typedef struct Object {
 	int *pad;
 	uint64_t lastDataMask;   /* the custom data layer mask that was last used to calculate derivedDeform and derivedFinal */
 	uint64_t customdata_mask; /* (extra) custom data layer mask to use for creating derivedmesh, set by depsgraph */
+	uint64_t modifier_cache_key; /* runtime, key of the mesh that last went into the modifier stack, see modifier_cache.c */
 	unsigned int state;			/* bit masks of game controllers that are active */
 	unsigned int init_state;	/* bit masks of initial state as recorded by the users */
 
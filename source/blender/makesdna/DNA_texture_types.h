@@ -182,6 +182,7 @@ typedef struct VoxelData {
 
 	/* temporary data */
 	float *dataset;
+	unsigned char *blockmask;  /* BLI_voxel blocks of the dataset holding non-zero values */
 	int cachedframe;
 	int ok;
 	
@@ -571,6 +571,7 @@ typedef enum eUserPref_Flag {
 	USER_NONEGFRAMES		= (1 << 24),
 	USER_TXT_TABSTOSPACES_DISABLE	= (1 << 25),
 	USER_TOOLTIPS_PYTHON    = (1 << 26),
+	USER_MODIFIER_CACHE     = (1 << 27),
 } eUserPref_Flag;
 
 /* flag */
@@ -881,6 +881,13 @@ int RNA_property_collection_raw_array(PointerRNA *ptr, PropertyRNA *prop, Proper
 int RNA_property_collection_raw_get(struct ReportList *reports, PointerRNA *ptr, PropertyRNA *prop, const char *propname, void *array, RawPropertyType type, int len);
 int RNA_property_collection_raw_set(struct ReportList *reports, PointerRNA *ptr, PropertyRNA *prop, const char *propname, void *array, RawPropertyType type, int len);
 int RNA_raw_type_sizeof(RawPropertyType type);
+
+/* Direct access to the DNA data of a property (or of an item property in all items of a collection),
+ * for zero-copy views. Unlike raw arrays, properties with a custom set function are supported,
+ * r_is_editable is false for them. */
+bool RNA_property_collection_raw_view(PointerRNA *ptr, PropertyRNA *prop, PropertyRNA *itemprop, RawArray *array,
+                                      bool *r_is_editable);
+bool RNA_property_raw_view(PointerRNA *ptr, PropertyRNA *prop, RawArray *array, bool *r_is_editable);
 RawPropertyType RNA_property_raw_type(PropertyRNA *prop);
 
 
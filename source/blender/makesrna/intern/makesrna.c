@@ -1345,32 +1345,33 @@ static char *rna_def_property_end_func(FILE *f, StructRNA *srna, PropertyRNA *pr
 	return func;
 }
 
-static void rna_set_raw_property(PropertyDefRNA *dp, PropertyRNA *prop)
+/* Raw access is enabled for properties stored as plain DNA members with the default get/set functions.
+ * With only the default get function, the raw type and offset are still stored for read-only
+ * direct access to the data (zero-copy views from python), without enabling raw access. */
+static void rna_set_raw_property(PropertyDefRNA *dp, PropertyRNA *prop, const bool use_write)
 {
+	RawPropertyType rawtype = PROP_RAW_UNSET;
+
 	if (dp->dnapointerlevel != 0)
 		return;
 	if (!dp->dnatype || !dp->dnaname || !dp->dnastructname)
 		return;
 	
-	if (strcmp(dp->dnatype, "char") == 0) {
-		prop->rawtype = PROP_RAW_CHAR;
-		prop->flag |= PROP_RAW_ACCESS;
-	}
-	else if (strcmp(dp->dnatype, "short") == 0) {
-		prop->rawtype = PROP_RAW_SHORT;
-		prop->flag |= PROP_RAW_ACCESS;
-	}
-	else if (strcmp(dp->dnatype, "int") == 0) {
-		prop->rawtype = PROP_RAW_INT;
-		prop->flag |= PROP_RAW_ACCESS;
-	}
-	else if (strcmp(dp->dnatype, "float") == 0) {
-		prop->rawtype = PROP_RAW_FLOAT;
-		prop->flag |= PROP_RAW_ACCESS;
-	}
-	else if (strcmp(dp->dnatype, "double") == 0) {
-		prop->rawtype = PROP_RAW_DOUBLE;
-		prop->flag |= PROP_RAW_ACCESS;
+	if (strcmp(dp->dnatype, "char") == 0)
+		rawtype = PROP_RAW_CHAR;
+	else if (strcmp(dp->dnatype, "short") == 0)
+		rawtype = PROP_RAW_SHORT;
+	else if (strcmp(dp->dnatype, "int") == 0)
+		rawtype = PROP_RAW_INT;
+	else if (strcmp(dp->dnatype, "float") == 0)
+		rawtype = PROP_RAW_FLOAT;
+	else if (strcmp(dp->dnatype, "double") == 0)
+		rawtype = PROP_RAW_DOUBLE;
+
+	if (rawtype != PROP_RAW_UNSET) {
+		prop->rawtype = rawtype;
+		if (use_write)
+			prop->flag |= PROP_RAW_ACCESS;
 	}
 }
 
@@ -1394,7 +1395,7 @@ static void rna_def_property_funcs(FILE *f, StructRNA *srna, PropertyDefRNA *dp)
 
 			if (!prop->arraydimension) {
 				if (!bprop->get && !bprop->set && !dp->booleanbit)
-					rna_set_raw_property(dp, prop);
+					rna_set_raw_property(dp, prop, true);
 
 				bprop->get = (void *)rna_def_property_get_func(f, srna, prop, dp, (const char *)bprop->get);
 				bprop->set = (void *)rna_def_property_set_func(f, srna, prop, dp, (const char *)bprop->set);
@@ -1410,15 +1411,15 @@ static void rna_def_property_funcs(FILE *f, StructRNA *srna, PropertyDefRNA *dp)
 			IntPropertyRNA *iprop = (IntPropertyRNA *)prop;
 
 			if (!prop->arraydimension) {
-				if (!iprop->get && !iprop->set)
-					rna_set_raw_property(dp, prop);
+				if (!iprop->get)
+					rna_set_raw_property(dp, prop, iprop->set == NULL);
 
 				iprop->get = (void *)rna_def_property_get_func(f, srna, prop, dp, (const char *)iprop->get);
 				iprop->set = (void *)rna_def_property_set_func(f, srna, prop, dp, (const char *)iprop->set);
 			}
 			else {
-				if (!iprop->getarray && !iprop->setarray)
-					rna_set_raw_property(dp, prop);
+				if (!iprop->getarray)
+					rna_set_raw_property(dp, prop, iprop->setarray == NULL);
 
 				iprop->getarray = (void *)rna_def_property_get_func(f, srna, prop, dp, (const char *)iprop->getarray);
 				iprop->setarray = (void *)rna_def_property_set_func(f, srna, prop, dp, (const char *)iprop->setarray);
@@ -1430,15 +1431,15 @@ static void rna_def_property_funcs(FILE *f, StructRNA *srna, PropertyDefRNA *dp)
 			FloatPropertyRNA *fprop = (FloatPropertyRNA *)prop;
 
 			if (!prop->arraydimension) {
-				if (!fprop->get && !fprop->set)
-					rna_set_raw_property(dp, prop);
+				if (!fprop->get)
+					rna_set_raw_property(dp, prop, fprop->set == NULL);
 
 				fprop->get = (void *)rna_def_property_get_func(f, srna, prop, dp, (const char *)fprop->get);
 				fprop->set = (void *)rna_def_property_set_func(f, srna, prop, dp, (const char *)fprop->set);
 			}
 			else {
-				if (!fprop->getarray && !fprop->setarray)
-					rna_set_raw_property(dp, prop);
+				if (!fprop->getarray)
+					rna_set_raw_property(dp, prop, fprop->setarray == NULL);
 
 				fprop->getarray = (void *)rna_def_property_get_func(f, srna, prop, dp, (const char *)fprop->getarray);
 				fprop->setarray = (void *)rna_def_property_set_func(f, srna, prop, dp, (const char *)fprop->setarray);
@@ -2941,7 +2942,7 @@ static void rna_generate_property(FILE *f, StructRNA *srna, const char *nest, Pr
 	        rna_function_string(prop->editable),
 	        rna_function_string(prop->itemeditable));
 
-	if (prop->flag & PROP_RAW_ACCESS) rna_set_raw_offset(f, srna, prop);
+	if (prop->rawtype != PROP_RAW_UNSET) rna_set_raw_offset(f, srna, prop);
 	else fprintf(f, "\t0, -1");
 
 	/* our own type - collections/arrays only */
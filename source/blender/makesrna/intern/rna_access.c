@@ -3249,6 +3249,73 @@ int RNA_property_collection_raw_array(PointerRNA *ptr, PropertyRNA *prop, Proper
 	return 1;
 }
 
+bool RNA_property_collection_raw_view(PointerRNA *ptr, PropertyRNA *prop, PropertyRNA *itemprop, RawArray *array,
+                                      bool *r_is_editable)
+{
+	CollectionPropertyIterator iter;
+	ArrayIterator *internal;
+	char *arrayp;
+	bool ok = true;
+
+	BLI_assert(RNA_property_type(prop) == PROP_COLLECTION);
+
+	/* unlike RNA_property_collection_raw_array, items without raw write access can still be viewed */
+	if (!(prop->flag & PROP_RAW_ARRAY) || itemprop->magic != RNA_MAGIC ||
+	    itemprop->rawtype == PROP_RAW_UNSET || (itemprop->flag & PROP_DYNAMIC))
+	{
+		return false;
+	}
+
+	*r_is_editable = (itemprop->flag & PROP_RAW_ACCESS) != 0;
+
+	RNA_property_collection_begin(ptr, prop, &iter);
+
+	if (iter.valid) {
+		internal = iter.internal;
+		arrayp = iter.ptr.data;
+
+		if (internal->skip) {
+			/* we might skip some items, so it's not a proper array */
+			ok = false;
+		}
+		else {
+			array->array = arrayp + itemprop->rawoffset;
+			array->stride = internal->itemsize;
+			array->len = ((char *)internal->endptr - arrayp) / internal->itemsize;
+			array->type = itemprop->rawtype;
+
+			if (*r_is_editable && !RNA_property_editable(&iter.ptr, itemprop))
+				*r_is_editable = false;
+		}
+	}
+	else {
+		memset(array, 0, sizeof(RawArray));
+		array->type = itemprop->rawtype;
+	}
+
+	RNA_property_collection_end(&iter);
+
+	return ok;
+}
+
+bool RNA_property_raw_view(PointerRNA *ptr, PropertyRNA *prop, RawArray *array, bool *r_is_editable)
+{
+	if (prop->magic != RNA_MAGIC || prop->rawtype == PROP_RAW_UNSET || (prop->flag & PROP_DYNAMIC) ||
+	    ptr->data == NULL)
+	{
+		return false;
+	}
+
+	array->array = (char *)ptr->data + prop->rawoffset;
+	array->type = prop->rawtype;
+	array->stride = RNA_raw_type_sizeof(prop->rawtype);
+	array->len = max_ii(prop->totarraylength, 1);
+
+	*r_is_editable = (prop->flag & PROP_RAW_ACCESS) && RNA_property_editable(ptr, prop);
+
+	return true;
+}
+
 #define RAW_GET(dtype, var, raw, a)                                           \
 {                                                                             \
 	switch (raw.type) {                                                       \
@@ -3610,7 +3677,7 @@ static int rna_raw_access(ReportList *reports, PointerRNA *ptr, PropertyRNA *pro
 
 RawPropertyType RNA_property_raw_type(PropertyRNA *prop)
 {
-	if (prop->rawtype == PROP_RAW_UNSET) {
+	if (prop->rawtype == PROP_RAW_UNSET || !(prop->flag & PROP_RAW_ACCESS)) {
 		/* this property has no raw access, yet we try to provide a raw type to help building the array */
 		switch (prop->type) {
 			case PROP_BOOLEAN:
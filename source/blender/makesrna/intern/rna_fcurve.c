@@ -32,6 +32,7 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "BLI_listbase.h"
 #include "BLI_math.h"
 
 #include "BKE_action.h"
@@ -124,7 +125,7 @@ static void rna_ChannelDriver_update_data(Main *bmain, Scene *scene, PointerRNA
 static void rna_ChannelDriver_update_expr(Main *bmain, Scene *scene, PointerRNA *ptr)
 {
 	ChannelDriver *driver = ptr->data;
-	driver->flag |= DRIVER_FLAG_RECOMPILE;
+	driver_invalidate_expression(driver, true, false);
 	rna_ChannelDriver_update_data(bmain, scene, ptr);
 }
 
@@ -135,6 +136,10 @@ static void rna_DriverTarget_update_data(Main *bmain, Scene *scene, PointerRNA *
 	FCurve *fcu;
 	AnimData *adt = BKE_animdata_from_id(ptr->id.data);
 
+	if (adt == NULL) {
+		return;
+	}
+
 	/* find the driver this belongs to and update it */
 	for (fcu = adt->drivers.first; fcu; fcu = fcu->next) {
 		driver = fcu->driver;
@@ -152,11 +157,23 @@ static void rna_DriverTarget_update_data(Main *bmain, Scene *scene, PointerRNA *
 
 static void rna_DriverTarget_update_name(Main *bmain, Scene *scene, PointerRNA *ptr)
 {
-	ChannelDriver *driver = ptr->data;
+	DriverVar *dvar = ptr->data;
+	AnimData *adt = BKE_animdata_from_id(ptr->id.data);
+	FCurve *fcu;
+
 	rna_DriverTarget_update_data(bmain, scene, ptr);
 
-	driver->flag |= DRIVER_FLAG_RENAMEVAR;
+	if (adt == NULL) {
+		return;
+	}
 
+	/* find the driver this variable belongs to, its compiled expression refers to the old name */
+	for (fcu = adt->drivers.first; fcu; fcu = fcu->next) {
+		if (fcu->driver && BLI_findindex(&fcu->driver->variables, dvar) != -1) {
+			driver_invalidate_expression(fcu->driver, false, true);
+			break;
+		}
+	}
 }
 
 /* ----------- */
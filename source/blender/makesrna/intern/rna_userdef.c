@@ -89,6 +89,7 @@ EnumPropertyItem navigation_mode_items[] = {
 #include "BKE_global.h"
 #include "BKE_main.h"
 #include "BKE_idprop.h"
+#include "BKE_modifier.h"
 
 #include "GPU_draw.h"
 
@@ -304,6 +305,12 @@ static void rna_Userdef_memcache_update(Main *UNUSED(bmain), Scene *UNUSED(scene
 	MEM_CacheLimiter_set_maximum(((size_t) U.memcachelimit) * 1024 * 1024);
 }
 
+static void rna_Userdef_modifier_cache_update(Main *UNUSED(bmain), Scene *UNUSED(scene), PointerRNA *UNUSED(ptr))
+{
+	if (!(U.flag & USER_MODIFIER_CACHE))
+		BKE_modifier_cache_free();
+}
+
 static void rna_UserDef_weight_color_update(Main *bmain, Scene *scene, PointerRNA *ptr)
 {
 	Object *ob;
@@ -3785,6 +3792,13 @@ static void rna_def_userdef_system(BlenderRNA *brna)
 	RNA_def_property_ui_text(prop, "Memory Cache Limit", "Memory cache limit (in megabytes)");
 	RNA_def_property_update(prop, 0, "rna_Userdef_memcache_update");
 
+	prop = RNA_def_property(srna, "use_modifier_cache", PROP_BOOLEAN, PROP_NONE);
+	RNA_def_property_boolean_sdna(prop, NULL, "flag", USER_MODIFIER_CACHE);
+	RNA_def_property_ui_text(prop, "Modifier Cache",
+	                         "Keep intermediate results of the mesh modifier stack in the memory cache, "
+	                         "so editing a modifier only evaluates the stack from that modifier on");
+	RNA_def_property_update(prop, 0, "rna_Userdef_modifier_cache_update");
+
 	prop = RNA_def_property(srna, "frame_server_port", PROP_INT, PROP_NONE);
 	RNA_def_property_int_sdna(prop, NULL, "frameserverport");
 	RNA_def_property_range(prop, 0, 32727);
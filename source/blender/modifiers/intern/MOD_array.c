@@ -37,11 +37,10 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "BLI_kdtree.h"
 #include "BLI_math.h"
 #include "BLI_utildefines.h"
 #include "BLI_string.h"
-#include "BLI_ghash.h"
-#include "BLI_edgehash.h"
 
 #include "DNA_curve_types.h"
 #include "DNA_meshdata_types.h"
@@ -57,8 +56,6 @@
 
 #include "MOD_util.h"
 
-#include "bmesh.h"
-
 #include "depsgraph_private.h"
 
 #include <ctype.h>
@@ -163,189 +160,220 @@ static float vertarray_size(MVert *mvert, int numVerts, int axis)
 	return max_co - min_co;
 }
 
-static int *find_doubles_index_map(BMesh *bm, BMOperator *dupe_op,
-                                   const ArrayModifierData *amd,
-                                   int *index_map_length)
-{
-	BMOperator find_op;
-	BMOIter oiter;
-	BMVert *v, *v2;
-	BMElem *ele;
-	int *index_map, i;
-
-	BMO_op_initf(bm, &find_op, (BMO_FLAG_DEFAULTS & ~BMO_FLAG_RESPECT_HIDE),
-	             "find_doubles verts=%av dist=%f keep_verts=%s",
-	             amd->merge_dist, dupe_op, "geom");
+/* -------------------------------------------------------------------- */
+/* Merging */
 
-	BMO_op_exec(bm, &find_op);
-
-	i = 0;
-	BMO_ITER (ele, &oiter, dupe_op->slots_in, "geom", BM_ALL) {
-		BM_elem_index_set(ele, i); /* set_dirty */
-		i++;
-	}
+static void array_vert_bounds(const MVert *mvert, const int totvert, const float dist,
+                              float r_min[3], float r_max[3])
+{
+	int i;
 
-	BMO_ITER (ele, &oiter, dupe_op->slots_out, "geom.out", BM_ALL) {
-		BM_elem_index_set(ele, i); /* set_dirty */
-		i++;
+	INIT_MINMAX(r_min, r_max);
+	for (i = 0; i < totvert; i++) {
+		minmax_v3v3_v3(r_min, r_max, mvert[i].co);
 	}
-	/* above loops over all, so set all to dirty, if this is somehow
-	 * setting valid values, this line can be removed - campbell */
-	bm->elem_index_dirty |= BM_VERT | BM_EDGE | BM_FACE;
+	add_v3_fl(r_min, -dist);
+	add_v3_fl(r_max, dist);
+}
 
-	(*index_map_length) = i;
-	index_map = MEM_callocN(sizeof(int) * (*index_map_length), "index_map");
+static bool array_co_in_bounds(const float co[3], const float min[3], const float max[3])
+{
+	return ((co[0] >= min[0]) && (co[0] <= max[0]) &&
+	        (co[1] >= min[1]) && (co[1] <= max[1]) &&
+	        (co[2] >= min[2]) && (co[2] <= max[2]));
+}
 
-	/*element type argument doesn't do anything here*/
-	BMO_ITER (v, &oiter, find_op.slots_out, "targetmap.out", 0) {
-		v2 = BMO_iter_map_value_ptr(&oiter);
+/* true when the offset moves the copies without rotating or scaling them */
+static bool array_offset_is_translation(float mat[4][4])
+{
+	int i, j;
 
-		index_map[BM_elem_index_get(v)] = BM_elem_index_get(v2) + 1;
+	for (i = 0; i < 3; i++) {
+		for (j = 0; j < 3; j++) {
+			if (mat[i][j] != ((i == j) ? 1.0f : 0.0f)) {
+				return false;
+			}
+		}
 	}
 
-	BMO_op_finish(bm, &find_op);
-
-	return index_map;
+	return true;
 }
 
-/* Used for start/end cap.
+/**
+ * Find for every vertex of \a src the closest vertex of \a dst within \a dist,
+ * \a r_map is set to its index in \a dst, or -1 when there is none.
  *
- * this function expects all existing vertices to be tagged,
- * so we can know new verts are not tagged.
+ * Only the vertices where both sets overlap are put in the tree and looked up,
+ * so merging copies of a large mesh costs about as much as their seam.
  *
- * All verts will be tagged on exit.
+ * \return the number of vertices which have a double.
  */
-static void bm_merge_dm_transform(BMesh *bm, DerivedMesh *dm, float mat[4][4],
-                                  const ArrayModifierData *amd,
-                                  BMOperator *dupe_op,
-                                  BMOpSlot dupe_op_slot_args[BMO_OP_MAX_SLOTS], const char *dupe_slot_name,
-                                  BMOperator *weld_op)
+static int array_find_doubles(const MVert *dst, const int dst_num,
+                              const MVert *src, const int src_num,
+                              const float dist, int *r_map)
 {
-	const bool is_input = (dupe_op->slots_in == dupe_op_slot_args);
-	BMVert *v, *v2, *v3;
-	BMIter iter;
-
-	/* Add the DerivedMesh's elements to the BMesh. The pre-existing
-	 * elements were already tagged, so the new elements can be
-	 * identified by not having the BM_ELEM_TAG flag set. */
-	DM_to_bmesh_ex(dm, bm, false);
-
-	if (amd->flags & MOD_ARR_MERGE) {
-		/* if merging is enabled, find doubles */
-		
-		BMOIter oiter;
-		BMOperator find_op;
-		BMOpSlot *slot_targetmap;
-
-		BMO_op_initf(bm, &find_op, (BMO_FLAG_DEFAULTS & ~BMO_FLAG_RESPECT_HIDE),
-		             is_input ?  /* ugh */
-		             "find_doubles verts=%Hv dist=%f keep_verts=%s" :
-		             "find_doubles verts=%Hv dist=%f keep_verts=%S",
-		             BM_ELEM_TAG, amd->merge_dist,
-		             dupe_op, dupe_slot_name);
-
-		/* append the dupe's geom to the findop input verts */
-		if (is_input) {
-			BMO_slot_buffer_append(&find_op, slots_in, "verts",
-			                       dupe_op,  slots_in, dupe_slot_name);
+	float dst_min[3], dst_max[3];
+	float src_min[3], src_max[3];
+	KDTree *tree;
+	int tree_num = 0, found_num = 0;
+	int i;
+
+	fill_vn_i(r_map, src_num, -1);
+
+	if (dst_num == 0 || src_num == 0) {
+		return 0;
+	}
+
+	array_vert_bounds(dst, dst_num, dist, dst_min, dst_max);
+	array_vert_bounds(src, src_num, dist, src_min, src_max);
+
+	if (!isect_aabb_aabb_v3(dst_min, dst_max, src_min, src_max)) {
+		return 0;
+	}
+
+	for (i = 0; i < dst_num; i++) {
+		if (array_co_in_bounds(dst[i].co, src_min, src_max)) {
+			tree_num++;
 		}
-		else if (dupe_op->slots_out == dupe_op_slot_args) {
-			BMO_slot_buffer_append(&find_op, slots_in,  "verts",
-			                       dupe_op,  slots_out, dupe_slot_name);
+	}
+
+	if (tree_num == 0) {
+		return 0;
+	}
+
+	tree = BLI_kdtree_new((unsigned int)tree_num);
+	for (i = 0; i < dst_num; i++) {
+		if (array_co_in_bounds(dst[i].co, src_min, src_max)) {
+			BLI_kdtree_insert(tree, i, dst[i].co, NULL);
 		}
-		else {
-			BLI_assert(0);
+	}
+	BLI_kdtree_balance(tree);
+
+#pragma omp parallel for reduction(+:found_num) if (src_num > BKE_MESH_OMP_LIMIT)
+	for (i = 0; i < src_num; i++) {
+		KDTreeNearest nearest;
+
+		if (!array_co_in_bounds(src[i].co, dst_min, dst_max)) {
+			continue;
 		}
 
-		/* transform and tag verts */
-		BM_ITER_MESH (v, &iter, bm, BM_VERTS_OF_MESH) {
-			if (!BM_elem_flag_test(v, BM_ELEM_TAG)) {
-				mul_m4_v3(mat, v->co);
-				BM_elem_flag_enable(v, BM_ELEM_TAG);
-			}
+		if ((BLI_kdtree_find_nearest(tree, src[i].co, NULL, &nearest) != -1) &&
+		    (nearest.dist <= dist))
+		{
+			r_map[i] = nearest.index;
+			found_num++;
 		}
+	}
 
-		BMO_op_exec(bm, &find_op);
+	BLI_kdtree_free(tree);
 
-		slot_targetmap = BMO_slot_get(weld_op->slots_in, "targetmap");
+	return found_num;
+}
 
-		/* add new merge targets to weld operator */
-		BMO_ITER (v, &oiter, find_op.slots_out, "targetmap.out", 0) {
-			v2 = BMO_iter_map_value_ptr(&oiter);
-			/* check in case the target vertex (v2) is already marked
-			 * for merging */
-			while ((v3 = BMO_slot_map_elem_get(slot_targetmap, v2))) {
-				v2 = v3;
-			}
-			BMO_slot_map_elem_insert(weld_op, slot_targetmap, v, v2);
-		}
+/* -------------------------------------------------------------------- */
+/* Building */
 
-		BMO_op_finish(bm, &find_op);
+/**
+ * Offset the vertex, edge and loop indices of elements copied to the result
+ * from a mesh with its own numbering, and transform their vertices by \a mat.
+ */
+static void array_offset_elements(MVert *mvert, const int totvert,
+                                  MEdge *medge, const int totedge,
+                                  MLoop *mloop, const int totloop,
+                                  MPoly *mpoly, const int totpoly,
+                                  const int vert_offset, const int edge_offset, const int loop_offset,
+                                  float mat[4][4])
+{
+	int i;
+
+	for (i = 0; i < totvert; i++) {
+		mul_m4_v3(mat, mvert[i].co);
 	}
-	else {
-		/* transform and tag verts */
-		BM_ITER_MESH (v, &iter, bm, BM_VERTS_OF_MESH) {
-			if (!BM_elem_flag_test(v, BM_ELEM_TAG)) {
-				mul_m4_v3(mat, v->co);
-				BM_elem_flag_enable(v, BM_ELEM_TAG);
-			}
-		}
+	for (i = 0; i < totedge; i++) {
+		medge[i].v1 += vert_offset;
+		medge[i].v2 += vert_offset;
+	}
+	for (i = 0; i < totloop; i++) {
+		mloop[i].v += vert_offset;
+		mloop[i].e += edge_offset;
+	}
+	for (i = 0; i < totpoly; i++) {
+		mpoly[i].loopstart += loop_offset;
 	}
 }
 
-static void merge_first_last(BMesh *bm,
-                             const ArrayModifierData *amd,
-                             BMOperator *dupe_first,
-                             BMOperator *dupe_last,
-                             BMOperator *weld_op)
+/**
+ * Copy a start or end cap at the given offsets in \a result and transform it by \a mat.
+ * The caps belong to other objects, their original indices are cleared.
+ */
+static void array_copy_cap(DerivedMesh *cap, DerivedMesh *result, float mat[4][4],
+                           const int vert_offset, const int edge_offset,
+                           const int loop_offset, const int poly_offset)
 {
-	BMOperator find_op;
-	BMOIter oiter;
-	BMVert *v, *v2;
-	BMOpSlot *slot_targetmap;
-
-	BMO_op_initf(bm, &find_op, (BMO_FLAG_DEFAULTS & ~BMO_FLAG_RESPECT_HIDE),
-	             "find_doubles verts=%s dist=%f keep_verts=%s",
-	             dupe_first, "geom", amd->merge_dist,
-	             dupe_first, "geom");
-
-	/* append the last dupe's geom to the findop input verts */
-	BMO_slot_buffer_append(&find_op,  slots_in,  "verts",
-	                       dupe_last, slots_out, "geom.out");
-
-	BMO_op_exec(bm, &find_op);
-
-	/* add new merge targets to weld operator */
-	slot_targetmap = BMO_slot_get(weld_op->slots_in, "targetmap");
-	BMO_ITER (v, &oiter, find_op.slots_out, "targetmap.out", 0) {
-		if (!BMO_slot_map_contains(slot_targetmap, v)) {
-			v2 = BMO_iter_map_value_ptr(&oiter);
-			BMO_slot_map_elem_insert(weld_op, slot_targetmap, v, v2);
-		}
+	const int cap_nverts = cap->getNumVerts(cap);
+	const int cap_nedges = cap->getNumEdges(cap);
+	const int cap_nloops = cap->getNumLoops(cap);
+	const int cap_npolys = cap->getNumPolys(cap);
+	MVert *mvert = CDDM_get_verts(result) + vert_offset;
+	MEdge *medge = CDDM_get_edges(result) + edge_offset;
+	MLoop *mloop = CDDM_get_loops(result) + loop_offset;
+	MPoly *mpoly = CDDM_get_polys(result) + poly_offset;
+	int *origindex;
+
+	DM_copy_vert_data(cap, result, 0, vert_offset, cap_nverts);
+	DM_copy_edge_data(cap, result, 0, edge_offset, cap_nedges);
+	DM_copy_loop_data(cap, result, 0, loop_offset, cap_nloops);
+	DM_copy_poly_data(cap, result, 0, poly_offset, cap_npolys);
+
+	if (!CustomData_has_layer(&cap->vertData, CD_MVERT)) {
+		cap->copyVertArray(cap, mvert);
+	}
+	if (!CustomData_has_layer(&cap->edgeData, CD_MEDGE)) {
+		cap->copyEdgeArray(cap, medge);
 	}
+	if (!CustomData_has_layer(&cap->polyData, CD_MPOLY)) {
+		cap->copyLoopArray(cap, mloop);
+		cap->copyPolyArray(cap, mpoly);
+	}
+
+	array_offset_elements(mvert, cap_nverts, medge, cap_nedges,
+	                      mloop, cap_nloops, mpoly, cap_npolys,
+	                      vert_offset, edge_offset, loop_offset, mat);
 
-	BMO_op_finish(bm, &find_op);
+	if ((origindex = CustomData_get_layer(&result->vertData, CD_ORIGINDEX))) {
+		fill_vn_i(origindex + vert_offset, cap_nverts, ORIGINDEX_NONE);
+	}
+	if ((origindex = CustomData_get_layer(&result->edgeData, CD_ORIGINDEX))) {
+		fill_vn_i(origindex + edge_offset, cap_nedges, ORIGINDEX_NONE);
+	}
+	if ((origindex = CustomData_get_layer(&result->polyData, CD_ORIGINDEX))) {
+		fill_vn_i(origindex + poly_offset, cap_npolys, ORIGINDEX_NONE);
+	}
 }
 
 static DerivedMesh *arrayModifier_doArray(ArrayModifierData *amd,
                                           Scene *scene, Object *ob, DerivedMesh *dm,
                                           ModifierApplyFlag flag)
 {
+	const bool use_merge = (amd->flags & MOD_ARR_MERGE) != 0;
 	DerivedMesh *result;
-	BMesh *bm = DM_to_bmesh(dm, false);
-	BMOperator first_dupe_op, dupe_op, old_dupe_op, weld_op;
-	BMVert **first_geom = NULL;
-	int i, j;
-	int index_len = -1;  /* initialize to an invalid value */
+	int c, i, j;
 	/* offset matrix */
 	float offset[4][4];
 	float final_offset[4][4];
+	float (*chunk_mats)[4][4];
 	float length = amd->length;
-	int count = amd->count, maxVerts;
-	int *indexMap = NULL;
+	int count = amd->count;
 	DerivedMesh *start_cap = NULL, *end_cap = NULL;
-	MVert *src_mvert;
-	BMOpSlot *slot_targetmap = NULL;  /* for weld_op */
+	MVert *src_mvert, *result_mvert;
+	MEdge *result_medge;
+	MLoop *result_mloop;
+	MPoly *result_mpoly;
+	int chunk_nverts, chunk_nedges, chunk_nloops, chunk_npolys;
+	int start_cap_nverts = 0, start_cap_nedges = 0, start_cap_nloops = 0, start_cap_npolys = 0;
+	int end_cap_nverts = 0, end_cap_nedges = 0, end_cap_nloops = 0, end_cap_npolys = 0;
+	int result_nverts, result_nedges, result_nloops, result_npolys;
+	int start_cap_vert, end_cap_vert;
 
 	/* need to avoid infinite recursion here */
 	if (amd->start_cap && amd->start_cap != ob && amd->start_cap->type == OB_MESH)
@@ -356,13 +384,16 @@ static DerivedMesh *arrayModifier_doArray(ArrayModifierData *amd,
 	unit_m4(offset);
 
 	src_mvert = dm->getVertArray(dm);
-	maxVerts = dm->getNumVerts(dm);
+	chunk_nverts = dm->getNumVerts(dm);
+	chunk_nedges = dm->getNumEdges(dm);
+	chunk_nloops = dm->getNumLoops(dm);
+	chunk_npolys = dm->getNumPolys(dm);
 
 	if (amd->offset_type & MOD_ARR_OFF_CONST)
 		add_v3_v3v3(offset[3], offset[3], amd->offset);
 	if (amd->offset_type & MOD_ARR_OFF_RELATIVE) {
 		for (j = 0; j < 3; j++)
-			offset[3][j] += amd->scale[j] * vertarray_size(src_mvert, maxVerts, j);
+			offset[3][j] += amd->scale[j] * vertarray_size(src_mvert, chunk_nverts, j);
 	}
 
 	if ((amd->offset_type & MOD_ARR_OFF_OBJ) && (amd->offset_ob)) {
@@ -413,155 +444,203 @@ static DerivedMesh *arrayModifier_doArray(ArrayModifierData *amd,
 	if (count < 1)
 		count = 1;
 
-	/* calculate the offset matrix of the final copy (for merging) */
-	unit_m4(final_offset);
+	/* calculate the offset matrix of every copy, the last one is used for merging */
+	chunk_mats = MEM_mallocN(sizeof(*chunk_mats) * count, __func__);
+	unit_m4(chunk_mats[0]);
+	for (c = 1; c < count; c++) {
+		mul_m4_m4m4(chunk_mats[c], offset, chunk_mats[c - 1]);
+	}
+	copy_m4_m4(final_offset, chunk_mats[count - 1]);
 
-	for (j = 0; j < count - 1; j++) {
-		float tmp_mat[4][4];
-		mul_m4_m4m4(tmp_mat, offset, final_offset);
-		copy_m4_m4(final_offset, tmp_mat);
+	if (start_cap) {
+		start_cap_nverts = start_cap->getNumVerts(start_cap);
+		start_cap_nedges = start_cap->getNumEdges(start_cap);
+		start_cap_nloops = start_cap->getNumLoops(start_cap);
+		start_cap_npolys = start_cap->getNumPolys(start_cap);
+	}
+	if (end_cap) {
+		end_cap_nverts = end_cap->getNumVerts(end_cap);
+		end_cap_nedges = end_cap->getNumEdges(end_cap);
+		end_cap_nloops = end_cap->getNumLoops(end_cap);
+		end_cap_npolys = end_cap->getNumPolys(end_cap);
 	}
 
-	/* BMESH_TODO: bumping up the stack level avoids computing the normals
-	 * after every top-level operator execution (and this modifier has the
-	 * potential to execute a *lot* of top-level BMOps. There should be a
-	 * cleaner way to do this. One possibility: a "mirror" BMOp would
-	 * certainly help by compressing it all into one top-level BMOp that
-	 * executes a lot of second-level BMOps. */
-	BM_mesh_elem_toolflags_ensure(bm);
-	BMO_push(bm, NULL);
-	bmesh_edit_begin(bm, 0);
+	/* the copies come first, followed by the start and end caps */
+	result_nverts = chunk_nverts * count + start_cap_nverts + end_cap_nverts;
+	result_nedges = chunk_nedges * count + start_cap_nedges + end_cap_nedges;
+	result_nloops = chunk_nloops * count + start_cap_nloops + end_cap_nloops;
+	result_npolys = chunk_npolys * count + start_cap_npolys + end_cap_npolys;
+
+	start_cap_vert = chunk_nverts * count;
+	end_cap_vert = start_cap_vert + start_cap_nverts;
+
+	result = CDDM_from_template(dm, result_nverts, result_nedges, 0, result_nloops, result_npolys);
+	result_mvert = CDDM_get_verts(result);
+	result_medge = CDDM_get_edges(result);
+	result_mloop = CDDM_get_loops(result);
+	result_mpoly = CDDM_get_polys(result);
+
+	/* copy customdata to the first copy */
+	DM_copy_vert_data(dm, result, 0, 0, chunk_nverts);
+	DM_copy_edge_data(dm, result, 0, 0, chunk_nedges);
+	DM_copy_loop_data(dm, result, 0, 0, chunk_nloops);
+	DM_copy_poly_data(dm, result, 0, 0, chunk_npolys);
+
+	/* subsurf for eg wont have mesh data in the */
+	/* now add mvert/medge/mface layers */
+	if (!CustomData_has_layer(&dm->vertData, CD_MVERT)) {
+		dm->copyVertArray(dm, result_mvert);
+	}
+	if (!CustomData_has_layer(&dm->edgeData, CD_MEDGE)) {
+		dm->copyEdgeArray(dm, result_medge);
+	}
+	if (!CustomData_has_layer(&dm->polyData, CD_MPOLY)) {
+		dm->copyLoopArray(dm, result_mloop);
+		dm->copyPolyArray(dm, result_mpoly);
+	}
 
-	if (amd->flags & MOD_ARR_MERGE) {
-		BMO_op_init(bm, &weld_op, (BMO_FLAG_DEFAULTS & ~BMO_FLAG_RESPECT_HIDE),
-		            "weld_verts");
+	/* copy the first copy to the others, this may allocate
+	 * (deform weights for eg) so it's not done in threads */
+	for (c = 1; c < count; c++) {
+		DM_copy_vert_data(result, result, 0, c * chunk_nverts, chunk_nverts);
+		DM_copy_edge_data(result, result, 0, c * chunk_nedges, chunk_nedges);
+		DM_copy_loop_data(result, result, 0, c * chunk_nloops, chunk_nloops);
+		DM_copy_poly_data(result, result, 0, c * chunk_npolys, chunk_npolys);
+	}
 
-		slot_targetmap = BMO_slot_get(weld_op.slots_in, "targetmap");
+	/* each copy only depends on the first one */
+#pragma omp parallel for if (count * chunk_nverts > BKE_MESH_OMP_LIMIT)
+	for (c = 1; c < count; c++) {
+		array_offset_elements(result_mvert + c * chunk_nverts, chunk_nverts,
+		                      result_medge + c * chunk_nedges, chunk_nedges,
+		                      result_mloop + c * chunk_nloops, chunk_nloops,
+		                      result_mpoly + c * chunk_npolys, chunk_npolys,
+		                      c * chunk_nverts, c * chunk_nedges, c * chunk_nloops,
+		                      chunk_mats[c]);
 	}
 
-	BMO_op_initf(bm, &dupe_op, (BMO_FLAG_DEFAULTS & ~BMO_FLAG_RESPECT_HIDE),
-	             "duplicate geom=%avef");
-	first_dupe_op = dupe_op;
+	MEM_freeN(chunk_mats);
 
-	for (j = 0; j < count - 1; j++) {
-		BMVert *v, *v2, *v3;
-		BMOpSlot *geom_slot;
-		BMOpSlot *geom_out_slot;
-		BMOIter oiter;
+	if (start_cap) {
+		float startoffset[4][4];
+		invert_m4_m4(startoffset, offset);
+		array_copy_cap(start_cap, result, startoffset,
+		               start_cap_vert,
+		               chunk_nedges * count,
+		               chunk_nloops * count,
+		               chunk_npolys * count);
+	}
 
-		if (j != 0) {
-			BMO_op_initf(bm, &dupe_op,
-			             (BMO_FLAG_DEFAULTS & ~BMO_FLAG_RESPECT_HIDE),
-			             "duplicate geom=%S", &old_dupe_op, "geom.out");
-		}
-		BMO_op_exec(bm, &dupe_op);
-
-		geom_slot   = BMO_slot_get(dupe_op.slots_in,  "geom");
-		geom_out_slot = BMO_slot_get(dupe_op.slots_out, "geom.out");
-
-		if ((amd->flags & MOD_ARR_MERGEFINAL) && j == 0) {
-			int first_geom_bytes = sizeof(BMVert *) * geom_slot->len;
-				
-			/* make a copy of the initial geometry ordering so the
-			 * last duplicate can be merged into it */
-			first_geom = MEM_mallocN(first_geom_bytes, "first_geom");
-			memcpy(first_geom, geom_slot->data.buf, first_geom_bytes);
-		}
+	if (end_cap) {
+		float endoffset[4][4];
+		mul_m4_m4m4(endoffset, offset, final_offset);
+		array_copy_cap(end_cap, result, endoffset,
+		               end_cap_vert,
+		               chunk_nedges * count + start_cap_nedges,
+		               chunk_nloops * count + start_cap_nloops,
+		               chunk_npolys * count + start_cap_npolys);
+	}
 
-		/* apply transformation matrix */
-		BMO_ITER (v, &oiter, dupe_op.slots_out, "geom.out", BM_VERT) {
-			mul_m4_v3(offset, v->co);
-		}
+	if (use_merge) {
+		const int last_chunk_vert = (count - 1) * chunk_nverts;
+		int *vtargetmap = MEM_mallocN(sizeof(*vtargetmap) * result_nverts, __func__);
+		int *doubles_map = MEM_mallocN(sizeof(*doubles_map) *
+		                               max_iii(chunk_nverts, start_cap_nverts, end_cap_nverts), __func__);
+		int tot_vtargetmap = 0;
+
+		fill_vn_i(vtargetmap, result_nverts, -1);
+
+		if (count > 1) {
+			/* when the copies are only moved, each one has the same doubles with
+			 * the previous one, so they are only searched for between the first two.
+			 * With a scale (or the rounding of rotated copies) they can differ
+			 * from copy to copy, so every pair is searched */
+			const bool use_first_doubles = array_offset_is_translation(offset);
+			bool has_doubles = false;
+
+			for (c = 1; c < count; c++) {
+				int *vtmap = vtargetmap + c * chunk_nverts;
+				const int target_vert = (c - 1) * chunk_nverts;
+
+				if (c == 1 || !use_first_doubles) {
+					has_doubles = array_find_doubles(result_mvert + target_vert, chunk_nverts,
+					                                 result_mvert + c * chunk_nverts, chunk_nverts,
+					                                 amd->merge_dist, doubles_map) != 0;
+				}
 
-		if (amd->flags & MOD_ARR_MERGE) {
-			/*calculate merge mapping*/
-			if (j == 0) {
-				indexMap = find_doubles_index_map(bm, &dupe_op,
-				                                  amd, &index_len);
+				if (has_doubles) {
+					for (i = 0; i < chunk_nverts; i++) {
+						if (doubles_map[i] != -1) {
+							vtmap[i] = target_vert + doubles_map[i];
+						}
+					}
+				}
 			}
 
-#define _E(s, i) ((BMVert **)(s)->data.buf)[i]
-
-			/* ensure this is set */
-			BLI_assert(index_len != -1);
-
-			for (i = 0; i < index_len; i++) {
-				if (!indexMap[i]) continue;
-
-				/* merge v (from 'geom.out') into v2 (from old 'geom') */
-				v = _E(geom_out_slot, i - geom_slot->len);
-				v2 = _E(geom_slot, indexMap[i] - 1);
-
-				/* check in case the target vertex (v2) is already marked
-				 * for merging */
-				while ((v3 = BMO_slot_map_elem_get(slot_targetmap, v2))) {
-					v2 = v3;
+			if (amd->flags & MOD_ARR_MERGEFINAL) {
+				/* Merge first and last copies. Note that we can't use the
+				 * doubles of the other copies for this because (unless the
+				 * array is forming a loop) the offset between first and last
+				 * is different from dupe X to dupe X+1. */
+				if (array_find_doubles(result_mvert, chunk_nverts,
+				                       result_mvert + last_chunk_vert, chunk_nverts,
+				                       amd->merge_dist, doubles_map))
+				{
+					int *vtmap = vtargetmap + last_chunk_vert;
+
+					for (i = 0; i < chunk_nverts; i++) {
+						if (doubles_map[i] != -1 && vtmap[i] == -1) {
+							vtmap[i] = doubles_map[i];
+						}
+					}
 				}
-
-				BMO_slot_map_elem_insert(&weld_op, slot_targetmap, v, v2);
 			}
-
-#undef _E
 		}
 
-		/* already copied earlier, but after executation more slot
-		 * memory may be allocated */
-		if (j == 0)
-			first_dupe_op = dupe_op;
-		
-		if (j >= 2)
-			BMO_op_finish(bm, &old_dupe_op);
-		old_dupe_op = dupe_op;
-	}
-
-	if ((amd->flags & MOD_ARR_MERGE) &&
-	    (amd->flags & MOD_ARR_MERGEFINAL) &&
-	    (count > 1))
-	{
-		/* Merge first and last copies. Note that we can't use the
-		 * indexMap for this because (unless the array is forming a
-		 * loop) the offset between first and last is different from
-		 * dupe X to dupe X+1. */
-
-		merge_first_last(bm, amd, &first_dupe_op, &dupe_op, &weld_op);
-	}
-
-	/* start capping */
-	if (start_cap || end_cap) {
-		BM_mesh_elem_hflag_enable_all(bm, BM_VERT, BM_ELEM_TAG, FALSE);
-
 		if (start_cap) {
-			float startoffset[4][4];
-			invert_m4_m4(startoffset, offset);
-			bm_merge_dm_transform(bm, start_cap, startoffset, amd,
-			                      &first_dupe_op, first_dupe_op.slots_in, "geom", &weld_op);
+			if (array_find_doubles(result_mvert, chunk_nverts,
+			                       result_mvert + start_cap_vert, start_cap_nverts,
+			                       amd->merge_dist, doubles_map))
+			{
+				for (i = 0; i < start_cap_nverts; i++) {
+					vtargetmap[start_cap_vert + i] = doubles_map[i];
+				}
+			}
 		}
 
 		if (end_cap) {
-			float endoffset[4][4];
-			mul_m4_m4m4(endoffset, offset, final_offset);
-			bm_merge_dm_transform(bm, end_cap, endoffset, amd,
-			                      &dupe_op, (count == 1) ? dupe_op.slots_in : dupe_op.slots_out,
-			                      (count == 1) ? "geom" : "geom.out", &weld_op);
+			if (array_find_doubles(result_mvert + last_chunk_vert, chunk_nverts,
+			                       result_mvert + end_cap_vert, end_cap_nverts,
+			                       amd->merge_dist, doubles_map))
+			{
+				for (i = 0; i < end_cap_nverts; i++) {
+					if (doubles_map[i] != -1) {
+						vtargetmap[end_cap_vert + i] = last_chunk_vert + doubles_map[i];
+					}
+				}
+			}
 		}
-	}
-	/* done capping */
-
-	/* free remaining dupe operators */
-	BMO_op_finish(bm, &first_dupe_op);
-	if (count > 2)
-		BMO_op_finish(bm, &dupe_op);
 
-	/* run merge operator */
-	if (amd->flags & MOD_ARR_MERGE) {
-		BMO_op_exec(bm, &weld_op);
-		BMO_op_finish(bm, &weld_op);
-	}
+		/* a vertex can be merged into one which is merged itself,
+		 * targets always come first so one pass resolves the chains */
+		for (i = 0; i < result_nverts; i++) {
+			if (vtargetmap[i] != -1) {
+				const int target = vtargetmap[vtargetmap[i]];
+				if (target != -1) {
+					vtargetmap[i] = target;
+				}
+				tot_vtargetmap++;
+			}
+		}
 
-	/* Bump the stack level back down to match the adjustment up above */
-	BMO_pop(bm);
+		/* slow - so only call if one or more merge verts are found */
+		if (tot_vtargetmap) {
+			result = CDDM_merge_verts(result, vtargetmap, tot_vtargetmap);
+		}
 
-	result = CDDM_from_bmesh(bm, false);
+		MEM_freeN(vtargetmap);
+		MEM_freeN(doubles_map);
+	}
 
 	if ((dm->dirty & DM_DIRTY_NORMALS) ||
 	    ((amd->offset_type & MOD_ARR_OFF_OBJ) && (amd->offset_ob)))
@@ -570,13 +649,6 @@ static DerivedMesh *arrayModifier_doArray(ArrayModifierData *amd,
 		result->dirty |= DM_DIRTY_NORMALS;
 	}
 
-	BM_mesh_free(bm);
-
-	if (indexMap)
-		MEM_freeN(indexMap);
-	if (first_geom)
-		MEM_freeN(first_geom);
-
 	return result;
 }
 
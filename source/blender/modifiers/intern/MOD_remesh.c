@@ -28,6 +28,7 @@
 
 #include "BLI_math_base.h"
 #include "BLI_math_vector.h"
+#include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
 #include "BKE_cdderivedmesh.h"
@@ -173,7 +174,10 @@ static DerivedMesh *applyModifier(ModifierData *md,
 			mode = DUALCON_SHARP_FEATURES;
 			break;
 	}
-	
+
+	/* the octree is scan converted in threads, which allocate
+	 * (through MEM_mallocN with WITH_CXX_GUARDEDALLOC) */
+	BLI_begin_threaded_malloc();
 	output = dualcon(&input,
 	                 dualcon_alloc_output,
 	                 dualcon_add_vert,
@@ -184,6 +188,7 @@ static DerivedMesh *applyModifier(ModifierData *md,
 	                 rmd->hermite_num,
 	                 rmd->scale,
 	                 rmd->depth);
+	BLI_end_threaded_malloc();
 	result = output->dm;
 	MEM_freeN(output);
 
@@ -4449,6 +4449,66 @@ static bool foreach_compat_buffer(RawPropertyType raw_type, int attr_signed, con
 	return 0;
 }
 
+/* inverse of foreach_compat_buffer, the struct module format of raw data */
+static const char *foreach_raw_buffer_format(RawPropertyType raw_type, bool attr_signed)
+{
+	switch (raw_type) {
+		case PROP_RAW_CHAR:
+			return attr_signed ? "b" : "B";
+		case PROP_RAW_SHORT:
+			return attr_signed ? "h" : "H";
+		case PROP_RAW_INT:
+			return attr_signed ? "i" : "I";
+		case PROP_RAW_FLOAT:
+			return "f";
+		case PROP_RAW_DOUBLE:
+			return "d";
+		case PROP_RAW_UNSET:
+			break;
+	}
+
+	return NULL;
+}
+
+/* shape and strides of a view on raw data, items are the first dimension when 'items_len' isn't -1 */
+#define PYRNA_VIEW_MAX_DIMENSION 4
+
+typedef struct PyRNA_RawViewShape {
+	int ndim;
+	Py_ssize_t len;
+	Py_ssize_t shape[PYRNA_VIEW_MAX_DIMENSION];
+	Py_ssize_t strides[PYRNA_VIEW_MAX_DIMENSION];
+} PyRNA_RawViewShape;
+
+static void pyrna_raw_view_shape(PyRNA_RawViewShape *r_shape, const RawArray *raw, int items_len,
+                                 const int *dims, int dims_len)
+{
+	const Py_ssize_t itemsize = RNA_raw_type_sizeof(raw->type);
+	Py_ssize_t stride = itemsize;
+	int offset = 0, i;
+
+	BLI_assert(dims_len < PYRNA_VIEW_MAX_DIMENSION);
+
+	if (items_len != -1) {
+		r_shape->shape[0] = items_len;
+		r_shape->strides[0] = raw->stride;
+		offset = 1;
+	}
+
+	r_shape->ndim = offset + dims_len;
+
+	for (i = dims_len - 1; i >= 0; i--) {
+		r_shape->shape[offset + i] = dims[i];
+		r_shape->strides[offset + i] = stride;
+		stride *= dims[i];
+	}
+
+	r_shape->len = itemsize;
+	for (i = 0; i < r_shape->ndim; i++) {
+		r_shape->len *= r_shape->shape[i];
+	}
+}
+
 static PyObject *foreach_getset(BPy_PropertyRNA *self, PyObject *args, int set)
 {
 	PyObject *item = NULL;
@@ -4475,17 +4535,21 @@ static PyObject *foreach_getset(BPy_PropertyRNA *self, PyObject *args, int set)
 		buffer_is_compat = false;
 		if (PyObject_CheckBuffer(seq)) {
 			Py_buffer buf;
-			PyObject_GetBuffer(seq, &buf, PyBUF_SIMPLE | PyBUF_FORMAT);
+			if (PyObject_GetBuffer(seq, &buf, PyBUF_SIMPLE | PyBUF_FORMAT) == -1) {
+				/* not all buffers can be accessed this way, use as a sequence */
+				PyErr_Clear();
+			}
+			else {
+				/* check if the buffer matches */
 
-			/* check if the buffer matches */
+				buffer_is_compat = foreach_compat_buffer(raw_type, attr_signed, buf.format);
 
-			buffer_is_compat = foreach_compat_buffer(raw_type, attr_signed, buf.format);
+				if (buffer_is_compat) {
+					ok = RNA_property_collection_raw_set(NULL, &self->ptr, self->prop, attr, buf.buf, raw_type, tot);
+				}
 
-			if (buffer_is_compat) {
-				ok = RNA_property_collection_raw_set(NULL, &self->ptr, self->prop, attr, buf.buf, raw_type, tot);
+				PyBuffer_Release(&buf);
 			}
-
-			PyBuffer_Release(&buf);
 		}
 
 		/* could not use the buffer, fallback to sequence */
@@ -4526,17 +4590,21 @@ static PyObject *foreach_getset(BPy_PropertyRNA *self, PyObject *args, int set)
 		buffer_is_compat = false;
 		if (PyObject_CheckBuffer(seq)) {
 			Py_buffer buf;
-			PyObject_GetBuffer(seq, &buf, PyBUF_SIMPLE | PyBUF_FORMAT);
+			if (PyObject_GetBuffer(seq, &buf, PyBUF_SIMPLE | PyBUF_FORMAT | PyBUF_WRITABLE) == -1) {
+				/* not all buffers can be accessed this way, use as a sequence */
+				PyErr_Clear();
+			}
+			else {
+				/* check if the buffer matches, TODO - signed/unsigned types */
 
-			/* check if the buffer matches, TODO - signed/unsigned types */
+				buffer_is_compat = foreach_compat_buffer(raw_type, attr_signed, buf.format);
 
-			buffer_is_compat = foreach_compat_buffer(raw_type, attr_signed, buf.format);
+				if (buffer_is_compat) {
+					ok = RNA_property_collection_raw_get(NULL, &self->ptr, self->prop, attr, buf.buf, raw_type, tot);
+				}
 
-			if (buffer_is_compat) {
-				ok = RNA_property_collection_raw_get(NULL, &self->ptr, self->prop, attr, buf.buf, raw_type, tot);
+				PyBuffer_Release(&buf);
 			}
-
-			PyBuffer_Release(&buf);
 		}
 
 		/* could not use the buffer, fallback to sequence */
@@ -4620,6 +4688,238 @@ static PyObject *pyrna_prop_collection_foreach_set(BPy_PropertyRNA *self, PyObje
 	return foreach_getset(self, args, 1);
 }
 
+/* Exports the raw data viewed by foreach_view(), holding a reference to the collection. */
+typedef struct BPy_PropertyCollectionViewRNA {
+	PyObject_HEAD
+	BPy_PropertyRNA *collection;
+	void *buf;
+	bool readonly;
+	Py_ssize_t itemsize;
+	const char *format;
+	PyRNA_RawViewShape shape;
+} BPy_PropertyCollectionViewRNA;
+
+static int pyrna_prop_collection_view_getbuffer(BPy_PropertyCollectionViewRNA *self, Py_buffer *view, int flags)
+{
+	view->obj = NULL;
+
+	if ((flags & PyBUF_WRITABLE) && self->readonly) {
+		PyErr_SetString(PyExc_BufferError, "bpy_prop_collection view is read-only");
+		return -1;
+	}
+
+	view->buf = self->buf;
+	view->obj = (PyObject *)self;
+	Py_INCREF(self);
+	view->len = self->shape.len;
+	view->readonly = self->readonly;
+	view->itemsize = self->itemsize;
+	view->format = (flags & PyBUF_FORMAT) ? (char *)self->format : NULL;
+	view->ndim = self->shape.ndim;
+	view->shape = (flags & PyBUF_ND) ? self->shape.shape : NULL;
+	view->strides = ((flags & PyBUF_STRIDES) == PyBUF_STRIDES) ? self->shape.strides : NULL;
+	view->suboffsets = NULL;
+	view->internal = NULL;
+
+	return 0;
+}
+
+static void pyrna_prop_collection_view_dealloc(BPy_PropertyCollectionViewRNA *self)
+{
+	Py_DECREF(self->collection);
+	PyObject_DEL(self);
+}
+
+static PyBufferProcs pyrna_prop_collection_view_as_buffer = {
+	(getbufferproc)pyrna_prop_collection_view_getbuffer,
+	NULL,
+};
+
+static PyTypeObject pyrna_prop_collection_view_Type = {
+	PyVarObject_HEAD_INIT(NULL, 0)
+	"bpy_prop_collection_view", /* tp_name */
+	sizeof(BPy_PropertyCollectionViewRNA), /* tp_basicsize */
+	0,                          /* tp_itemsize */
+	/* methods */
+	(destructor)pyrna_prop_collection_view_dealloc, /* tp_dealloc */
+	NULL,                       /* printfunc tp_print; */
+	NULL,                       /* getattrfunc tp_getattr; */
+	NULL,                       /* setattrfunc tp_setattr; */
+	NULL,                       /* tp_compare */ /* DEPRECATED in python 3.0! */
+	NULL,                       /* tp_repr */
+
+	/* Method suites for standard classes */
+
+	NULL,                       /* PyNumberMethods *tp_as_number; */
+	NULL,                       /* PySequenceMethods *tp_as_sequence; */
+	NULL,                       /* PyMappingMethods *tp_as_mapping; */
+
+	/* More standard operations (here for binary compatibility) */
+
+	NULL,                       /* hashfunc tp_hash; */
+	NULL,                       /* ternaryfunc tp_call; */
+	NULL,                       /* reprfunc tp_str; */
+	NULL,                       /* getattrofunc tp_getattro; */
+	NULL,                       /* setattrofunc tp_setattro; */
+
+	/* Functions to access object as input/output buffer */
+	&pyrna_prop_collection_view_as_buffer, /* PyBufferProcs *tp_as_buffer; */
+
+	/*** Flags to define presence of optional/expanded features ***/
+	Py_TPFLAGS_DEFAULT,         /* long tp_flags; */
+};
+
+PyDoc_STRVAR(pyrna_prop_collection_foreach_view_doc,
+".. method:: foreach_view(attr)\n"
+"\n"
+"   Return a memoryview on an attribute of all items in the collection,\n"
+"   mapping directly onto Blender's data without copying it.\n"
+"   This is only supported for collections stored as arrays (mesh vertices, loops, polygons, uv layer data...)\n"
+"   and attributes stored as plain numbers.\n"
+"\n"
+"   :arg attr: Name of the attribute.\n"
+"   :type attr: string\n"
+"   :return: A view with the number of items as its first dimension, followed by the dimensions of the\n"
+"      attribute, read-only when the attribute can't be set directly.\n"
+"   :rtype: memoryview\n"
+"\n"
+"   .. warning::\n"
+"\n"
+"      The view keeps the collection's Python object alive, not its data.\n"
+"      It's invalidated when the collection changes size or is freed\n"
+"      (e.g. adding vertices or toggling edit-mode), accessing it afterwards can crash Blender.\n"
+);
+static PyObject *pyrna_prop_collection_foreach_view(BPy_PropertyRNA *self, PyObject *value)
+{
+	/* used for the data pointer of empty views */
+	static char empty_buf[sizeof(double)];
+
+	const char *attr = _PyUnicode_AsString(value);
+	PointerRNA itemptr;
+	PropertyRNA *itemprop;
+	RawArray raw;
+	bool is_editable;
+	int dims[PYRNA_VIEW_MAX_DIMENSION], dims_len = 0;
+	BPy_PropertyCollectionViewRNA *view;
+	PyObject *ret;
+
+	PYRNA_PROP_CHECK_OBJ(self);
+
+	if (attr == NULL) {
+		PyErr_Format(PyExc_TypeError,
+		             "foreach_view(attr): expected a string, not %.200s",
+		             Py_TYPE(value)->tp_name);
+		return NULL;
+	}
+
+	/* look up the attribute from the item type, so this works for empty collections too */
+	RNA_pointer_create(self->ptr.id.data, RNA_property_pointer_type(&self->ptr, self->prop), NULL, &itemptr);
+	itemprop = RNA_struct_find_property(&itemptr, attr);
+
+	if (itemprop == NULL) {
+		PyErr_Format(PyExc_AttributeError,
+		             "foreach_view '%.200s.%200s[...]' elements have no attribute '%.200s'",
+		             RNA_struct_identifier(self->ptr.type), RNA_property_identifier(self->prop), attr);
+		return NULL;
+	}
+
+	if (RNA_property_array_check(itemprop)) {
+		dims_len = RNA_property_array_dimension(&itemptr, itemprop, dims);
+	}
+
+	if ((dims_len >= PYRNA_VIEW_MAX_DIMENSION) ||
+	    !RNA_property_collection_raw_view(&self->ptr, self->prop, itemprop, &raw, &is_editable))
+	{
+		PyErr_Format(PyExc_AttributeError,
+		             "foreach_view '%.200s.%200s[...].%.200s' isn't stored as an array and can't be viewed, "
+		             "use foreach_get/set instead",
+		             RNA_struct_identifier(self->ptr.type), RNA_property_identifier(self->prop), attr);
+		return NULL;
+	}
+
+	view = PyObject_New(BPy_PropertyCollectionViewRNA, &pyrna_prop_collection_view_Type);
+	if (view == NULL) {
+		return NULL;
+	}
+
+	view->collection = self;
+	Py_INCREF(self);
+	view->buf = raw.array ? raw.array : empty_buf;
+	view->readonly = !is_editable;
+	view->itemsize = RNA_raw_type_sizeof(raw.type);
+	view->format = foreach_raw_buffer_format(raw.type, RNA_property_subtype(itemprop) != PROP_UNSIGNED);
+	pyrna_raw_view_shape(&view->shape, &raw, raw.len, dims, dims_len);
+
+	/* the memoryview holds the exporter, which holds the collection */
+	ret = PyMemoryView_FromObject((PyObject *)view);
+	Py_DECREF(view);
+
+	return ret;
+}
+
+/* Buffer interface of arrays stored directly in DNA, so they can be used without copying,
+ * e.g. numpy.asarray(pose_bone.matrix). */
+static int pyrna_prop_array_getbuffer(BPy_PropertyArrayRNA *self, Py_buffer *view, int flags)
+{
+	RawArray raw;
+	bool is_editable;
+	int dims[PYRNA_VIEW_MAX_DIMENSION], dims_len;
+	PyRNA_RawViewShape *shape;
+
+	view->obj = NULL;
+
+	PYRNA_PROP_CHECK_INT((BPy_PropertyRNA *)self);
+
+	dims_len = RNA_property_array_dimension(&self->ptr, self->prop, dims);
+
+	if ((dims_len >= PYRNA_VIEW_MAX_DIMENSION) ||
+	    !RNA_property_raw_view(&self->ptr, self->prop, &raw, &is_editable))
+	{
+		PyErr_Format(PyExc_BufferError,
+		             "bpy_prop_array '%.200s' isn't stored as an array, it doesn't support the buffer interface",
+		             RNA_property_identifier(self->prop));
+		return -1;
+	}
+
+	if ((flags & PyBUF_WRITABLE) && !is_editable) {
+		PyErr_Format(PyExc_BufferError,
+		             "bpy_prop_array '%.200s' is read-only",
+		             RNA_property_identifier(self->prop));
+		return -1;
+	}
+
+	/* sub-arrays of multi-dimensional arrays, e.g. matrix[1] */
+	shape = PyMem_Malloc(sizeof(*shape));
+	pyrna_raw_view_shape(shape, &raw, -1, dims + self->arraydim, dims_len - self->arraydim);
+
+	view->buf = (char *)raw.array + (self->arrayoffset * raw.stride);
+	view->obj = (PyObject *)self;
+	Py_INCREF(self);
+	view->len = shape->len;
+	view->readonly = !is_editable;
+	view->itemsize = raw.stride;
+	view->format = (flags & PyBUF_FORMAT) ?
+	               (char *)foreach_raw_buffer_format(raw.type, RNA_property_subtype(self->prop) != PROP_UNSIGNED) :
+	               NULL;
+	view->ndim = shape->ndim;
+	view->shape = (flags & PyBUF_ND) ? shape->shape : NULL;
+	view->strides = ((flags & PyBUF_STRIDES) == PyBUF_STRIDES) ? shape->strides : NULL;
+	view->suboffsets = NULL;
+	view->internal = shape;
+
+	return 0;
+}
+
+static void pyrna_prop_array_releasebuffer(BPy_PropertyArrayRNA *UNUSED(self), Py_buffer *view)
+{
+	PyMem_Free(view->internal);
+}
+
+static PyBufferProcs pyrna_prop_array_as_buffer = {
+	(getbufferproc)pyrna_prop_array_getbuffer,
+	(releasebufferproc)pyrna_prop_array_releasebuffer,
+};
+
 /* A bit of a kludge, make a list out of a collection or array,
  * then return the lists iter function, not especially fast but convenient for now */
 static PyObject *pyrna_prop_array_iter(BPy_PropertyArrayRNA *self)
@@ -4716,6 +5016,7 @@ static struct PyMethodDef pyrna_prop_array_methods[] = {
 static struct PyMethodDef pyrna_prop_collection_methods[] = {
 	{"foreach_get", (PyCFunction)pyrna_prop_collection_foreach_get, METH_VARARGS, pyrna_prop_collection_foreach_get_doc},
 	{"foreach_set", (PyCFunction)pyrna_prop_collection_foreach_set, METH_VARARGS, pyrna_prop_collection_foreach_set_doc},
+	{"foreach_view", (PyCFunction)pyrna_prop_collection_foreach_view, METH_O, pyrna_prop_collection_foreach_view_doc},
 
 	{"keys", (PyCFunction)pyrna_prop_collection_keys, METH_NOARGS, pyrna_prop_collection_keys_doc},
 	{"items", (PyCFunction)pyrna_prop_collection_items, METH_NOARGS, pyrna_prop_collection_items_doc},
@@ -5613,7 +5914,7 @@ PyTypeObject pyrna_prop_array_Type = {
 	NULL,                       /* setattrofunc tp_setattro; */
 
 	/* Functions to access object as input/output buffer */
-	NULL,                       /* PyBufferProcs *tp_as_buffer; */
+	&pyrna_prop_array_as_buffer, /* PyBufferProcs *tp_as_buffer; */
 
 	/*** Flags to define presence of optional/expanded features ***/
 	Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, /* long tp_flags; */
@@ -6491,6 +6792,9 @@ void BPY_rna_init(void)
 	if (PyType_Ready(&pyrna_func_Type) < 0)
 		return;
 
+	if (PyType_Ready(&pyrna_prop_collection_view_Type) < 0)
+		return;
+
 #ifdef USE_PYRNA_ITER
 	if (PyType_Ready(&pyrna_prop_collection_iter_Type) < 0)
 		return;
@@ -212,7 +212,7 @@ int mathutils_array_parse_alloc_v(float **array, int array_dim, PyObject *value,
 		fp = *array = PyMem_Malloc(size * array_dim * sizeof(float));
 
 		for (i = 0; i < size; i++, fp += array_dim) {
-			PyObject *item = PySequence_Fast_GET_ITEM(value, i);
+			PyObject *item = PySequence_Fast_GET_ITEM(value_fast, i);
 
 			if (mathutils_array_parse(fp, array_dim, array_dim, item, error_prefix) == -1) {
 				PyMem_Free(*array);
@@ -457,6 +457,78 @@ void BaseMathObject_dealloc(BaseMathObject *self)
 	Py_TYPE(self)->tp_free(self); // PyObject_DEL(self); // breaks subtypes
 }
 
+/* Buffer interface: the exported buffer is a read-only copy of the values, taken when it's requested.
+ * The objects hold only a few values, and their own storage can be resized or be
+ * a copy read through a callback, which a buffer pointing into it wouldn't follow. */
+typedef struct BaseMathBuffer {
+	Py_ssize_t shape[2];
+	Py_ssize_t strides[2];
+	float data[1];  /* allocated to the number of values */
+} BaseMathBuffer;
+
+/**
+ * Start exporting a buffer of \a ndim dimensions, C contiguous.
+ *
+ * \return the values of the buffer for the caller to fill in, or NULL with an exception set.
+ */
+float *BaseMathObject_buffer_begin(BaseMathObject *self, Py_buffer *view, int flags,
+                                   const int ndim, const int shape[2])
+{
+	BaseMathBuffer *buffer;
+	Py_ssize_t len = 1;
+	int i;
+
+	BLI_assert(ndim >= 1 && ndim <= 2);
+
+	view->obj = NULL;
+
+	if (flags & PyBUF_WRITABLE) {
+		PyErr_Format(PyExc_BufferError,
+		             "%.200s: buffer is a read-only copy of the values",
+		             Py_TYPE(self)->tp_name);
+		return NULL;
+	}
+
+	if (BaseMath_ReadCallback(self) == -1) {
+		return NULL;
+	}
+
+	for (i = 0; i < ndim; i++) {
+		len *= shape[i];
+	}
+
+	buffer = PyMem_Malloc(sizeof(BaseMathBuffer) + sizeof(float) * (size_t)(len - 1));
+	if (buffer == NULL) {
+		PyErr_NoMemory();
+		return NULL;
+	}
+
+	for (i = ndim - 1; i >= 0; i--) {
+		buffer->shape[i] = shape[i];
+		buffer->strides[i] = (i == ndim - 1) ? sizeof(float) : buffer->strides[i + 1] * shape[i + 1];
+	}
+
+	view->buf = buffer->data;
+	view->obj = (PyObject *)self;
+	Py_INCREF(self);
+	view->len = len * (Py_ssize_t)sizeof(float);
+	view->readonly = 1;
+	view->itemsize = sizeof(float);
+	view->format = (flags & PyBUF_FORMAT) ? (char *)"f" : NULL;
+	view->ndim = ndim;
+	view->shape = (flags & PyBUF_ND) ? buffer->shape : NULL;
+	view->strides = ((flags & PyBUF_STRIDES) == PyBUF_STRIDES) ? buffer->strides : NULL;
+	view->suboffsets = NULL;
+	view->internal = buffer;
+
+	return buffer->data;
+}
+
+void BaseMathObject_releasebuffer(BaseMathObject *UNUSED(self), Py_buffer *view)
+{
+	PyMem_Free(view->internal);
+}
+
 /*----------------------------MODULE INIT-------------------------*/
 static struct PyMethodDef M_Mathutils_methods[] = {
 	{NULL, NULL, 0, NULL}
@@ -476,6 +548,7 @@ static struct PyModuleDef M_Mathutils_module_def = {
 
 
 /* submodules only */
+#include "mathutils_bvhtree.h"
 #include "mathutils_geometry.h"
 #include "mathutils_kdtree.h"
 #include "mathutils_noise.h"
@@ -526,6 +599,11 @@ PyMODINIT_FUNC PyInit_mathutils(void)
 	PyModule_AddObject(mod, "kdtree", (submodule = PyInit_mathutils_kdtree()));
 	PyDict_SetItemString(sys_modules, PyModule_GetName(submodule), submodule);
 	Py_INCREF(submodule);
+
+	/* BVHTree submodule */
+	PyModule_AddObject(mod, "bvhtree", (submodule = PyInit_mathutils_bvhtree()));
+	PyDict_SetItemString(sys_modules, PyModule_GetName(submodule), submodule);
+	Py_INCREF(submodule);
 #endif
 
 	mathutils_matrix_row_cb_index = Mathutils_RegisterCallback(&mathutils_matrix_row_cb);
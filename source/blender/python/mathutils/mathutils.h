@@ -62,6 +62,10 @@ int BaseMathObject_traverse(BaseMathObject *self, visitproc visit, void *arg);
 int BaseMathObject_clear(BaseMathObject *self);
 void BaseMathObject_dealloc(BaseMathObject *self);
 
+float *BaseMathObject_buffer_begin(BaseMathObject *self, Py_buffer *view, int flags,
+                                   const int ndim, const int shape[2]);
+void BaseMathObject_releasebuffer(BaseMathObject *self, Py_buffer *view);
+
 PyMODINIT_FUNC PyInit_mathutils(void);
 
 int EXPP_FloatsAreEqual(float A, float B, int floatSteps);
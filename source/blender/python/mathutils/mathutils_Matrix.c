@@ -2193,6 +2193,32 @@ static PyMappingMethods Matrix_AsMapping = {
 	(objobjargproc)Matrix_ass_subscript
 };
 
+/* read-only copy of the values in rows like the matrix is indexed, e.g. numpy.asarray(pose_bone.matrix) */
+static int Matrix_getbuffer(MatrixObject *self, Py_buffer *view, int flags)
+{
+	const int shape[2] = {self->num_row, self->num_col};
+	float *data = BaseMathObject_buffer_begin((BaseMathObject *)self, view, flags, 2, shape);
+	int row, col;
+
+	if (data == NULL) {
+		return -1;
+	}
+
+	/* the matrix stores its columns one after the other */
+	for (row = 0; row < self->num_row; row++) {
+		for (col = 0; col < self->num_col; col++) {
+			*data++ = MATRIX_ITEM(self, row, col);
+		}
+	}
+
+	return 0;
+}
+
+static PyBufferProcs Matrix_AsBuffer = {
+	(getbufferproc)Matrix_getbuffer,
+	(releasebufferproc)BaseMathObject_releasebuffer,
+};
+
 
 static PyNumberMethods Matrix_NumMethods = {
 	(binaryfunc)    Matrix_add,     /*nb_add*/
@@ -2472,7 +2498,7 @@ PyTypeObject matrix_Type = {
 #endif
 	NULL,                               /*tp_getattro*/
 	NULL,                               /*tp_setattro*/
-	NULL,                               /*tp_as_buffer*/
+	&Matrix_AsBuffer,                   /*tp_as_buffer*/
 	Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | Py_TPFLAGS_HAVE_GC, /*tp_flags*/
 	matrix_doc,                         /*tp_doc*/
 	(traverseproc)BaseMathObject_traverse,  /* tp_traverse */
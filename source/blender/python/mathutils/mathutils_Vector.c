@@ -2043,6 +2043,26 @@ static PyMappingMethods Vector_AsMapping = {
 	(objobjargproc)Vector_ass_subscript
 };
 
+/* read-only copy of the values, e.g. numpy.asarray(vertex.co) */
+static int Vector_getbuffer(VectorObject *self, Py_buffer *view, int flags)
+{
+	const int shape[2] = {self->size, 0};
+	float *data = BaseMathObject_buffer_begin((BaseMathObject *)self, view, flags, 1, shape);
+
+	if (data == NULL) {
+		return -1;
+	}
+
+	memcpy(data, self->vec, sizeof(float) * (size_t)self->size);
+
+	return 0;
+}
+
+static PyBufferProcs Vector_AsBuffer = {
+	(getbufferproc)Vector_getbuffer,
+	(releasebufferproc)BaseMathObject_releasebuffer,
+};
+
 
 static PyNumberMethods Vector_NumMethods = {
 	(binaryfunc)    Vector_add, /*nb_add*/
@@ -2831,7 +2851,7 @@ PyTypeObject vector_Type = {
 	NULL,                       /* setattrofunc tp_setattro; */
 
 	/* Functions to access object as input/output buffer */
-	NULL,                       /* PyBufferProcs *tp_as_buffer; */
+	&Vector_AsBuffer,           /* PyBufferProcs *tp_as_buffer; */
 
 	/*** Flags to define presence of optional/expanded features ***/
 	Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | Py_TPFLAGS_HAVE_GC,
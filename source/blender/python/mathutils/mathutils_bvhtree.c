@@ -0,0 +1,1348 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/python/mathutils/mathutils_bvhtree.c
+ *  \ingroup mathutils
+ *
+ * This file defines the 'mathutils.bvhtree' module, a general purpose module to access
+ * blenders bvhtree for mesh surface nearest-element search and ray casting.
+ *
+ * Besides the single query methods, batched variants take buffers of queries
+ * and run them on the task scheduler with the GIL released.
+ */
+
+#include <Python.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_kdopbvh.h"
+#include "BLI_math.h"
+#include "BLI_polyfill2d.h"
+
+#ifndef MATH_STANDALONE
+#include "DNA_object_types.h"
+#include "DNA_meshdata_types.h"
+
+#include "BLI_task.h"
+#include "BLI_threads.h"
+
+#include "BKE_customdata.h"
+#include "BKE_DerivedMesh.h"
+
+#include "bmesh.h"
+
+#include "../bmesh/bmesh_py_types.h"
+#endif  /* MATH_STANDALONE */
+
+#include "../generic/py_capi_utils.h"
+
+#include "mathutils.h"
+#include "mathutils_bvhtree.h"  /* own include */
+
+#include "BLI_strict_flags.h"
+
+typedef struct {
+	PyObject_HEAD
+	BVHTree *tree;  /* NULL when there are no triangles */
+	float epsilon;
+
+	float (*coords)[3];
+	unsigned int (*tris)[3];
+	unsigned int coords_len, tris_len;
+
+	/* Optional members */
+	/* aligned with 'tris', maps triangles to the polygons they were created from */
+	int *orig_index;
+} PyBVHTree;
+
+/* same values as BKE_bvhutils */
+#define PY_BVH_TREE_TYPE_DEFAULT 4
+#define PY_BVH_AXIS_DEFAULT 6
+
+/* number of queries each task of a batch handles */
+#define PY_BVH_BATCH_CHUNK_SIZE 256
+
+
+/* -------------------------------------------------------------------- */
+/* Utility helper functions */
+
+static PyObject *bvhtree_CreatePyObject(
+        BVHTree *tree, float epsilon,
+        float (*coords)[3], unsigned int coords_len,
+        unsigned int (*tris)[3], unsigned int tris_len,
+        int *orig_index)
+{
+	PyBVHTree *result = PyObject_New(PyBVHTree, &PyBVHTree_Type);
+
+	result->tree = tree;
+	result->epsilon = epsilon;
+
+	result->coords = coords;
+	result->tris = tris;
+	result->coords_len = coords_len;
+	result->tris_len = tris_len;
+
+	result->orig_index = orig_index;
+
+	return (PyObject *)result;
+}
+
+/* Build the tree from triangles, returns NULL when there are none to insert */
+static BVHTree *bvhtree_from_tris(
+        const float (*coords)[3],
+        const unsigned int (*tris)[3], unsigned int tris_len,
+        float epsilon)
+{
+	BVHTree *tree;
+	unsigned int i;
+
+	if (tris_len == 0) {
+		return NULL;
+	}
+
+	tree = BLI_bvhtree_new((int)tris_len, epsilon, PY_BVH_TREE_TYPE_DEFAULT, PY_BVH_AXIS_DEFAULT);
+
+	for (i = 0; i < tris_len; i++) {
+		float co[3][3];
+
+		copy_v3_v3(co[0], coords[tris[i][0]]);
+		copy_v3_v3(co[1], coords[tris[i][1]]);
+		copy_v3_v3(co[2], coords[tris[i][2]]);
+
+		BLI_bvhtree_insert(tree, (int)i, co[0], 3);
+	}
+
+	BLI_bvhtree_balance(tree);
+
+	return tree;
+}
+
+BLI_INLINE void bvhtree_tri_coords(const PyBVHTree *self, int index, const float *r_tri_co[3])
+{
+	const unsigned int *tri = self->tris[index];
+
+	r_tri_co[0] = self->coords[tri[0]];
+	r_tri_co[1] = self->coords[tri[1]];
+	r_tri_co[2] = self->coords[tri[2]];
+}
+
+BLI_INLINE int bvhtree_orig_index(const PyBVHTree *self, int index)
+{
+	return self->orig_index ? self->orig_index[index] : index;
+}
+
+static PyObject *py_bvhtree_result_to_py(
+        const PyBVHTree *self, int index, const float co[3], const float no[3], float dist)
+{
+	PyObject *py_retval = PyTuple_New(4);
+
+	if (index != -1) {
+		PyTuple_SET_ITEM(py_retval, 0, Vector_CreatePyObject((float *)co, 3, Py_NEW, NULL));
+		PyTuple_SET_ITEM(py_retval, 1, Vector_CreatePyObject((float *)no, 3, Py_NEW, NULL));
+		PyTuple_SET_ITEM(py_retval, 2, PyLong_FromLong(bvhtree_orig_index(self, index)));
+		PyTuple_SET_ITEM(py_retval, 3, PyFloat_FromDouble(dist));
+	}
+	else {
+		PyC_Tuple_Fill(py_retval, Py_None);
+	}
+
+	return py_retval;
+}
+
+static PyObject *py_bvhtree_raycast_to_py(const PyBVHTree *self, const BVHTreeRayHit *hit)
+{
+	return py_bvhtree_result_to_py(self, hit->index, hit->co, hit->no, hit->dist);
+}
+
+static PyObject *py_bvhtree_nearest_to_py(const PyBVHTree *self, const BVHTreeNearest *nearest)
+{
+	return py_bvhtree_result_to_py(self, nearest->index, nearest->co, nearest->no, sqrtf(nearest->dist_sq));
+}
+
+/* Parse 3d coordinates into a newly allocated array (free with PyMem_Free).
+ * Contiguous float or double buffers (numpy arrays for e.g.) are read directly,
+ * otherwise the value is parsed as a sequence of vectors.
+ * Returns the number of coordinates, -1 on error. */
+static int py_bvhtree_parse_points(PyObject *value, float (**r_points)[3], const char *error_prefix)
+{
+	*r_points = NULL;
+
+	if (PyObject_CheckBuffer(value)) {
+		Py_buffer view;
+		const char *format;
+		float *points;
+		Py_ssize_t i, len;
+
+		if (PyObject_GetBuffer(value, &view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) == -1) {
+			return -1;
+		}
+
+		/* only native byte order */
+		format = view.format ? view.format : "B";
+		if (ELEM(format[0], '@', '=')) {
+			format++;
+		}
+
+		if (!(ELEM(format[0], 'f', 'd') && format[1] == '\0') ||
+		    (view.len % (view.itemsize * 3)) != 0)
+		{
+			PyErr_Format(PyExc_TypeError,
+			             "%.200s: expected a buffer of float or double triplets, not '%.200s'",
+			             error_prefix, view.format ? view.format : "B");
+			PyBuffer_Release(&view);
+			return -1;
+		}
+
+		len = view.len / view.itemsize;
+		if (len / 3 > INT_MAX) {
+			PyErr_Format(PyExc_ValueError, "%.200s: buffer too large", error_prefix);
+			PyBuffer_Release(&view);
+			return -1;
+		}
+
+		points = PyMem_Malloc(sizeof(float) * (size_t)(len ? len : 1));
+		if (format[0] == 'f') {
+			memcpy(points, view.buf, sizeof(float) * (size_t)len);
+		}
+		else {
+			const double *buf = view.buf;
+			for (i = 0; i < len; i++) {
+				points[i] = (float)buf[i];
+			}
+		}
+
+		PyBuffer_Release(&view);
+
+		*r_points = (float (*)[3])points;
+		return (int)(len / 3);
+	}
+	else {
+		float *points = NULL;
+		int len = mathutils_array_parse_alloc_v(&points, 3, value, error_prefix);
+
+		*r_points = (float (*)[3])points;
+		return len;
+	}
+}
+
+
+/* -------------------------------------------------------------------- */
+/* Tree query callbacks */
+
+static void py_bvhtree_raycast_cb(void *userdata, int index, const BVHTreeRay *ray, BVHTreeRayHit *hit)
+{
+	const PyBVHTree *self = userdata;
+	const float *tri_co[3];
+	float dist;
+	bool is_hit;
+
+	bvhtree_tri_coords(self, index, tri_co);
+
+	if (self->epsilon == 0.0f) {
+		is_hit = isect_ray_tri_v3(ray->origin, ray->direction, UNPACK3(tri_co), &dist, NULL);
+	}
+	else {
+		is_hit = isect_ray_tri_epsilon_v3(ray->origin, ray->direction, UNPACK3(tri_co), &dist, NULL,
+		                                  self->epsilon);
+	}
+
+	if (is_hit && dist < hit->dist) {
+		hit->index = index;
+		hit->dist = dist;
+		madd_v3_v3v3fl(hit->co, ray->origin, ray->direction, dist);
+		normal_tri_v3(hit->no, UNPACK3(tri_co));
+	}
+}
+
+static void py_bvhtree_nearest_point_cb(void *userdata, int index, const float co[3], BVHTreeNearest *nearest)
+{
+	const PyBVHTree *self = userdata;
+	const float *tri_co[3];
+	float nearest_tmp[3], dist_sq;
+
+	bvhtree_tri_coords(self, index, tri_co);
+
+	closest_on_tri_to_point_v3(nearest_tmp, co, UNPACK3(tri_co));
+	dist_sq = len_squared_v3v3(co, nearest_tmp);
+
+	if (dist_sq < nearest->dist_sq) {
+		nearest->index = index;
+		nearest->dist_sq = dist_sq;
+		copy_v3_v3(nearest->co, nearest_tmp);
+		normal_tri_v3(nearest->no, UNPACK3(tri_co));
+	}
+}
+
+/* the direction doesn't need to be normalized, but must not be zero length */
+static void bvhtree_ray_cast(const PyBVHTree *self, const float co[3], const float dir[3], float max_dist,
+                             BVHTreeRayHit *hit)
+{
+	hit->index = -1;
+	hit->dist = max_dist;
+
+	if (self->tree) {
+		BLI_bvhtree_ray_cast(self->tree, co, dir, 0.0f, hit, py_bvhtree_raycast_cb, (void *)self);
+	}
+}
+
+static void bvhtree_find_nearest(const PyBVHTree *self, const float co[3], float max_dist,
+                                 BVHTreeNearest *nearest)
+{
+	nearest->index = -1;
+	nearest->dist_sq = max_dist * max_dist;
+
+	if (self->tree) {
+		BLI_bvhtree_find_nearest(self->tree, co, nearest, py_bvhtree_nearest_point_cb, (void *)self);
+	}
+}
+
+
+/* -------------------------------------------------------------------- */
+/* Batched queries */
+
+typedef struct PyBVHTree_Batch {
+	const PyBVHTree *self;
+	const float (*origins)[3];
+	const float (*directions)[3];
+	float max_dist;
+
+	/* one of these is set, the query type depends on it */
+	BVHTreeRayHit *hits;
+	BVHTreeNearest *nearest;
+} PyBVHTree_Batch;
+
+typedef struct PyBVHTree_BatchChunk {
+	unsigned int start, end;
+} PyBVHTree_BatchChunk;
+
+static void bvhtree_batch_range(const PyBVHTree_Batch *batch, unsigned int start, unsigned int end)
+{
+	unsigned int i;
+
+	for (i = start; i < end; i++) {
+		if (batch->hits) {
+			if (is_zero_v3(batch->directions[i])) {
+				batch->hits[i].index = -1;
+			}
+			else {
+				bvhtree_ray_cast(batch->self, batch->origins[i], batch->directions[i], batch->max_dist,
+				                 &batch->hits[i]);
+			}
+		}
+		else {
+			bvhtree_find_nearest(batch->self, batch->origins[i], batch->max_dist, &batch->nearest[i]);
+		}
+	}
+}
+
+#ifndef MATH_STANDALONE
+static void bvhtree_batch_task(TaskPool *pool, void *taskdata, int UNUSED(threadid))
+{
+	const PyBVHTree_Batch *batch = BLI_task_pool_userdata(pool);
+	const PyBVHTree_BatchChunk *chunk = taskdata;
+
+	bvhtree_batch_range(batch, chunk->start, chunk->end);
+}
+#endif
+
+/* Runs the queries, must be called without holding the GIL */
+static void bvhtree_batch_run(PyBVHTree_Batch *batch, unsigned int len)
+{
+#ifndef MATH_STANDALONE
+	if (len > PY_BVH_BATCH_CHUNK_SIZE) {
+		TaskScheduler *scheduler = BLI_task_scheduler_get();
+		TaskPool *pool = BLI_task_pool_create(scheduler, batch);
+		unsigned int start;
+
+		for (start = 0; start < len; start += PY_BVH_BATCH_CHUNK_SIZE) {
+			PyBVHTree_BatchChunk *chunk = MEM_mallocN(sizeof(*chunk), __func__);
+
+			chunk->start = start;
+			chunk->end = (len - start > PY_BVH_BATCH_CHUNK_SIZE) ? start + PY_BVH_BATCH_CHUNK_SIZE : len;
+
+			BLI_task_pool_push(pool, bvhtree_batch_task, chunk, true, TASK_PRIORITY_LOW);
+		}
+
+		BLI_task_pool_work_and_wait(pool);
+		BLI_task_pool_free(pool);
+		return;
+	}
+#endif
+
+	bvhtree_batch_range(batch, 0, len);
+}
+
+
+/* -------------------------------------------------------------------- */
+/* BVHTree */
+
+static void PyBVHTree__tp_dealloc(PyBVHTree *self)
+{
+	if (self->tree) {
+		BLI_bvhtree_free(self->tree);
+	}
+
+	MEM_SAFE_FREE(self->coords);
+	MEM_SAFE_FREE(self->tris);
+	MEM_SAFE_FREE(self->orig_index);
+
+	PyObject_Del(self);
+}
+
+PyDoc_STRVAR(py_bvhtree_ray_cast_doc,
+".. method:: ray_cast(origin, direction, distance=sys.float_info.max)\n"
+"\n"
+"   Cast a ray onto the mesh.\n"
+"\n"
+"   :arg origin: Start location of the ray in object space.\n"
+"   :type origin: :class:`Vector`\n"
+"   :arg direction: Direction of the ray in object space.\n"
+"   :type direction: :class:`Vector`\n"
+"   :arg distance: Maximum distance to search for hits.\n"
+"   :type distance: float\n"
+"   :return: Returns a tuple (:class:`Vector` location, :class:`Vector` normal, int index, float distance),\n"
+"      values will all be None if no hit is found.\n"
+"   :rtype: :class:`tuple`\n"
+);
+static PyObject *py_bvhtree_ray_cast(PyBVHTree *self, PyObject *args, PyObject *kwargs)
+{
+	PyObject *py_co, *py_direction;
+	float co[3], direction[3];
+	float max_dist = FLT_MAX;
+	BVHTreeRayHit hit;
+	const char *keywords[] = {"origin", "direction", "distance", NULL};
+
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, (char *) "OO|f:ray_cast", (char **)keywords,
+	                                 &py_co, &py_direction, &max_dist))
+	{
+		return NULL;
+	}
+
+	if ((mathutils_array_parse(co, 3, 3, py_co, "ray_cast: invalid 'origin' arg") == -1) ||
+	    (mathutils_array_parse(direction, 3, 3, py_direction, "ray_cast: invalid 'direction' arg") == -1))
+	{
+		return NULL;
+	}
+
+	if (is_zero_v3(direction)) {
+		PyErr_SetString(PyExc_ValueError, "ray_cast: zero length 'direction' given");
+		return NULL;
+	}
+
+	bvhtree_ray_cast(self, co, direction, max_dist, &hit);
+
+	return py_bvhtree_raycast_to_py(self, &hit);
+}
+
+PyDoc_STRVAR(py_bvhtree_find_nearest_doc,
+".. method:: find_nearest(origin, distance=sys.float_info.max)\n"
+"\n"
+"   Find the nearest point on the mesh surface to ``origin``.\n"
+"\n"
+"   :arg origin: Find nearest surface point to this location.\n"
+"   :type origin: :class:`Vector`\n"
+"   :arg distance: Maximum distance to search.\n"
+"   :type distance: float\n"
+"   :return: Returns a tuple (:class:`Vector` location, :class:`Vector` normal, int index, float distance),\n"
+"      values will all be None if no surface is found within ``distance``.\n"
+"   :rtype: :class:`tuple`\n"
+);
+static PyObject *py_bvhtree_find_nearest(PyBVHTree *self, PyObject *args, PyObject *kwargs)
+{
+	PyObject *py_co;
+	float co[3];
+	float max_dist = FLT_MAX;
+	BVHTreeNearest nearest;
+	const char *keywords[] = {"origin", "distance", NULL};
+
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, (char *) "O|f:find_nearest", (char **)keywords,
+	                                 &py_co, &max_dist))
+	{
+		return NULL;
+	}
+
+	if (mathutils_array_parse(co, 3, 3, py_co, "find_nearest: invalid 'origin' arg") == -1) {
+		return NULL;
+	}
+
+	bvhtree_find_nearest(self, co, max_dist, &nearest);
+
+	return py_bvhtree_nearest_to_py(self, &nearest);
+}
+
+typedef struct PyBVHTree_RangeData {
+	const PyBVHTree *self;
+	const float *co;
+	float dist_sq;
+	PyObject *result;
+} PyBVHTree_RangeData;
+
+static void py_bvhtree_range_cb(void *userdata, int index, float UNUSED(dist_sq_bvh))
+{
+	PyBVHTree_RangeData *data = userdata;
+	const float *tri_co[3];
+	float co[3], no[3], dist_sq;
+
+	bvhtree_tri_coords(data->self, index, tri_co);
+
+	/* the tree only checks the bounds, test against the triangle itself */
+	closest_on_tri_to_point_v3(co, data->co, UNPACK3(tri_co));
+	dist_sq = len_squared_v3v3(data->co, co);
+
+	if (dist_sq <= data->dist_sq) {
+		PyObject *py_item;
+
+		normal_tri_v3(no, UNPACK3(tri_co));
+		py_item = py_bvhtree_result_to_py(data->self, index, co, no, sqrtf(dist_sq));
+		PyList_Append(data->result, py_item);
+		Py_DECREF(py_item);
+	}
+}
+
+PyDoc_STRVAR(py_bvhtree_find_range_doc,
+".. method:: find_range(origin, distance)\n"
+"\n"
+"   Find all surfaces within ``distance`` of ``origin``.\n"
+"\n"
+"   :arg origin: 3d coordinates.\n"
+"   :type origin: :class:`Vector`\n"
+"   :arg distance: Maximum distance to search.\n"
+"   :type distance: float\n"
+"   :return: Returns a list of tuples (:class:`Vector` location, :class:`Vector` normal, int index,\n"
+"      float distance), one for each triangle in range.\n"
+"   :rtype: :class:`list`\n"
+);
+static PyObject *py_bvhtree_find_range(PyBVHTree *self, PyObject *args, PyObject *kwargs)
+{
+	PyObject *py_co;
+	float co[3];
+	float max_dist;
+	PyBVHTree_RangeData data;
+	const char *keywords[] = {"origin", "distance", NULL};
+
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, (char *) "Of:find_range", (char **)keywords,
+	                                 &py_co, &max_dist))
+	{
+		return NULL;
+	}
+
+	if (mathutils_array_parse(co, 3, 3, py_co, "find_range: invalid 'origin' arg") == -1) {
+		return NULL;
+	}
+
+	if (max_dist < 0.0f) {
+		PyErr_SetString(PyExc_ValueError, "find_range: negative 'distance' given");
+		return NULL;
+	}
+
+	data.self = self;
+	data.co = co;
+	data.dist_sq = max_dist * max_dist;
+	data.result = PyList_New(0);
+
+	if (self->tree) {
+		BLI_bvhtree_range_query(self->tree, co, max_dist, py_bvhtree_range_cb, &data);
+	}
+
+	return data.result;
+}
+
+/* Exact test for two triangles crossing, from their edges crossing the other triangle.
+ * Coplanar triangles are not considered intersecting. */
+static bool bvhtree_tri_tri_edges_isect(const float *tri_a[3], const float *tri_b[3])
+{
+	unsigned int i_prev, i;
+
+	for (i_prev = 2, i = 0; i < 3; i_prev = i++) {
+		float lambda;
+		if (isect_line_tri_v3(tri_a[i_prev], tri_a[i], UNPACK3(tri_b), &lambda, NULL)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool bvhtree_overlap_tris(const PyBVHTree *tree_a, int index_a, const PyBVHTree *tree_b, int index_b)
+{
+	const float *tri_a_co[3], *tri_b_co[3];
+
+	if (tree_a == tree_b) {
+		const unsigned int *tri_a = tree_a->tris[index_a];
+		const unsigned int *tri_b = tree_b->tris[index_b];
+
+		/* triangles touching themselves or their neighbors aren't overlapping */
+		unsigned int i;
+
+		for (i = 0; i < 3; i++) {
+			if (ELEM3(tri_a[i], tri_b[0], tri_b[1], tri_b[2])) {
+				return false;
+			}
+		}
+	}
+
+	bvhtree_tri_coords(tree_a, index_a, tri_a_co);
+	bvhtree_tri_coords(tree_b, index_b, tri_b_co);
+
+	return (bvhtree_tri_tri_edges_isect(tri_a_co, tri_b_co) ||
+	        bvhtree_tri_tri_edges_isect(tri_b_co, tri_a_co));
+}
+
+static int bvhtree_overlap_cmp(const void *a_v, const void *b_v)
+{
+	const BVHTreeOverlap *a = a_v, *b = b_v;
+
+	if      (a->indexA < b->indexA) return -1;
+	else if (a->indexA > b->indexA) return  1;
+	else if (a->indexB < b->indexB) return -1;
+	else if (a->indexB > b->indexB) return  1;
+	else                            return  0;
+}
+
+PyDoc_STRVAR(py_bvhtree_overlap_doc,
+".. method:: overlap(other_tree)\n"
+"\n"
+"   Find overlapping indices between 2 trees.\n"
+"\n"
+"   :arg other_tree: Other tree to perform overlap test on.\n"
+"   :type other_tree: :class:`BVHTree`\n"
+"   :return: Returns a list of unique index pairs,"
+"      the first index referencing this tree, the second referencing the **other_tree**.\n"
+"   :rtype: :class:`list`\n"
+);
+static PyObject *py_bvhtree_overlap(PyBVHTree *self, PyBVHTree *other)
+{
+	BVHTreeOverlap *overlap;
+	unsigned int overlap_len = 0, overlap_isect_len = 0;
+	unsigned int i;
+	PyObject *ret;
+
+	if (!PyBVHTree_Check(other)) {
+		PyErr_SetString(PyExc_ValueError, "Expected a BVHTree argument");
+		return NULL;
+	}
+
+	if (self->tree == NULL || other->tree == NULL) {
+		return PyList_New(0);
+	}
+
+	overlap = BLI_bvhtree_overlap(self->tree, other->tree, &overlap_len);
+
+	if (overlap == NULL) {
+		return PyList_New(0);
+	}
+
+	/* the tree overlap only checks the bounds */
+	for (i = 0; i < overlap_len; i++) {
+		if (bvhtree_overlap_tris(self, overlap[i].indexA, other, overlap[i].indexB)) {
+			BVHTreeOverlap *ov = &overlap[overlap_isect_len++];
+
+			ov->indexA = bvhtree_orig_index(self, overlap[i].indexA);
+			ov->indexB = bvhtree_orig_index(other, overlap[i].indexB);
+		}
+	}
+
+	/* triangles of the same polygons give duplicate pairs */
+	if (overlap_isect_len > 1 && (self->orig_index || other->orig_index)) {
+		unsigned int overlap_unique_len = 1;
+
+		qsort(overlap, overlap_isect_len, sizeof(*overlap), bvhtree_overlap_cmp);
+
+		for (i = 1; i < overlap_isect_len; i++) {
+			if (bvhtree_overlap_cmp(&overlap[i], &overlap[overlap_unique_len - 1]) != 0) {
+				overlap[overlap_unique_len++] = overlap[i];
+			}
+		}
+		overlap_isect_len = overlap_unique_len;
+	}
+
+	ret = PyList_New((Py_ssize_t)overlap_isect_len);
+
+	for (i = 0; i < overlap_isect_len; i++) {
+		PyObject *item = PyTuple_New(2);
+
+		PyTuple_SET_ITEM(item, 0, PyLong_FromLong(overlap[i].indexA));
+		PyTuple_SET_ITEM(item, 1, PyLong_FromLong(overlap[i].indexB));
+
+		PyList_SET_ITEM(ret, (Py_ssize_t)i, item);
+	}
+
+	MEM_freeN(overlap);
+
+	return ret;
+}
+
+PyDoc_STRVAR(py_bvhtree_ray_cast_batch_doc,
+".. method:: ray_cast_batch(origins, directions, distance=sys.float_info.max)\n"
+"\n"
+"   Cast many rays onto the mesh, using multiple threads.\n"
+"\n"
+"   :arg origins: Start locations of the rays, a contiguous buffer of float or double triplets\n"
+"      (a numpy array of shape (n, 3) for example) or a sequence of vectors.\n"
+"   :arg directions: Directions of the rays, matching ``origins``.\n"
+"   :arg distance: Maximum distance to search for hits.\n"
+"   :type distance: float\n"
+"   :return: Returns a list of tuples in the same format as :class:`BVHTree.ray_cast`.\n"
+"   :rtype: :class:`list`\n"
+);
+static PyObject *py_bvhtree_ray_cast_batch(PyBVHTree *self, PyObject *args, PyObject *kwargs)
+{
+	PyObject *py_origins, *py_directions;
+	float (*origins)[3], (*directions)[3];
+	int origins_len, directions_len;
+	float max_dist = FLT_MAX;
+	PyBVHTree_Batch batch = {NULL};
+	PyObject *ret;
+	int i;
+	const char *keywords[] = {"origins", "directions", "distance", NULL};
+
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, (char *) "OO|f:ray_cast_batch", (char **)keywords,
+	                                 &py_origins, &py_directions, &max_dist))
+	{
+		return NULL;
+	}
+
+	origins_len = py_bvhtree_parse_points(py_origins, &origins, "ray_cast_batch: invalid 'origins' arg");
+	if (origins_len == -1) {
+		return NULL;
+	}
+
+	directions_len = py_bvhtree_parse_points(py_directions, &directions,
+	                                         "ray_cast_batch: invalid 'directions' arg");
+	if (directions_len == -1) {
+		PyMem_Free(origins);
+		return NULL;
+	}
+
+	if (origins_len != directions_len) {
+		PyErr_Format(PyExc_ValueError,
+		             "ray_cast_batch: %d origins and %d directions given, expected the same number",
+		             origins_len, directions_len);
+		PyMem_Free(origins);
+		PyMem_Free(directions);
+		return NULL;
+	}
+
+	batch.self = self;
+	batch.origins = (const float (*)[3])origins;
+	batch.directions = (const float (*)[3])directions;
+	batch.max_dist = max_dist;
+	batch.hits = MEM_mallocN(sizeof(*batch.hits) * (size_t)max_ii(origins_len, 1), __func__);
+
+	Py_BEGIN_ALLOW_THREADS
+	bvhtree_batch_run(&batch, (unsigned int)origins_len);
+	Py_END_ALLOW_THREADS
+
+	ret = PyList_New(origins_len);
+	for (i = 0; i < origins_len; i++) {
+		PyList_SET_ITEM(ret, i, py_bvhtree_raycast_to_py(self, &batch.hits[i]));
+	}
+
+	MEM_freeN(batch.hits);
+	PyMem_Free(origins);
+	PyMem_Free(directions);
+
+	return ret;
+}
+
+PyDoc_STRVAR(py_bvhtree_find_nearest_batch_doc,
+".. method:: find_nearest_batch(origins, distance=sys.float_info.max)\n"
+"\n"
+"   Find the nearest surface points to many locations, using multiple threads.\n"
+"\n"
+"   :arg origins: Locations to search from, a contiguous buffer of float or double triplets\n"
+"      (a numpy array of shape (n, 3) for example) or a sequence of vectors.\n"
+"   :arg distance: Maximum distance to search.\n"
+"   :type distance: float\n"
+"   :return: Returns a list of tuples in the same format as :class:`BVHTree.find_nearest`.\n"
+"   :rtype: :class:`list`\n"
+);
+static PyObject *py_bvhtree_find_nearest_batch(PyBVHTree *self, PyObject *args, PyObject *kwargs)
+{
+	PyObject *py_origins;
+	float (*origins)[3];
+	int origins_len;
+	float max_dist = FLT_MAX;
+	PyBVHTree_Batch batch = {NULL};
+	PyObject *ret;
+	int i;
+	const char *keywords[] = {"origins", "distance", NULL};
+
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, (char *) "O|f:find_nearest_batch", (char **)keywords,
+	                                 &py_origins, &max_dist))
+	{
+		return NULL;
+	}
+
+	origins_len = py_bvhtree_parse_points(py_origins, &origins, "find_nearest_batch: invalid 'origins' arg");
+	if (origins_len == -1) {
+		return NULL;
+	}
+
+	batch.self = self;
+	batch.origins = (const float (*)[3])origins;
+	batch.max_dist = max_dist;
+	batch.nearest = MEM_mallocN(sizeof(*batch.nearest) * (size_t)max_ii(origins_len, 1), __func__);
+
+	Py_BEGIN_ALLOW_THREADS
+	bvhtree_batch_run(&batch, (unsigned int)origins_len);
+	Py_END_ALLOW_THREADS
+
+	ret = PyList_New(origins_len);
+	for (i = 0; i < origins_len; i++) {
+		PyList_SET_ITEM(ret, i, py_bvhtree_nearest_to_py(self, &batch.nearest[i]));
+	}
+
+	MEM_freeN(batch.nearest);
+	PyMem_Free(origins);
+
+	return ret;
+}
+
+
+/* -------------------------------------------------------------------- */
+/* Class methods */
+
+PyDoc_STRVAR(C_BVHTree_FromPolygons_doc,
+".. classmethod:: FromPolygons(vertices, polygons, all_triangles=False, epsilon=0.0)\n"
+"\n"
+"   BVH tree constructed geometry passed in as arguments.\n"
+"\n"
+"   :arg vertices: float triplets each representing ``(x, y, z)``\n"
+"   :type vertices: float triplet sequence\n"
+"   :arg polygons: Sequence of polygons, each containing indices to the vertices argument.\n"
+"   :type polygons: Sequence of sequences containing ints\n"
+"   :arg all_triangles: Use when all **polygons** are triangles for more efficient conversion.\n"
+"   :type all_triangles: bool\n"
+"   :arg epsilon: Increase the threshold for detecting overlap and raycast hits.\n"
+"   :type epsilon: float\n"
+);
+static PyObject *C_BVHTree_FromPolygons(PyObject *UNUSED(cls), PyObject *args, PyObject *kwargs)
+{
+	const char *error_prefix = "BVHTree.FromPolygons";
+	const char *keywords[] = {"vertices", "polygons", "all_triangles", "epsilon", NULL};
+
+	PyObject *py_coords, *py_polys, *py_polys_fast;
+	int all_triangles = 0;
+	float epsilon = 0.0f;
+
+	float (*coords_parse)[3] = NULL;
+	int coords_len;
+
+	/* flattened polygon vertex indices */
+	unsigned int *poly_verts;
+	unsigned int *poly_sizes;
+	unsigned int polys_len, poly_verts_len = 0, poly_size_max = 0;
+
+	float (*coords)[3];
+	unsigned int (*tris)[3];
+	int *orig_index = NULL;
+	unsigned int tris_len = 0;
+	unsigned int i;
+	bool valid = true;
+
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, (char *) "OO|if:BVHTree.FromPolygons", (char **)keywords,
+	                                 &py_coords, &py_polys, &all_triangles, &epsilon))
+	{
+		return NULL;
+	}
+
+	coords_len = py_bvhtree_parse_points(py_coords, &coords_parse, error_prefix);
+	if (coords_len == -1) {
+		return NULL;
+	}
+
+	if (!(py_polys_fast = PySequence_Fast(py_polys, error_prefix))) {
+		PyMem_Free(coords_parse);
+		return NULL;
+	}
+
+	polys_len = (unsigned int)PySequence_Fast_GET_SIZE(py_polys_fast);
+
+	/* first pass, validate and flatten the polygons */
+	for (i = 0; i < polys_len; i++) {
+		PyObject *py_poly = PySequence_Fast_GET_ITEM(py_polys_fast, i);
+		Py_ssize_t poly_size = PySequence_Size(py_poly);
+
+		if (poly_size == -1) {
+			valid = false;
+			break;
+		}
+		else if (poly_size < 3 || (all_triangles && poly_size != 3)) {
+			PyErr_Format(PyExc_ValueError,
+			             "%s: polygon %u has %d vertices, expected %s",
+			             error_prefix, i, (int)poly_size, all_triangles ? "3" : "3 or more");
+			valid = false;
+			break;
+		}
+
+		poly_verts_len += (unsigned int)poly_size;
+		poly_size_max = (unsigned int)max_ii((int)poly_size_max, (int)poly_size);
+		tris_len += (unsigned int)poly_size - 2;
+	}
+
+	if (!valid) {
+		Py_DECREF(py_polys_fast);
+		PyMem_Free(coords_parse);
+		return NULL;
+	}
+
+	poly_verts = MEM_mallocN(sizeof(*poly_verts) * (size_t)max_ii((int)poly_verts_len, 1), __func__);
+	poly_sizes = MEM_mallocN(sizeof(*poly_sizes) * (size_t)max_ii((int)polys_len, 1), __func__);
+
+	{
+		unsigned int *pv = poly_verts;
+
+		for (i = 0; i < polys_len && valid; i++) {
+			PyObject *py_poly_fast = PySequence_Fast(PySequence_Fast_GET_ITEM(py_polys_fast, i), error_prefix);
+			Py_ssize_t j, poly_size;
+
+			if (py_poly_fast == NULL) {
+				valid = false;
+				break;
+			}
+
+			poly_size = PySequence_Fast_GET_SIZE(py_poly_fast);
+			poly_sizes[i] = (unsigned int)poly_size;
+
+			for (j = 0; j < poly_size; j++) {
+				long index = PyLong_AsLong(PySequence_Fast_GET_ITEM(py_poly_fast, j));
+
+				if (index == -1 && PyErr_Occurred()) {
+					valid = false;
+					break;
+				}
+				else if (index < 0 || index >= coords_len) {
+					PyErr_Format(PyExc_ValueError,
+					             "%s: index %ld out of range for %d vertices",
+					             error_prefix, index, coords_len);
+					valid = false;
+					break;
+				}
+
+				*pv++ = (unsigned int)index;
+			}
+
+			Py_DECREF(py_poly_fast);
+		}
+	}
+
+	Py_DECREF(py_polys_fast);
+
+	if (!valid) {
+		MEM_freeN(poly_verts);
+		MEM_freeN(poly_sizes);
+		PyMem_Free(coords_parse);
+		return NULL;
+	}
+
+	coords = MEM_mallocN(sizeof(*coords) * (size_t)max_ii(coords_len, 1), __func__);
+	if (coords_len) {
+		memcpy(coords, coords_parse, sizeof(*coords) * (size_t)coords_len);
+	}
+	PyMem_Free(coords_parse);
+
+	tris = MEM_mallocN(sizeof(*tris) * (size_t)max_ii((int)tris_len, 1), __func__);
+
+	if (all_triangles || poly_size_max <= 3) {
+		/* no triangulation needed, triangle and polygon indices match */
+		memcpy(tris, poly_verts, sizeof(*tris) * tris_len);
+	}
+	else {
+		/* second pass, triangulate */
+		float (*projverts)[2] = MEM_mallocN(sizeof(*projverts) * poly_size_max, __func__);
+		unsigned int (*poly_tris)[3] = MEM_mallocN(sizeof(*poly_tris) * (poly_size_max - 2), __func__);
+		unsigned int *pv = poly_verts;
+		unsigned int (*tri)[3] = tris;
+
+		orig_index = MEM_mallocN(sizeof(*orig_index) * (size_t)max_ii((int)tris_len, 1), __func__);
+
+		for (i = 0; i < polys_len; i++) {
+			const unsigned int poly_size = poly_sizes[i];
+			unsigned int j;
+
+			if (poly_size == 3) {
+				(*tri)[0] = pv[0];
+				(*tri)[1] = pv[1];
+				(*tri)[2] = pv[2];
+				orig_index[tri - tris] = (int)i;
+				tri++;
+			}
+			else {
+				float normal[3] = {0.0f, 0.0f, 0.0f};
+				float axis_mat[3][3];
+				const float *co_prev = coords[pv[poly_size - 1]];
+
+				/* Newell's method */
+				for (j = 0; j < poly_size; j++) {
+					const float *co_curr = coords[pv[j]];
+					add_newell_cross_v3_v3v3(normal, co_prev, co_curr);
+					co_prev = co_curr;
+				}
+
+				axis_dominant_v3_to_m3(axis_mat, normal);
+
+				for (j = 0; j < poly_size; j++) {
+					mul_v2_m3v3(projverts[j], axis_mat, coords[pv[j]]);
+				}
+
+				BLI_polyfill_calc((const float (*)[2])projverts, poly_size, poly_tris);
+
+				for (j = 0; j < poly_size - 2; j++) {
+					(*tri)[0] = pv[poly_tris[j][0]];
+					(*tri)[1] = pv[poly_tris[j][1]];
+					(*tri)[2] = pv[poly_tris[j][2]];
+					orig_index[tri - tris] = (int)i;
+					tri++;
+				}
+			}
+
+			pv += poly_size;
+		}
+
+		MEM_freeN(projverts);
+		MEM_freeN(poly_tris);
+	}
+
+	MEM_freeN(poly_verts);
+	MEM_freeN(poly_sizes);
+
+	return bvhtree_CreatePyObject(
+	        bvhtree_from_tris((const float (*)[3])coords, (const unsigned int (*)[3])tris, tris_len, epsilon),
+	        epsilon,
+	        coords, (unsigned int)coords_len,
+	        tris, tris_len,
+	        orig_index);
+}
+
+#ifndef MATH_STANDALONE
+
+PyDoc_STRVAR(C_BVHTree_FromBMesh_doc,
+".. classmethod:: FromBMesh(bmesh, epsilon=0.0)\n"
+"\n"
+"   BVH tree based on :class:`BMesh` data.\n"
+"\n"
+"   :arg bmesh: BMesh data.\n"
+"   :type bmesh: :class:`BMesh`\n"
+"   :arg epsilon: Increase the threshold for detecting overlap and raycast hits.\n"
+"   :type epsilon: float\n"
+);
+static PyObject *C_BVHTree_FromBMesh(PyObject *UNUSED(cls), PyObject *args, PyObject *kwargs)
+{
+	const char *keywords[] = {"bmesh", "epsilon", NULL};
+
+	BPy_BMesh *py_bm;
+	float epsilon = 0.0f;
+
+	BMesh *bm;
+	BMLoop *(*looptris)[3];
+	BMIter iter;
+	BMVert *v;
+
+	float (*coords)[3];
+	unsigned int (*tris)[3];
+	int *orig_index;
+	unsigned int coords_len, tris_len;
+	int looptris_len, i;
+
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, (char *) "O!|f:BVHTree.FromBMesh", (char **)keywords,
+	                                 &BPy_BMesh_Type, &py_bm, &epsilon))
+	{
+		return NULL;
+	}
+
+	BPY_BM_CHECK_OBJ(py_bm);
+
+	bm = py_bm->bm;
+
+	coords_len = (unsigned int)bm->totvert;
+	tris_len = (unsigned int)poly_to_tri_count(bm->totface, bm->totloop);
+
+	coords = MEM_mallocN(sizeof(*coords) * (size_t)max_ii((int)coords_len, 1), __func__);
+	tris = MEM_mallocN(sizeof(*tris) * (size_t)max_ii((int)tris_len, 1), __func__);
+	orig_index = MEM_mallocN(sizeof(*orig_index) * (size_t)max_ii((int)tris_len, 1), __func__);
+
+	looptris = MEM_mallocN(sizeof(*looptris) * (size_t)max_ii((int)tris_len, 1), __func__);
+	BM_bmesh_calc_tessellation(bm, looptris, &looptris_len);
+
+	BM_mesh_elem_index_ensure(bm, BM_VERT | BM_FACE);
+
+	BM_ITER_MESH_INDEX (v, &iter, bm, BM_VERTS_OF_MESH, i) {
+		copy_v3_v3(coords[i], v->co);
+	}
+
+	for (i = 0; i < looptris_len; i++) {
+		tris[i][0] = (unsigned int)BM_elem_index_get(looptris[i][0]->v);
+		tris[i][1] = (unsigned int)BM_elem_index_get(looptris[i][1]->v);
+		tris[i][2] = (unsigned int)BM_elem_index_get(looptris[i][2]->v);
+		orig_index[i] = BM_elem_index_get(looptris[i][0]->f);
+	}
+	tris_len = (unsigned int)looptris_len;
+
+	MEM_freeN(looptris);
+
+	return bvhtree_CreatePyObject(
+	        bvhtree_from_tris((const float (*)[3])coords, (const unsigned int (*)[3])tris, tris_len, epsilon),
+	        epsilon,
+	        coords, coords_len,
+	        tris, tris_len,
+	        orig_index);
+}
+
+PyDoc_STRVAR(C_BVHTree_FromObject_doc,
+".. classmethod:: FromObject(object, scene, deform=True, render=False, cage=False, epsilon=0.0)\n"
+"\n"
+"   BVH tree based on :class:`Object` data, in object space.\n"
+"\n"
+"   :arg object: Mesh object.\n"
+"   :type object: :class:`Object`\n"
+"   :arg scene: Scene data to use for evaluating the mesh.\n"
+"   :type scene: :class:`Scene`\n"
+"   :arg deform: Use mesh with deformations.\n"
+"   :type deform: bool\n"
+"   :arg render: Use render settings.\n"
+"   :type render: bool\n"
+"   :arg cage: Use the modifier cage, only deforming modifiers are applied.\n"
+"   :type cage: bool\n"
+"   :arg epsilon: Increase the threshold for detecting overlap and raycast hits.\n"
+"   :type epsilon: float\n"
+);
+static PyObject *C_BVHTree_FromObject(PyObject *UNUSED(cls), PyObject *args, PyObject *kwargs)
+{
+	const char *keywords[] = {"object", "scene", "deform", "render", "cage", "epsilon", NULL};
+
+	PyObject *py_ob, *py_scene;
+	Object *ob;
+	struct Scene *scene;
+	int use_deform = true;
+	int use_render = false;
+	int use_cage = false;
+	float epsilon = 0.0f;
+
+	const CustomDataMask mask = CD_MASK_BAREMESH;
+	DerivedMesh *dm;
+	const MVert *mvert;
+	const MFace *mface;
+	const int *index_mf_to_mpoly;
+
+	float (*coords)[3];
+	unsigned int (*tris)[3];
+	int *orig_index;
+	unsigned int coords_len, tris_len;
+	unsigned int i;
+	int faces_len, j;
+
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, (char *) "OO|iiif:BVHTree.FromObject", (char **)keywords,
+	                                 &py_ob, &py_scene, &use_deform, &use_render, &use_cage, &epsilon) ||
+	    ((ob = PyC_RNA_AsPointer(py_ob, "Object")) == NULL) ||
+	    ((scene = PyC_RNA_AsPointer(py_scene, "Scene")) == NULL))
+	{
+		return NULL;
+	}
+
+	if (ob->type != OB_MESH) {
+		PyErr_Format(PyExc_ValueError, "BVHTree.FromObject: object '%.200s' is not a mesh", ob->id.name + 2);
+		return NULL;
+	}
+
+	if (use_deform == false) {
+		if (use_render) {
+			dm = mesh_create_derived_no_deform_render(scene, ob, NULL, mask);
+		}
+		else {
+			dm = mesh_create_derived_no_deform(scene, ob, NULL, mask);
+		}
+	}
+	else if (use_render) {
+		dm = mesh_create_derived_render(scene, ob, mask);
+	}
+	else if (use_cage) {
+		dm = mesh_get_derived_deform(scene, ob, mask);
+	}
+	else {
+		dm = mesh_get_derived_final(scene, ob, mask);
+	}
+
+	if (dm == NULL) {
+		PyErr_Format(PyExc_ValueError, "BVHTree.FromObject: failed to get mesh data from '%.200s'", ob->id.name + 2);
+		return NULL;
+	}
+
+	DM_ensure_tessface(dm);
+
+	mvert = dm->getVertArray(dm);
+	mface = dm->getTessFaceArray(dm);
+	index_mf_to_mpoly = dm->getTessFaceDataArray(dm, CD_ORIGINDEX);
+	faces_len = dm->getNumTessFaces(dm);
+
+	coords_len = (unsigned int)dm->getNumVerts(dm);
+	tris_len = 0;
+	for (j = 0; j < faces_len; j++) {
+		tris_len += mface[j].v4 ? 2 : 1;
+	}
+
+	coords = MEM_mallocN(sizeof(*coords) * (size_t)max_ii((int)coords_len, 1), __func__);
+	tris = MEM_mallocN(sizeof(*tris) * (size_t)max_ii((int)tris_len, 1), __func__);
+	orig_index = MEM_mallocN(sizeof(*orig_index) * (size_t)max_ii((int)tris_len, 1), __func__);
+
+	for (i = 0; i < coords_len; i++) {
+		copy_v3_v3(coords[i], mvert[i].co);
+	}
+
+	for (i = 0, j = 0; j < faces_len; j++) {
+		const MFace *mf = &mface[j];
+		const int index = index_mf_to_mpoly ? index_mf_to_mpoly[j] : j;
+
+		tris[i][0] = mf->v1;
+		tris[i][1] = mf->v2;
+		tris[i][2] = mf->v3;
+		orig_index[i++] = index;
+
+		if (mf->v4) {
+			tris[i][0] = mf->v1;
+			tris[i][1] = mf->v3;
+			tris[i][2] = mf->v4;
+			orig_index[i++] = index;
+		}
+	}
+
+	dm->release(dm);
+
+	return bvhtree_CreatePyObject(
+	        bvhtree_from_tris((const float (*)[3])coords, (const unsigned int (*)[3])tris, tris_len, epsilon),
+	        epsilon,
+	        coords, coords_len,
+	        tris, tris_len,
+	        orig_index);
+}
+
+#endif  /* MATH_STANDALONE */
+
+
+static PyMethodDef PyBVHTree_methods[] = {
+	{"ray_cast", (PyCFunction)py_bvhtree_ray_cast, METH_VARARGS | METH_KEYWORDS, py_bvhtree_ray_cast_doc},
+	{"find_nearest", (PyCFunction)py_bvhtree_find_nearest, METH_VARARGS | METH_KEYWORDS, py_bvhtree_find_nearest_doc},
+	{"find_range", (PyCFunction)py_bvhtree_find_range, METH_VARARGS | METH_KEYWORDS, py_bvhtree_find_range_doc},
+	{"overlap", (PyCFunction)py_bvhtree_overlap, METH_O, py_bvhtree_overlap_doc},
+	{"ray_cast_batch", (PyCFunction)py_bvhtree_ray_cast_batch, METH_VARARGS | METH_KEYWORDS,
+	 py_bvhtree_ray_cast_batch_doc},
+	{"find_nearest_batch", (PyCFunction)py_bvhtree_find_nearest_batch, METH_VARARGS | METH_KEYWORDS,
+	 py_bvhtree_find_nearest_batch_doc},
+
+	/* class methods */
+	{"FromPolygons", (PyCFunction) C_BVHTree_FromPolygons, METH_VARARGS | METH_KEYWORDS | METH_CLASS,
+	 C_BVHTree_FromPolygons_doc},
+#ifndef MATH_STANDALONE
+	{"FromBMesh", (PyCFunction) C_BVHTree_FromBMesh, METH_VARARGS | METH_KEYWORDS | METH_CLASS,
+	 C_BVHTree_FromBMesh_doc},
+	{"FromObject", (PyCFunction) C_BVHTree_FromObject, METH_VARARGS | METH_KEYWORDS | METH_CLASS,
+	 C_BVHTree_FromObject_doc},
+#endif
+	{NULL, NULL, 0, NULL}
+};
+
+PyDoc_STRVAR(py_BVHTree_doc,
+"BVH tree structure for proximity searches and ray casts on geometry.\n"
+"\n"
+"Trees are created with one of the class methods: "
+":class:`BVHTree.FromPolygons`, :class:`BVHTree.FromBMesh` or :class:`BVHTree.FromObject`.\n"
+"Indices in the results refer to the polygons the tree was created from.\n"
+);
+PyTypeObject PyBVHTree_Type = {
+	PyVarObject_HEAD_INIT(NULL, 0)
+	"BVHTree",                                   /* tp_name */
+	sizeof(PyBVHTree),                           /* tp_basicsize */
+	0,                                           /* tp_itemsize */
+	/* methods */
+	(destructor)PyBVHTree__tp_dealloc,           /* tp_dealloc */
+	NULL,                                        /* tp_print */
+	NULL,                                        /* tp_getattr */
+	NULL,                                        /* tp_setattr */
+	NULL,                                        /* tp_compare */
+	NULL,                                        /* tp_repr */
+	NULL,                                        /* tp_as_number */
+	NULL,                                        /* tp_as_sequence */
+	NULL,                                        /* tp_as_mapping */
+	NULL,                                        /* tp_hash */
+	NULL,                                        /* tp_call */
+	NULL,                                        /* tp_str */
+	NULL,                                        /* tp_getattro */
+	NULL,                                        /* tp_setattro */
+	NULL,                                        /* tp_as_buffer */
+	Py_TPFLAGS_DEFAULT,                          /* tp_flags */
+	py_BVHTree_doc,                              /* Documentation string */
+	NULL,                                        /* tp_traverse */
+	NULL,                                        /* tp_clear */
+	NULL,                                        /* tp_richcompare */
+	0,                                           /* tp_weaklistoffset */
+	NULL,                                        /* tp_iter */
+	NULL,                                        /* tp_iternext */
+	(struct PyMethodDef *)PyBVHTree_methods,     /* tp_methods */
+	NULL,                                        /* tp_members */
+	NULL,                                        /* tp_getset */
+	NULL,                                        /* tp_base */
+	NULL,                                        /* tp_dict */
+	NULL,                                        /* tp_descr_get */
+	NULL,                                        /* tp_descr_set */
+	0,                                           /* tp_dictoffset */
+	NULL,                                        /* tp_init */
+	NULL,                                        /* tp_alloc */
+	NULL,                                        /* tp_new (only created from class methods) */
+	(freefunc)0,                                 /* tp_free */
+	NULL,                                        /* tp_is_gc */
+	NULL,                                        /* tp_bases */
+	NULL,                                        /* tp_mro */
+	NULL,                                        /* tp_cache */
+	NULL,                                        /* tp_subclasses */
+	NULL,                                        /* tp_weaklist */
+	(destructor) NULL                            /* tp_del */
+};
+
+PyDoc_STRVAR(py_bvhtree_doc,
+"BVH tree structures for proximity searches and ray casts on geometry."
+);
+static struct PyModuleDef bvhtree_moduledef = {
+	PyModuleDef_HEAD_INIT,
+	"mathutils.bvhtree",                         /* m_name */
+	py_bvhtree_doc,                              /* m_doc */
+	0,                                           /* m_size */
+	NULL,                                        /* m_methods */
+	NULL,                                        /* m_reload */
+	NULL,                                        /* m_traverse */
+	NULL,                                        /* m_clear */
+	NULL                                         /* m_free */
+};
+
+PyMODINIT_FUNC PyInit_mathutils_bvhtree(void)
+{
+	PyObject *m = PyModule_Create(&bvhtree_moduledef);
+
+	if (m == NULL) {
+		return NULL;
+	}
+
+	/* Register the 'BVHTree' class */
+	if (PyType_Ready(&PyBVHTree_Type)) {
+		return NULL;
+	}
+	PyModule_AddObject(m, (char *)"BVHTree", (PyObject *) &PyBVHTree_Type);
+
+	return m;
+}
@@ -330,6 +330,7 @@ typedef struct ObjectRen {
 	int  actmtface, actmcol, bakemtface;
 
 	float obmat[4][4];	/* only used in convertblender.c, for instancing */
+	struct ObjectRenFinalize *finalize;	/* only used in convertblender.c, postponed conversion */
 
 	/* used on makeraytree */
 	struct RayObject *raytree;
@@ -42,6 +42,9 @@
 #include "BLI_math.h"
 #include "BLI_utildefines.h"
 
+/* builders with more objects than this sort and split the three axes in threads */
+#define RTBUILD_THREAD_LIMIT 100000
+
 static bool selected_node(RTBuilder::Object *node)
 {
 	return node->selected;
@@ -155,9 +158,10 @@ static void object_sort(Item *begin, Item *end, int axis)
 
 void rtbuild_done(RTBuilder *b, RayObjectControl *ctrl)
 {
+#pragma omp parallel for if (rtbuild_size(b) > RTBUILD_THREAD_LIMIT)
 	for (int i = 0; i < 3; i++) {
 		if (b->sorted_begin[i]) {
-			if (RE_rayobjectcontrol_test_break(ctrl)) break;
+			if (RE_rayobjectcontrol_test_break(ctrl)) continue;
 			object_sort(b->sorted_begin[i], b->sorted_end[i], i);
 		}
 	}
@@ -321,6 +325,81 @@ struct SweepCost {
 	float cost;
 };
 
+/*
+ * Find the best split of the objects sorted on one axis, only splits
+ * cheaper than bound are considered so a previous axis can end the sweep early.
+ * Returns the cost of the split found and sets r_offset, or returns bound.
+ */
+static float rtbuild_heuristic_axis_split(RTBuilder *b, int size, int axis, SweepCost *sweep,
+                                          float bound, int *r_offset)
+{
+	SweepCost sweep_left;
+	float bcost = bound;
+
+	RTBuilder::Object **obj = b->sorted_begin[axis];
+	
+//	float right_cost = 0;
+	for (int i = size - 1; i >= 0; i--) {
+		if (i == size - 1) {
+			copy_v3_v3(sweep[i].bb, obj[i]->bb);
+			copy_v3_v3(sweep[i].bb + 3, obj[i]->bb + 3);
+			sweep[i].cost = obj[i]->cost;
+		}
+		else {
+			sweep[i].bb[0] = min_ff(obj[i]->bb[0], sweep[i + 1].bb[0]);
+			sweep[i].bb[1] = min_ff(obj[i]->bb[1], sweep[i + 1].bb[1]);
+			sweep[i].bb[2] = min_ff(obj[i]->bb[2], sweep[i + 1].bb[2]);
+			sweep[i].bb[3] = max_ff(obj[i]->bb[3], sweep[i + 1].bb[3]);
+			sweep[i].bb[4] = max_ff(obj[i]->bb[4], sweep[i + 1].bb[4]);
+			sweep[i].bb[5] = max_ff(obj[i]->bb[5], sweep[i + 1].bb[5]);
+			sweep[i].cost  = obj[i]->cost + sweep[i + 1].cost;
+		}
+//		right_cost += obj[i]->cost;
+	}
+	
+	sweep_left.bb[0] = obj[0]->bb[0];
+	sweep_left.bb[1] = obj[0]->bb[1];
+	sweep_left.bb[2] = obj[0]->bb[2];
+	sweep_left.bb[3] = obj[0]->bb[3];
+	sweep_left.bb[4] = obj[0]->bb[4];
+	sweep_left.bb[5] = obj[0]->bb[5];
+	sweep_left.cost  = obj[0]->cost;
+	
+//	right_cost -= obj[0]->cost;	if (right_cost < 0) right_cost = 0;
+
+	for (int i = 1; i < size; i++) {
+		//Worst case heuristic (cost of each child is linear)
+		float hcost, left_side, right_side;
+		
+		// not using log seems to have no impact on raytracing perf, but
+		// makes tree construction quicker, left out for now to test (brecht)
+		// left_side  = bb_area(sweep_left.bb, sweep_left.bb + 3) * (sweep_left.cost + logf((float)i));
+		// right_side = bb_area(sweep[i].bb,   sweep[i].bb   + 3) * (sweep[i].cost   + logf((float)size - i));
+		left_side = bb_area(sweep_left.bb, sweep_left.bb + 3) * (sweep_left.cost);
+		right_side = bb_area(sweep[i].bb, sweep[i].bb + 3) * (sweep[i].cost);
+		hcost = left_side + right_side;
+
+		assert(left_side >= 0);
+		assert(right_side >= 0);
+		
+		if (left_side > bcost) break;   //No way we can find a better heuristic in this axis
+
+		assert(hcost >= 0);
+		// on equal cost the first split wins, as does the first axis in rtbuild_heuristic_object_split
+		if (hcost < bcost) {
+			bcost = hcost;
+			*r_offset = i;
+		}
+		DO_MIN(obj[i]->bb,   sweep_left.bb);
+		DO_MAX(obj[i]->bb + 3, sweep_left.bb + 3);
+
+		sweep_left.cost += obj[i]->cost;
+//		right_cost -= obj[i]->cost; if (right_cost < 0) right_cost = 0;
+	}
+
+	return bcost;
+}
+
 /* Object Surface Area Heuristic splitter */
 int rtbuild_heuristic_object_split(RTBuilder *b, int nchilds)
 {
@@ -328,85 +407,55 @@ int rtbuild_heuristic_object_split(RTBuilder *b, int nchilds)
 	assert(nchilds == 2);
 	assert(size > 1);
 	int baxis = -1, boffset = 0;
+	const bool threaded = (size > RTBUILD_THREAD_LIMIT);
 
 	if (size > nchilds) {
 		float bcost = FLT_MAX;
 		baxis = -1, boffset = size / 2;
 
-		SweepCost *sweep = (SweepCost *)MEM_mallocN(sizeof(SweepCost) * size, "RTBuilder.HeuristicSweep");
-		
-		for (int axis = 0; axis < 3; axis++) {
-			SweepCost sweep_left;
-
-			RTBuilder::Object **obj = b->sorted_begin[axis];
-			
-//			float right_cost = 0;
-			for (int i = size - 1; i >= 0; i--) {
-				if (i == size - 1) {
-					copy_v3_v3(sweep[i].bb, obj[i]->bb);
-					copy_v3_v3(sweep[i].bb + 3, obj[i]->bb + 3);
-					sweep[i].cost = obj[i]->cost;
-				}
-				else {
-					sweep[i].bb[0] = min_ff(obj[i]->bb[0], sweep[i + 1].bb[0]);
-					sweep[i].bb[1] = min_ff(obj[i]->bb[1], sweep[i + 1].bb[1]);
-					sweep[i].bb[2] = min_ff(obj[i]->bb[2], sweep[i + 1].bb[2]);
-					sweep[i].bb[3] = max_ff(obj[i]->bb[3], sweep[i + 1].bb[3]);
-					sweep[i].bb[4] = max_ff(obj[i]->bb[4], sweep[i + 1].bb[4]);
-					sweep[i].bb[5] = max_ff(obj[i]->bb[5], sweep[i + 1].bb[5]);
-					sweep[i].cost  = obj[i]->cost + sweep[i + 1].cost;
-				}
-//				right_cost += obj[i]->cost;
+		if (threaded) {
+			/* the axes are swept independently, each in its own buffer */
+			SweepCost *sweep = (SweepCost *)MEM_mallocN(sizeof(SweepCost) * size * 3, "RTBuilder.HeuristicSweep");
+			float axis_cost[3];
+			int axis_offset[3];
+
+#pragma omp parallel for
+			for (int axis = 0; axis < 3; axis++) {
+				axis_cost[axis] = rtbuild_heuristic_axis_split(b, size, axis, sweep + axis * size,
+				                                               FLT_MAX, &axis_offset[axis]);
 			}
-			
-			sweep_left.bb[0] = obj[0]->bb[0];
-			sweep_left.bb[1] = obj[0]->bb[1];
-			sweep_left.bb[2] = obj[0]->bb[2];
-			sweep_left.bb[3] = obj[0]->bb[3];
-			sweep_left.bb[4] = obj[0]->bb[4];
-			sweep_left.bb[5] = obj[0]->bb[5];
-			sweep_left.cost  = obj[0]->cost;
-			
-//			right_cost -= obj[0]->cost;	if (right_cost < 0) right_cost = 0;
-
-			for (int i = 1; i < size; i++) {
-				//Worst case heuristic (cost of each child is linear)
-				float hcost, left_side, right_side;
-				
-				// not using log seems to have no impact on raytracing perf, but
-				// makes tree construction quicker, left out for now to test (brecht)
-				// left_side  = bb_area(sweep_left.bb, sweep_left.bb + 3) * (sweep_left.cost + logf((float)i));
-				// right_side = bb_area(sweep[i].bb,   sweep[i].bb   + 3) * (sweep[i].cost   + logf((float)size - i));
-				left_side = bb_area(sweep_left.bb, sweep_left.bb + 3) * (sweep_left.cost);
-				right_side = bb_area(sweep[i].bb, sweep[i].bb + 3) * (sweep[i].cost);
-				hcost = left_side + right_side;
-
-				assert(left_side >= 0);
-				assert(right_side >= 0);
-				
-				if (left_side > bcost) break;   //No way we can find a better heuristic in this axis
-
-				assert(hcost >= 0);
-				// this makes sure the tree built is the same whatever is the order of the sorting axis
-				if (hcost < bcost || (hcost == bcost && axis < baxis)) {
-					bcost = hcost;
+
+			// this makes sure the tree built is the same whatever is the order of the sorting axis
+			for (int axis = 0; axis < 3; axis++) {
+				if (axis_cost[axis] < bcost) {
+					bcost = axis_cost[axis];
 					baxis = axis;
-					boffset = i;
+					boffset = axis_offset[axis];
 				}
-				DO_MIN(obj[i]->bb,   sweep_left.bb);
-				DO_MAX(obj[i]->bb + 3, sweep_left.bb + 3);
+			}
 
-				sweep_left.cost += obj[i]->cost;
-//				right_cost -= obj[i]->cost; if (right_cost < 0) right_cost = 0;
+			MEM_freeN(sweep);
+		}
+		else {
+			SweepCost *sweep = (SweepCost *)MEM_mallocN(sizeof(SweepCost) * size, "RTBuilder.HeuristicSweep");
+
+			for (int axis = 0; axis < 3; axis++) {
+				const float cost = rtbuild_heuristic_axis_split(b, size, axis, sweep, bcost, &boffset);
+
+				if (cost < bcost) {
+					bcost = cost;
+					baxis = axis;
+				}
 			}
-			
-			//assert(baxis >= 0 && baxis < 3);
-			if (!(baxis >= 0 && baxis < 3))
-				baxis = 0;
+
+			MEM_freeN(sweep);
+		}
+
+		//assert(baxis >= 0 && baxis < 3);
+		if (!(baxis >= 0 && baxis < 3)) {
+			baxis = 0;
+			boffset = size / 2;
 		}
-			
-		
-		MEM_freeN(sweep);
 	}
 	else if (size == 2) {
 		baxis = 0;
@@ -426,6 +475,7 @@ int rtbuild_heuristic_object_split(RTBuilder *b, int nchilds)
 	/* Adjust sorted arrays for childs */
 	for (int i = 0; i < boffset; i++) b->sorted_begin[baxis][i]->selected = true;
 	for (int i = boffset; i < size; i++) b->sorted_begin[baxis][i]->selected = false;
+#pragma omp parallel for if (threaded)
 	for (int i = 0; i < 3; i++)
 		std::stable_partition(b->sorted_begin[i], b->sorted_end[i], selected_node);
 
@@ -40,6 +40,7 @@
 #include "BLI_utildefines.h"
 #include "BLI_rand.h"
 #include "BLI_task.h"
+#include "BLI_threads.h"
 #include "BLI_memarena.h"
 #include "BLI_linklist.h"
 #ifdef WITH_FREESTYLE
@@ -2911,6 +2912,35 @@ static void init_render_curve(Render *re, ObjectRen *obr, int timeoffset)
 /* Mesh     																 */
 /* ------------------------------------------------------------------------- */
 
+/* Conversion steps which only use the data of their own ObjectRen are
+ * postponed until all objects are created, then run in threads,
+ * see database_finalize_objects */
+typedef struct ObjectRenFinalize {
+	/* init_render_mesh */
+	float mat[4][4];
+	int autosmooth_degr;
+	short do_autosmooth, do_normals;
+	short need_tangent, need_nmap_tangent;
+
+	/* finalize_render_object */
+	short do_finalize, do_phong_threshold;
+	short do_check_quads, quad_split;
+
+	/* results which are not local to the object */
+	short has_smoothresh;
+	float smoothresh;
+	int totvert_added, totvlak_added;
+	int totcounted;  /* times the object was added to the render totals, once per instance */
+} ObjectRenFinalize;
+
+static ObjectRenFinalize *object_finalize_get(ObjectRen *obr)
+{
+	if (obr->finalize == NULL)
+		obr->finalize = MEM_callocN(sizeof(ObjectRenFinalize), "ObjectRenFinalize");
+
+	return obr->finalize;
+}
+
 struct edgesort {
 	unsigned int v1, v2;
 	int f;
@@ -3546,13 +3576,19 @@ static void init_render_mesh(Render *re, ObjectRen *obr, int timeoffset)
 				do_displacement(re, obr, NULL, NULL);
 		}
 
-		if (do_autosmooth) {
-			recalc_normals= 1;
-			autosmooth(re, obr, mat, me->smoothresh);
-		}
+		if (do_autosmooth || recalc_normals!=0 || need_tangent!=0) {
+			ObjectRenFinalize *fin = object_finalize_get(obr);
+
+			if (do_autosmooth) {
+				copy_m4_m4(fin->mat, mat);
+				fin->autosmooth_degr = me->smoothresh;
+				fin->do_autosmooth = TRUE;
+			}
 
-		if (recalc_normals!=0 || need_tangent!=0)
-			calc_vertexnormals(re, obr, need_tangent, need_nmap_tangent);
+			fin->do_normals = TRUE;
+			fin->need_tangent = need_tangent;
+			fin->need_nmap_tangent = need_nmap_tangent;
+		}
 	}
 
 	dm->release(dm);
@@ -4058,8 +4094,9 @@ void init_render_world(Render *re)
 /* Object Finalization														 */
 /* ------------------------------------------------------------------------- */
 
-/* prevent phong interpolation for giving ray shadow errors (terminator problem) */
-static void set_phong_threshold(ObjectRen *obr)
+/* prevent phong interpolation for giving ray shadow errors (terminator problem),
+ * returns false when there are no smooth faces to compute the threshold from */
+static bool calc_phong_threshold(ObjectRen *obr, float *r_smoothresh)
 {
 //	VertRen *ver;
 	VlakRen *vlr;
@@ -4102,8 +4139,11 @@ static void set_phong_threshold(ObjectRen *obr)
 	
 	if (tot) {
 		thresh/= (float)tot;
-		obr->ob->smoothresh= cosf(0.5f*(float)M_PI-saacos(thresh));
+		*r_smoothresh= cosf(0.5f*(float)M_PI-saacos(thresh));
+		return true;
 	}
+
+	return false;
 }
 
 /* per face check if all samples should be taken.
@@ -4347,11 +4387,6 @@ static void check_non_flat_quads(ObjectRen *obr)
 static void finalize_render_object(Render *re, ObjectRen *obr, int timeoffset)
 {
 	Object *ob= obr->ob;
-	VertRen *ver= NULL;
-	StrandRen *strand= NULL;
-	StrandBound *sbound= NULL;
-	float min[3], max[3], smin[3], smax[3];
-	int a, b;
 
 	if (obr->totvert || obr->totvlak || obr->tothalo || obr->totstrand) {
 		/* the exception below is because displace code now is in init_render_mesh call, 
@@ -4361,64 +4396,149 @@ static void finalize_render_object(Render *re, ObjectRen *obr, int timeoffset)
 			do_displacement(re, obr, NULL, NULL);
 	
 		if (!timeoffset) {
+			/* the rest runs in finalize_render_object_data */
+			ObjectRenFinalize *fin = object_finalize_get(obr);
+
+			fin->do_finalize = TRUE;
+
 			/* phong normal interpolation can cause error in tracing
 			 * (terminator problem) */
-			ob->smoothresh= 0.0;
-			if ((re->r.mode & R_RAYTRACE) && (re->r.mode & R_SHADOW))
-				set_phong_threshold(obr);
-			
+			fin->do_phong_threshold = (re->r.mode & R_RAYTRACE) && (re->r.mode & R_SHADOW);
+
 			if (re->flag & R_BAKING && re->r.bake_quad_split != 0) {
 				/* Baking lets us define a quad split order */
-				split_quads(obr, re->r.bake_quad_split);
+				fin->quad_split = re->r.bake_quad_split;
 			}
 			else if (BKE_object_is_animated(re->scene, ob))
-				split_quads(obr, 1);
+				fin->quad_split = 1;
 			else {
 				if ((re->r.mode & R_SIMPLIFY && re->r.simplify_flag & R_SIMPLE_NO_TRIANGULATE) == 0)
-					check_non_flat_quads(obr);
+					fin->do_check_quads = TRUE;
 			}
-			
-			set_fullsample_trace_flag(re, obr);
+		}
+	}
+}
 
-			/* compute bounding boxes for clipping */
-			INIT_MINMAX(min, max);
-			for (a=0; a<obr->totvert; a++) {
-				if ((a & 255)==0) ver= obr->vertnodes[a>>8].vert;
-				else ver++;
+static void finalize_render_object_data(Render *re, ObjectRen *obr, ObjectRenFinalize *fin)
+{
+	VertRen *ver= NULL;
+	StrandRen *strand= NULL;
+	StrandBound *sbound= NULL;
+	float min[3], max[3], smin[3], smax[3];
+	int a, b;
 
-				minmax_v3v3_v3(min, max, ver->co);
-			}
+	if (fin->do_phong_threshold)
+		fin->has_smoothresh = calc_phong_threshold(obr, &fin->smoothresh);
 
-			if (obr->strandbuf) {
-				float width;
-				
-				/* compute average bounding box of strandpoint itself (width) */
-				if (obr->strandbuf->flag & R_STRAND_B_UNITS)
-					obr->strandbuf->maxwidth = max_ff(obr->strandbuf->ma->strand_sta, obr->strandbuf->ma->strand_end);
-				else
-					obr->strandbuf->maxwidth= 0.0f;
-				
-				width= obr->strandbuf->maxwidth;
-				sbound= obr->strandbuf->bound;
-				for (b=0; b<obr->strandbuf->totbound; b++, sbound++) {
-					
-					INIT_MINMAX(smin, smax);
+	if (fin->quad_split)
+		split_quads(obr, fin->quad_split);
+	else if (fin->do_check_quads)
+		check_non_flat_quads(obr);
 
-					for (a=sbound->start; a<sbound->end; a++) {
-						strand= RE_findOrAddStrand(obr, a);
-						strand_minmax(strand, smin, smax, width);
-					}
+	set_fullsample_trace_flag(re, obr);
+
+	/* compute bounding boxes for clipping */
+	INIT_MINMAX(min, max);
+	for (a=0; a<obr->totvert; a++) {
+		if ((a & 255)==0) ver= obr->vertnodes[a>>8].vert;
+		else ver++;
 
-					copy_v3_v3(sbound->boundbox[0], smin);
-					copy_v3_v3(sbound->boundbox[1], smax);
+		minmax_v3v3_v3(min, max, ver->co);
+	}
 
-					minmax_v3v3_v3(min, max, smin);
-					minmax_v3v3_v3(min, max, smax);
-				}
+	if (obr->strandbuf) {
+		float width;
+		
+		/* compute average bounding box of strandpoint itself (width) */
+		if (obr->strandbuf->flag & R_STRAND_B_UNITS)
+			obr->strandbuf->maxwidth = max_ff(obr->strandbuf->ma->strand_sta, obr->strandbuf->ma->strand_end);
+		else
+			obr->strandbuf->maxwidth= 0.0f;
+		
+		width= obr->strandbuf->maxwidth;
+		sbound= obr->strandbuf->bound;
+		for (b=0; b<obr->strandbuf->totbound; b++, sbound++) {
+			
+			INIT_MINMAX(smin, smax);
+
+			for (a=sbound->start; a<sbound->end; a++) {
+				strand= RE_findOrAddStrand(obr, a);
+				strand_minmax(strand, smin, smax, width);
 			}
 
-			copy_v3_v3(obr->boundbox[0], min);
-			copy_v3_v3(obr->boundbox[1], max);
+			copy_v3_v3(sbound->boundbox[0], smin);
+			copy_v3_v3(sbound->boundbox[1], smax);
+
+			minmax_v3v3_v3(min, max, smin);
+			minmax_v3v3_v3(min, max, smax);
+		}
+	}
+
+	copy_v3_v3(obr->boundbox[0], min);
+	copy_v3_v3(obr->boundbox[1], max);
+}
+
+static void finalize_render_object_task(TaskPool *pool, void *taskdata, int UNUSED(threadid))
+{
+	Render *re = BLI_task_pool_userdata(pool);
+	ObjectRen *obr = taskdata;
+	ObjectRenFinalize *fin = obr->finalize;
+	const int totvert = obr->totvert, totvlak = obr->totvlak;
+
+	if (re->test_break(re->tbh))
+		return;
+
+	if (fin->do_autosmooth)
+		autosmooth(re, obr, fin->mat, fin->autosmooth_degr);
+
+	if (fin->do_normals)
+		calc_vertexnormals(re, obr, fin->need_tangent, fin->need_nmap_tangent);
+
+	if (fin->do_finalize)
+		finalize_render_object_data(re, obr, fin);
+
+	fin->totvert_added = obr->totvert - totvert;
+	fin->totvlak_added = obr->totvlak - totvlak;
+}
+
+/* run the postponed conversion steps of all objects in threads, each task only
+ * changes its own ObjectRen, the rest is applied afterwards in object order so
+ * the result doesn't depend on the threads */
+static void database_finalize_objects(Render *re)
+{
+	ObjectRen *obr;
+	TaskScheduler *task_scheduler;
+	TaskPool *task_pool;
+
+	BLI_begin_threaded_malloc();
+
+	task_scheduler = BLI_task_scheduler_create(re->r.threads);
+	task_pool = BLI_task_pool_create(task_scheduler, re);
+
+	for (obr=re->objecttable.first; obr; obr=obr->next)
+		if (obr->finalize)
+			BLI_task_pool_push(task_pool, finalize_render_object_task, obr, false, TASK_PRIORITY_HIGH);
+
+	BLI_task_pool_work_and_wait(task_pool);
+
+	BLI_task_pool_free(task_pool);
+	BLI_task_scheduler_free(task_scheduler);
+
+	BLI_end_threaded_malloc();
+
+	for (obr=re->objecttable.first; obr; obr=obr->next) {
+		ObjectRenFinalize *fin = obr->finalize;
+
+		if (fin) {
+			if (fin->do_finalize)
+				obr->ob->smoothresh = (fin->has_smoothresh)? fin->smoothresh: 0.0f;
+
+			/* the instances were counted before finalizing */
+			re->totvert += fin->totvert_added * fin->totcounted;
+			re->totvlak += fin->totvlak_added * fin->totcounted;
+
+			MEM_freeN(fin);
+			obr->finalize = NULL;
 		}
 	}
 }
@@ -4432,6 +4552,19 @@ static int render_object_type(short type)
 	return OB_TYPE_SUPPORT_MATERIAL(type);
 }
 
+/* add the elements of obr to the render totals, for the object itself or one of its instances */
+static void add_render_object_totals(Render *re, ObjectRen *obr)
+{
+	re->totvert += obr->totvert;
+	re->totvlak += obr->totvlak;
+	re->tothalo += obr->tothalo;
+	re->totstrand += obr->totstrand;
+
+	/* the elements added when finalizing are counted later, see database_finalize_objects */
+	if (obr->finalize)
+		obr->finalize->totcounted++;
+}
+
 static void find_dupli_instances(Render *re, ObjectRen *obr, DupliObject *dob)
 {
 	ObjectInstanceRen *obi;
@@ -4464,10 +4597,7 @@ static void find_dupli_instances(Render *re, ObjectRen *obr, DupliObject *dob)
 			}
 
 			if (!first) {
-				re->totvert += obr->totvert;
-				re->totvlak += obr->totvlak;
-				re->tothalo += obr->tothalo;
-				re->totstrand += obr->totstrand;
+				add_render_object_totals(re, obr);
 			}
 			else
 				first= 0;
@@ -4499,10 +4629,7 @@ static void assign_dupligroup_dupli(Render *re, ObjectInstanceRen *obi, ObjectRe
 		obi->dupliuv[1]= dob->uv[1];
 	}
 
-	re->totvert += obr->totvert;
-	re->totvlak += obr->totvlak;
-	re->tothalo += obr->tothalo;
-	re->totstrand += obr->totstrand;
+	add_render_object_totals(re, obr);
 }
 
 static ObjectRen *find_dupligroup_dupli(Render *re, Object *ob, int psysindex)
@@ -4605,10 +4732,7 @@ static void init_render_object_data(Render *re, ObjectRen *obr, int timeoffset)
 
 	finalize_render_object(re, obr, timeoffset);
 
-	re->totvert += obr->totvert;
-	re->totvlak += obr->totvlak;
-	re->tothalo += obr->tothalo;
-	re->totstrand += obr->totstrand;
+	add_render_object_totals(re, obr);
 }
 
 static void add_render_object(Render *re, Object *ob, Object *par, DupliObject *dob, float omat[4][4], int timeoffset)
@@ -5137,6 +5261,8 @@ static void database_init_objects(Render *re, unsigned int renderlay, int nolamp
 	for (group= re->main->group.first; group; group=group->id.next)
 		add_group_render_dupli_obs(re, group, nolamps, onlyselected, actob, timeoffset, 0);
 
+	database_finalize_objects(re);
+
 	if (!re->test_break(re->tbh))
 		RE_makeRenderInstances(re);
 }
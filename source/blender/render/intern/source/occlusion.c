@@ -41,6 +41,7 @@
 #include "BLI_math.h"
 #include "BLI_blenlib.h"
 #include "BLI_memarena.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
@@ -67,6 +68,14 @@
 #define TOTCHILD 8
 #define CACHE_STEP 3
 
+/* subtrees with more faces are built in their own task */
+#define OCC_BUILD_TASK_LIMIT 1024
+/* number of faces per task for passes and bounces */
+#define OCC_PASS_TASK_SIZE 1024
+
+/* childflag bit for nodes whose children are still being built in tasks */
+#define OCC_NODE_DEFERRED (1 << TOTCHILD)
+
 typedef struct OcclusionCacheSample {
 	float co[3], n[3], ao[3], env[3], indirect[3], intensity, dist2;
 	int x, y, filled;
@@ -113,8 +122,7 @@ typedef struct OcclusionTree {
 	float error;
 	float distfac;
 
-	int dothreadedbuild;
-	int totbuildthread;
+	struct TaskPool *buildpool;   /* temporary during threaded build */
 	int doindirect;
 
 	OcclusionCache *cache;
@@ -130,11 +138,19 @@ typedef struct OcclusionThread {
 	int thread;
 } OcclusionThread;
 
-typedef struct OcclusionBuildThread {
-	OcclusionTree *tree;
+typedef struct OcclusionBuildTask {
 	int begin, end, depth;
 	OccNode *node;
-} OcclusionBuildThread;
+} OcclusionBuildTask;
+
+typedef struct OcclusionPassTask {
+	Render *re;
+	OcclusionTree *tree;
+	float *occ;         /* occlusion for faces, passes only */
+	float (*rad)[3];    /* radiance for faces, bounces only */
+	float (*sum)[3];    /* summed radiance for faces, bounces only */
+	int begin, end;
+} OcclusionPassTask;
 
 /* ------------------------- Shading --------------------------- */
 
@@ -518,22 +534,52 @@ static void occ_build_8_split(OcclusionTree *tree, int begin, int end, int *offs
 
 static void occ_build_recursive(OcclusionTree *tree, OccNode *node, int begin, int end, int depth);
 
-static void *exec_occ_build(void *data)
+static void occ_build_task(TaskPool *pool, void *taskdata, int UNUSED(threadid))
 {
-	OcclusionBuildThread *othread = (OcclusionBuildThread *)data;
+	OcclusionTree *tree = (OcclusionTree *)BLI_task_pool_userdata(pool);
+	OcclusionBuildTask *task = (OcclusionBuildTask *)taskdata;
+
+	occ_build_recursive(tree, task->node, task->begin, task->end, task->depth);
+}
 
-	occ_build_recursive(othread->tree, othread->node, othread->begin, othread->end, othread->depth);
+static void occ_build_combine(OcclusionTree *tree, OccNode *node)
+{
+	OccNode *child, tmpnode;
+	int b;
 
-	return NULL;
+	/* combine area, position and sh */
+	for (b = 0; b < TOTCHILD; b++) {
+		if (node->childflag & (1 << b)) {
+			child = &tmpnode;
+			occ_node_from_face(tree->face + node->child[b].face, &tmpnode);
+		}
+		else {
+			child = node->child[b].node;
+		}
+
+		if (child) {
+			node->area += child->area;
+			sh_add(node->sh, node->sh, child->sh);
+			madd_v3_v3fl(node->co, child->co, child->area);
+		}
+	}
+
+	if (node->area != 0.0f)
+		mul_v3_fl(node->co, 1.0f / node->area);
+
+	/* compute maximum distance from center */
+	node->dco = 0.0f;
+	if (node->area > 0.0f)
+		occ_build_dco(tree, node, node->co, &node->dco);
 }
 
 static void occ_build_recursive(OcclusionTree *tree, OccNode *node, int begin, int end, int depth)
 {
-	ListBase threads;
-	OcclusionBuildThread othreads[BLENDER_MAX_THREADS];
-	OccNode *child, tmpnode;
+	OcclusionBuildTask *task;
+	OccNode *child;
 	/* OccFace *face; */
-	int a, b, totthread = 0, offset[TOTCHILD], count[TOTCHILD];
+	int a, b, offset[TOTCHILD], count[TOTCHILD];
+	bool deferred = false;
 
 	/* add a new node */
 	node->occlusion = 1.0f;
@@ -550,9 +596,6 @@ static void occ_build_recursive(OcclusionTree *tree, OccNode *node, int begin, i
 		/* order faces */
 		occ_build_8_split(tree, begin, end, offset, count);
 
-		if (depth == 1 && tree->dothreadedbuild)
-			BLI_init_threads(&threads, exec_occ_build, tree->totbuildthread);
-
 		for (b = 0; b < TOTCHILD; b++) {
 			if (count[b] == 0) {
 				node->child[b].node = NULL;
@@ -563,7 +606,7 @@ static void occ_build_recursive(OcclusionTree *tree, OccNode *node, int begin, i
 				node->childflag |= (1 << b);
 			}
 			else {
-				if (tree->dothreadedbuild)
+				if (tree->buildpool)
 					BLI_lock_thread(LOCK_CUSTOM1);
 
 				child = BLI_memarena_alloc(tree->arena, sizeof(OccNode));
@@ -573,51 +616,47 @@ static void occ_build_recursive(OcclusionTree *tree, OccNode *node, int begin, i
 				if (depth >= tree->maxdepth)
 					tree->maxdepth = depth + 1;
 
-				if (tree->dothreadedbuild)
+				if (tree->buildpool)
 					BLI_unlock_thread(LOCK_CUSTOM1);
 
-				if (depth == 1 && tree->dothreadedbuild) {
-					othreads[totthread].tree = tree;
-					othreads[totthread].node = child;
-					othreads[totthread].begin = offset[b];
-					othreads[totthread].end = offset[b] + count[b];
-					othreads[totthread].depth = depth + 1;
-					BLI_insert_thread(&threads, &othreads[totthread]);
-					totthread++;
+				if (tree->buildpool && count[b] > OCC_BUILD_TASK_LIMIT) {
+					task = MEM_mallocN(sizeof(OcclusionBuildTask), "OcclusionBuildTask");
+					task->node = child;
+					task->begin = offset[b];
+					task->end = offset[b] + count[b];
+					task->depth = depth + 1;
+					BLI_task_pool_push(tree->buildpool, occ_build_task, task, true, TASK_PRIORITY_HIGH);
+
+					deferred = true;
 				}
 				else
 					occ_build_recursive(tree, child, offset[b], offset[b] + count[b], depth + 1);
 			}
 		}
-
-		if (depth == 1 && tree->dothreadedbuild)
-			BLI_end_threads(&threads);
 	}
 
-	/* combine area, position and sh */
-	for (b = 0; b < TOTCHILD; b++) {
-		if (node->childflag & (1 << b)) {
-			child = &tmpnode;
-			occ_node_from_face(tree->face + node->child[b].face, &tmpnode);
-		}
-		else {
-			child = node->child[b].node;
-		}
+	/* children built in tasks are not done yet, combine in occ_build_finish */
+	if (deferred)
+		node->childflag |= OCC_NODE_DEFERRED;
+	else
+		occ_build_combine(tree, node);
+}
 
-		if (child) {
-			node->area += child->area;
-			sh_add(node->sh, node->sh, child->sh);
-			madd_v3_v3fl(node->co, child->co, child->area);
-		}
-	}
+static void occ_build_finish(OcclusionTree *tree, OccNode *node)
+{
+	/* combine the nodes that were deferred during threaded build, after
+	 * all tasks are done, children first */
+	int b;
 
-	if (node->area != 0.0f)
-		mul_v3_fl(node->co, 1.0f / node->area);
+	if (!(node->childflag & OCC_NODE_DEFERRED))
+		return;
 
-	/* compute maximum distance from center */
-	node->dco = 0.0f;
-	if (node->area > 0.0f)
-		occ_build_dco(tree, node, node->co, &node->dco);
+	for (b = 0; b < TOTCHILD; b++)
+		if (!(node->childflag & (1 << b)) && node->child[b].node)
+			occ_build_finish(tree, node->child[b].node);
+
+	node->childflag &= ~OCC_NODE_DEFERRED;
+	occ_build_combine(tree, node);
 }
 
 static void occ_build_sh_normalize(OccNode *node)
@@ -707,14 +746,29 @@ static OcclusionTree *occ_tree_build(Render *re)
 		}
 	}
 
-	/* threads */
-	tree->totbuildthread = (re->r.threads > 1 && totface > 10000) ? 8 : 1;
-	tree->dothreadedbuild = (tree->totbuildthread > 1);
-
 	/* recurse */
 	tree->root = BLI_memarena_alloc(tree->arena, sizeof(OccNode));
 	tree->maxdepth = 1;
-	occ_build_recursive(tree, tree->root, 0, totface, 1);
+
+	if (re->r.threads > 1 && totface > 10000) {
+		/* big subtrees are built in tasks at any depth */
+		TaskScheduler *scheduler = BLI_task_scheduler_create(re->r.threads);
+
+		tree->buildpool = BLI_task_pool_create(scheduler, tree);
+
+		BLI_begin_threaded_malloc();
+		occ_build_recursive(tree, tree->root, 0, totface, 1);
+		BLI_task_pool_work_and_wait(tree->buildpool);
+		BLI_end_threaded_malloc();
+
+		BLI_task_pool_free(tree->buildpool);
+		BLI_task_scheduler_free(scheduler);
+		tree->buildpool = NULL;
+
+		occ_build_finish(tree, tree->root);
+	}
+	else
+		occ_build_recursive(tree, tree->root, 0, totface, 1);
 
 	if (tree->doindirect) {
 		if (!(re->test_break(re->tbh)))
@@ -927,29 +981,83 @@ static void occ_lookup(OcclusionTree *tree, int thread, OccFace *exclude,
 	if (bentn) normalize_v3(bentn);
 }
 
+static OcclusionPassTask *occ_pass_tasks_create(Render *re, OcclusionTree *tree, int *r_tottask)
+{
+	OcclusionPassTask *tasks;
+	int a, tottask;
+
+	/* split faces in ranges, each done in a task */
+	tottask = (tree->totface + OCC_PASS_TASK_SIZE - 1) / OCC_PASS_TASK_SIZE;
+	tasks = MEM_callocN(sizeof(OcclusionPassTask) * tottask, "OcclusionPassTask");
+
+	for (a = 0; a < tottask; a++) {
+		tasks[a].re = re;
+		tasks[a].tree = tree;
+		tasks[a].begin = a * OCC_PASS_TASK_SIZE;
+		tasks[a].end = min_ii((a + 1) * OCC_PASS_TASK_SIZE, tree->totface);
+	}
+
+	*r_tottask = tottask;
+	return tasks;
+}
+
+static void occ_pass_tasks_run(TaskPool *pool, TaskRunFunction run, OcclusionPassTask *tasks, int tottask)
+{
+	int a;
+
+	for (a = 0; a < tottask; a++)
+		BLI_task_pool_push(pool, run, &tasks[a], false, TASK_PRIORITY_HIGH);
+
+	BLI_task_pool_work_and_wait(pool);
+}
+
+static void occ_bounce_task(TaskPool *UNUSED(pool), void *taskdata, int threadid)
+{
+	OcclusionPassTask *task = (OcclusionPassTask *)taskdata;
+	OcclusionTree *tree = task->tree;
+	Render *re = task->re;
+	float (*rad)[3] = task->rad, (*sum)[3] = task->sum, co[3], n[3], occ;
+	int i;
+
+	for (i = task->begin; i < task->end; i++) {
+		occ_face(&tree->face[i], co, n, NULL);
+		madd_v3_v3fl(co, n, 1e-8f);
+
+		/* the thread id indexes the traversal stack */
+		occ_lookup(tree, threadid, &tree->face[i], co, n, &occ, rad[i], NULL);
+		rad[i][0] = MAX2(rad[i][0], 0.0f);
+		rad[i][1] = MAX2(rad[i][1], 0.0f);
+		rad[i][2] = MAX2(rad[i][2], 0.0f);
+		add_v3_v3(sum[i], rad[i]);
+
+		if (re->test_break(re->tbh))
+			break;
+	}
+}
+
 static void occ_compute_bounces(Render *re, OcclusionTree *tree, int totbounce)
 {
-	float (*rad)[3], (*sum)[3], (*tmp)[3], co[3], n[3], occ;
-	int bounce, i;
+	TaskScheduler *scheduler;
+	TaskPool *pool;
+	OcclusionPassTask *tasks;
+	float (*rad)[3], (*sum)[3], (*tmp)[3];
+	int bounce, a, tottask;
 
 	rad = MEM_callocN(sizeof(float) * 3 * tree->totface, "OcclusionBounceRad");
 	sum = MEM_dupallocN(tree->rad);
 
-	for (bounce = 1; bounce < totbounce; bounce++) {
-		for (i = 0; i < tree->totface; i++) {
-			occ_face(&tree->face[i], co, n, NULL);
-			madd_v3_v3fl(co, n, 1e-8f);
-
-			occ_lookup(tree, 0, &tree->face[i], co, n, &occ, rad[i], NULL);
-			rad[i][0] = MAX2(rad[i][0], 0.0f);
-			rad[i][1] = MAX2(rad[i][1], 0.0f);
-			rad[i][2] = MAX2(rad[i][2], 0.0f);
-			add_v3_v3(sum[i], rad[i]);
+	tasks = occ_pass_tasks_create(re, tree, &tottask);
+	scheduler = BLI_task_scheduler_create(re->r.threads);
+	pool = BLI_task_pool_create(scheduler, NULL);
 
-			if (re->test_break(re->tbh))
-				break;
+	for (bounce = 1; bounce < totbounce; bounce++) {
+		for (a = 0; a < tottask; a++) {
+			tasks[a].rad = rad;
+			tasks[a].sum = sum;
 		}
 
+		occ_pass_tasks_run(pool, occ_bounce_task, tasks, tottask);
+
 		if (re->test_break(re->tbh))
 			break;
 
@@ -960,6 +1068,10 @@ static void occ_compute_bounces(Render *re, OcclusionTree *tree, int totbounce)
 		occ_sum_occlusion(tree, tree->root);
 	}
 
+	BLI_task_pool_free(pool);
+	BLI_task_scheduler_free(scheduler);
+	MEM_freeN(tasks);
+
 	MEM_freeN(rad);
 	MEM_freeN(tree->rad);
 	tree->rad = sum;
@@ -968,23 +1080,45 @@ static void occ_compute_bounces(Render *re, OcclusionTree *tree, int totbounce)
 		occ_sum_occlusion(tree, tree->root);
 }
 
+static void occ_pass_task(TaskPool *UNUSED(pool), void *taskdata, int threadid)
+{
+	OcclusionPassTask *task = (OcclusionPassTask *)taskdata;
+	OcclusionTree *tree = task->tree;
+	Render *re = task->re;
+	float co[3], n[3];
+	int i;
+
+	for (i = task->begin; i < task->end; i++) {
+		occ_face(&tree->face[i], co, n, NULL);
+		negate_v3(n);
+		madd_v3_v3fl(co, n, 1e-8f);
+
+		/* the thread id indexes the traversal stack */
+		occ_lookup(tree, threadid, &tree->face[i], co, n, &task->occ[i], NULL, NULL);
+		if (re->test_break(re->tbh))
+			break;
+	}
+}
+
 static void occ_compute_passes(Render *re, OcclusionTree *tree, int totpass)
 {
-	float *occ, co[3], n[3];
-	int pass, i;
+	TaskScheduler *scheduler;
+	TaskPool *pool;
+	OcclusionPassTask *tasks;
+	float *occ;
+	int pass, a, i, tottask;
 	
 	occ = MEM_callocN(sizeof(float) * tree->totface, "OcclusionPassOcc");
 
-	for (pass = 0; pass < totpass; pass++) {
-		for (i = 0; i < tree->totface; i++) {
-			occ_face(&tree->face[i], co, n, NULL);
-			negate_v3(n);
-			madd_v3_v3fl(co, n, 1e-8f);
+	tasks = occ_pass_tasks_create(re, tree, &tottask);
+	for (a = 0; a < tottask; a++)
+		tasks[a].occ = occ;
 
-			occ_lookup(tree, 0, &tree->face[i], co, n, &occ[i], NULL, NULL);
-			if (re->test_break(re->tbh))
-				break;
-		}
+	scheduler = BLI_task_scheduler_create(re->r.threads);
+	pool = BLI_task_pool_create(scheduler, NULL);
+
+	for (pass = 0; pass < totpass; pass++) {
+		occ_pass_tasks_run(pool, occ_pass_task, tasks, tottask);
 
 		if (re->test_break(re->tbh))
 			break;
@@ -998,6 +1132,10 @@ static void occ_compute_passes(Render *re, OcclusionTree *tree, int totpass)
 		occ_sum_occlusion(tree, tree->root);
 	}
 
+	BLI_task_pool_free(pool);
+	BLI_task_scheduler_free(scheduler);
+	MEM_freeN(tasks);
+
 	MEM_freeN(occ);
 }
 
@@ -42,9 +42,13 @@
 
 #include "BLI_blenlib.h"
 #include "BLI_cpu.h"
+#include "BLI_ghash.h"
 #include "BLI_jitter.h"
+#include "BLI_linklist.h"
 #include "BLI_math.h"
 #include "BLI_rand.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
 #include "BLF_translation.h"
@@ -224,62 +228,68 @@ static int is_raytraceable(Render *re, ObjectInstanceRen *obi)
 }
 
 
-RayObject* makeraytree_object(Render *re, ObjectInstanceRen *obi)
+/* build the tree of the faces of obi->obr, used by all its instances */
+static void makeraytree_object_build(Render *re, ObjectInstanceRen *obi)
 {
 	/*TODO
 	 * out-of-memory safeproof
 	 * break render
 	 * update render stats */
 	ObjectRen *obr = obi->obr;
+	RayObject *raytree;
+	RayFace *face = NULL;
+	VlakPrimitive *vlakprimitive = NULL;
+	int v;
+	
+	//Count faces
+	int faces = 0;
+	for (v=0;v<obr->totvlak;v++) {
+		VlakRen *vlr = obr->vlaknodes[v>>8].vlak + (v&255);
+		if (is_raytraceable_vlr(re, vlr))
+			faces++;
+	}
+	
+	if (faces == 0)
+		return;
 
-	if (obr->raytree == NULL) {
-		RayObject *raytree;
-		RayFace *face = NULL;
-		VlakPrimitive *vlakprimitive = NULL;
-		int v;
-		
-		//Count faces
-		int faces = 0;
-		for (v=0;v<obr->totvlak;v++) {
-			VlakRen *vlr = obr->vlaknodes[v>>8].vlak + (v&255);
-			if (is_raytraceable_vlr(re, vlr))
-				faces++;
-		}
-		
-		if (faces == 0)
-			return NULL;
-
-		//Create Ray cast accelaration structure
-		raytree = rayobject_create( re,  re->r.raytrace_structure, faces );
-		if (  (re->r.raytrace_options & R_RAYTRACE_USE_LOCAL_COORDS) )
-			vlakprimitive = obr->rayprimitives = (VlakPrimitive *)MEM_callocN(faces * sizeof(VlakPrimitive), "ObjectRen primitives");
-		else
-			face = obr->rayfaces = (RayFace *)MEM_callocN(faces * sizeof(RayFace), "ObjectRen faces");
+	//Create Ray cast accelaration structure
+	raytree = rayobject_create( re,  re->r.raytrace_structure, faces );
+	if (  (re->r.raytrace_options & R_RAYTRACE_USE_LOCAL_COORDS) )
+		vlakprimitive = obr->rayprimitives = (VlakPrimitive *)MEM_callocN(faces * sizeof(VlakPrimitive), "ObjectRen primitives");
+	else
+		face = obr->rayfaces = (RayFace *)MEM_callocN(faces * sizeof(RayFace), "ObjectRen faces");
 
-		obr->rayobi = obi;
-		
-		for (v=0;v<obr->totvlak;v++) {
-			VlakRen *vlr = obr->vlaknodes[v>>8].vlak + (v&255);
-			if (is_raytraceable_vlr(re, vlr)) {
-				if ((re->r.raytrace_options & R_RAYTRACE_USE_LOCAL_COORDS)) {
-					RE_rayobject_add(raytree, RE_vlakprimitive_from_vlak(vlakprimitive, obi, vlr));
-					vlakprimitive++;
-				}
-				else {
-					RE_rayface_from_vlak(face, obi, vlr);
-					RE_rayobject_add(raytree, RE_rayobject_unalignRayFace(face));
-					face++;
-				}
+	obr->rayobi = obi;
+	
+	for (v=0;v<obr->totvlak;v++) {
+		VlakRen *vlr = obr->vlaknodes[v>>8].vlak + (v&255);
+		if (is_raytraceable_vlr(re, vlr)) {
+			if ((re->r.raytrace_options & R_RAYTRACE_USE_LOCAL_COORDS)) {
+				RE_rayobject_add(raytree, RE_vlakprimitive_from_vlak(vlakprimitive, obi, vlr));
+				vlakprimitive++;
+			}
+			else {
+				RE_rayface_from_vlak(face, obi, vlr);
+				RE_rayobject_add(raytree, RE_rayobject_unalignRayFace(face));
+				face++;
 			}
 		}
-		RE_rayobject_done(raytree);
-
-		/* in case of cancel during build, raytree is not usable */
-		if (test_break(re))
-			RE_rayobject_free(raytree);
-		else
-			obr->raytree= raytree;
 	}
+	RE_rayobject_done(raytree);
+
+	/* in case of cancel during build, raytree is not usable */
+	if (test_break(re))
+		RE_rayobject_free(raytree);
+	else
+		obr->raytree= raytree;
+}
+
+RayObject* makeraytree_object(Render *re, ObjectInstanceRen *obi)
+{
+	ObjectRen *obr = obi->obr;
+
+	if (obr->raytree == NULL)
+		makeraytree_object_build(re, obi);
 
 	if (obr->raytree) {
 		if ((obi->flag & R_TRANSFORMED) && obi->raytree == NULL) {
@@ -309,6 +319,63 @@ static bool has_special_rayobject(Render *re, ObjectInstanceRen *obi)
 	}
 	return 0;
 }
+static void makeraytree_object_task(TaskPool *pool, void *taskdata, int UNUSED(threadid))
+{
+	Render *re = (Render *)BLI_task_pool_userdata(pool);
+	ObjectInstanceRen *obi = (ObjectInstanceRen *)taskdata;
+
+	if (!test_break(re))
+		makeraytree_object_build(re, obi);
+}
+
+/*
+ * build the trees of the objects added as instances to the main tree in threads,
+ * once for each ObjectRen, makeraytree_single only adds them afterwards
+ */
+static void makeraytree_objects_threaded(Render *re)
+{
+	ObjectInstanceRen *obi;
+	GSet *obr_set = BLI_gset_ptr_new(__func__);
+	LinkNode *build_obis = NULL, *node;
+	int totbuild = 0;
+
+	for (obi=re->instancetable.first; obi; obi=obi->next) {
+		ObjectRen *obr = obi->obr;
+
+		if (obr->raytree == NULL && !BLI_gset_haskey(obr_set, obr)) {
+			if (is_raytraceable(re, obi) && has_special_rayobject(re, obi)) {
+				BLI_gset_insert(obr_set, obr);
+				BLI_linklist_prepend(&build_obis, obi);
+				totbuild++;
+			}
+		}
+	}
+
+	BLI_gset_free(obr_set, NULL);
+
+	if (totbuild > 1 && re->r.threads > 1) {
+		TaskScheduler *task_scheduler;
+		TaskPool *task_pool;
+
+		BLI_begin_threaded_malloc();
+
+		task_scheduler = BLI_task_scheduler_create(re->r.threads);
+		task_pool = BLI_task_pool_create(task_scheduler, re);
+
+		for (node = build_obis; node; node = node->next)
+			BLI_task_pool_push(task_pool, makeraytree_object_task, node->link, false, TASK_PRIORITY_HIGH);
+
+		BLI_task_pool_work_and_wait(task_pool);
+
+		BLI_task_pool_free(task_pool);
+		BLI_task_scheduler_free(task_scheduler);
+
+		BLI_end_threaded_malloc();
+	}
+
+	BLI_linklist_free(build_obis, NULL);
+}
+
 /*
  * create a single raytrace structure with all faces
  */
@@ -342,6 +409,9 @@ static void makeraytree_single(Render *re)
 		re->raytree = RE_rayobject_empty_create();
 		return;
 	}
+
+	if (special > 1)
+		makeraytree_objects_threaded(re);
 	
 	//Create raytree
 	raytree = re->raytree = rayobject_create( re, re->r.raytrace_structure, faces+special );
@@ -365,6 +365,30 @@ static void init_frame_smoke(VoxelData *vd, int cfra)
 #endif
 }
 
+/* mark the blocks holding data, so lookups in empty space don't need to sample */
+static void make_voxeldata_blockmask(VoxelData *vd)
+{
+	const size_t totres = vd_resol_size(vd);
+	const int depth = (vd->data_type == TEX_VD_RGBA_PREMUL) ? 4 : 1;
+	int block_res[3], totblock, ch, b;
+	unsigned char *chmask;
+
+	totblock = BLI_voxel_block_res(vd->resol, block_res);
+	vd->blockmask = MEM_callocN(totblock, "voxel block mask");
+	chmask = MEM_mallocN(totblock, "voxel block mask channel");
+
+	for (ch = 0; ch < depth; ch++) {
+		BLI_voxel_block_mask(vd->dataset + ch * totres, vd->resol, chmask);
+		for (b = 0; b < totblock; b++)
+			vd->blockmask[b] |= chmask[b];
+	}
+
+	MEM_freeN(chmask);
+
+	/* interpolation reads voxels of the neighbor blocks */
+	BLI_voxel_block_mask_dilate(block_res, vd->blockmask);
+}
+
 void cache_voxeldata(Tex *tex, int scene_frame)
 {	
 	VoxelData *vd = tex->vd;
@@ -381,6 +405,10 @@ void cache_voxeldata(Tex *tex, int scene_frame)
 		MEM_freeN(vd->dataset);
 		vd->dataset = NULL;
 	}
+	if (vd->blockmask) {
+		MEM_freeN(vd->blockmask);
+		vd->blockmask = NULL;
+	}
 	/* reset data_type */
 	vd->data_type = TEX_VD_INTENSITY;
 
@@ -394,10 +422,10 @@ void cache_voxeldata(Tex *tex, int scene_frame)
 	switch (vd->file_format) {
 		case TEX_VD_IMAGE_SEQUENCE:
 			load_frame_image_sequence(vd, tex);
-			return;
+			break;
 		case TEX_VD_SMOKE:
 			init_frame_smoke(vd, scene_frame);
-			return;
+			break;
 		case TEX_VD_BLENDERVOXEL:
 			BLI_path_abs(path, G.main->name);
 			if (!BLI_exists(path)) return;
@@ -408,7 +436,7 @@ void cache_voxeldata(Tex *tex, int scene_frame)
 				load_frame_blendervoxel(vd, fp, curframe - 1);
 
 			fclose(fp);
-			return;
+			break;
 		case TEX_VD_RAW_8BIT:
 			BLI_path_abs(path, G.main->name);
 			if (!BLI_exists(path)) return;
@@ -417,8 +445,11 @@ void cache_voxeldata(Tex *tex, int scene_frame)
 			
 			load_frame_raw8(vd, fp, curframe);
 			fclose(fp);
-			return;
+			break;
 	}
+
+	if (vd->dataset)
+		make_voxeldata_blockmask(vd);
 }
 
 void make_voxeldata(struct Render *re)
@@ -447,6 +478,7 @@ int voxeldatatex(struct Tex *tex, const float texvec[3], struct TexResult *texre
 	int retval = (vd->data_type == TEX_VD_RGBA_PREMUL) ? TEX_RGB : TEX_INT;
 	int depth = (vd->data_type == TEX_VD_RGBA_PREMUL) ? 4 : 1;
 	int ch;
+	bool empty;
 
 	if (vd->dataset == NULL) {
 		texres->tin = 0.0f;
@@ -486,6 +518,9 @@ int voxeldatatex(struct Tex *tex, const float texvec[3], struct TexResult *texre
 		}
 	}
 
+	/* all the voxels around co are zero, skip the interpolation */
+	empty = vd->blockmask && BLI_voxel_block_is_empty(vd->blockmask, vd->resol, co);
+
 	for (ch = 0; ch < depth; ch++) {
 		float *dataset = vd->dataset + ch*vd->resol[0]*vd->resol[1]*vd->resol[2];
 		float *result = &texres->tin;
@@ -504,6 +539,11 @@ int voxeldatatex(struct Tex *tex, const float texvec[3], struct TexResult *texre
 			}
 		}
 
+		if (empty) {
+			*result = 0.0f;
+			continue;
+		}
+
 		switch (vd->interp_type) {
 			case TEX_VD_NEARESTNEIGHBOR:
 				*result = BLI_voxel_sample_nearest(dataset, vd->resol, co);
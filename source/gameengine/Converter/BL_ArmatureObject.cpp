@@ -500,6 +500,17 @@ void BL_ArmatureObject::RestorePose()
 	m_armpose = NULL;
 }
 
+bool BL_ArmatureObject::HasPoseConstraints() const
+{
+	bPoseChannel *pchan;
+
+	for (pchan = (bPoseChannel *)m_pose->chanbase.first; pchan; pchan = pchan->next) {
+		if (pchan->constraints.first)
+			return true;
+	}
+	return false;
+}
+
 void BL_ArmatureObject::SetPose(bPose *pose)
 {
 	extract_pose_from_pose(m_pose, pose);
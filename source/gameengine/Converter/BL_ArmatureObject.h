@@ -80,6 +80,8 @@ public:
 
 	void ApplyPose();
 	void RestorePose();
+	/// True if the pose has constraints, their evaluation may read and modify other objects.
+	bool HasPoseConstraints() const;
 
 	bool SetActiveAction(class BL_ActionActuator *act, short priority, double curtime);
 	
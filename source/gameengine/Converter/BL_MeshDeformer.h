@@ -70,6 +70,7 @@ public:
 	virtual	RAS_Deformer*	GetReplica() {return NULL;}
 	virtual void ProcessReplica();
 	struct Mesh* GetMesh() { return m_bmesh; }
+	struct Object* GetBlenderObject() { return m_objMesh; }
 	virtual class RAS_MeshObject* GetRasMesh() { return m_pMeshObject; }
 	virtual float (* GetTransVerts(int *tot))[3]	{	*tot= m_tvtot; return m_transverts; }
 	//	virtual void InitDeform(double time) {}
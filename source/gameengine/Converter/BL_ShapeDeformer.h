@@ -61,6 +61,8 @@ public:
 	virtual ~BL_ShapeDeformer();
 
 	bool Update (void);
+	/* shape keys are evaluated on the Blender mesh shared by the replicas, leave it to Apply() */
+	virtual void PrepareUpdate() {}
 	bool LoadShapeDrivers(Object* arma);
 	bool ExecuteShapeDrivers(void);
 
@@ -115,6 +115,7 @@ BL_SkinDeformer::BL_SkinDeformer(
 		m_lastArmaUpdate(-1),
 		//m_defbase(&bmeshobj_old->defbase),
 		m_releaseobject(release_object),
+		m_poseApplied(false),
 		m_recalcNormal(recalc_normal),
 		m_copyNormals(false),
 		m_dfnrToPC(NULL)
@@ -157,9 +158,10 @@ bool BL_SkinDeformer::Apply(RAS_IPolyMaterial *mat)
 	RAS_MeshSlot *slot;
 	size_t i, nmat, imat;
 
-	// update the vertex in m_transverts
-	if (!Update())
+	// update the vertex in m_transverts, unless PrepareUpdate() already did
+	if (!Update() && !m_poseApplied)
 		return false;
+	m_poseApplied = false;
 
 	if (m_transverts) {
 		// the vertex cache is unique to this deformer, no need to update it
@@ -207,6 +209,7 @@ void BL_SkinDeformer::ProcessReplica()
 	BL_MeshDeformer::ProcessReplica();
 	m_lastArmaUpdate = -1;
 	m_releaseobject = false;
+	m_poseApplied = false;
 	m_dfnrToPC = NULL;
 }
 
@@ -370,6 +373,12 @@ bool BL_SkinDeformer::Update(void)
 	return UpdateInternal(false);
 }
 
+void BL_SkinDeformer::PrepareUpdate()
+{
+	if (UpdateInternal(false))
+		m_poseApplied = true;
+}
+
 /* XXX note: I propose to drop this function */
 void BL_SkinDeformer::SetArmature(BL_ArmatureObject *armobj)
 {
@@ -81,6 +81,11 @@ public:
 		// update the deformer and all the mesh slots; Apply() does it well, so just call it.
 		return Apply(NULL);
 	}
+	/* Skin the mesh ahead of rendering, Apply() then only copies the vertices to the mesh slots.
+	 * Only the data of this deformer and of its armature are modified, so the deformers of armatures
+	 * that don't share their Blender object can be prepared on different threads. */
+	virtual void PrepareUpdate();
+	BL_ArmatureObject *GetArmature() { return m_armobj; }
 	bool PoseUpdated(void)
 		{ 
 			if (m_armobj && m_lastArmaUpdate!=m_armobj->GetLastFrame()) {
@@ -105,7 +110,7 @@ protected:
 	//ListBase*				m_defbase;
 	float					m_obmat[4][4];	// the reference matrix for skeleton deform
 	bool					m_releaseobject;
-	bool					m_poseApplied;
+	bool					m_poseApplied;	// PrepareUpdate() skinned the mesh, Apply() must copy the vertices
 	bool					m_recalcNormal;
 	bool					m_copyNormals; // dirty flag so we know if Apply() needs to copy normal information (used for BGEDeformVerts())
 	struct bPoseChannel**	m_dfnrToPC;
@@ -52,6 +52,16 @@ SCA_IObject::SCA_IObject():
 }
 
 SCA_IObject::~SCA_IObject()
+{
+	ClearLogic();
+
+	//T_InterpolatorList::iterator i;
+	//for (i = m_interpolators.begin(); !(i == m_interpolators.end()); ++i) {
+	//	delete *i;
+	//}
+}
+
+void SCA_IObject::ClearLogic()
 {
 	SCA_SensorList::iterator its;
 	for (its = m_sensors.begin(); !(its == m_sensors.end()); ++its)
@@ -83,10 +93,24 @@ SCA_IObject::~SCA_IObject()
 		(*ito)->UnlinkObject(this);
 	}
 
-	//T_InterpolatorList::iterator i;
-	//for (i = m_interpolators.begin(); !(i == m_interpolators.end()); ++i) {
-	//	delete *i;
-	//}
+	m_sensors.clear();
+	m_controllers.clear();
+	m_actuators.clear();
+	m_registeredActuators.clear();
+	m_registeredObjects.clear();
+}
+
+void SCA_IObject::SetLogicTemplate(SCA_IObject* orgobj)
+{
+	// same as the copy constructor: the bricks are shared until ReParentLogic()
+	m_sensors = orgobj->m_sensors;
+	m_controllers = orgobj->m_controllers;
+	m_actuators = orgobj->m_actuators;
+	m_ignore_activity_culling = orgobj->m_ignore_activity_culling;
+	m_suspended = orgobj->m_suspended;
+	m_initState = orgobj->m_initState;
+	m_state = 0;
+	m_firstState = orgobj->m_firstState;
 }
 
 void SCA_IObject::AddSensor(SCA_ISensor* act)
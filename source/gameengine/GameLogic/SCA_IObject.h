@@ -165,6 +165,19 @@ public:
 	void SetCurrentTime(float currentTime) {}
 
 	virtual void ReParentLogic();
+
+	/**
+	 * Delete the logic bricks and unlink this object from the actuators and
+	 * objects that refer to it, as the destructor does. Used when an ended
+	 * replica is kept for recycling.
+	 */
+	void ClearLogic();
+
+	/**
+	 * Take the logic bricks and the logic state of orgobj as a new replica
+	 * does, ReParentLogic() must be called next to replicate the bricks.
+	 */
+	void SetLogicTemplate(SCA_IObject* orgobj);
 	
 	/**
 	 * Set whether or not to ignore activity culling requests
@@ -45,6 +45,7 @@
 #include <iostream>
 #include <MT_assert.h>
 #include <stdlib.h>
+#include <ctype.h>
 
 /**********************************
  * Begin Blender include block
@@ -70,6 +71,9 @@ extern "C"
 
 #include "BL_System.h"
 #include "KX_KetsjiEngine.h"
+#include "KX_Scene.h"
+#include "KX_GameObject.h"
+#include "ListValue.h"
 
 // include files needed by "KX_BlenderSceneConverter.h"
 #include "CTR_Map.h"
@@ -78,12 +82,15 @@ extern "C"
 #include "RAS_OpenGLRasterizer.h"
 #include "RAS_ListRasterizer.h"
 #include "RAS_GLExtensionManager.h"
+#include "RAS_NullCanvas.h"
+#include "RAS_NullRasterizer.h"
 #include "KX_PythonInit.h"
 #include "KX_PyConstraintBinding.h"
 #include "BL_Material.h" // MAXTEX
 
 #include "KX_BlenderSceneConverter.h"
 #include "NG_LoopBackNetworkDeviceInterface.h"
+#include "NG_UdpNetworkDeviceInterface.h"
 
 #include "GPC_MouseDevice.h"
 #include "GPG_Canvas.h" 
@@ -121,6 +128,7 @@ GPG_Application::GPG_Application(GHOST_ISystem* system)
 	  m_engineInitialized(0), 
 	  m_engineRunning(0), 
 	  m_isEmbedded(false),
+	  m_isHeadless(false),
 	  m_ketsjiengine(0),
 	  m_kxsystem(0), 
 	  m_keyboard(0), 
@@ -129,6 +137,8 @@ GPG_Application::GPG_Application(GHOST_ISystem* system)
 	  m_rasterizer(0), 
 	  m_sceneconverter(0),
 	  m_networkdevice(0),
+	  m_networkPort(0),
+	  m_networkLocalPort(0),
 	  m_blendermat(0),
 	  m_blenderglslmat(0),
 	  m_pyGlobalDictString(0),
@@ -372,6 +382,18 @@ bool GPG_Application::startEmbeddedWindow(
 }
 
 
+bool GPG_Application::startHeadless()
+{
+	m_isHeadless = true;
+
+	bool success = initEngine(NULL, RAS_IRasterizer::RAS_STEREO_NOSTEREO);
+	if (success) {
+		success = startEngine();
+	}
+	return success;
+}
+
+
 bool GPG_Application::startFullScreen(
         int width,
         int height,
@@ -506,7 +528,7 @@ bool GPG_Application::processEvent(GHOST_IEvent* event)
 			if (m_canvas) {
 				GHOST_Rect bnds;
 				window->getClientBounds(bnds);
-				m_canvas->Resize(bnds.getWidth(), bnds.getHeight());
+				((GPG_Canvas *)m_canvas)->Resize(bnds.getWidth(), bnds.getHeight());
 				m_ketsjiengine->Resize();
 			}
 			}
@@ -545,8 +567,10 @@ bool GPG_Application::initEngine(GHOST_IWindow* window, const int stereoMode)
 {
 	if (!m_engineInitialized)
 	{
-		GPU_extensions_init();
-		bgl::InitExtensions(true);
+		if (!m_isHeadless) {
+			GPU_extensions_init();
+			bgl::InitExtensions(true);
+		}
 
 		// get and set the preferences
 		SYS_SystemHandle syshandle = SYS_GetSystem();
@@ -562,7 +586,7 @@ bool GPG_Application::initEngine(GHOST_IWindow* window, const int stereoMode)
 		bool showPhysics = (gm->flag & GAME_SHOW_PHYSICS);
 		SYS_WriteCommandLineInt(syshandle, "show_physics", showPhysics);
 
-		bool fixed_framerate= (SYS_GetCommandLineInt(syshandle, "fixedtime", (gm->flag & GAME_ENABLE_ALL_FRAMES)) != 0);
+		bool fixed_framerate= m_isHeadless || (SYS_GetCommandLineInt(syshandle, "fixedtime", (gm->flag & GAME_ENABLE_ALL_FRAMES)) != 0);
 		bool frameRate = (SYS_GetCommandLineInt(syshandle, "show_framerate", 0) != 0);
 		bool useLists = (SYS_GetCommandLineInt(syshandle, "displaylists", gm->flag & GAME_DISPLAY_LISTS) != 0) && GPU_display_list_support();
 		bool nodepwarnings = (SYS_GetCommandLineInt(syshandle, "ignore_deprecation_warnings", 1) != 0);
@@ -577,7 +601,10 @@ bool GPG_Application::initEngine(GHOST_IWindow* window, const int stereoMode)
 			m_blendermat = false;
 
 		// create the canvas, rasterizer and rendertools
-		m_canvas = new GPG_Canvas(window);
+		if (m_isHeadless)
+			m_canvas = new RAS_NullCanvas(gm->xplay > 0 ? gm->xplay : 640, gm->yplay > 0 ? gm->yplay : 480);
+		else
+			m_canvas = new GPG_Canvas(window);
 		if (!m_canvas)
 			return false;
 
@@ -592,7 +619,9 @@ bool GPG_Application::initEngine(GHOST_IWindow* window, const int stereoMode)
 		
 		//Don't use displaylists with VBOs
 		//If auto starts using VBOs, make sure to check for that here
-		if (useLists && gm->raster_storage != RAS_STORE_VBO)
+		if (m_isHeadless)
+			m_rasterizer = new RAS_NullRasterizer(m_canvas);
+		else if (useLists && gm->raster_storage != RAS_STORE_VBO)
 			m_rasterizer = new RAS_ListRasterizer(m_canvas, false, gm->raster_storage);
 		else
 			m_rasterizer = new RAS_OpenGLRasterizer(m_canvas, gm->raster_storage);
@@ -614,7 +643,16 @@ bool GPG_Application::initEngine(GHOST_IWindow* window, const int stereoMode)
 			goto initFailed;
 			
 		// create a networkdevice
-		m_networkdevice = new NG_LoopBackNetworkDeviceInterface();
+		if (!m_networkAddress.IsEmpty())
+		{
+			NG_UdpNetworkDeviceInterface* udpdevice = new NG_UdpNetworkDeviceInterface();
+			if (!udpdevice->Connect(m_networkAddress.Ptr(), m_networkPort, NULL, m_networkLocalPort, 0))
+				printf("error: couldn't connect to %s:%u, network messages stay local.\n",
+				       m_networkAddress.ReadPtr(), m_networkPort);
+			m_networkdevice = udpdevice;
+		}
+		else
+			m_networkdevice = new NG_LoopBackNetworkDeviceInterface();
 		if (!m_networkdevice)
 			goto initFailed;
 			
@@ -724,7 +762,7 @@ bool GPG_Application::startEngine(void)
 #endif // WITH_PYTHON
 
 		//initialize Dome Settings
-		if (m_startScene->gm.stereoflag == STEREO_DOME)
+		if (m_startScene->gm.stereoflag == STEREO_DOME && !m_isHeadless)
 			m_ketsjiengine->InitDome(m_startScene->gm.dome.res, m_startScene->gm.dome.mode, m_startScene->gm.dome.angle, m_startScene->gm.dome.resbuf, m_startScene->gm.dome.tilt, m_startScene->gm.dome.warptext);
 
 		// initialize 3D Audio Settings
@@ -748,7 +786,7 @@ bool GPG_Application::startEngine(void)
 		m_ketsjiengine->AddScene(startscene);
 		
 		// Create a timer that is used to kick the engine
-		if (!m_frameTimer) {
+		if (!m_frameTimer && !m_isHeadless) {
 			m_frameTimer = m_system->installTimer(0, kTimerFreq, frameTimerProc, m_mainWindow);
 		}
 		m_rasterizer->Init();
@@ -786,6 +824,12 @@ void GPG_Application::stopEngine()
 #endif
 	
 	m_ketsjiengine->StopEngine();
+	if (!m_networkAddress.IsEmpty()) {
+		unsigned int lost = ((NG_UdpNetworkDeviceInterface *)m_networkdevice)->GetLostPackets();
+		if (lost)
+			printf("Network: %u datagrams from %s:%u were lost or arrived too late\n",
+			       lost, m_networkAddress.ReadPtr(), m_networkPort);
+	}
 	m_networkdevice->Disconnect();
 
 	if (m_sceneconverter) {
@@ -823,6 +867,62 @@ void GPG_Application::EngineNextFrame()
 	m_exitString = m_ketsjiengine->GetExitString();
 }
 
+/* "GPU Latency:" -> "gpu_latency" */
+static void write_profile_key(FILE *fp, const char *label)
+{
+	for (const char *c = label; *c && *c != ':'; c++)
+		fputc((*c == ' ') ? '_' : tolower(*c), fp);
+}
+
+void GPG_Application::SetNetworkPeer(const char *address, unsigned int port, unsigned int localport)
+{
+	m_networkAddress = address;
+	m_networkPort = port;
+	m_networkLocalPort = localport;
+}
+
+void GPG_Application::runHeadless(int frames, FILE *fp)
+{
+	const int numcategories = KX_KetsjiEngine::GetNumProfileCategories();
+	double *times = new double[numcategories];
+	int i;
+
+	fprintf(fp, "frame");
+	for (i = 0; i < numcategories; i++) {
+		fputc(',', fp);
+		write_profile_key(fp, KX_KetsjiEngine::GetProfileLabel(i));
+	}
+	fputc('\n', fp);
+
+	// start the measurement of the first frame
+	m_ketsjiengine->NextProfileMeasurement(times);
+
+	for (int frame = 1; frame <= frames && !m_exitRequested; frame++) {
+		// Nothing is drawn so the view culling doesn't run, consider all objects
+		// visible so that animations and deformations are computed as on screen.
+		KX_SceneList *scenes = m_ketsjiengine->CurrentScenes();
+		for (KX_SceneList::iterator sceneit = scenes->begin(); sceneit != scenes->end(); ++sceneit) {
+			CListValue *objects = (*sceneit)->GetObjectList();
+			for (i = 0; i < objects->GetCount(); i++)
+				((KX_GameObject *)objects->GetValue(i))->SetCulled(false);
+		}
+
+		// with a fixed time every call steps one logic frame
+		m_ketsjiengine->NextFrame();
+		m_exitRequested = m_ketsjiengine->GetExitCode();
+
+		m_ketsjiengine->NextProfileMeasurement(times);
+		fprintf(fp, "%d", frame);
+		for (i = 0; i < numcategories; i++)
+			fprintf(fp, ",%.4f", times[i] * 1000.0);
+		fputc('\n', fp);
+	}
+	fflush(fp);
+
+	delete [] times;
+	m_exitString = m_ketsjiengine->GetExitString();
+}
+
 void GPG_Application::exitEngine()
 {
 	// We only want to kill the engine if it has been initialized
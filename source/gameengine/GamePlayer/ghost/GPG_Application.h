@@ -33,6 +33,8 @@
 #include "GHOST_IEventConsumer.h"
 #include "STR_String.h"
 
+#include <stdio.h>
+
 #ifdef WIN32
 #include <wtypes.h>
 #endif
@@ -41,14 +43,14 @@
 
 class KX_KetsjiEngine;
 class KX_ISceneConverter;
-class NG_LoopBackNetworkDeviceInterface;
+class NG_NetworkDeviceInterface;
 class RAS_IRasterizer;
 class GHOST_IEvent;
 class GHOST_ISystem;
 class GHOST_ITimerTask;
 class GHOST_IWindow;
 class GPC_MouseDevice;
-class GPG_Canvas;
+class RAS_ICanvas;
 class GPG_KeyboardDevice;
 class GPG_System;
 struct Main;
@@ -71,6 +73,7 @@ public:
 	                     const GHOST_TUns16 samples=0, bool useDesktop=false);
 	bool startEmbeddedWindow(STR_String& title, const GHOST_TEmbedderWindowID parent_window,
 	                         const bool stereoVisual, const int stereoMode, const GHOST_TUns16 samples=0);
+	bool startHeadless();
 #ifdef WIN32
 	bool startScreenSaverFullScreen(int width, int height,
 	                                int bpp, int frequency,
@@ -87,6 +90,18 @@ public:
 	void StopGameEngine();
 	void EngineNextFrame();
 
+	/**
+	 * Steps a headless engine by a number of logic frames at a fixed time step, without drawing,
+	 * and writes the time spent in each profiling category per frame to fp, as CSV.
+	 */
+	void runHeadless(int frames, FILE *fp);
+
+	/**
+	 * Send the network messages to a peer over UDP as well, from localport to address:port.
+	 * Must be called before the engine is started.
+	 */
+	void SetNetworkPeer(const char *address, unsigned int port, unsigned int localport);
+
 protected:
 	bool	handleWheel(GHOST_IEvent* event);
 	bool	handleButton(GHOST_IEvent* event, bool isDown);
@@ -139,6 +154,8 @@ protected:
 	bool m_engineRunning;
 	/** Running on embedded window */
 	bool m_isEmbedded;
+	/** Running without window nor drawing */
+	bool m_isHeadless;
 
 	/** the gameengine itself */
 	KX_KetsjiEngine* m_ketsjiengine;
@@ -149,13 +166,17 @@ protected:
 	/** The game engine's mouse abstraction. */
 	GPC_MouseDevice* m_mouse;
 	/** The game engine's canvas abstraction. */
-	GPG_Canvas* m_canvas;
+	RAS_ICanvas* m_canvas;
 	/** the rasterizer */
 	RAS_IRasterizer* m_rasterizer;
 	/** Converts Blender data files. */
 	KX_ISceneConverter* m_sceneconverter;
 	/** Network interface. */
-	NG_LoopBackNetworkDeviceInterface* m_networkdevice;
+	NG_NetworkDeviceInterface* m_networkdevice;
+	/** Network peer, messages stay local when the address is empty. */
+	STR_String m_networkAddress;
+	unsigned int m_networkPort;
+	unsigned int m_networkLocalPort;
 
 	bool m_blendermat;
 	bool m_blenderglslmat;
@@ -210,7 +210,7 @@ static void usage(const char* program, bool isBlenderPlayer)
 	}
 	
 	printf("usage:   %s [-w [w h l t]] [-f [fw fh fb ff]] %s[-g gamengineoptions] "
-	       "[-s stereomode] [-m aasamples] %s\n", program, consoleoption, example_filename);
+	       "[-s stereomode] [-m aasamples] [-b frames [file]] [-n address port localport] %s\n", program, consoleoption, example_filename);
 	printf("  -h: Prints this command summary\n\n");
 	printf("  -w: display in a window\n");
 	printf("       --Optional parameters--\n"); 
@@ -248,6 +248,15 @@ static void usage(const char* program, bool isBlenderPlayer)
 	printf("                             depending on the type of dome you are using\n\n");
 	printf("  -m: maximum anti-aliasing (eg. 2,4,8,16)\n\n");
 	printf("  -i: parent windows ID\n\n");
+	printf("  -b: run headless, without window nor drawing: step the logic and physics\n");
+	printf("      by frames logic frames at a fixed time step and write the time spent in\n");
+	printf("      each profiling category for every frame, in milliseconds, as CSV\n");
+	printf("       --Optional parameters--\n");
+	printf("       file = file to write the timings to, instead of the standard output\n\n");
+	printf("  -n: send the network messages to another player over UDP\n");
+	printf("       address   = host name or IP address of the other player\n");
+	printf("       port      = UDP port the other player uses as localport\n");
+	printf("       localport = UDP port to receive the messages of the other player on\n\n");
 #ifdef _WIN32
 	printf("  -c: keep console window open\n\n");
 #endif
@@ -267,7 +276,8 @@ static void usage(const char* program, bool isBlenderPlayer)
 	printf("\n");
 	printf("example: %s -w 320 200 10 10 -g noaudio%s%s\n", program, example_pathname, example_filename);
 	printf("example: %s -g show_framerate = 0 %s%s\n", program, example_pathname, example_filename);
-	printf("example: %s -i 232421 -m 16 %s%s\n\n", program, example_pathname, example_filename);
+	printf("example: %s -i 232421 -m 16 %s%s\n", program, example_pathname, example_filename);
+	printf("example: %s -b 600 timings.csv %s%s\n\n", program, example_pathname, example_filename);
 }
 
 static void get_filename(int argc, char **argv, char *filename)
@@ -348,6 +358,76 @@ static BlendFileData *load_game_data(const char *progname, char *filename = NULL
 	return bfd;
 }
 
+/* Run the game without window for the -b option, returns false on errors */
+static bool GPG_RunHeadless(int argc, char **argv, int argc_py_clamped, int frames, const char *outputname,
+                            const char *networkAddress, int networkPort, int networkLocalPort)
+{
+	char filename[FILE_MAX];
+	BlendFileData *bfd;
+	FILE *fp = stdout;
+	bool success;
+
+	get_filename(argc_py_clamped, argv, filename);
+	if (filename[0])
+		BLI_path_cwd(filename);
+
+	bfd = load_game_data(BLI_program_path(), filename[0]? filename: NULL);
+	if (!bfd) {
+		printf("error: couldn't load the game data.\n");
+		return false;
+	}
+
+	if (outputname) {
+		fp = BLI_fopen(outputname, "w");
+		if (!fp) {
+			printf("error: couldn't open %s for writing.\n", outputname);
+			BLO_blendfiledata_free(bfd);
+			return false;
+		}
+	}
+
+	Main *maggie = bfd->main;
+	Scene *scene = bfd->curscene;
+	G.main = maggie;
+	G.fileflags = bfd->fileflags;
+
+	GlobalSettings gs;
+	gs.matmode = scene->gm.matmode;
+	gs.glslflag = scene->gm.flag;
+
+	//Seg Fault; icon.c gIcons == 0
+	BKE_icons_init(1);
+
+	// app must go out of scope before the blend file data is freed
+	{
+		GPG_Application app(NULL);
+
+		app.SetGameEngineData(maggie, scene, &gs, argc, argv);
+		if (networkAddress)
+			app.SetNetworkPeer(networkAddress, networkPort, networkLocalPort);
+#ifdef WITH_PYTHON
+		setGamePythonPath(G.main->name);
+#endif
+		success = app.startHeadless();
+		if (success)
+			app.runHeadless(frames, fp);
+		else
+			printf("error: couldn't start the game engine.\n");
+		app.StopGameEngine();
+	}
+
+	BKE_icons_free();
+
+	if (fp != stdout)
+		fclose(fp);
+
+	BLO_blendfiledata_free(bfd);
+	/* G.main == bfd->main, it gets referenced in free_nodesystem so we can't have a dangling pointer */
+	G.main = NULL;
+
+	return success;
+}
+
 static bool GPG_NextFrame(GHOST_ISystem* system, GPG_Application *app, int &exitcode, STR_String &exitstring, GlobalSettings *gs)
 {
 	bool run = true;
@@ -416,6 +496,11 @@ int main(int argc, char** argv)
 	int validArguments=0;
 	bool samplesParFound = false;
 	GHOST_TUns16 aasamples = 0;
+	int headlessFrames = 0;
+	const char *headlessOutput = NULL;
+	const char *networkAddress = NULL;
+	int networkPort = 0;
+	int networkLocalPort = 0;
 	
 #ifdef __linux__
 #ifdef __alpha__
@@ -636,6 +721,34 @@ int main(int argc, char** argv)
 					printf("error: No argument supplied for -m");
 				}
 				break;
+			case 'b':
+				i++;
+				if ((i + 1) <= validArguments && argv[i][0] != '-')
+				{
+					headlessFrames = atoi(argv[i++]);
+					if ((i + 1) <= validArguments && argv[i][0] != '-')
+						headlessOutput = argv[i++];
+				}
+				if (headlessFrames <= 0)
+				{
+					error = true;
+					printf("error: No number of frames supplied for -b\n");
+				}
+				break;
+			case 'n':
+				i++;
+				if ((i + 3) <= validArguments)
+				{
+					networkAddress = argv[i++];
+					networkPort = atoi(argv[i++]);
+					networkLocalPort = atoi(argv[i++]);
+				}
+				if (networkPort <= 0 || networkPort > 65535 || networkLocalPort <= 0 || networkLocalPort > 65535)
+				{
+					error = true;
+					printf("error: -n requires an address, a port and a local port\n");
+				}
+				break;
 			case 'c':
 				i++;
 #ifdef WIN32
@@ -765,8 +878,13 @@ int main(int argc, char** argv)
 		GPU_set_anisotropic(U.anisotropic_filter);
 		GPU_set_gpu_mipmapping(U.use_gpu_mipmap);
 		
+		if (headlessFrames > 0) {
+			// Run without GHOST system, headless machines may have no display at all
+			error = !GPG_RunHeadless(argc, argv, argc_py_clamped, headlessFrames, headlessOutput,
+			                         networkAddress, networkPort, networkLocalPort);
+		}
 		// Create the system
-		if (GHOST_ISystem::createSystem() == GHOST_kSuccess) {
+		else if (GHOST_ISystem::createSystem() == GHOST_kSuccess) {
 			GHOST_ISystem* system = GHOST_ISystem::getSystem();
 			assertd(system);
 			
@@ -913,6 +1031,8 @@ int main(int argc, char** argv)
 						
 						//					GPG_Application app (system, maggie, startscenename);
 						app.SetGameEngineData(maggie, scene, &gs, argc, argv); /* this argc cant be argc_py_clamped, since python uses it */
+						if (networkAddress)
+							app.SetNetworkPeer(networkAddress, networkPort, networkLocalPort);
 						BLI_strncpy(pathname, maggie->name, sizeof(pathname));
 						if (G.main != maggie) {
 							BLI_strncpy(G.main->name, maggie->name, sizeof(G.main->name));
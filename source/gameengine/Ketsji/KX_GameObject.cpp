@@ -69,8 +69,12 @@ typedef unsigned long uint_ptr;
 #include "SCA_IController.h"
 #include "NG_NetworkScene.h" //Needed for sendMessage()
 #include "KX_ObstacleSimulation.h"
+#include "IntValue.h"
+#include "FloatValue.h"
+#include "BoolValue.h"
 
 #include "BKE_object.h"
+#include "DNA_object_types.h"
 
 #include "BL_ActionManager.h"
 #include "BL_Action.h"
@@ -112,6 +116,7 @@ KX_GameObject::KX_GameObject(
       m_pObstacleSimulation(NULL),
       m_pInstanceObjects(NULL),
       m_pDupliGroupObject(NULL),
+      m_pReplicaTemplate(NULL),
       m_actionManager(NULL),
       m_bRecordAnimation(false),
       m_isDeformable(false)
@@ -501,6 +506,7 @@ void KX_GameObject::ProcessReplica()
 	m_pClient_info = new KX_ClientObjectInfo(*m_pClient_info);
 	m_pClient_info->m_gameobject = this;
 	m_actionManager = NULL;
+	m_pReplicaTemplate = NULL;
 	m_state = 0;
 
 	KX_Scene* scene = KX_GetActiveScene();
@@ -518,6 +524,136 @@ void KX_GameObject::ProcessReplica()
 		
 }
 
+/* Reset a property of a recycled replica without reallocating it, only done
+ * for the number types that SetValue() supports. */
+static bool reset_replica_property(CValue* prop, CValue* orgprop)
+{
+	if (!((dynamic_cast<CIntValue*>(prop) && dynamic_cast<CIntValue*>(orgprop)) ||
+	      (dynamic_cast<CFloatValue*>(prop) && dynamic_cast<CFloatValue*>(orgprop)) ||
+	      (dynamic_cast<CBoolValue*>(prop) && dynamic_cast<CBoolValue*>(orgprop))))
+		return false;
+	// timers are float properties with a 'timer' property
+	if ((prop->GetProperty("timer") == NULL) != (orgprop->GetProperty("timer") == NULL))
+		return false;
+
+	prop->SetValue(orgprop);
+	return true;
+}
+
+void KX_GameObject::SuspendReplica()
+{
+#ifdef WITH_PYTHON
+	if (m_attr_dict) {
+		PyDict_Clear(m_attr_dict);
+		Py_CLEAR(m_attr_dict);
+	}
+	if (m_collisionCallbacks) {
+		UnregisterCollisionCallbacks();
+		Py_CLEAR(m_collisionCallbacks);
+	}
+#endif // WITH_PYTHON
+
+	// scripts can't use the object anymore, it gets a new proxy when it is reused
+	InvalidateProxy();
+
+	// same order as the destructor, physics before logic
+	if (m_pGraphicController)
+		m_pGraphicController->Activate(false);
+
+	if (m_pPhysicsController) {
+		PHY_IPhysicsController* orgctrl = (m_pReplicaTemplate) ? m_pReplicaTemplate->GetPhysicsController() : NULL;
+		Object* blenderobj = GetBlenderObject();
+
+		// the controllers of plain static and rigid bodies are taken out of the
+		// world and kept, the other types hold more state and are replicated again
+		if (orgctrl && blenderobj && !m_pPhysicsController->IsCompound() &&
+		    (blenderobj->gameflag & OB_COLLISION) &&
+		    !(blenderobj->gameflag & (OB_CHARACTER | OB_SENSOR | OB_SOFT_BODY)))
+		{
+			// bring back the settings scripts can change to those of the template
+			m_pPhysicsController->RestoreDynamics();
+			if (m_pPhysicsController->GetMass() != orgctrl->GetMass())
+				m_pPhysicsController->SetMass(orgctrl->GetMass());
+			if (m_pPhysicsController->GetMargin() != orgctrl->GetMargin())
+				m_pPhysicsController->SetMargin(orgctrl->GetMargin());
+			m_pPhysicsController->SetLinVelocityMin(orgctrl->GetLinVelocityMin());
+			m_pPhysicsController->SetLinVelocityMax(orgctrl->GetLinVelocityMax());
+			m_pPhysicsController->SetActive(false);
+		}
+		else {
+			delete m_pPhysicsController;
+			m_pPhysicsController = NULL;
+		}
+	}
+
+	if (m_actionManager) {
+		delete m_actionManager;
+		m_actionManager = NULL;
+	}
+
+	ClearLogic();
+
+	// the touch sensors of the object were deleted, the client info is kept
+	m_pClient_info->m_sensors.clear();
+
+	// the lifespan is set again when the replica is reused
+	RemoveProperty("::timebomb");
+
+	m_pHitObject = NULL;
+	m_pReplicaTemplate = NULL;
+}
+
+void KX_GameObject::ResetReplica(KX_GameObject* orgobj)
+{
+	// the members that GetReplica() copies from orgobj, the meshes were
+	// removed by KX_Scene::NewRemoveObject()
+	m_bDyna = orgobj->m_bDyna;
+	m_layer = orgobj->m_layer;
+	m_meshes = orgobj->m_meshes;
+	m_bSuspendDynamics = orgobj->m_bSuspendDynamics;
+	m_bUseObjectColor = orgobj->m_bUseObjectColor;
+	m_bIsNegativeScaling = orgobj->m_bIsNegativeScaling;
+	m_objectColor = orgobj->m_objectColor;
+	m_userCollisionGroup = orgobj->m_userCollisionGroup;
+	m_userCollisionMask = orgobj->m_userCollisionMask;
+	m_bVisible = orgobj->m_bVisible;
+	m_bCulled = orgobj->m_bCulled;
+	m_bOccluder = orgobj->m_bOccluder;
+	m_testPropName = orgobj->m_testPropName;
+	m_xray = orgobj->m_xray;
+	m_bRecordAnimation = orgobj->m_bRecordAnimation;
+
+	SetLogicTemplate(orgobj);
+
+	// properties are reset in place when possible, scripts can add or
+	// replace properties so anything else is replicated again
+	vector<STR_String> names = orgobj->GetPropertyNames();
+	vector<STR_String>::iterator it;
+	bool sameprops = ((size_t)GetPropertyCount() == names.size());
+
+	for (it = names.begin(); sameprops && it != names.end(); ++it)
+		sameprops = (GetProperty(*it) != NULL);
+	if (!sameprops)
+		ClearProperties();
+
+	for (it = names.begin(); it != names.end(); ++it)
+	{
+		CValue* orgprop = orgobj->GetProperty(*it);
+		CValue* prop = GetProperty(*it);
+
+		if (!prop || !reset_replica_property(prop, orgprop)) {
+			CValue* replica = orgprop->GetReplica();
+			SetProperty(*it, replica);
+			replica->Release();
+		}
+	}
+
+#ifdef WITH_PYTHON
+	if (orgobj->m_attr_dict)
+		m_attr_dict = PyDict_Copy(orgobj->m_attr_dict);
+#endif
+}
+
 static void setGraphicController_recursive(SG_Node* node)
 {
 	NodeList& children = node->GetSGChildren();
@@ -122,6 +122,9 @@ protected:
 	CListValue*							m_pInstanceObjects;
 	KX_GameObject*						m_pDupliGroupObject;
 
+	// Object this replica was added from by KX_Scene::AddReplicaObject(), used to recycle it
+	KX_GameObject*						m_pReplicaTemplate;
+
 	// The action manager is used to play/stop/update actions
 	BL_ActionManager*					m_actionManager;
 
@@ -394,6 +397,42 @@ public:
 	virtual	void
 	ProcessReplica();
 
+	/**
+	 * Release the data owned by an ended replica before it is kept in the
+	 * replica pool of the scene: logic bricks, actions and Python data, the
+	 * proxy is invalidated. The scenegraph node and the graphic controller
+	 * are kept, the graphic controller is deactivated. The physics controller
+	 * of a static or rigid body is removed from the physics world and kept,
+	 * other physics controllers are deleted.
+	 */
+		void
+	SuspendReplica(
+	);
+
+	/**
+	 * Bring a pooled replica of orgobj back to the state of a new replica
+	 * returned by orgobj->GetReplica(). The logic bricks are those of orgobj
+	 * until ReParentLogic() is called, the physics controller is not
+	 * touched.
+	 */
+		void
+	ResetReplica(
+		KX_GameObject* orgobj
+	);
+
+		KX_GameObject*
+	GetReplicaTemplate(
+	) {
+		return m_pReplicaTemplate;
+	}
+
+		void
+	SetReplicaTemplate(
+		KX_GameObject* orgobj
+	) {
+		m_pReplicaTemplate = orgobj;
+	}
+
 	/** 
 	 * Return the linear velocity of the game object.
 	 */
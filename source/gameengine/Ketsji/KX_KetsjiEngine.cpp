@@ -93,6 +93,7 @@ const char KX_KetsjiEngine::m_profileLabels[tc_numCategories][15] = {
 	"Physics:",		// tc_physics
 	"Logic:",		// tc_logic
 	"Animations:",	// tc_animations
+	"Skinning:",	// tc_skinning
 	"Network:",		// tc_network
 	"Scenegraph:",	// tc_scenegraph
 	"Rasterizer:",	// tc_rasterizer
@@ -809,6 +810,18 @@ bool KX_KetsjiEngine::NextFrame()
 		}
 	}
 	
+	// Evaluate the poses and skin the meshes before rendering
+	if (doRender)
+	{
+		m_logger->StartLog(tc_skinning, m_kxsystem->GetTimeInSeconds(), true);
+		SG_SetActiveStage(SG_STAGE_ANIMATION_UPDATE);
+		for (sceneit = m_scenes.begin();sceneit != m_scenes.end(); ++sceneit)
+		{
+			if (!(*sceneit)->IsSuspended())
+				(*sceneit)->UpdateSkinDeformers();
+		}
+	}
+
 	// Start logging time spend outside main loop
 	m_logger->StartLog(tc_outside, m_kxsystem->GetTimeInSeconds(), true);
 	
@@ -1934,6 +1947,30 @@ void KX_KetsjiEngine::GetTimingDisplay(bool& frameRate, bool& profile, bool& pro
 
 
 
+int KX_KetsjiEngine::GetNumProfileCategories()
+{
+	return tc_numCategories;
+}
+
+
+
+const char *KX_KetsjiEngine::GetProfileLabel(int category)
+{
+	return m_profileLabels[category];
+}
+
+
+
+void KX_KetsjiEngine::NextProfileMeasurement(double *times)
+{
+	m_logger->NextMeasurement(m_kxsystem->GetTimeInSeconds());
+
+	for (int i = tc_first; i < tc_numCategories; i++)
+		times[i] = m_logger->GetLast((KX_TimeCategory)i);
+}
+
+
+
 void KX_KetsjiEngine::ProcessScheduledScenes(void)
 {
 	// Check whether there will be changes to the list of scenes
@@ -154,6 +154,7 @@ private:
 		tc_physics = 0,
 		tc_logic,
 		tc_animations,
+		tc_skinning,	// pose evaluation and skin deformation
 		tc_network,
 		tc_scenegraph,
 		tc_rasterizer,
@@ -371,6 +372,20 @@ public:
 	 */ 
 	void GetTimingDisplay(bool& frameRate, bool& profile, bool& properties) const;
 
+	/**
+	 * Number of profiling categories and their labels, as in the profile display.
+	 */
+	static int GetNumProfileCategories();
+	static const char *GetProfileLabel(int category);
+
+	/**
+	 * Ends the current profiling measurement when frames are not rendered,
+	 * EndFrame() does it otherwise.
+	 * \param times Receives the time spent in each profiling category during the
+	 *              measurement, in seconds, GetNumProfileCategories() values.
+	 */
+	void NextProfileMeasurement(double *times);
+
 	/** 
 	 * Sets cursor hiding on every frame.
 	 * \param hideCursor Turns hiding on or off.
@@ -74,6 +74,7 @@
 #include "SG_IObject.h"
 #include "SG_Tree.h"
 #include "DNA_group_types.h"
+#include "DNA_object_types.h"
 #include "DNA_scene_types.h"
 #include "DNA_property_types.h"
 
@@ -100,7 +101,10 @@
 
 #include "KX_Light.h"
 
+#include "BLI_task.h"
+
 #include <stdio.h>
+#include <map>
 
 static void *KX_SceneReplicationFunc(SG_IObject* node,void* gameobj,void* scene)
 {
@@ -239,6 +243,18 @@ KX_Scene::KX_Scene(class SCA_IInputDevice* keyboarddevice,
 
 
 
+static void FreeReplicaPool(std::vector<KX_GameObject*>& pool)
+{
+	for (std::vector<KX_GameObject*>::iterator it = pool.begin(); it != pool.end(); ++it)
+	{
+		// the object was already removed from the scene, only the node is left
+		SG_Node* node = (*it)->GetSGNode();
+		(*it)->Release();
+		delete node;
+	}
+	pool.clear();
+}
+
 KX_Scene::~KX_Scene()
 {
 	// The release of debug properties used to be in SCA_IScene::~SCA_IScene
@@ -246,6 +262,11 @@ KX_Scene::~KX_Scene()
 	// reference might be hanging and causing late release of objects
 	RemoveAllDebugProperties();
 
+	std::map<KX_GameObject*, std::vector<KX_GameObject*> >::iterator pit;
+	for (pit = m_replicaPool.begin(); pit != m_replicaPool.end(); ++pit)
+		FreeReplicaPool(pit->second);
+	m_replicaPool.clear();
+
 	while (GetRootParentList()->GetCount() > 0) 
 	{
 		KX_GameObject* parentobj = (KX_GameObject*) GetRootParentList()->GetValue(0);
@@ -455,6 +476,75 @@ void KX_Scene::AddObjectDebugProperties(class KX_GameObject* gameobj)
 		AddDebugProperty(gameobj,STR_String("__state__"));
 }
 
+/* Detach an object that is still referenced after its removal from the
+ * node that is about to be deleted. */
+static void ReleaseZombieObject(KX_GameObject* gameobj)
+{
+	printf("Zombie object! name=%s\n", gameobj->GetName().ReadPtr());
+	gameobj->SetSGNode(NULL);
+	PHY_IGraphicController* ctrl = gameobj->GetGraphicController();
+	if (ctrl)
+	{
+		// a graphic controller is set, we must delete it as the node will be deleted
+		delete ctrl;
+		gameobj->SetGraphicController(NULL);
+	}
+}
+
+static void RegisterTimeProperties(SCA_TimeEventManager* timemgr, KX_GameObject* gameobj)
+{
+	int numprops = gameobj->GetPropertyCount();
+
+	for (int i = 0; i < numprops; i++)
+	{
+		CValue* prop = gameobj->GetProperty(i);
+
+		if (prop->GetProperty("timer"))
+			timemgr->AddTimeProperty(prop);
+	}
+}
+
+static void ReplicateSGControllers(KX_GameObject* orgobj, SG_IObject* replicanode)
+{
+	SGControllerList	scenegraphcontrollers = orgobj->GetSGNode()->GetSGControllerList();
+	SGControllerList::iterator cit;
+	
+	for (cit = scenegraphcontrollers.begin();!(cit==scenegraphcontrollers.end());++cit)
+	{
+		// controller replication is quite complicated
+		// only replicate ipo controller for now
+
+		SG_Controller* replicacontroller = (*cit)->GetReplica((SG_Node*) replicanode);
+		if (replicacontroller)
+		{
+			replicacontroller->SetObject(replicanode);
+			replicanode->AddSGController(replicacontroller);
+		}
+	}
+}
+
+static void ReplicatePhysicsController(KX_GameObject* orgobj, KX_GameObject* newobj)
+{
+#ifdef WITH_BULLET
+	// replicate physics controller
+	if (orgobj->GetPhysicsController())
+	{
+		PHY_IMotionState* motionstate = new KX_MotionState(newobj->GetSGNode());
+		PHY_IPhysicsController* newctrl = orgobj->GetPhysicsController()->GetReplica();
+
+		KX_GameObject *parent = newobj->GetParent();
+		PHY_IPhysicsController* parentctrl = (parent) ? parent->GetPhysicsController() : NULL;
+
+		newctrl->SetNewClientInfo(newobj->getClientInfo());
+		newobj->SetPhysicsController(newctrl, newobj->IsDynamic());
+		newctrl->PostProcessReplica(motionstate, parentctrl);
+
+		if (parent)
+			parent->Release();
+	}
+#endif
+}
+
 void KX_Scene::RemoveNodeDestructObject(class SG_IObject* node,class CValue* gameobj)
 {
 	KX_GameObject* orgobj = (KX_GameObject*)gameobj;
@@ -464,15 +554,7 @@ void KX_Scene::RemoveNodeDestructObject(class SG_IObject* node,class CValue* gam
 		// This should not happen anymore since we use proxy object for Python
 		// confident enough to put an assert?
 		//assert(false);
-		printf("Zombie object! name=%s\n", orgobj->GetName().ReadPtr());
-		orgobj->SetSGNode(NULL);
-		PHY_IGraphicController* ctrl = orgobj->GetGraphicController();
-		if (ctrl)
-		{
-			// a graphic controller is set, we must delete it as the node will be deleted
-			delete ctrl;
-			orgobj->SetGraphicController(NULL);
-		}
+		ReleaseZombieObject(orgobj);
 	}
 	if (node)
 		delete node;
@@ -490,15 +572,7 @@ KX_GameObject* KX_Scene::AddNodeReplicaObject(class SG_IObject* node, class CVal
 	m_map_gameobject_to_replica.insert(orgobj, newobj);
 
 	// also register 'timers' (time properties) of the replica
-	int numprops = newobj->GetPropertyCount();
-
-	for (int i = 0; i < numprops; i++)
-	{
-		CValue* prop = newobj->GetProperty(i);
-
-		if (prop->GetProperty("timer"))
-			this->m_timemgr->AddTimeProperty(prop);
-	}
+	RegisterTimeProperties(m_timemgr, newobj);
 
 	if (node)
 	{
@@ -536,23 +610,8 @@ KX_GameObject* KX_Scene::AddNodeReplicaObject(class SG_IObject* node, class CVal
 	// logic cannot be replicated, until the whole hierarchy is replicated.
 	m_logicHierarchicalGameObjects.push_back(newobj);
 	//replicate controllers of this node
-	SGControllerList	scenegraphcontrollers = orgobj->GetSGNode()->GetSGControllerList();
 	replicanode->RemoveAllControllers();
-	SGControllerList::iterator cit;
-	//int numcont = scenegraphcontrollers.size();
-	
-	for (cit = scenegraphcontrollers.begin();!(cit==scenegraphcontrollers.end());++cit)
-	{
-		// controller replication is quite complicated
-		// only replicate ipo controller for now
-
-		SG_Controller* replicacontroller = (*cit)->GetReplica((SG_Node*) replicanode);
-		if (replicacontroller)
-		{
-			replicacontroller->SetObject(replicanode);
-			replicanode->AddSGController(replicacontroller);
-		}
-	}
+	ReplicateSGControllers(orgobj, replicanode);
 	// replicate graphic controller
 	if (orgobj->GetGraphicController())
 	{
@@ -562,28 +621,124 @@ KX_GameObject* KX_Scene::AddNodeReplicaObject(class SG_IObject* node, class CVal
 		newobj->SetGraphicController(newctrl);
 	}
 
-#ifdef WITH_BULLET
-	// replicate physics controller
-	if (orgobj->GetPhysicsController())
-	{
-		PHY_IMotionState* motionstate = new KX_MotionState(newobj->GetSGNode());
-		PHY_IPhysicsController* newctrl = orgobj->GetPhysicsController()->GetReplica();
+	ReplicatePhysicsController(orgobj, newobj);
 
-		KX_GameObject *parent = newobj->GetParent();
-		PHY_IPhysicsController* parentctrl = (parent) ? parent->GetPhysicsController() : NULL;
+	return newobj;
+}
 
-		newctrl->SetNewClientInfo(newobj->getClientInfo());
-		newobj->SetPhysicsController(newctrl, newobj->IsDynamic());
-		newctrl->PostProcessReplica(motionstate, parentctrl);
+KX_GameObject* KX_Scene::AddPooledReplicaObject(KX_GameObject* orgobj)
+{
+	std::vector<KX_GameObject*>& pool = m_replicaPool[orgobj];
+	if (pool.empty())
+		return NULL;
 
-		if (parent)
-			parent->Release();
+	KX_GameObject* newobj = pool.back();
+	pool.pop_back();
+
+	// the reference of the pool is passed to the caller, like a new replica
+	newobj->ResetReplica(orgobj);
+	m_map_gameobject_to_replica.insert(orgobj, newobj);
+	RegisterTimeProperties(m_timemgr, newobj);
+
+	// the node was kept with the object, reset it like a new root node
+	m_rootnode = newobj->GetSGNode();
+	SG_Node* orgnode = orgobj->GetSGNode();
+	// through the game object so a kept physics controller gets the scale too
+	newobj->NodeSetLocalScale(orgnode->GetLocalScale());
+	m_rootnode->SetLocalPosition(orgnode->GetLocalPosition());
+	m_rootnode->SetLocalOrientation(orgnode->GetLocalOrientation());
+
+	m_objectlist->Add(newobj->AddRef());
+	newobj->AddMeshUser();
+
+	m_logicHierarchicalGameObjects.push_back(newobj);
+
+	// scenegraph controllers hold animation state, start again from those of orgobj
+	SGControllerList& oldcontrollers = m_rootnode->GetSGControllerList();
+	for (SGControllerList::iterator cit = oldcontrollers.begin(); cit != oldcontrollers.end(); ++cit)
+		delete (*cit);
+	m_rootnode->RemoveAllControllers();
+	ReplicateSGControllers(orgobj, m_rootnode);
+
+	// the graphic controller was kept, it is activated again by AddReplicaObject()
+
+#ifdef WITH_BULLET
+	// a kept physics controller is put back in the world at the reset position
+	// with the collision filter of orgobj, see KX_GameObject::SuspendReplica()
+	CcdPhysicsController* ctrl = (CcdPhysicsController*)newobj->GetPhysicsController();
+	CcdPhysicsController* orgctrl = (CcdPhysicsController*)orgobj->GetPhysicsController();
+	if (ctrl && orgctrl)
+	{
+		ctrl->GetConstructionInfo().m_collisionFilterGroup = orgctrl->GetCollisionFilterGroup();
+		ctrl->GetConstructionInfo().m_collisionFilterMask = orgctrl->GetCollisionFilterMask();
+		m_rootnode->UpdateWorldData(0);
+		ctrl->SetActive(true);
+		return newobj;
 	}
 #endif
 
+	ReplicatePhysicsController(orgobj, newobj);
+
 	return newobj;
 }
 
+bool KX_Scene::RecycleReplicaObject(KX_GameObject* gameobj)
+{
+	KX_GameObject* orgobj = gameobj->GetReplicaTemplate();
+	if (!orgobj)
+		return false;
+
+	// no entry when orgobj was removed since the replica was added
+	std::map<KX_GameObject*, std::vector<KX_GameObject*> >::iterator pit = m_replicaPool.find(orgobj);
+	if (pit == m_replicaPool.end())
+		return false;
+
+	// only plain objects without hierarchy are recycled, the objects with
+	// more per instance data are deleted as usual
+	SG_Node* node = gameobj->GetSGNode();
+	Object* blenderobj = gameobj->GetBlenderObject();
+
+	if (!node || node->GetSGParent() || !node->GetSGChildren().empty() ||
+	    gameobj->GetType() != &KX_GameObject::Type ||
+	    gameobj->GetDeformer() ||
+	    gameobj->IsDupliGroup() ||
+	    gameobj->GetInstanceObjects() ||
+	    gameobj->GetDupliGroupObject() ||
+	    blenderobj != orgobj->GetBlenderObject() ||
+	    (blenderobj && (blenderobj->gameflag & OB_HASOBSTACLE)) ||
+	    gameobj->GetMeshCount() != orgobj->GetMeshCount())
+	{
+		return false;
+	}
+
+	// the meshes are reset to those of orgobj, they must not have been replaced
+	for (int i = 0; i < gameobj->GetMeshCount(); i++) {
+		if (gameobj->GetMesh(i) != orgobj->GetMesh(i))
+			return false;
+	}
+
+	// the pool keeps a reference
+	gameobj->AddRef();
+
+	if (NewRemoveObject(gameobj) != 1)
+	{
+		// a reference is hanging somewhere, finish the removal as RemoveObject() does
+		ReleaseZombieObject(gameobj);
+		gameobj->Release();
+		delete node;
+		return true;
+	}
+
+	// the node must not be updated while the object is in the pool
+	node->QDelink();
+	node->Delink();
+
+	gameobj->SuspendReplica();
+	pit->second.push_back(gameobj);
+
+	return true;
+}
+
 
 
 // before calling this method KX_Scene::ReplicateLogic(), make sure to
@@ -878,8 +1033,11 @@ SCA_IObject* KX_Scene::AddReplicaObject(class CValue* originalobject,
 
 	m_ueberExecutionPriority++;
 
-	// lets create a replica
-	KX_GameObject* replica = (KX_GameObject*) AddNodeReplicaObject(NULL,originalobj);
+	// lets create a replica, or reuse an ended one
+	KX_GameObject* replica = AddPooledReplicaObject(originalobj);
+	if (!replica)
+		replica = (KX_GameObject*) AddNodeReplicaObject(NULL,originalobj);
+	replica->SetReplicaTemplate(originalobj);
 
 	if (lifespan > 0)
 	{
@@ -1066,6 +1224,22 @@ int KX_Scene::NewRemoveObject(class CValue* gameobj)
 		}
 	}
 
+	// the ended replicas of this object can't be reused anymore
+	std::map<KX_GameObject*, std::vector<KX_GameObject*> >::iterator pit = m_replicaPool.find(newobj);
+	if (pit != m_replicaPool.end())
+	{
+		FreeReplicaPool(pit->second);
+		m_replicaPool.erase(pit);
+
+		// nor the ones still in the scene, they must not refer to the removed object
+		for (int i = 0; i < m_objectlist->GetCount(); i++)
+		{
+			KX_GameObject* replica = (KX_GameObject*)m_objectlist->GetValue(i);
+			if (replica->GetReplicaTemplate() == newobj)
+				replica->SetReplicaTemplate(NULL);
+		}
+	}
+
 	// if the object is the dupligroup proxy, you have to cleanup all m_pDupliGroupObject's in all
 	// instances refering to this group
 	if (newobj->GetInstanceObjects()) {
@@ -1644,6 +1818,78 @@ void KX_Scene::UpdateAnimations(double curtime)
 	}
 }
 
+/* deformers whose armatures share a Blender object, prepared in order by a single task */
+typedef std::vector<BL_SkinDeformer *> SkinDeformerGroup;
+
+static void update_skin_deformers_task(TaskPool *UNUSED(pool), void *taskdata, int UNUSED(threadid))
+{
+	SkinDeformerGroup *group = (SkinDeformerGroup *)taskdata;
+
+	for (SkinDeformerGroup::iterator it = group->begin(); it != group->end(); ++it)
+		(*it)->PrepareUpdate();
+}
+
+void KX_Scene::UpdateSkinDeformers()
+{
+	// Replicas of an armature swap their pose into the same Blender object while evaluating it,
+	// and their meshes share the Blender mesh object, so the deformers are grouped by that object.
+	std::map<Object *, SkinDeformerGroup> groups;
+	std::map<Object *, Object *> mesh_armatures;
+
+	for (int i = 0; i < m_animatedlist->GetCount(); ++i) {
+		KX_GameObject *gameobj = (KX_GameObject *)m_animatedlist->GetValue(i);
+
+		if (gameobj->GetGameObjectType() != SCA_IObject::OBJ_ARMATURE)
+			continue;
+
+		// Constraints read (and for the controlled ones modify) other objects,
+		// such poses are left to be evaluated when rendering.
+		BL_ArmatureObject *armobj = (BL_ArmatureObject *)gameobj;
+		if (armobj->HasPoseConstraints())
+			continue;
+
+		Object *blendarma = armobj->GetArmatureObject();
+		CListValue *children = gameobj->GetChildren();
+
+		for (int j = 0; j < children->GetCount(); ++j) {
+			KX_GameObject *child = (KX_GameObject *)children->GetValue(j);
+			BL_SkinDeformer *deformer = dynamic_cast<BL_SkinDeformer *>(child->GetDeformer());
+
+			// Culled meshes are skinned on demand if they become visible
+			if (!deformer || child->GetCulled() || deformer->GetArmature() != armobj || !deformer->PoseUpdated())
+				continue;
+
+			// A mesh reparented to an armature of another group stays on the main thread
+			Object *blendmesh = deformer->GetBlenderObject();
+			std::map<Object *, Object *>::iterator mit = mesh_armatures.find(blendmesh);
+			if (mit == mesh_armatures.end())
+				mesh_armatures[blendmesh] = blendarma;
+			else if (mit->second != blendarma)
+				continue;
+
+			groups[blendarma].push_back(deformer);
+		}
+		children->Release();
+	}
+
+	if (groups.empty())
+		return;
+
+	if (groups.size() == 1) {
+		update_skin_deformers_task(NULL, &groups.begin()->second, 0);
+		return;
+	}
+
+	TaskScheduler *task_scheduler = BLI_task_scheduler_get();
+	TaskPool *task_pool = BLI_task_pool_create(task_scheduler, NULL);
+
+	for (std::map<Object *, SkinDeformerGroup>::iterator it = groups.begin(); it != groups.end(); ++it)
+		BLI_task_pool_push(task_pool, update_skin_deformers_task, &it->second, false, TASK_PRIORITY_LOW);
+
+	BLI_task_pool_work_and_wait(task_pool);
+	BLI_task_pool_free(task_pool);
+}
+
 void KX_Scene::LogicUpdateFrame(double curtime, bool frame)
 {
 	m_logicmgr->UpdateFrame(curtime, frame);
@@ -1664,7 +1910,8 @@ void KX_Scene::LogicEndFrame()
 		obj = (KX_GameObject*)m_euthanasyobjects->GetValue(numobj-1);
 		m_euthanasyobjects->Remove(numobj-1);
 		obj->Release();
-		RemoveObject(obj);
+		if (!RecycleReplicaObject(obj))
+			RemoveObject(obj);
 	}
 
 	//prepare obstacle simulation for new frame
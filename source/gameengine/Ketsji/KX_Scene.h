@@ -38,6 +38,7 @@
 #include <vector>
 #include <set>
 #include <list>
+#include <map>
 
 #include "CTR_Map.h"
 #include "CTR_HashedPtr.h"
@@ -226,6 +227,14 @@ protected:
 	 * means don't care.
 	 */
 	std::set<CValue*>	m_groupGameObjects;
+
+	/**
+	 * Ended replicas kept for reuse by AddReplicaObject(), indexed by
+	 * the object they were replicated from. An entry is created for
+	 * every object added with AddReplicaObject(), replicas of objects
+	 * without an entry are not recycled.
+	 */
+	std::map<KX_GameObject*, std::vector<KX_GameObject*> > m_replicaPool;
 	
 	/** 
 	 * Pointer to system variable passed in in constructor
@@ -329,6 +338,20 @@ public:
 	                              int lifespan=0);
 	KX_GameObject* AddNodeReplicaObject(SG_IObject* node,
 	                                    CValue* gameobj);
+	/**
+	 * Reuse an ended replica of gameobj kept in the replica pool,
+	 * returns NULL if there is none. Same as AddNodeReplicaObject()
+	 * for a top level object. The game object, its node, graphic and
+	 * rigid body controllers are reused, the logic bricks and
+	 * scenegraph controllers are still replicated from gameobj.
+	 */
+	KX_GameObject* AddPooledReplicaObject(KX_GameObject* gameobj);
+	/**
+	 * Remove an ended replica from the scene and keep it in the replica
+	 * pool, returns false if the object can't be recycled and must be
+	 * removed with RemoveObject().
+	 */
+	bool RecycleReplicaObject(KX_GameObject* gameobj);
 	void RemoveNodeDestructObject(SG_IObject* node,
 	                              CValue* gameobj);
 	void RemoveObject(CValue* gameobj);
@@ -347,6 +370,11 @@ public:
 	void LogicBeginFrame(double curtime);
 	void LogicUpdateFrame(double curtime, bool frame);
 	void UpdateAnimations(double curtime);
+	/**
+	 * Evaluate the poses of the animated armatures and skin their visible meshes ahead of
+	 * rendering, independent armatures are processed on multiple threads.
+	 */
+	void UpdateSkinDeformers();
 
 		void
 	LogicEndFrame(
@@ -131,6 +131,12 @@ double KX_TimeCategoryLogger::GetAverage(void)
 }
 
 
+double KX_TimeCategoryLogger::GetLast(TimeCategory tc)
+{
+	return m_loggers[tc]->GetLast();
+}
+
+
 void KX_TimeCategoryLogger::DisposeLoggers(void)
 {
 	KX_TimeLoggerMap::iterator it;
@@ -115,6 +115,11 @@ public:
 	 */
 	virtual double GetAverage(void);
 
+	/**
+	 * Returns the last complete measurement of a category.
+	 */
+	virtual double GetLast(TimeCategory tc);
+
 protected:
 	/**  
 	 * Disposes loggers.
@@ -115,3 +115,9 @@ double KX_TimeLogger::GetAverage(void) const
 	return avg;
 }
 
+
+double KX_TimeLogger::GetLast(void) const
+{
+	return (m_measurements.size() > 1) ? m_measurements[1] : 0.0;
+}
+
@@ -92,6 +92,12 @@ public:
 	 */
 	virtual double GetAverage(void) const;
 
+	/**
+	 * Returns the last complete measurement.
+	 * \return The measurement before the current one.
+	 */
+	virtual double GetLast(void) const;
+
 protected:
 	/** Storage for the measurements. */
 	std::deque<double> m_measurements;
@@ -0,0 +1,436 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ * UdpNetworkDeviceInterface derived from NG_NetworkDeviceInterface
+ */
+
+/** \file gameengine/Network/UdpNetwork/NG_UdpNetworkDeviceInterface.cpp
+ *  \ingroup bgenetudp
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef WIN32
+#  include <winsock2.h>
+#  include <ws2tcpip.h>
+#  define INVALID_SOCKET_ID ((long)INVALID_SOCKET)
+#else
+#  include <sys/types.h>
+#  include <sys/socket.h>
+#  include <netinet/in.h>
+#  include <netdb.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+#  include <errno.h>
+#  define INVALID_SOCKET_ID (-1L)
+#endif
+
+#include "NG_UdpNetworkDeviceInterface.h"
+#include "NG_NetworkMessage.h"
+
+using namespace std;
+
+/* Datagram layout, all numbers in network byte order:
+ *
+ *   magic        4 bytes "BGEN"
+ *   password     4 bytes, hash of the password
+ *   sequence     4 bytes, incremented for every datagram
+ *   count        2 bytes, number of messages
+ *   count times: destination, sender, subject and body, each as
+ *                2 bytes length followed by the characters
+ *
+ * Datagrams are filled up to NG_UDP_PACKET_SIZE so they are not fragmented
+ * on common networks, a message that doesn't fit is sent alone in a larger
+ * datagram. */
+#define NG_UDP_HEADER_SIZE		14
+#define NG_UDP_PACKET_SIZE		1400
+#define NG_UDP_MAX_PACKET_SIZE	65507
+
+/* datagrams at most this many sequence numbers older than the last one are
+ * late or duplicated, an older sequence means the peer was restarted */
+#define NG_UDP_SEQUENCE_WINDOW	64
+
+static const unsigned char ng_udp_magic[4] = {'B', 'G', 'E', 'N'};
+
+static void put_uint16(unsigned char *buf, unsigned int value)
+{
+	buf[0] = (value >> 8) & 0xff;
+	buf[1] = value & 0xff;
+}
+
+static void put_uint32(unsigned char *buf, unsigned int value)
+{
+	buf[0] = (value >> 24) & 0xff;
+	buf[1] = (value >> 16) & 0xff;
+	buf[2] = (value >> 8) & 0xff;
+	buf[3] = value & 0xff;
+}
+
+static unsigned int get_uint16(const unsigned char *buf)
+{
+	return (buf[0] << 8) | buf[1];
+}
+
+static unsigned int get_uint32(const unsigned char *buf)
+{
+	return ((unsigned int)buf[0] << 24) | (buf[1] << 16) | (buf[2] << 8) | buf[3];
+}
+
+/* FNV-1a */
+static unsigned int hash_password(const char *password)
+{
+	unsigned int hash = 2166136261u;
+
+	if (password) {
+		for (; *password; password++) {
+			hash ^= (unsigned char)*password;
+			hash *= 16777619u;
+		}
+	}
+	return hash;
+}
+
+static unsigned int message_size(NG_NetworkMessage *msg)
+{
+	return 8 +
+	       msg->GetDestinationName().Length() +
+	       msg->GetSenderName().Length() +
+	       msg->GetSubject().Length() +
+	       msg->GetMessageText().Length();
+}
+
+static unsigned char *write_string(unsigned char *buf, const STR_String& str)
+{
+	put_uint16(buf, str.Length());
+	memcpy(buf + 2, str.ReadPtr(), str.Length());
+	return buf + 2 + str.Length();
+}
+
+/* returns NULL if the string goes past end */
+static const unsigned char *read_string(const unsigned char *buf, const unsigned char *end, STR_String& str)
+{
+	unsigned int len;
+
+	if (end - buf < 2)
+		return NULL;
+	len = get_uint16(buf);
+	buf += 2;
+	if ((unsigned int)(end - buf) < len)
+		return NULL;
+	str = STR_String((const char *)buf, len);
+	return buf + len;
+}
+
+static void close_socket(long sock)
+{
+#ifdef WIN32
+	closesocket((SOCKET)sock);
+	WSACleanup();
+#else
+	close((int)sock);
+#endif
+}
+
+NG_UdpNetworkDeviceInterface::NG_UdpNetworkDeviceInterface()
+{
+	m_currentQueue = 0;
+	m_socket = INVALID_SOCKET_ID;
+	m_peerAddress = 0;
+	m_peerPort = 0;
+	m_passwordHash = 0;
+	m_sendSequence = 0;
+	m_receiveSequence = 0;
+	m_hasReceived = false;
+	m_lostPackets = 0;
+	m_buffer = new unsigned char[NG_UDP_MAX_PACKET_SIZE];
+	// messages are delivered locally even without peer, like with the loopback device
+	Online();
+}
+
+NG_UdpNetworkDeviceInterface::~NG_UdpNetworkDeviceInterface()
+{
+	Disconnect();
+
+	for (int i = 0; i < 2; i++) {
+		while (m_messages[i].size() > 0) {
+			m_messages[i][0]->Release();
+			m_messages[i].pop_front();
+		}
+	}
+
+	delete [] m_buffer;
+}
+
+bool NG_UdpNetworkDeviceInterface::Connect(char *address, unsigned int port, char *password,
+                                           unsigned int localport, unsigned int timeout)
+{
+	struct addrinfo hints, *res;
+	struct sockaddr_in local;
+	long sock;
+
+	Disconnect();
+
+#ifdef WIN32
+	WSADATA wsadata;
+	if (WSAStartup(MAKEWORD(2, 2), &wsadata) != 0)
+		return false;
+#endif
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_DGRAM;
+	if (getaddrinfo(address, NULL, &hints, &res) != 0 || !res) {
+		printf("Network: can't resolve address %s\n", address);
+#ifdef WIN32
+		WSACleanup();
+#endif
+		return false;
+	}
+	m_peerAddress = ((struct sockaddr_in *)res->ai_addr)->sin_addr.s_addr;
+	m_peerPort = htons((unsigned short)port);
+	freeaddrinfo(res);
+
+	sock = (long)socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (sock == INVALID_SOCKET_ID) {
+#ifdef WIN32
+		WSACleanup();
+#endif
+		return false;
+	}
+
+	memset(&local, 0, sizeof(local));
+	local.sin_family = AF_INET;
+	local.sin_addr.s_addr = htonl(INADDR_ANY);
+	local.sin_port = htons((unsigned short)localport);
+
+	bool ok = (bind(sock, (struct sockaddr *)&local, sizeof(local)) == 0);
+	if (ok) {
+		// never wait for the network in the game loop
+#ifdef WIN32
+		u_long nonblocking = 1;
+		ok = (ioctlsocket((SOCKET)sock, FIONBIO, &nonblocking) == 0);
+#else
+		int flags = fcntl(sock, F_GETFL, 0);
+		ok = (flags != -1 && fcntl(sock, F_SETFL, flags | O_NONBLOCK) != -1);
+#endif
+	}
+	if (!ok) {
+		printf("Network: can't use local port %u\n", localport);
+		close_socket(sock);
+		return false;
+	}
+
+	m_socket = sock;
+	m_passwordHash = hash_password(password);
+	m_sendSequence = 0;
+	m_receiveSequence = 0;
+	m_hasReceived = false;
+	m_lostPackets = 0;
+	return true;
+}
+
+bool NG_UdpNetworkDeviceInterface::Disconnect(void)
+{
+	for (vector<NG_NetworkMessage*>::iterator it = m_outgoing.begin(); it != m_outgoing.end(); ++it)
+		(*it)->Release();
+	m_outgoing.clear();
+
+	if (m_socket != INVALID_SOCKET_ID) {
+		close_socket(m_socket);
+		m_socket = INVALID_SOCKET_ID;
+	}
+	return true;
+}
+
+void NG_UdpNetworkDeviceInterface::NextFrame()
+{
+	// Release reference to the messages while emptying the queue
+	while (m_messages[m_currentQueue].size() > 0) {
+		m_messages[m_currentQueue][0]->Release();
+		m_messages[m_currentQueue].pop_front();
+	}
+
+	m_currentQueue = 1 - m_currentQueue;
+
+	if (m_socket != INVALID_SOCKET_ID) {
+		SendOutgoingMessages();
+		// the received messages are delivered with the local ones of the last frame
+		ReceiveMessages();
+	}
+}
+
+void NG_UdpNetworkDeviceInterface::SendNetworkMessage(NG_NetworkMessage* nwmsg)
+{
+	int backqueue = 1 - m_currentQueue;
+
+	nwmsg->AddRef();
+	m_messages[backqueue].push_back(nwmsg);
+
+	if (m_socket != INVALID_SOCKET_ID) {
+		nwmsg->AddRef();
+		m_outgoing.push_back(nwmsg);
+	}
+}
+
+vector<NG_NetworkMessage*> NG_UdpNetworkDeviceInterface::RetrieveNetworkMessages()
+{
+	// We don't increase the reference count for these messages, like the loopback device
+	return vector<NG_NetworkMessage*>(m_messages[m_currentQueue].begin(), m_messages[m_currentQueue].end());
+}
+
+void NG_UdpNetworkDeviceInterface::SendPacket(unsigned int size, unsigned int count)
+{
+	struct sockaddr_in peer;
+
+	memcpy(m_buffer, ng_udp_magic, 4);
+	put_uint32(m_buffer + 4, m_passwordHash);
+	put_uint32(m_buffer + 8, m_sendSequence++);
+	put_uint16(m_buffer + 12, count);
+
+	memset(&peer, 0, sizeof(peer));
+	peer.sin_family = AF_INET;
+	peer.sin_addr.s_addr = m_peerAddress;
+	peer.sin_port = m_peerPort;
+
+	// a full send buffer drops the datagram, like the network would
+	sendto(m_socket, (const char *)m_buffer, size, 0, (struct sockaddr *)&peer, sizeof(peer));
+}
+
+void NG_UdpNetworkDeviceInterface::SendOutgoingMessages()
+{
+	unsigned int size = NG_UDP_HEADER_SIZE, count = 0;
+
+	for (vector<NG_NetworkMessage*>::iterator it = m_outgoing.begin(); it != m_outgoing.end(); ++it)
+	{
+		NG_NetworkMessage *msg = *it;
+		unsigned int msgsize = message_size(msg);
+
+		if (msg->GetDestinationName().Length() > 0xffff || msg->GetSenderName().Length() > 0xffff ||
+		    msg->GetSubject().Length() > 0xffff || msg->GetMessageText().Length() > 0xffff ||
+		    NG_UDP_HEADER_SIZE + msgsize > NG_UDP_MAX_PACKET_SIZE)
+		{
+			printf("Network: message '%s' is too large to be sent\n", msg->GetSubject().ReadPtr());
+			msg->Release();
+			continue;
+		}
+
+		if (count && (size + msgsize > NG_UDP_PACKET_SIZE || count == 0xffff)) {
+			SendPacket(size, count);
+			size = NG_UDP_HEADER_SIZE;
+			count = 0;
+		}
+
+		unsigned char *buf = m_buffer + size;
+		buf = write_string(buf, msg->GetDestinationName());
+		buf = write_string(buf, msg->GetSenderName());
+		buf = write_string(buf, msg->GetSubject());
+		buf = write_string(buf, msg->GetMessageText());
+		size += msgsize;
+		count++;
+
+		msg->Release();
+	}
+
+	if (count)
+		SendPacket(size, count);
+
+	m_outgoing.clear();
+}
+
+void NG_UdpNetworkDeviceInterface::ReceiveMessages()
+{
+	struct sockaddr_in from;
+
+	for (;;) {
+#ifdef WIN32
+		int fromlen = sizeof(from);
+#else
+		socklen_t fromlen = sizeof(from);
+#endif
+		int size = recvfrom(m_socket, (char *)m_buffer, NG_UDP_MAX_PACKET_SIZE, 0,
+		                    (struct sockaddr *)&from, &fromlen);
+
+		if (size < 0) {
+#ifdef WIN32
+			// the peer being unreachable is reported on the next receive, ignore it
+			if (WSAGetLastError() == WSAECONNRESET)
+				continue;
+#else
+			if (errno == EINTR || errno == ECONNREFUSED)
+				continue;
+#endif
+			// nothing left to read
+			break;
+		}
+
+		// only accept the datagrams of the peer
+		if (from.sin_addr.s_addr != m_peerAddress || from.sin_port != m_peerPort)
+			continue;
+
+		ReadPacket(size);
+	}
+}
+
+void NG_UdpNetworkDeviceInterface::ReadPacket(unsigned int size)
+{
+	const unsigned char *buf = m_buffer, *end = m_buffer + size;
+
+	if (size < NG_UDP_HEADER_SIZE ||
+	    memcmp(buf, ng_udp_magic, 4) != 0 ||
+	    get_uint32(buf + 4) != m_passwordHash)
+	{
+		return;
+	}
+
+	// drop the duplicated datagrams and those that arrive after a newer one,
+	// the difference is signed so the sequence can wrap around
+	unsigned int sequence = get_uint32(buf + 8);
+	if (m_hasReceived) {
+		int delta = (int)(sequence - m_receiveSequence);
+		if (delta > 0) {
+			m_lostPackets += delta - 1;
+		}
+		else if (sequence != 0 && delta >= -NG_UDP_SEQUENCE_WINDOW) {
+			return;
+		}
+		// else the peer started again from 0, accept it as the new sequence
+	}
+	m_receiveSequence = sequence;
+	m_hasReceived = true;
+
+	unsigned int count = get_uint16(buf + 12);
+	buf += NG_UDP_HEADER_SIZE;
+
+	for (unsigned int i = 0; i < count; i++) {
+		STR_String to, from, subject, body;
+
+		if (!(buf = read_string(buf, end, to)) ||
+		    !(buf = read_string(buf, end, from)) ||
+		    !(buf = read_string(buf, end, subject)) ||
+		    !(buf = read_string(buf, end, body)))
+		{
+			// truncated datagram
+			return;
+		}
+
+		// the message is owned by the queue, delivered on this frame
+		NG_NetworkMessage *msg = new NG_NetworkMessage(to, from, subject, body);
+		m_messages[m_currentQueue].push_back(msg);
+	}
+}
@@ -0,0 +1,95 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file NG_UdpNetworkDeviceInterface.h
+ *  \ingroup bgenetudp
+ *  \brief UdpNetworkDeviceInterface derived from NG_NetworkDeviceInterface
+ *
+ * Messages are delivered locally like with the loopback device, and are
+ * also sent to a peer over UDP. The messages sent during a frame are packed
+ * in as few datagrams as possible at the end of the frame, the messages
+ * received from the peer are delivered on the next frame, together with the
+ * local ones. Sockets are non-blocking, the game never waits for the network.
+ */
+
+#ifndef __NG_UDPNETWORKDEVICEINTERFACE_H__
+#define __NG_UDPNETWORKDEVICEINTERFACE_H__
+
+#include <deque>
+#include <vector>
+#include "NG_NetworkDeviceInterface.h"
+
+class NG_UdpNetworkDeviceInterface : public NG_NetworkDeviceInterface
+{
+	std::deque<NG_NetworkMessage*> m_messages[2];
+	int		m_currentQueue;
+
+	/* messages to send to the peer at the end of the frame */
+	std::vector<NG_NetworkMessage*> m_outgoing;
+
+	/* the socket, an int on Unix and a SOCKET on Windows */
+	long	m_socket;
+	unsigned int	m_peerAddress;	/* IPv4 address, network byte order */
+	unsigned short	m_peerPort;		/* network byte order */
+	unsigned int	m_passwordHash;
+
+	unsigned int	m_sendSequence;
+	unsigned int	m_receiveSequence;
+	bool	m_hasReceived;
+	unsigned int	m_lostPackets;
+
+	/* datagram being packed or read */
+	unsigned char*	m_buffer;
+
+	void SendOutgoingMessages();
+	void ReceiveMessages();
+	void SendPacket(unsigned int size, unsigned int count);
+	void ReadPacket(unsigned int size);
+
+public:
+	NG_UdpNetworkDeviceInterface();
+	virtual ~NG_UdpNetworkDeviceInterface();
+
+	/**
+	 * Clear message buffer, send the messages of this frame to the peer
+	 * and queue the received ones for the next frame.
+	 */
+	virtual void NextFrame();
+
+	/**
+	 * Open a socket on localport and send the messages to address:port.
+	 * The password is not sent, the datagrams of peers using another
+	 * password are ignored. UDP has no connection, timeout is unused.
+	 */
+	virtual bool Connect(char *address, unsigned int port, char *password,
+	                     unsigned int localport, unsigned int timeout);
+	virtual bool Disconnect(void);
+
+	virtual void SendNetworkMessage(class NG_NetworkMessage* msg);
+	virtual std::vector<NG_NetworkMessage*>		RetrieveNetworkMessages();
+
+	/**
+	 * Number of datagrams of the peer that were lost or arrived too late,
+	 * known from the gaps in their sequence numbers.
+	 */
+	unsigned int GetLostPackets() { return m_lostPackets; }
+};
+
+#endif  /* __NG_UDPNETWORKDEVICEINTERFACE_H__ */
@@ -0,0 +1,200 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file gameengine/Network/UdpNetwork/test/udptest.cpp
+ *  \ingroup bgenetudp
+ *
+ * Loopback test of the UDP network device: message ordering between two
+ * devices, and late, duplicated and lost datagrams and a restarted peer
+ * using hand made datagrams.
+ */
+
+/* To compile run:
+ * g++ -I.. -I../.. -I../../../../../intern/string udptest.cpp ../NG_UdpNetworkDeviceInterface.cpp
+ *     ../../NG_NetworkMessage.cpp ../../../../../intern/string/intern/STR_String.cpp -o udptest
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+#include "NG_UdpNetworkDeviceInterface.h"
+#include "NG_NetworkMessage.h"
+
+#define PORT_A		47101
+#define PORT_B		47102
+#define PORT_RAW	47103
+#define PORT_C		47104
+
+static int error_status = 0;
+
+static void check(bool ok, const char *what)
+{
+	printf("%s: %s\n", ok ? "ok    " : "FAILED", what);
+	if (!ok)
+		error_status = 1;
+}
+
+static bool check_subjects(NG_UdpNetworkDeviceInterface *device, const char *expected[], unsigned int count)
+{
+	std::vector<NG_NetworkMessage*> messages = device->RetrieveNetworkMessages();
+
+	if (messages.size() != count)
+		return false;
+	for (unsigned int i = 0; i < count; i++) {
+		if (messages[i]->GetSubject() != expected[i])
+			return false;
+	}
+	return true;
+}
+
+/* datagram with one message, as written by SendPacket, password hash of NULL */
+static void send_raw(int sock, unsigned int sequence, const char *subject)
+{
+	unsigned char buf[256], *p = buf;
+	const char *strings[4] = {"", "raw", subject, ""};
+	struct sockaddr_in peer;
+
+	memcpy(p, "BGEN", 4);
+	p[4] = 0x81; p[5] = 0x1c; p[6] = 0x9d; p[7] = 0xc5;
+	p[8] = sequence >> 24; p[9] = sequence >> 16; p[10] = sequence >> 8; p[11] = sequence;
+	p[12] = 0; p[13] = 1;
+	p += 14;
+
+	for (int i = 0; i < 4; i++) {
+		unsigned int len = strlen(strings[i]);
+		p[0] = len >> 8;
+		p[1] = len;
+		memcpy(p + 2, strings[i], len);
+		p += 2 + len;
+	}
+
+	memset(&peer, 0, sizeof(peer));
+	peer.sin_family = AF_INET;
+	peer.sin_addr.s_addr = inet_addr("127.0.0.1");
+	peer.sin_port = htons(PORT_C);
+	sendto(sock, buf, p - buf, 0, (struct sockaddr *)&peer, sizeof(peer));
+}
+
+static void test_ordering()
+{
+	NG_UdpNetworkDeviceInterface a, b;
+	char address[] = "127.0.0.1";
+	char subject[16];
+
+	check(a.Connect(address, PORT_B, NULL, PORT_A, 0) && b.Connect(address, PORT_A, NULL, PORT_B, 0),
+	      "connect two devices");
+
+	// enough messages to be split over several datagrams
+	for (int i = 0; i < 200; i++) {
+		sprintf(subject, "%d", i);
+		a.SendNetworkMessage(new NG_NetworkMessage("", "a", subject, "0123456789012345678901234567890123456789"));
+	}
+	a.NextFrame();
+	b.NextFrame();
+
+	std::vector<NG_NetworkMessage*> messages = b.RetrieveNetworkMessages();
+	bool ok = (messages.size() == 200);
+	for (unsigned int i = 0; ok && i < messages.size(); i++) {
+		sprintf(subject, "%u", i);
+		ok = (messages[i]->GetSubject() == subject);
+	}
+	check(ok, "messages arrive in the order they were sent");
+	check(b.GetLostPackets() == 0, "no lost datagrams on loopback");
+}
+
+static void test_sequence()
+{
+	NG_UdpNetworkDeviceInterface c;
+	char address[] = "127.0.0.1";
+	struct sockaddr_in local;
+	int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+	memset(&local, 0, sizeof(local));
+	local.sin_family = AF_INET;
+	local.sin_addr.s_addr = inet_addr("127.0.0.1");
+	local.sin_port = htons(PORT_RAW);
+	check(sock != -1 && bind(sock, (struct sockaddr *)&local, sizeof(local)) == 0 &&
+	      c.Connect(address, PORT_RAW, NULL, PORT_C, 0), "connect device to raw socket");
+
+	// 2 is late and 1 duplicated, 4 is lost
+	send_raw(sock, 0, "0");
+	send_raw(sock, 1, "1");
+	send_raw(sock, 3, "3");
+	send_raw(sock, 2, "2");
+	send_raw(sock, 1, "1");
+	send_raw(sock, 5, "5");
+	c.NextFrame();
+
+	const char *expected[] = {"0", "1", "3", "5"};
+	check(check_subjects(&c, expected, 4), "late and duplicated datagrams are dropped");
+	check(c.GetLostPackets() == 2, "late and lost datagrams are counted");
+
+	// the peer starts again from 0
+	send_raw(sock, 0, "restart 0");
+	send_raw(sock, 1, "restart 1");
+	c.NextFrame();
+
+	const char *restarted[] = {"restart 0", "restart 1"};
+	check(check_subjects(&c, restarted, 2), "restarted peer is accepted");
+	check(c.GetLostPackets() == 2, "restart is not counted as lost");
+
+	// far older sequence, the peer was restarted and its first datagrams lost
+	send_raw(sock, 1000, "1000");
+	c.NextFrame();
+	send_raw(sock, 990, "990");
+	send_raw(sock, 900, "900");
+	c.NextFrame();
+
+	const char *jumped[] = {"900"};
+	check(check_subjects(&c, jumped, 1), "large backwards jump is a restart");
+
+	// the sequence wraps around
+	send_raw(sock, 0xfffffffeu, "-2");
+	c.NextFrame();
+	send_raw(sock, 0xffffffffu, "-1");
+	send_raw(sock, 1, "1");
+	send_raw(sock, 0xfffffffeu, "-2");
+	c.NextFrame();
+
+	const char *wrapped[] = {"-1", "1"};
+	check(check_subjects(&c, wrapped, 2), "sequence wraps around");
+
+	close(sock);
+}
+
+int main(int argc, char *argv[])
+{
+	test_ordering();
+	test_sequence();
+
+	if (error_status)
+		printf("\n*** UDP network test FAILED\n");
+	else
+		printf("\n*** UDP network test passed\n");
+
+	return error_status;
+}
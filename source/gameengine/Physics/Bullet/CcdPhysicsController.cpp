@@ -1340,6 +1340,35 @@ void		CcdPhysicsController::Jump()
 
 void		CcdPhysicsController::SetActive(bool active)
 {
+	// sensor objects are added to the world by their sensors
+	if (!m_object || m_cci.m_bSensor)
+		return;
+
+	// the broadphase handle tells if the object is in the world
+	if (active)
+	{
+		if (!m_object->getBroadphaseHandle())
+		{
+			// start from the current position of the object
+			btTransform xform = GetTransformFromMotionState(m_MotionState);
+			SetCenterOfMassTransform(xform);
+			m_object->activate(true);
+			m_cci.m_physicsEnv->AddCcdPhysicsController(this);
+		}
+	}
+	else if (m_object->getBroadphaseHandle())
+	{
+		m_cci.m_physicsEnv->RemoveCcdPhysicsController(this);
+
+		// an inactive object doesn't move, drop its motion
+		btRigidBody* body = GetRigidBody();
+		if (body)
+		{
+			body->setLinearVelocity(btVector3(0.0f, 0.0f, 0.0f));
+			body->setAngularVelocity(btVector3(0.0f, 0.0f, 0.0f));
+			body->clearForces();
+		}
+	}
 }
 		// reading out information from physics
 MT_Vector3		CcdPhysicsController::GetLinearVelocity()
@@ -89,6 +89,7 @@ class PHY_IPhysicsController : public PHY_IController
 		virtual void		SuspendDynamics(bool ghost=false)=0;
 		virtual void		RestoreDynamics()=0;
 
+		// add or remove the object from the physics world, the object is kept
 		virtual void		SetActive(bool active)=0;
 
 		// reading out information from physics
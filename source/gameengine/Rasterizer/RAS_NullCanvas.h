@@ -0,0 +1,103 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file RAS_NullCanvas.h
+ *  \ingroup bgerast
+ *  \brief Canvas without a window, for running the game engine headless.
+ */
+
+#ifndef __RAS_NULLCANVAS_H__
+#define __RAS_NULLCANVAS_H__
+
+#include "RAS_ICanvas.h"
+#include "RAS_Rect.h"
+
+/**
+ * Canvas of a fixed size that draws nothing, used with RAS_NullRasterizer
+ * to run the logic and physics of a game without a display.
+ */
+class RAS_NullCanvas : public RAS_ICanvas
+{
+	int m_width;
+	int m_height;
+	RAS_Rect m_displayarea;
+	int m_viewport[4];
+
+public:
+	RAS_NullCanvas(int width, int height)
+		:m_width(width),
+		m_height(height)
+	{
+		m_displayarea.SetLeft(0);
+		m_displayarea.SetBottom(0);
+		m_displayarea.SetRight(width);
+		m_displayarea.SetTop(height);
+		SetViewPort(0, 0, width - 1, height - 1);
+		m_mousestate = MOUSE_INVISIBLE;
+	}
+
+	virtual ~RAS_NullCanvas() {}
+
+	virtual void Init() {}
+	virtual void BeginFrame() {}
+	virtual void EndFrame() {}
+	virtual bool BeginDraw() { return true; }
+	virtual void EndDraw() {}
+	virtual void SwapBuffers() {}
+	virtual void SetSwapInterval(int interval) {}
+	virtual int GetSwapInterval() { return 0; }
+	virtual void ClearBuffer(int type) {}
+	virtual void ClearColor(float r, float g, float b, float a) {}
+
+	virtual int GetWidth() const { return m_width; }
+	virtual int GetHeight() const { return m_height; }
+	virtual int GetMouseX(int x) { return x; }
+	virtual int GetMouseY(int y) { return y; }
+	virtual float GetMouseNormalizedX(int x) { return float(x) / m_width; }
+	virtual float GetMouseNormalizedY(int y) { return float(y) / m_height; }
+
+	virtual const RAS_Rect &GetDisplayArea() const { return m_displayarea; }
+	virtual void SetDisplayArea(RAS_Rect *rect) { m_displayarea = *rect; }
+	virtual RAS_Rect &GetWindowArea() { return m_displayarea; }
+
+	virtual void SetViewPort(int x1, int y1, int x2, int y2)
+	{
+		m_viewport[0] = x1;
+		m_viewport[1] = y1;
+		m_viewport[2] = x2;
+		m_viewport[3] = y2;
+	}
+	virtual void UpdateViewPort(int x1, int y1, int x2, int y2) { SetViewPort(x1, y1, x2, y2); }
+	virtual const int *GetViewPort() { return m_viewport; }
+
+	virtual void SetMouseState(RAS_MouseState mousestate) { m_mousestate = mousestate; }
+	virtual void SetMousePosition(int x, int y) {}
+	virtual void MakeScreenShot(const char *filename) {}
+	virtual void ResizeWindow(int width, int height) {}
+	virtual void SetFullScreen(bool enable) {}
+	virtual bool GetFullScreen() { return false; }
+
+
+#ifdef WITH_CXX_GUARDEDALLOC
+	MEM_CXX_CLASS_ALLOC_FUNCS("GE:RAS_NullCanvas")
+#endif
+};
+
+#endif  /* __RAS_NULLCANVAS_H__ */
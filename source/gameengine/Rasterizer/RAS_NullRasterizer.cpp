@@ -0,0 +1,119 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file gameengine/Rasterizer/RAS_NullRasterizer.cpp
+ *  \ingroup bgerast
+ */
+
+#include "RAS_NullRasterizer.h"
+
+RAS_NullRasterizer::RAS_NullRasterizer(RAS_ICanvas *canvas)
+	:RAS_IRasterizer(canvas),
+	m_stereomode(RAS_STEREO_NOSTEREO),
+	m_curreye(RAS_STEREO_LEFTEYE),
+	m_eyeseparation(0.0f),
+	m_focallength(0.0f),
+	m_drawingmode(KX_TEXTURED),
+	m_fogenabled(false),
+	m_motionblur(0),
+	m_motionblurvalue(-1.0f),
+	m_anisotropic(0),
+	m_mipmapping(RAS_MIPMAP_NONE),
+	m_usingoverrideshader(false),
+	m_camortho(false),
+	m_campos(0.0, 0.0, 0.0)
+{
+	m_viewmatrix.setIdentity();
+	m_viewinvmatrix.setIdentity();
+}
+
+RAS_NullRasterizer::~RAS_NullRasterizer()
+{
+}
+
+bool RAS_NullRasterizer::Stereo()
+{
+	return (m_stereomode > RAS_STEREO_NOSTEREO);
+}
+
+bool RAS_NullRasterizer::InterlacedStereo()
+{
+	return (m_stereomode == RAS_STEREO_VINTERLACE || m_stereomode == RAS_STEREO_INTERLACED);
+}
+
+void RAS_NullRasterizer::SetViewMatrix(const MT_Matrix4x4 &mat, const MT_Matrix3x3 &ori,
+                                       const MT_Point3 &pos, bool perspective)
+{
+	// nothing is drawn, so the stereo eye offset of the OpenGL rasterizer is left out
+	m_viewmatrix = mat;
+	m_viewinvmatrix = m_viewmatrix;
+	m_viewinvmatrix.invert();
+	m_campos = pos;
+}
+
+/* Same matrix as glFrustum(), computed without a context */
+MT_Matrix4x4 RAS_NullRasterizer::GetFrustumMatrix(
+        float left, float right, float bottom, float top,
+        float frustnear, float frustfar,
+        float focallength, bool perspective)
+{
+	MT_Scalar x = (2.0 * frustnear) / (right - left);
+	MT_Scalar y = (2.0 * frustnear) / (top - bottom);
+	MT_Scalar a = (right + left) / (right - left);
+	MT_Scalar b = (top + bottom) / (top - bottom);
+	MT_Scalar c = -(frustfar + frustnear) / (frustfar - frustnear);
+	MT_Scalar d = -(2.0 * frustfar * frustnear) / (frustfar - frustnear);
+
+	return MT_Matrix4x4(x,   0.0, a,    0.0,
+	                    0.0, y,   b,    0.0,
+	                    0.0, 0.0, c,    d,
+	                    0.0, 0.0, -1.0, 0.0);
+}
+
+/* Same matrix as glOrtho(), computed without a context */
+MT_Matrix4x4 RAS_NullRasterizer::GetOrthoMatrix(
+        float left, float right, float bottom, float top,
+        float frustnear, float frustfar)
+{
+	MT_Scalar x = 2.0 / (right - left);
+	MT_Scalar y = 2.0 / (top - bottom);
+	MT_Scalar z = -2.0 / (frustfar - frustnear);
+	MT_Scalar tx = -(right + left) / (right - left);
+	MT_Scalar ty = -(top + bottom) / (top - bottom);
+	MT_Scalar tz = -(frustfar + frustnear) / (frustfar - frustnear);
+
+	return MT_Matrix4x4(x,   0.0, 0.0, tx,
+	                    0.0, y,   0.0, ty,
+	                    0.0, 0.0, z,   tz,
+	                    0.0, 0.0, 0.0, 1.0);
+}
+
+void RAS_NullRasterizer::EnableMotionBlur(float motionblurvalue)
+{
+	if (m_motionblur == 0)
+		m_motionblur = 1;
+	m_motionblurvalue = motionblurvalue;
+}
+
+void RAS_NullRasterizer::DisableMotionBlur()
+{
+	m_motionblur = 0;
+	m_motionblurvalue = -1.0f;
+}
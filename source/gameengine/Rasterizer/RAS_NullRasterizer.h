@@ -0,0 +1,175 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file RAS_NullRasterizer.h
+ *  \ingroup bgerast
+ *  \brief Rasterizer without a graphics context, for running the game engine headless.
+ */
+
+#ifndef __RAS_NULLRASTERIZER_H__
+#define __RAS_NULLRASTERIZER_H__
+
+#include "RAS_IRasterizer.h"
+
+/**
+ * Rasterizer that draws nothing. It keeps the state the engine reads back
+ * (camera, stereo and drawing settings) so that the scenes behave as with
+ * RAS_OpenGLRasterizer, but needs no OpenGL context.
+ */
+class RAS_NullRasterizer : public RAS_IRasterizer
+{
+	StereoMode m_stereomode;
+	StereoEye m_curreye;
+	float m_eyeseparation;
+	float m_focallength;
+	int m_drawingmode;
+	bool m_fogenabled;
+	int m_motionblur;
+	float m_motionblurvalue;
+	short m_anisotropic;
+	MipmapOption m_mipmapping;
+	bool m_usingoverrideshader;
+	bool m_camortho;
+	MT_Point3 m_campos;
+	MT_Matrix4x4 m_viewmatrix;
+	MT_Matrix4x4 m_viewinvmatrix;
+
+public:
+	RAS_NullRasterizer(RAS_ICanvas *canvas);
+	virtual ~RAS_NullRasterizer();
+
+	virtual void SetDepthMask(DepthMask depthmask) {}
+	virtual bool SetMaterial(const RAS_IPolyMaterial &mat) { return true; }
+	virtual bool Init() { return true; }
+	virtual void Exit() {}
+	virtual bool BeginFrame(int drawingmode, double time) { m_drawingmode = drawingmode; return true; }
+	virtual void ClearColorBuffer() {}
+	virtual void ClearDepthBuffer() {}
+	virtual void ClearCachingInfo(void) {}
+	virtual void EndFrame() {}
+	virtual void SetRenderArea() {}
+
+	virtual void SetStereoMode(const StereoMode stereomode) { m_stereomode = stereomode; }
+	virtual bool Stereo();
+	virtual StereoMode GetStereoMode() { return m_stereomode; }
+	virtual bool InterlacedStereo();
+	virtual void SetEye(const StereoEye eye) { m_curreye = eye; }
+	virtual StereoEye GetEye() { return m_curreye; }
+	virtual void SetEyeSeparation(const float eyeseparation) { m_eyeseparation = eyeseparation; }
+	virtual float GetEyeSeparation() { return m_eyeseparation; }
+	virtual void SetFocalLength(const float focallength) { m_focallength = focallength; }
+	virtual float GetFocalLength() { return m_focallength; }
+	virtual void SwapBuffers() {}
+
+	virtual void IndexPrimitives(class RAS_MeshSlot &ms) {}
+	virtual void IndexPrimitivesMulti(class RAS_MeshSlot &ms) {}
+	virtual void IndexPrimitives_3DText(class RAS_MeshSlot &ms, class RAS_IPolyMaterial *polymat) {}
+
+	virtual void SetProjectionMatrix(MT_CmMatrix4x4 &mat) { m_camortho = (mat(3, 3) != 0.0); }
+	virtual void SetProjectionMatrix(const MT_Matrix4x4 &mat) { m_camortho = (mat[3][3] != 0.0); }
+	virtual void SetViewMatrix(const MT_Matrix4x4 &mat, const MT_Matrix3x3 &ori,
+	                           const MT_Point3 &pos, bool perspective);
+	virtual const MT_Point3& GetCameraPosition() { return m_campos; }
+	virtual bool GetCameraOrtho() { return m_camortho; }
+
+	virtual void SetFog(float start, float dist, float r, float g, float b) { m_fogenabled = true; }
+	virtual void SetFogColor(float r, float g, float b) { m_fogenabled = true; }
+	virtual void SetFogStart(float start) { m_fogenabled = true; }
+	virtual void SetFogEnd(float end) { m_fogenabled = true; }
+	virtual void DisplayFog() {}
+	virtual void DisableFog() { m_fogenabled = false; }
+	virtual bool IsFogEnabled() { return m_fogenabled; }
+
+	virtual void SetBackColor(float red, float green, float blue, float alpha) {}
+	virtual void SetDrawingMode(int drawingmode) { m_drawingmode = drawingmode; }
+	virtual int GetDrawingMode() { return m_drawingmode; }
+	virtual void SetCullFace(bool enable) {}
+	virtual void SetLines(bool enable) {}
+	virtual double GetTime() { return 0.0; }
+
+	virtual MT_Matrix4x4 GetFrustumMatrix(
+	        float left, float right, float bottom, float top,
+	        float frustnear, float frustfar,
+	        float focallength = 0.0f, bool perspective = true);
+	virtual MT_Matrix4x4 GetOrthoMatrix(
+	        float left, float right, float bottom, float top,
+	        float frustnear, float frustfar);
+
+	virtual void SetSpecularity(float specX, float specY, float specZ, float specval) {}
+	virtual void SetShinyness(float shiny) {}
+	virtual void SetDiffuse(float difX, float difY, float difZ, float diffuse) {}
+	virtual void SetEmissive(float eX, float eY, float eZ, float e) {}
+	virtual void SetAmbientColor(float red, float green, float blue) {}
+	virtual void SetAmbient(float factor) {}
+	virtual void SetPolygonOffset(float mult, float add) {}
+
+	virtual void DrawDebugLine(const MT_Vector3 &from, const MT_Vector3 &to, const MT_Vector3& color) {}
+	virtual void DrawDebugCircle(const MT_Vector3 &center, const MT_Scalar radius, const MT_Vector3 &color,
+	                             const MT_Vector3 &normal, int nsector) {}
+	virtual void FlushDebugShapes() {}
+
+	virtual void SetTexCoordNum(int num) {}
+	virtual void SetAttribNum(int num) {}
+	virtual void SetTexCoord(TexCoGen coords, int unit) {}
+	virtual void SetAttrib(TexCoGen coords, int unit, int layer = 0) {}
+
+	virtual const MT_Matrix4x4 &GetViewMatrix() const { return m_viewmatrix; }
+	virtual const MT_Matrix4x4 &GetViewInvMatrix() const { return m_viewinvmatrix; }
+
+	virtual void EnableMotionBlur(float motionblurvalue);
+	virtual void DisableMotionBlur();
+	virtual float GetMotionBlurValue() { return m_motionblurvalue; }
+	virtual int GetMotionBlurState() { return m_motionblur; }
+	virtual void SetMotionBlurState(int newstate) { m_motionblur = (newstate < 0) ? 0 : (newstate > 2) ? 2 : newstate; }
+
+	virtual void SetAlphaBlend(int alphablend) {}
+	virtual void SetFrontFace(bool ccw) {}
+
+	virtual void SetAnisotropicFiltering(short level) { m_anisotropic = level; }
+	virtual short GetAnisotropicFiltering() { return m_anisotropic; }
+	virtual void SetMipmapping(MipmapOption val) { m_mipmapping = val; }
+	virtual MipmapOption GetMipmapping() { return m_mipmapping; }
+	virtual void SetUsingOverrideShader(bool val) { m_usingoverrideshader = val; }
+	virtual bool GetUsingOverrideShader() { return m_usingoverrideshader; }
+
+	virtual void applyTransform(double *oglmatrix, int drawingmode) {}
+	virtual void RenderBox2D(int xco, int yco, int width, int height, float percentage) {}
+	virtual void RenderText3D(
+	        int fontid, const char *text, int size, int dpi,
+	        const float color[4], const double mat[16], float aspect) {}
+	virtual void RenderText2D(
+	        RAS_TEXT_RENDER_MODE mode, const char *text,
+	        int xco, int yco, int width, int height) {}
+	virtual void ProcessLighting(bool uselights, const MT_Transform &trans) {}
+	virtual void PushMatrix() {}
+	virtual void PopMatrix() {}
+	virtual void AddLight(struct RAS_LightObject *lightobject) {}
+	virtual void RemoveLight(struct RAS_LightObject *lightobject) {}
+	virtual void MotionBlur() {}
+	virtual void SetClientObject(void *obj) {}
+	virtual void SetAuxilaryClientInfo(void *inf) {}
+
+
+#ifdef WITH_CXX_GUARDEDALLOC
+	MEM_CXX_CLASS_ALLOC_FUNCS("GE:RAS_NullRasterizer")
+#endif
+};
+
+#endif  /* __RAS_NULLRASTERIZER_H__ */
@@ -0,0 +1,133 @@
+# ./blender.bin --background -noaudio --python source/tests/bl_modifier_cache.py
+#
+# Results of the modifier stack read from the modifier cache
+# must match the ones of an evaluation without the cache.
+
+import unittest
+from test import support
+
+import bpy
+import bmesh
+
+
+def mesh_grid_new(name, size=4):
+    verts = [(x, y, 0.0) for y in range(size) for x in range(size)]
+    faces = [(y * size + x, y * size + x + 1, (y + 1) * size + x + 1, (y + 1) * size + x)
+             for y in range(size - 1) for x in range(size - 1)]
+
+    me = bpy.data.meshes.new(name)
+    me.from_pydata(verts, [], faces)
+    me.update()
+    return me
+
+
+def object_evaluate(scene, obj):
+    """Evaluate the modifier stack of obj, return its vertices and faces."""
+    obj.update_tag(refresh={'DATA'})
+    scene.update()
+
+    bm = bmesh.new()
+    bm.from_object(obj, scene)
+
+    verts = [tuple(v.co) for v in bm.verts]
+    faces = [(tuple(v.index for v in f.verts), f.material_index) for f in bm.faces]
+
+    bm.free()
+    return verts, faces
+
+
+class ModifierCacheTesting(unittest.TestCase):
+    def setUp(self):
+        self.system = bpy.context.user_preferences.system
+        self.scene = bpy.context.scene
+
+        me = mesh_grid_new("cache_test")
+        self.obj = bpy.data.objects.new("cache_test", me)
+        self.scene.objects.link(self.obj)
+
+        md = self.obj.modifiers.new("array", 'ARRAY')
+        md.count = 3
+        md.use_merge_vertices = True
+
+        md = self.obj.modifiers.new("solidify", 'SOLIDIFY')
+        md.thickness = 0.25
+        md.material_offset = 1
+
+        md = self.obj.modifiers.new("subsurf", 'SUBSURF')
+        md.levels = 1
+
+        md = self.obj.modifiers.new("triangulate", 'TRIANGULATE')
+
+    def tearDown(self):
+        self.system.use_modifier_cache = False
+        self.scene.objects.unlink(self.obj)
+        me = self.obj.data
+        bpy.data.objects.remove(self.obj)
+        bpy.data.meshes.remove(me)
+
+    def evaluate_uncached(self):
+        """Evaluate with the cache off, this also frees the cache."""
+        use_cache = self.system.use_modifier_cache
+        self.system.use_modifier_cache = False
+        result = object_evaluate(self.scene, self.obj)
+        self.system.use_modifier_cache = use_cache
+        return result
+
+    def evaluate_cached(self):
+        """Evaluate twice with the cache on, the unchanged input lets the second one store its results."""
+        self.system.use_modifier_cache = True
+        object_evaluate(self.scene, self.obj)
+        return object_evaluate(self.scene, self.obj)
+
+    def test_cache_hit(self):
+        self.evaluate_cached()
+
+        # the array and solidify results are read from the cache
+        self.obj.modifiers["subsurf"].levels = 2
+        cached = object_evaluate(self.scene, self.obj)
+
+        self.assertEqual(cached, self.evaluate_uncached())
+
+    def test_cache_hit_last(self):
+        first = self.evaluate_cached()
+
+        # the whole stack is read from the cache
+        cached = object_evaluate(self.scene, self.obj)
+
+        self.assertEqual(cached, first)
+        self.assertEqual(cached, self.evaluate_uncached())
+
+    def test_panel_expanded(self):
+        self.evaluate_cached()
+
+        for md in self.obj.modifiers:
+            md.show_expanded = not md.show_expanded
+        cached = object_evaluate(self.scene, self.obj)
+
+        self.assertEqual(cached, self.evaluate_uncached())
+
+    def test_material_count(self):
+        self.obj.data.materials.append(bpy.data.materials.new("cache_test_a"))
+        self.evaluate_cached()
+
+        # solidify clamps the offset material indices to the object materials
+        self.obj.data.materials.append(bpy.data.materials.new("cache_test_b"))
+        cached = object_evaluate(self.scene, self.obj)
+
+        self.assertEqual(cached, self.evaluate_uncached())
+        self.assertTrue(any(material_index == 1 for _verts, material_index in cached[1]))
+
+
+def test_main():
+    try:
+        support.run_unittest(ModifierCacheTesting)
+    except:
+        import traceback
+        traceback.print_exc()
+
+        # alert CTest we failed
+        import sys
+        sys.exit(1)
+
+if __name__ == '__main__':
+    test_main()